@@ -0,0 +1,142 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "Bitmap.h"
+#include "BitmapView.h"
+#include "UtilsCubemap.h"
+
+// Note: Microbenchmark of the per pixel Bitmap interface (getPixel/setPixel) against BitmapView and BitmapKernels
+// on the conversions the texture loaders do. Headless, built as its own executable (see benchmarks/CMakeLists.txt).
+namespace {
+
+	constexpr int WIDTH = 2048;
+	constexpr int HEIGHT = 1024;
+	constexpr int RUNS = 5;
+
+	// best of RUNS in milliseconds
+	template<class Function>
+	double Measure(Function&& function) {
+		double best = 1e30;
+
+		for (int run = 0; run < RUNS; run++) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		return best;
+	}
+
+	void Report(const std::string& name, double oldTime, double newTime) {
+		const double pixels = double(WIDTH) * HEIGHT;
+
+		std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(10) << pixels / (oldTime * 1000.0) << " MPix/s"
+			<< std::setw(10) << pixels / (newTime * 1000.0) << " MPix/s"
+			<< std::setw(8) << oldTime / newTime << "x\n";
+	}
+
+	// keeps the optimizer from dropping the results
+	volatile float g_Sink = 0.0f;
+}
+
+int main() {
+	Bitmap rgba8(WIDTH, HEIGHT, 4, eBitmapFormat_UnsignedByte);
+	Bitmap rgb32(WIDTH, HEIGHT, 3, eBitmapFormat_Float);
+	Bitmap rgba32(WIDTH, HEIGHT, 4, eBitmapFormat_Float);
+	Bitmap srgb8(WIDTH, HEIGHT, 4, eBitmapFormat_UnsignedByte);
+
+	for (size_t i = 0; i < rgba8.Data.size(); i++)
+		rgba8.Data[i] = uint8_t(i * 31);
+
+	auto rgb = rgb32.view<eBitmapFormat_Float, 3>();
+
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
+			rgb.store(x, y, glm::vec4(float(x) / WIDTH, float(y) / HEIGHT, 0.5f, 1.0f));
+
+	std::cout << std::left << std::setw(28) << "" << std::right << std::setw(17) << "getPixel/setPixel" << std::setw(17) << "view/kernels" << '\n';
+
+	Report("u8 -> f32 RGBA",
+		Measure([&]() {
+			for (int y = 0; y < HEIGHT; y++)
+				for (int x = 0; x < WIDTH; x++)
+					rgba32.setPixel(x, y, rgba8.getPixel(x, y));
+		}),
+		Measure([&]() {
+			BitmapKernels::unsignedByteToFloat(rgba8.Data.data(), rgba32.view<eBitmapFormat_Float, 4>().data(), rgba8.Data.size());
+		}));
+
+	Report("f32 RGB -> RGBA",
+		Measure([&]() {
+			for (int y = 0; y < HEIGHT; y++) {
+				for (int x = 0; x < WIDTH; x++) {
+					glm::vec4 color = rgb32.getPixel(x, y);
+					color.w = 1.0f;
+					rgba32.setPixel(x, y, color);
+				}
+			}
+		}),
+		Measure([&]() {
+			BitmapKernels::rgbToRGBA(rgb32.view<eBitmapFormat_Float, 3>().data(), rgba32.view<eBitmapFormat_Float, 4>().data(), size_t(WIDTH) * HEIGHT);
+		}));
+
+	Report("linear f32 -> sRGB u8",
+		Measure([&]() {
+			for (int y = 0; y < HEIGHT; y++) {
+				for (int x = 0; x < WIDTH; x++) {
+					glm::vec4 color = rgba32.getPixel(x, y);
+
+					for (int c = 0; c < 3; c++)
+						color[c] = color[c] <= 0.0031308f ? color[c] * 12.92f : 1.055f * std::pow(color[c], 1.0f / 2.4f) - 0.055f;
+
+					srgb8.setPixel(x, y, color);
+				}
+			}
+		}),
+		Measure([&]() {
+			BitmapKernels::linearToSRGB(rgba32.view<eBitmapFormat_Float, 4>().data(), srgb8.view<eBitmapFormat_UnsignedByte, 4>().data(), size_t(WIDTH) * HEIGHT, 4);
+		}));
+
+	Report("f32 RGBA 2x2 sum",
+		Measure([&]() {
+			float sum = 0.0f;
+
+			for (int y = 0; y + 1 < HEIGHT; y++)
+				for (int x = 0; x + 1 < WIDTH; x++)
+					sum += (rgba32.getPixel(x, y) + rgba32.getPixel(x + 1, y) + rgba32.getPixel(x, y + 1) + rgba32.getPixel(x + 1, y + 1)).x;
+
+			g_Sink = sum;
+		}),
+		Measure([&]() {
+			const auto view = rgba32.view<eBitmapFormat_Float, 4>();
+			float sum = 0.0f;
+
+			for (int y = 0; y + 1 < HEIGHT; y++) {
+				const auto row0 = view.row(y);
+				const auto row1 = view.row(y + 1);
+
+				for (int x = 0; x + 1 < WIDTH; x++)
+					sum += row0[x * 4] + row0[x * 4 + 4] + row1[x * 4] + row1[x * 4 + 4];
+			}
+
+			g_Sink = sum;
+		}));
+
+	Report("equirect -> cube faces",
+		Measure([&]() {
+			Bitmap faces = Utils::convertVerticalCrossToCubeMapFaces(Utils::convertEquirectangularMapToVerticalCross(rgba32));
+			g_Sink = float(faces.Data[0]);
+		}),
+		Measure([&]() {
+			Bitmap faces = Utils::convertEquirectangularMapToCubeMapFaces(rgba32, 1);
+			g_Sink = float(faces.Data[0]);
+		}));
+
+	return 0;
+}
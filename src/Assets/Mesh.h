@@ -4,6 +4,9 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
 #include <glm.hpp>
 #include <gtx/hash.hpp>
@@ -69,7 +72,163 @@ namespace Assets {
 			return attributeDescriptions;
 		}
 	};
+
+	// Note: Vertex is always the CPU side format (importer, mesh cache, optimizer), the layout only changes what 
+	// CompileMesh uploads to the GPU and which vertex input/shader variant the pipelines are built with.
+	enum VertexLayout : uint8_t {
+		tStandardLayout = 0,		// Vertex, 56 bytes of fp32
+		tPackedLayout,				// PackedVertex, 20 bytes
+		tPackedColorLayout,			// PackedColorVertex, 24 bytes
+		tNumVertexLayouts
+	};
+
+	// Note: The position is quantized to unorm16 against the model bounds (Model::PositionOffset/PositionScale), 
+	// the normal and tangent are octahedral encoded to snorm16 and the uv is stored as half floats. The attribute 
+	// locations match Vertex but there is no color (location 2), vertex shaders declaring it need a packed variant. 
+	// Shaders reading nothing but the position (e.g. shadow_mapping.vert) work unchanged.
+	struct PackedVertex {
+		uint16_t pos[4]			= {};		// w is padding, three component 16 bit formats are not required for vertex buffers
+		int16_t normal[2]		= {};
+		int16_t tangent[2]		= {};
+		uint16_t texCoord[2]	= {};
+
+		static VkVertexInputBindingDescription GetBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(PackedVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions() {
+
+			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+
+			attributeDescriptions[0].binding	= 0;
+			attributeDescriptions[0].location	= 0;
+			attributeDescriptions[0].format		= VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset		= offsetof(PackedVertex, pos);
+
+			attributeDescriptions[1].binding	= 0;
+			attributeDescriptions[1].location	= 1;
+			attributeDescriptions[1].format		= VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[1].offset		= offsetof(PackedVertex, normal);
+
+			attributeDescriptions[2].binding	= 0;
+			attributeDescriptions[2].location	= 3;
+			attributeDescriptions[2].format		= VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[2].offset		= offsetof(PackedVertex, tangent);
+
+			attributeDescriptions[3].binding	= 0;
+			attributeDescriptions[3].location	= 4;
+			attributeDescriptions[3].format		= VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[3].offset		= offsetof(PackedVertex, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	struct PackedColorVertex {
+		uint16_t pos[4]			= {};
+		int16_t normal[2]		= {};
+		int16_t tangent[2]		= {};
+		uint16_t texCoord[2]	= {};
+		uint8_t color[4]		= {};
+
+		static VkVertexInputBindingDescription GetBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(PackedColorVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions() {
+
+			std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
+
+			attributeDescriptions[0].binding	= 0;
+			attributeDescriptions[0].location	= 0;
+			attributeDescriptions[0].format		= VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset		= offsetof(PackedColorVertex, pos);
+
+			attributeDescriptions[1].binding	= 0;
+			attributeDescriptions[1].location	= 1;
+			attributeDescriptions[1].format		= VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[1].offset		= offsetof(PackedColorVertex, normal);
+
+			attributeDescriptions[2].binding	= 0;
+			attributeDescriptions[2].location	= 2;
+			attributeDescriptions[2].format		= VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[2].offset		= offsetof(PackedColorVertex, color);
+
+			attributeDescriptions[3].binding	= 0;
+			attributeDescriptions[3].location	= 3;
+			attributeDescriptions[3].format		= VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[3].offset		= offsetof(PackedColorVertex, tangent);
+
+			attributeDescriptions[4].binding	= 0;
+			attributeDescriptions[4].location	= 4;
+			attributeDescriptions[4].format		= VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[4].offset		= offsetof(PackedColorVertex, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	struct VertexInputDescription {
+		VkVertexInputBindingDescription Binding = {};
+		std::vector<VkVertexInputAttributeDescription> Attributes;
+	};
+
+	template<class VertexType>
+	VertexInputDescription MakeVertexInputDescription() {
+		auto attributes = VertexType::GetAttributeDescriptions();
+
+		return { VertexType::GetBindingDescription(), std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end()) };
+	}
+
+	inline VertexInputDescription GetVertexInputDescription(VertexLayout layout) {
+		switch (layout) {
+		case tPackedLayout:			return MakeVertexInputDescription<PackedVertex>();
+		case tPackedColorLayout:	return MakeVertexInputDescription<PackedColorVertex>();
+		default:					return MakeVertexInputDescription<Vertex>();
+		}
+	}
+
+	inline size_t GetVertexStride(VertexLayout layout) {
+		return GetVertexInputDescription(layout).Binding.stride;
+	}
 	
+	// Note: 64 bytes and std430 compatible so the GPU copy can be read straight from the model's DataBuffer. 
+	// The cone test is 'dot(normalize(ConeApex - viewPosition), ConeAxis) >= ConeCutoff' -> every triangle is 
+	// backfacing, all in mesh space. See MeshletBuilder.h.
+	struct Meshlet {
+		glm::vec3 Center		= glm::vec3(0.0f);				// bounding sphere
+		float Radius			= 0.0f;
+
+		glm::vec3 ConeApex		= glm::vec3(0.0f);
+		float ConeCutoff		= 1.0f;							// 1 when the normals spread too much to ever cull
+
+		glm::vec3 ConeAxis		= glm::vec3(0.0f, 0.0f, 1.0f);
+		uint32_t VertexOffset	= 0;							// into MeshletVertices
+
+		uint32_t TriangleOffset = 0;							// into MeshletTriangles
+		uint32_t VertexCount	= 0;
+		uint32_t TriangleCount	= 0;
+		uint32_t BaseVertex		= 0;							// added to MeshletVertices, 0 on the CPU, Mesh::VertexOffset on the GPU
+	};
+
+	// Note: A simplified index buffer over the vertices of the mesh, see MeshSimplifier.h.
+	struct MeshLod {
+		std::vector<uint32_t> Indices;
+
+		size_t IndexOffset	= 0;
+		float Error			= 0.0f;		// largest distance from the full detail surface, in mesh units
+	};
+
 	struct Mesh {
 		std::string MaterialName = "";
 
@@ -78,11 +237,47 @@ namespace Assets {
 		std::vector<Vertex> Vertices;
 		std::vector<uint32_t> Indices;
 
+		// optional, built by CompileMesh. MeshletVertices are mesh local vertex indices and every MeshletTriangles 
+		// entry packs the three meshlet local indices of a triangle (8 bits each)
+		std::vector<Meshlet> Meshlets;
+		std::vector<uint32_t> MeshletVertices;
+		std::vector<uint32_t> MeshletTriangles;
+
 		size_t MaterialIndex	= 0;
 		size_t IndexOffset		= 0;
 		size_t VertexOffset		= 0;
+		size_t MeshletOffset	= 0;		// first meshlet of the mesh in the model's meshlet stream
+
+		// optional coarser levels sharing Vertices, level 0 is Indices itself and level i is Lods[i - 1]
+		std::vector<MeshLod> Lods;
 
 		glm::vec3 PivotVector = glm::vec3(1.0f);
+
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(Lods.size()) + 1; }
+
+		size_t GetIndexCount(uint32_t lod) const {
+			lod = std::min(lod, static_cast<uint32_t>(Lods.size()));
+			return lod == 0 ? Indices.size() : Lods[lod - 1].Indices.size();
+		}
+
+		size_t GetIndexOffset(uint32_t lod) const {
+			lod = std::min(lod, static_cast<uint32_t>(Lods.size()));
+			return lod == 0 ? IndexOffset : Lods[lod - 1].IndexOffset;
+		}
+
+		// coarsest level whose error stays within 'maxError' (mesh units), no limit (<= 0) always keeps the full mesh,
+		// even over levels with no error at all (e.g. only welded vertices)
+		uint32_t SelectLod(float maxError) const {
+			uint32_t lod = 0;
+
+			if (maxError <= 0.0f)
+				return lod;
+
+			while (lod < Lods.size() && Lods[lod].Error <= maxError)
+				lod++;
+
+			return lod;
+		}
 	};	
 }
 
@@ -93,17 +288,42 @@ namespace PSOFlags {
 		tTwoSided		= 0x004,
 		tStencilTest	= 0x008,
 //		tHasTangent		= 0x0016,
+		tPackedVertex	= 0x010,
+		tVertexColor	= 0x020,		// only meaningful together with tPackedVertex
 	};
+
+	inline uint16_t FromVertexLayout(Assets::VertexLayout layout) {
+		switch (layout) {
+		case Assets::tPackedLayout:			return tPackedVertex;
+		case Assets::tPackedColorLayout:	return tPackedVertex | tVertexColor;
+		default:							return 0;
+		}
+	}
+
+	inline Assets::VertexLayout GetVertexLayout(uint16_t flags) {
+		if (!(flags & tPackedVertex))
+			return Assets::tStandardLayout;
+
+		return flags & tVertexColor ? Assets::tPackedColorLayout : Assets::tPackedLayout;
+	}
 }
 
 namespace std {
     template<> struct hash<Assets::Vertex> {
         size_t operator()(Assets::Vertex const& vertex) const {
-			return hash<glm::vec3>()(vertex.pos)
-				^ hash<glm::vec3>()(vertex.normal)
-				^ hash<glm::vec3>()(vertex.color)
-				^ hash<glm::vec2>()(vertex.texCoord);
+			// combined instead of xor'ed, symmetric attributes (e.g. pos == normal) would cancel each other out
+			size_t seed = 0;
+
+			auto combine = [&seed](size_t value) {
+				seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			};
+
+			combine(hash<glm::vec3>()(vertex.pos));
+			combine(hash<glm::vec3>()(vertex.normal));
+			combine(hash<glm::vec3>()(vertex.color));
+			combine(hash<glm::vec2>()(vertex.texCoord));
+
+			return seed;
         }
     };
 }
-
@@ -1,6 +1,8 @@
 #include "Model.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 #include "../Core/GraphicsDevice.h"
 #include "../Core/UI.h"
@@ -38,6 +40,40 @@ namespace Assets {
 		return model;
 	}
 
+	// Note: For shaders that only transform positions (e.g. shadow mapping) the dequantization of the packed 
+	// layouts can be folded into the model matrix instead of decoded per vertex.
+	glm::mat4 Model::GetPositionDecodeMatrix() {
+		return glm::scale(glm::translate(glm::mat4(1.0f), PositionOffset), PositionScale);
+	}
+
+
+	// Note: The error a level may have in mesh units so it projects to less than LodThreshold of the screen height at 
+	// 'distance'. Zero (LOD disabled or nothing to project) keeps every mesh at LOD 0, see Mesh::SelectLod.
+	float Model::GetLodErrorLimit(const Camera& camera, float distance) const {
+		float projection = camera.ProjectionMatrix[1][1] * Transformations.scaleHandler;
+
+		if (!EnableLod || projection <= 0.0f || distance <= 0.0f)
+			return 0.0f;
+
+		return LodThreshold * 2.0f * distance / projection;
+	}
+
+	// Note: One level for the whole model, for instanced draws. Meshes that run out of levels stay at their coarsest.
+	uint32_t Model::SelectLod(float maxError) const {
+		uint32_t lod = 0;
+		uint32_t limit = std::numeric_limits<uint32_t>::max();
+
+		for (const auto& mesh : Meshes) {
+			uint32_t meshLod = mesh.SelectLod(maxError);
+
+			lod = std::max(lod, meshLod);
+
+			if (meshLod < mesh.GetLodCount() - 1)
+				limit = std::min(limit, meshLod);
+		}
+
+		return std::min(lod, limit);
+	}
 
 	void Model::OnUIRender() {
 
@@ -76,6 +112,14 @@ namespace Assets {
 
 			ImGui::Checkbox("Stencil Test", &StencilTest);
 
+			if (std::any_of(Meshes.begin(), Meshes.end(), [](const Mesh& mesh) { return !mesh.Lods.empty(); })) {
+				ImGui::Checkbox("Level of Detail", &EnableLod);
+
+				if (EnableLod) {
+					ImGui::DragFloat("LOD Threshold", &LodThreshold, 0.0001f, 0.0f, 0.1f, "%.04f");
+				}
+			}
+
 			if (StencilTest && FirstStencil) {
 				AddPipelineFlag(PSOFlags::tStencilTest);
 				FirstStencil = false;
@@ -100,7 +144,11 @@ namespace Assets {
 	}
 
 	void Model::Render(Renderer::MeshSorter& sorter) {
-		
+		if (UploadTicket != 0) {
+			Graphics::GetDevice()->RequireUploads(UploadTicket);
+			UploadTicket = 0;
+		}
+
 		for (const auto& mesh : Meshes) {
 			glm::mat4 toOrigin = glm::translate(glm::mat4(1.0f), -mesh.PivotVector);
 			glm::mat4 toPosition = glm::translate(glm::mat4(1.0f), Transformations.translation);
@@ -109,8 +157,9 @@ namespace Assets {
 			glm::vec3 transformedMeshPivot = glm::vec3(meshModel * glm::vec4(mesh.PivotVector, 1.0));
 
 			float distance = glm::length(sorter.GetCamera().Position - transformedMeshPivot);
+			uint32_t lod = mesh.SelectLod(GetLodErrorLimit(sorter.GetCamera(), distance));
 
-			sorter.AddMesh(mesh, distance, ModelIndex, TotalIndices, DataBuffer);
+			sorter.AddMesh(mesh, distance, ModelIndex, TotalIndices, DataBuffer, lod);
 		}
 	}
 
@@ -11,6 +11,8 @@ namespace Renderer {
 };
 
 namespace Assets {
+	class Camera;
+
 	struct Transform {
 		glm::vec3 translation = glm::vec3(0.0f);
 		glm::vec3 rotation = glm::vec3(0.0f);
@@ -30,6 +32,10 @@ namespace Assets {
 		void Destroy();
 
 		glm::mat4 GetModelMatrix();
+		glm::mat4 GetPositionDecodeMatrix();
+
+		float GetLodErrorLimit(const Camera& camera, float distance) const;
+		uint32_t SelectLod(float maxError) const;
 
 		void AddPipelineFlag(uint16_t flag);
 		void RemovePipelineFlag(uint16_t flag);
@@ -43,6 +49,12 @@ namespace Assets {
 
 		size_t TotalVertices = 0;
 		size_t TotalIndices = 0;
+		size_t TotalMeshlets = 0;
+
+		// byte offsets of the meshlet streams in DataBuffer, after the vertices (see Assets::Meshlet)
+		VkDeviceSize MeshletsOffset = 0;
+		VkDeviceSize MeshletVerticesOffset = 0;
+		VkDeviceSize MeshletTrianglesOffset = 0;
 
 		bool FlipUvVertically = false;
 		bool GenerateMipMaps = true;
@@ -53,17 +65,31 @@ namespace Assets {
 
 		float OutlineWidth = 0.0f;
 
+		// largest projected simplification error when picking a level of detail, as a fraction of the screen height
+		bool EnableLod = true;
+		float LodThreshold = 0.001f;
+
 		int ModelIndex = 0;
 
 		std::string ModelPath;
 		std::string MaterialPath;
 
 		Graphics::GPUBuffer DataBuffer = {};
+
+		// async uploads of DataBuffer and the textures, required by the first Render (0 once it was)
+		uint64_t UploadTicket = 0;
 		Graphics::Buffer ModelBuffer = {};
 
 		VkDescriptorSetLayout ModelDescriptorSetLayout = VK_NULL_HANDLE;
 		VkDescriptorSet ModelDescriptorSet = VK_NULL_HANDLE;
 
 		glm::vec3 PivotVector = glm::vec3(1.0f);
+
+		// GPU vertex format, set before CompileMesh (see ModelLoader::ImportSettings::Layout)
+		VertexLayout Layout = tStandardLayout;
+
+		// packed positions decode to 'PositionOffset + position * PositionScale', identity for the standard layout
+		glm::vec3 PositionOffset = glm::vec3(0.0f);
+		glm::vec3 PositionScale = glm::vec3(1.0f);
 	};
 }
@@ -8,6 +8,13 @@
 #define MAX_LIGHT_SOURCES 5
 #define MAX_CAMERAS 10
 
+// Feature toggles, specialized per pipeline by the renderer (constant_id = bit of Renderer::ShaderFeatures). A disabled
+// feature is compiled out instead of branched over, the defaults leave everything to the material and light flags.
+layout (constant_id = 0) const bool NORMAL_MAPPING	= true;
+layout (constant_id = 1) const bool ALPHA_TEST		= true;
+layout (constant_id = 2) const bool SHADOWS			= true;
+layout (constant_id = 3) const bool PCF				= true;
+
 struct FSInput {
 	vec3 fragPos;
 	vec3 fragNormal;
@@ -110,10 +117,11 @@ layout (std140, set = 0, binding = 0) uniform SceneGPUData {
 	float time;
 	float min_shadow_bias;
 	float max_shadow_bias;
-	float extra_s_1;
+	float environment_intensity;
 	float extra_s_2;
 	float extra_s_3;
-	vec4 extra[14];
+	vec4 irradiance_sh[9];
+	vec4 extra[5];
 } sceneGPUData;
 
 layout (std140, set = 0, binding = 1) uniform material_uniform {
@@ -132,6 +140,9 @@ layout (std140, set = 0, binding = 6) uniform camera_uniform {
 
 layout (set = 0, binding = 7) uniform sampler2DArray shadow_mapping;		// retrieves texels from a texture array receiving a vec2 and a layer index
 
+layout (set = 0, binding = 8) uniform samplerCube environment_specular;	// GGX prefiltered, roughness of mip i = i / (mips - 1)
+layout (set = 0, binding = 9) uniform sampler2D environment_brdf;			// split sum LUT, (NdotV, roughness) -> (F0 scale, bias)
+
 layout (push_constant) uniform constant {
 	int material_index;
 	int model_index;
@@ -169,10 +180,10 @@ float calc_shadow(vec4 normal, vec4 light_position, light_t light) {
 
 	int mask = (1 << 1);
 	
-	bool shadow_map_enabled = bool(light.flags & mask);
+	bool shadow_map_enabled = SHADOWS && bool(light.flags & mask);
 
 	mask = (1 << 2);
-	bool pcf_enabled = bool(light.flags & mask);
+	bool pcf_enabled = PCF && bool(light.flags & mask);
 	
 	mask = (1 << 3);
 	bool sps_enabled = bool(light.flags & mask);
@@ -359,6 +370,43 @@ vec3 calc_spot_light(light_t light, material_t current_material, vec4 material_a
 	return result * intensity;
 }
 
+// Image based lighting of the environment (see TextureLoader::LoadEnvironmentLighting): the irradiance SH are already
+// convolved with the clamped cosine and use the basis order of Utils::IBLBaker, the specular part is the split sum.
+vec3 calc_environment_light(material_t current_material, vec4 material_diffuse, vec4 material_normal) {
+	if (sceneGPUData.environment_intensity <= 0.0)
+		return vec3(0.0);
+
+	const float PI = 3.14159265359;
+
+	vec3 n = normalize(material_normal.xyz);
+	vec3 view_dir = normalize(vec3(cameras[mesh_constant.camera_index].position) - fsInput.fragPos);
+
+	vec3 irradiance = sceneGPUData.irradiance_sh[0].rgb * 0.282095
+		+ sceneGPUData.irradiance_sh[1].rgb * 0.488603 * n.y
+		+ sceneGPUData.irradiance_sh[2].rgb * 0.488603 * n.z
+		+ sceneGPUData.irradiance_sh[3].rgb * 0.488603 * n.x
+		+ sceneGPUData.irradiance_sh[4].rgb * 1.092548 * n.x * n.y
+		+ sceneGPUData.irradiance_sh[5].rgb * 1.092548 * n.y * n.z
+		+ sceneGPUData.irradiance_sh[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+		+ sceneGPUData.irradiance_sh[7].rgb * 1.092548 * n.x * n.z
+		+ sceneGPUData.irradiance_sh[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+
+	float metallic = clamp(current_material.metallic, 0.0, 1.0);
+	float roughness = clamp(current_material.roughness, 0.0, 1.0);
+	float n_dot_v = max(dot(n, view_dir), 0.0);
+
+	vec3 f0 = mix(vec3(0.04), material_diffuse.rgb, metallic);
+	vec3 diffuse = material_diffuse.rgb * (1.0 - metallic) * max(irradiance, vec3(0.0)) / PI;
+
+	float max_lod = float(textureQueryLevels(environment_specular) - 1);
+	vec3 prefiltered = textureLod(environment_specular, reflect(-view_dir, n), roughness * max_lod).rgb;
+	vec2 brdf = texture(environment_brdf, vec2(n_dot_v, roughness)).rg;
+
+	vec3 specular = prefiltered * (f0 * brdf.x + brdf.y);
+
+	return (diffuse + specular) * sceneGPUData.environment_intensity;
+}
+
 float linearize_depth(float depth, float near, float far) {
 	float z = depth * 2.0 - 1.0; // back to NDC
 	return (2.0 * near * far) / (far + near - z * (far - near));
@@ -384,7 +432,7 @@ void main() {
 		material_ambient = vec4(current_material.diffuse);
 	} else {
 		material_ambient = texture(texSampler[current_material.diffuse_texture_index], fsInput.fragTexCoord);
-		if (material_ambient.a < 0.1) {
+		if (ALPHA_TEST && material_ambient.a < 0.1) {
 			discard;
 		}
 	}
@@ -393,17 +441,19 @@ void main() {
 		material_diffuse = vec4(current_material.diffuse);
 	} else {
 		material_diffuse = texture(texSampler[current_material.diffuse_texture_index], fsInput.fragTexCoord);
-		if (material_diffuse.a < 0.1) {
+		if (ALPHA_TEST && material_diffuse.a < 0.1) {
 			discard;
 		}
 	}
 
-	if (current_material.normal_texture_index == -1 || sceneGPUData.render_normal_map == 0) {
+	if (!NORMAL_MAPPING || current_material.normal_texture_index == -1) {
 		material_normal = vec4(fsInput.fragNormal, 1.0);
 	} else {
 		// normal mapping
-		// retrieve normal map in range [0, 1] and transform it to range [-1, 1]
-		material_normal = normalize(texture(texSampler[current_material.normal_texture_index], fsInput.fragTexCoord) * 2.0 - 1.0);
+		// retrieve normal map in range [0, 1] and transform it to range [-1, 1], Z is rebuilt from X and Y since
+		// block compressed (BC5) normal maps only store two channels
+		vec2 normal_xy = texture(texSampler[current_material.normal_texture_index], fsInput.fragTexCoord).rg * 2.0 - 1.0;
+		material_normal = vec4(normal_xy, sqrt(max(1.0 - dot(normal_xy, normal_xy), 0.0)), 0.0);
 
 		// create TBN matrix from tangent bitangent and normal
 		mat3 tbn = mat3(fsInput.fragTangent, fsInput.fragBiTangent, fsInput.fragNormal);
@@ -451,6 +501,8 @@ void main() {
 		}
 	}
 	
+	material_color.rgb += calc_environment_light(current_material, material_diffuse, material_normal);
+
 	material_color.a = material_diffuse.a;
 
 	out_color = vec4(material_color.rgb, 1.0);
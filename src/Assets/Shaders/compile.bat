@@ -1,6 +1,9 @@
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe default.vert -o default_vert.spv
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe sinewave.vert -o sinewave_vert.spv
 
+C:/VulkanSDK/1.3.250.0/Bin/glslc.exe default_packed.vert -o default_packed_vert.spv
+C:/VulkanSDK/1.3.250.0/Bin/glslc.exe -DVERTEX_COLOR default_packed.vert -o default_packed_color_vert.spv
+
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe color_ps.frag -o color_ps.spv
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe wireframe.frag -o wireframe_frag.spv
 
@@ -12,6 +15,7 @@ C:/VulkanSDK/1.3.250.0/Bin/glslc.exe skybox.frag -o skybox_frag.spv
 
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe outline.vert -o outline_vert.spv
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe outline.frag -o outline_frag.spv
+C:/VulkanSDK/1.3.250.0/Bin/glslc.exe outline_packed.vert -o outline_packed_vert.spv
 
 C:/VulkanSDK/1.3.250.0/Bin/glslc.exe transparent_ps.frag -o transparent_frag.spv
 
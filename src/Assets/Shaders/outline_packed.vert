@@ -0,0 +1,72 @@
+#version 450
+
+#define MAX_MODELS 10
+#define MAX_CAMERAS 10
+
+layout (std140, set = 0, binding = 0) uniform SceneGPUData {
+	int total_lights;
+	float time;
+	float extra_s_2;
+	float extra_s_3;
+	vec4 extra[15];
+} sceneGPUData;
+
+struct model_t {
+	vec4 extra[4];
+	vec4 position_offset;
+	vec4 position_scale;
+	vec4 color;
+	mat4 model;
+	mat4 normal_matrix;
+	int extra_scalar;
+	int extra_scalar1;
+	
+	int flip_uv_vertically;
+	float outline_width;
+};
+
+layout (std140, set = 0, binding = 5) uniform model_uniform {
+	model_t models[MAX_MODELS];
+};
+
+struct camera_t {
+	vec4 extra[7];
+	vec4 position;
+	mat4 view;
+	mat4 proj;
+};
+
+layout (std140, set = 0, binding = 6) uniform camera_uniform {
+	camera_t cameras[MAX_CAMERAS];
+};
+
+// packed vertex layouts, see default_packed.vert
+layout (location = 0) in vec4 inPosition;
+layout (location = 1) in vec2 inNormal;
+
+layout (push_constant) uniform constant {
+	int material_index;
+	int model_index;
+	int light_source_index;
+	int camera_index;
+} mesh_constant;
+
+vec3 decode_octahedral(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+
+	return normalize(n);
+}
+
+void main() {
+	camera_t current_camera = cameras[mesh_constant.camera_index];
+	model_t current_model = models[mesh_constant.model_index];
+
+	vec3 position = current_model.position_offset.xyz + inPosition.xyz * current_model.position_scale.xyz;
+
+	vec4 pos = vec4(position + decode_octahedral(inNormal) * current_model.outline_width, 1.0);
+	gl_Position = current_camera.proj * current_camera.view * current_model.model * pos;
+}
@@ -3,11 +3,8 @@
 #define MAX_MODELS 10
 #define MAX_LIGHT_SOURCES 5
 
+// only the position, every vertex layout provides location 0
 layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec3 inNormal;
-layout (location = 2) in vec3 inColor;
-layout (location = 3) in vec3 inTangent;
-layout (location = 4) in vec2 inTexCoord;
 
 struct model_t {
 	vec4 extra[12];
@@ -231,6 +231,10 @@ void main() {
 		material_normal = vec4(normalize(fsInput.fragNormal), 1.0);
 	} else {
 		material_normal = texture(texSampler[current_material.normal_texture_index], fsInput.fragTexCoord);
+
+		// BC5 normal maps only store X and Y, rebuild Z (kept in the [0, 1] encoding of the map)
+		vec2 normal_xy = material_normal.rg * 2.0 - 1.0;
+		material_normal = vec4(material_normal.rg, sqrt(max(1.0 - dot(normal_xy, normal_xy), 0.0)) * 0.5 + 0.5, 1.0);
 	}
 
 	if (current_material.specular_texture_index == -1) {
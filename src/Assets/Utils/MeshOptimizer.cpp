@@ -0,0 +1,292 @@
+#include "./MeshOptimizer.h"
+#include "../Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace Assets {
+
+	namespace {
+		// Note: Scoring constants from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+		constexpr int	FORSYTH_CACHE_SIZE			= 32;
+		constexpr float FORSYTH_CACHE_DECAY_POWER	= 1.5f;
+		constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+		constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+		constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+		constexpr uint32_t OVERDRAW_CACHE_SIZE		= 16;
+
+		float VertexScore(int cachePosition, uint32_t remainingTriangles) {
+			if (remainingTriangles == 0)
+				return -1.0f;
+
+			float score = 0.0f;
+
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) {
+					// the vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse its edge
+					score = FORSYTH_LAST_TRIANGLE_SCORE;
+				}
+				else {
+					const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+					score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+				}
+			}
+
+			// vertices with few triangles left are boosted so they get finished and stop polluting the cache
+			score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+
+			return score;
+		}
+	}
+
+	void MeshOptimizer::Optimize(Mesh& mesh) {
+		OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+		OptimizeOverdraw(mesh);
+		OptimizeVertexFetch(mesh);
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+		const size_t triangleCount = indices.size() / 3;
+
+		if (triangleCount < 2 || vertexCount == 0)
+			return;
+
+		// vertex -> triangle adjacency, stored as offsets into a flat list
+		std::vector<uint32_t> triangleCounts(vertexCount, 0);
+		std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			triangleCounts[indices[i]]++;
+
+		for (size_t v = 0; v < vertexCount; v++)
+			triangleOffsets[v + 1] = triangleOffsets[v] + triangleCounts[v];
+
+		std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t vertex = indices[t * 3 + k];
+				adjacency[fill[vertex]++] = static_cast<uint32_t>(t);
+			}
+		}
+
+		// triangleCounts is reused as the number of triangles not yet emitted for each vertex
+		std::vector<float>		vertexScores(vertexCount);
+		std::vector<float>		triangleScores(triangleCount, 0.0f);
+		std::vector<bool>		emitted(triangleCount, false);
+
+		for (size_t v = 0; v < vertexCount; v++)
+			vertexScores[v] = VertexScore(-1, triangleCounts[v]);
+
+		for (size_t t = 0; t < triangleCount; t++)
+			triangleScores[t] = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> newCache;
+		std::vector<uint32_t> output;
+
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+		output.reserve(indices.size());
+
+		size_t bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+		size_t scanCursor	= 0;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+
+			if (bestTriangle == std::numeric_limits<size_t>::max()) {
+				// nothing adjacent to the cache is left, continue with the next triangle in the original order
+				while (emitted[scanCursor])
+					scanCursor++;
+
+				bestTriangle = scanCursor;
+			}
+
+			const uint32_t* triangle = &indices[bestTriangle * 3];
+
+			emitted[bestTriangle] = true;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			// new cache: triangle vertices first, then the previous cache without them
+			newCache.assign(triangle, triangle + 3);
+
+			for (uint32_t vertex : cache) {
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					newCache.push_back(vertex);
+			}
+
+			for (size_t k = 0; k < 3; k++)
+				triangleCounts[triangle[k]]--;
+
+			for (size_t i = 0; i < newCache.size(); i++) {
+				int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+				vertexScores[newCache[i]]	= VertexScore(position, triangleCounts[newCache[i]]);
+			}
+
+			// rescore the triangles touching the cache (including the vertices that just fell out of it) and pick the best
+			float bestScore = -std::numeric_limits<float>::max();
+			bestTriangle	= std::numeric_limits<size_t>::max();
+
+			for (uint32_t vertex : newCache) {
+				for (uint32_t a = triangleOffsets[vertex]; a < triangleOffsets[vertex + 1]; a++) {
+					uint32_t t = adjacency[a];
+
+					if (emitted[t])
+						continue;
+
+					triangleScores[t] = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+					if (triangleScores[t] > bestScore) {
+						bestScore		= triangleScores[t];
+						bestTriangle	= t;
+					}
+				}
+			}
+
+			if (newCache.size() > FORSYTH_CACHE_SIZE)
+				newCache.resize(FORSYTH_CACHE_SIZE);
+
+			cache.swap(newCache);
+		}
+
+		// a trailing non triangle index (if any) is kept as is
+		output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end());
+
+		indices.swap(output);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(Mesh& mesh) {
+		const size_t triangleCount = mesh.Indices.size() / 3;
+
+		if (triangleCount < 2)
+			return;
+
+		// hard cluster boundaries: triangles where the simulated cache restarts (all three vertices miss), 
+		// reordering whole clusters doesn't change the cache efficiency in between them
+		std::vector<size_t> clusterStarts;
+		std::vector<uint32_t> cacheTimestamps(mesh.Vertices.size(), 0);
+		uint32_t timestamp = OVERDRAW_CACHE_SIZE + 1;
+
+		for (size_t t = 0; t < triangleCount; t++) {
+			uint32_t misses = 0;
+
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t vertex = mesh.Indices[t * 3 + k];
+
+				if (timestamp - cacheTimestamps[vertex] > OVERDRAW_CACHE_SIZE) {
+					cacheTimestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+
+			if (t == 0 || misses == 3)
+				clusterStarts.push_back(t);
+		}
+
+		if (clusterStarts.size() < 2)
+			return;
+
+		glm::vec3 meshCentroid	= glm::vec3(0.0f);
+		float meshArea			= 0.0f;
+
+		std::vector<glm::vec3> clusterCentroids(clusterStarts.size(), glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals	(clusterStarts.size(), glm::vec3(0.0f));
+
+		for (size_t c = 0; c < clusterStarts.size(); c++) {
+			size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+			float clusterArea = 0.0f;
+
+			for (size_t t = clusterStarts[c]; t < end; t++) {
+				const glm::vec3& p0 = mesh.Vertices[mesh.Indices[t * 3 + 0]].pos;
+				const glm::vec3& p1 = mesh.Vertices[mesh.Indices[t * 3 + 1]].pos;
+				const glm::vec3& p2 = mesh.Vertices[mesh.Indices[t * 3 + 2]].pos;
+
+				// the cross product length is twice the area, so the summed normal is area weighted
+				glm::vec3 normal	= glm::cross(p1 - p0, p2 - p0);
+				float area			= glm::length(normal);
+				glm::vec3 centroid	= (p0 + p1 + p2) / 3.0f;
+
+				clusterNormals[c]	+= normal;
+				clusterCentroids[c] += centroid * area;
+				clusterArea			+= area;
+			}
+
+			meshCentroid	+= clusterCentroids[c];
+			meshArea		+= clusterArea;
+
+			clusterCentroids[c] = clusterArea > 0.0f ? clusterCentroids[c] / clusterArea : mesh.Vertices[mesh.Indices[clusterStarts[c] * 3]].pos;
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		std::vector<float> sortKeys(clusterStarts.size());
+
+		for (size_t c = 0; c < clusterStarts.size(); c++) {
+			float length = glm::length(clusterNormals[c]);
+			glm::vec3 normal = length > 0.0f ? clusterNormals[c] / length : glm::vec3(0.0f);
+
+			sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, normal);
+		}
+
+		std::vector<size_t> order(clusterStarts.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(mesh.Indices.size());
+
+		for (size_t c : order) {
+			size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+			output.insert(output.end(), mesh.Indices.begin() + clusterStarts[c] * 3, mesh.Indices.begin() + end * 3);
+		}
+
+		output.insert(output.end(), mesh.Indices.begin() + triangleCount * 3, mesh.Indices.end());
+
+		mesh.Indices.swap(output);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(Mesh& mesh) {
+		const uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+		std::vector<uint32_t> remap(mesh.Vertices.size(), unused);
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.Vertices.size());
+
+		for (auto& index : mesh.Indices) {
+			if (remap[index] == unused) {
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(mesh.Vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		// Note: Vertices not referenced by any triangle are dropped.
+		mesh.Vertices.swap(vertices);
+	}
+
+	VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+		VertexCacheStatistics statistics = {};
+		statistics.Triangles	= indices.size() / 3;
+		statistics.Vertices		= vertexCount;
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (size_t i = 0; i < statistics.Triangles * 3; i++) {
+			uint32_t vertex = indices[i];
+
+			if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+				cacheTimestamps[vertex] = timestamp++;
+				statistics.Misses++;
+			}
+		}
+
+		return statistics;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Assets {
+	struct Mesh;
+
+	struct VertexCacheStatistics {
+		size_t Triangles	= 0;
+		size_t Vertices		= 0;
+		size_t Misses		= 0;
+
+		// average cache miss ratio, transformed vertices per triangle (0.5 is the ideal for regular grids, 3.0 the worst)
+		float GetACMR() const { return Triangles == 0 ? 0.0f : static_cast<float>(Misses) / static_cast<float>(Triangles); }
+
+		// average transform to vertex ratio, 1.0 means every vertex is shaded exactly once
+		float GetATVR() const { return Vertices == 0 ? 0.0f : static_cast<float>(Misses) / static_cast<float>(Vertices); }
+
+		VertexCacheStatistics& operator+=(const VertexCacheStatistics& other) {
+			Triangles	+= other.Triangles;
+			Vertices	+= other.Vertices;
+			Misses		+= other.Misses;
+			
+			return *this;
+		}
+	};
+
+	class MeshOptimizer {
+	public:
+		MeshOptimizer() {};
+		~MeshOptimizer() {};
+
+		// Runs every pass below in order: vertex cache, overdraw and vertex fetch.
+		static void Optimize(Mesh& mesh);
+
+		// Forsyth's linear-speed vertex cache optimization, reorders triangles to maximize post-transform cache hits.
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		// Splits the (cache optimized) triangle list into clusters at cache restarts and sorts the clusters so the 
+		// outward facing ones, which are more likely to occlude the rest of the mesh, are drawn first.
+		static void OptimizeOverdraw(Mesh& mesh);
+
+		// Lays the vertices out in the order the index buffer first uses them, indices are remapped.
+		static void OptimizeVertexFetch(Mesh& mesh);
+
+		// Simulates a FIFO post-transform cache of cacheSize entries.
+		static VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+	};
+}
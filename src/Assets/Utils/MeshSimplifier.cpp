@@ -0,0 +1,522 @@
+#include "./MeshSimplifier.h"
+#include "./MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace Assets {
+
+	namespace {
+		constexpr uint32_t NONE		= ~0u;
+		constexpr uint32_t MULTIPLE = ~1u;
+
+		// Note: Seam edges get an extra constraint plane so the seam keeps its shape, weighted like meshoptimizer does.
+		constexpr float SEAM_EDGE_WEIGHT		= 10.0f;
+
+		// a collapse is rejected when it turns a triangle further than this (cosine of the normals)
+		constexpr float MIN_FLIP_COSINE			= 0.25f;
+
+		// relative error past which a level isn't worth it, roughly 5% of the mesh extent
+		constexpr float LOD_MAX_ERROR			= 0.05f;
+
+		enum VertexKind : uint8_t {
+			tManifold,		// interior, collapses anywhere
+			tSeam,			// one of two wedges split by an attribute seam, collapses along the seam only
+			tLocked			// borders, corners and complex vertices never move
+		};
+
+		struct Quadric {
+			double a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+			double b0 = 0, b1 = 0, b2 = 0, c = 0;
+			double w = 0;
+
+			void AddPlane(const glm::vec3& n, float d, float weight) {
+				a00 += weight * n.x * n.x; a11 += weight * n.y * n.y; a22 += weight * n.z * n.z;
+				a10 += weight * n.y * n.x; a20 += weight * n.z * n.x; a21 += weight * n.z * n.y;
+				b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+				c += weight * d * d;
+				w += weight;
+			}
+
+			Quadric& operator+=(const Quadric& q) {
+				a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+				b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+				return *this;
+			}
+
+			// squared distance to the accumulated planes, averaged by their weight
+			float Error(const glm::vec3& p) const {
+				double x = p.x, y = p.y, z = p.z;
+
+				double r = a00 * x * x + a11 * y * y + a22 * z * z
+					+ 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z)
+					+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+				return static_cast<float>(std::abs(r) / (w > 0.0 ? w : 1.0));
+			}
+		};
+
+		struct Collapse {
+			uint32_t V0;	// removed
+			uint32_t V1;	// kept
+			float Cost;
+		};
+
+		// vertex -> outgoing half edges, rebuilt after every pass
+		struct EdgeAdjacency {
+			std::vector<uint32_t> Offsets;
+			std::vector<uint32_t> Targets;
+
+			bool HasEdge(uint32_t a, uint32_t b) const {
+				for (uint32_t i = Offsets[a]; i < Offsets[a + 1]; i++)
+					if (Targets[i] == b)
+						return true;
+
+				return false;
+			}
+		};
+
+		void BuildEdgeAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, EdgeAdjacency& adjacency) {
+			adjacency.Offsets.assign(vertexCount + 1, 0);
+			adjacency.Targets.resize(indices.size());
+
+			for (uint32_t index : indices)
+				adjacency.Offsets[index + 1]++;
+
+			for (size_t i = 0; i < vertexCount; i++)
+				adjacency.Offsets[i + 1] += adjacency.Offsets[i];
+
+			std::vector<uint32_t> cursor(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				for (size_t k = 0; k < 3; k++) {
+					uint32_t a = indices[i + k];
+					uint32_t b = indices[i + (k + 1) % 3];
+
+					adjacency.Targets[cursor[a]++] = b;
+				}
+			}
+		}
+
+		// the unique open half edges leaving/entering every vertex (NONE, the vertex or MULTIPLE)
+		void FindOpenEdges(const std::vector<uint32_t>& indices, const EdgeAdjacency& adjacency, std::vector<uint32_t>& openOut, std::vector<uint32_t>& openIn) {
+			std::fill(openOut.begin(), openOut.end(), NONE);
+			std::fill(openIn.begin(), openIn.end(), NONE);
+
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				for (size_t k = 0; k < 3; k++) {
+					uint32_t a = indices[i + k];
+					uint32_t b = indices[i + (k + 1) % 3];
+
+					if (adjacency.HasEdge(b, a))
+						continue;
+
+					openOut[a]	= openOut[a] == NONE ? b : MULTIPLE;
+					openIn[b]	= openIn[b] == NONE ? a : MULTIPLE;
+				}
+			}
+		}
+
+		// vertices sharing a position form a ring through 'wedges', 'remap' points to the first vertex of the ring
+		void BuildPositionRemap(const std::vector<Vertex>& vertices, std::vector<uint32_t>& remap, std::vector<uint32_t>& wedges) {
+			struct PositionHash {
+				size_t operator()(const glm::vec3& p) const {
+					uint32_t bits[3];
+					std::memcpy(bits, &p, sizeof(bits));
+					return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+				}
+			};
+
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> positions;
+			positions.reserve(vertices.size());
+
+			remap.resize(vertices.size());
+			wedges.resize(vertices.size());
+
+			for (uint32_t i = 0; i < vertices.size(); i++) {
+				uint32_t first = positions.emplace(vertices[i].pos, i).first->second;
+
+				remap[i]	= first;
+				wedges[i]	= i;
+
+				if (first != i) {
+					wedges[i]		= wedges[first];
+					wedges[first]	= i;
+				}
+			}
+		}
+	}
+
+	float MeshSimplifier::GetMeshExtent(const std::vector<Vertex>& vertices) {
+		if (vertices.empty())
+			return 0.0f;
+
+		glm::vec3 min = vertices[0].pos;
+		glm::vec3 max = vertices[0].pos;
+
+		for (const auto& vertex : vertices) {
+			min = glm::min(min, vertex.pos);
+			max = glm::max(max, vertex.pos);
+		}
+
+		glm::vec3 extent = max - min;
+
+		return std::max(extent.x, std::max(extent.y, extent.z));
+	}
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError) {
+		std::vector<uint32_t> result = indices;
+
+		if (resultError)
+			*resultError = 0.0f;
+
+		const size_t vertexCount = vertices.size();
+		const float extent = GetMeshExtent(vertices);
+
+		if (result.size() <= targetIndexCount || extent <= 0.0f)
+			return result;
+
+		// positions in the unit cube so errors are relative to the mesh extent
+		glm::vec3 origin = vertices[0].pos;
+
+		for (const auto& vertex : vertices)
+			origin = glm::min(origin, vertex.pos);
+
+		std::vector<glm::vec3> positions(vertexCount);
+
+		for (size_t i = 0; i < vertexCount; i++)
+			positions[i] = (vertices[i].pos - origin) / extent;
+
+		std::vector<uint32_t> remap, wedges;
+		BuildPositionRemap(vertices, remap, wedges);
+
+		EdgeAdjacency adjacency;
+		BuildEdgeAdjacency(result, vertexCount, adjacency);
+
+		std::vector<uint32_t> openOut(vertexCount), openIn(vertexCount);
+		FindOpenEdges(result, adjacency, openOut, openIn);
+
+		// Note: Classified once on the input, a valid collapse never turns a seam into a border or the other way around.
+		std::vector<uint8_t> kinds(vertexCount, tManifold);
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t a = result[i + k];
+				uint32_t b = result[i + (k + 1) % 3];
+
+				// the edge is open on the position level when no wedge of b leads back to any wedge of a
+				bool open = true;
+
+				for (uint32_t w = b; open; ) {
+					for (uint32_t e = adjacency.Offsets[w]; e < adjacency.Offsets[w + 1] && open; e++)
+						open = remap[adjacency.Targets[e]] != remap[a];
+
+					w = wedges[w];
+
+					if (w == b)
+						break;
+				}
+
+				if (open) {
+					kinds[remap[a]] = tLocked;
+					kinds[remap[b]] = tLocked;
+				}
+			}
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			if (remap[v] != v || kinds[v] == tLocked)
+				continue;
+
+			uint32_t twin = wedges[v];
+
+			if (twin == v) {
+				kinds[v] = openOut[v] == NONE && openIn[v] == NONE ? tManifold : tLocked;
+				continue;
+			}
+
+			bool seam = wedges[twin] == v;
+
+			for (uint32_t w : { v, twin }) {
+				seam = seam && openOut[w] != NONE && openOut[w] != MULTIPLE && openIn[w] != NONE && openIn[w] != MULTIPLE;
+			}
+
+			kinds[v] = seam ? tSeam : tLocked;
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+			kinds[v] = kinds[remap[v]];
+
+		// plane quadrics per position, area weighted
+		std::vector<Quadric> quadrics(vertexCount);
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			const glm::vec3& p0 = positions[result[i + 0]];
+			const glm::vec3& p1 = positions[result[i + 1]];
+			const glm::vec3& p2 = positions[result[i + 2]];
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+
+			if (area <= 0.0f)
+				continue;
+
+			normal /= area;
+
+			Quadric q;
+			q.AddPlane(normal, -glm::dot(normal, p0), area);
+
+			for (size_t k = 0; k < 3; k++)
+				quadrics[remap[result[i + k]]] += q;
+
+			// seam edges also get a plane through the edge, perpendicular to the triangle
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t a = result[i + k];
+				uint32_t b = result[i + (k + 1) % 3];
+
+				if (kinds[a] == tManifold || kinds[b] == tManifold || openOut[a] != b)
+					continue;
+
+				glm::vec3 edge = positions[b] - positions[a];
+				float length = glm::length(edge);
+
+				if (length <= 0.0f)
+					continue;
+
+				glm::vec3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+
+				Quadric edgeQuadric;
+				edgeQuadric.AddPlane(edgeNormal, -glm::dot(edgeNormal, positions[a]), length * length * SEAM_EDGE_WEIGHT);
+
+				quadrics[remap[a]] += edgeQuadric;
+				quadrics[remap[b]] += edgeQuadric;
+			}
+		}
+
+		const float maxCost = targetError * targetError;
+		float worstCost = 0.0f;
+
+		std::vector<Collapse>	collapses;
+		std::vector<uint32_t>	collapseRemap(vertexCount);
+		std::vector<uint8_t>	collapseLocked(vertexCount);
+		std::vector<uint32_t>	triangleOffsets(vertexCount + 1);
+		std::vector<uint32_t>	triangles;
+
+		// finds the wedge of v1's position at the other side of the seam from w0
+		auto findTwin = [&](uint32_t w0, uint32_t v1) {
+			for (uint32_t w = wedges[v1]; ; w = wedges[w]) {
+				if (w != v1 && (openOut[w0] == w || openIn[w0] == w))
+					return w;
+
+				if (w == v1)
+					return NONE;
+			}
+		};
+
+		auto canCollapse = [&](uint32_t v0, uint32_t v1) {
+			if (kinds[v0] == tManifold)
+				return true;
+
+			if (kinds[v0] != tSeam || kinds[v1] == tManifold)
+				return false;
+
+			// only along the seam, and the twin wedge needs the matching seam edge
+			if (openOut[v0] != v1 && openIn[v0] != v1)
+				return false;
+
+			return findTwin(wedges[v0], v1) != NONE;
+		};
+
+		// Note: Passes collapse the cheapest independent edges in bulk, both ends of a collapse and the vertices
+		// around the removed one are locked for the rest of the pass so the flip checks stay valid.
+		while (result.size() > targetIndexCount) {
+			collapses.clear();
+
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (size_t k = 0; k < 3; k++) {
+					uint32_t a = result[i + k];
+					uint32_t b = result[i + (k + 1) % 3];
+
+					// every interior edge shows up twice, keep one
+					if (remap[a] > remap[b] && adjacency.HasEdge(b, a))
+						continue;
+
+					Collapse best = { NONE, NONE, std::numeric_limits<float>::max() };
+
+					if (canCollapse(a, b))
+						best = { a, b, quadrics[remap[a]].Error(positions[b]) };
+
+					if (canCollapse(b, a)) {
+						float cost = quadrics[remap[b]].Error(positions[a]);
+
+						if (cost < best.Cost)
+							best = { b, a, cost };
+					}
+
+					if (best.V0 != NONE && best.Cost <= maxCost)
+						collapses.push_back(best);
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+			// position -> triangles for the flip checks
+			std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+			triangles.resize(result.size());
+
+			for (uint32_t index : result)
+				triangleOffsets[remap[index] + 1]++;
+
+			for (size_t i = 0; i < vertexCount; i++)
+				triangleOffsets[i + 1] += triangleOffsets[i];
+
+			{
+				std::vector<uint32_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+
+				for (size_t i = 0; i < result.size(); i++)
+					triangles[cursor[remap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			for (uint32_t i = 0; i < vertexCount; i++)
+				collapseRemap[i] = i;
+
+			std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+
+			const size_t triangleTarget = targetIndexCount / 3;
+			size_t triangleCount = result.size() / 3;
+			size_t applied = 0;
+
+			for (const Collapse& collapse : collapses) {
+				if (triangleCount <= triangleTarget)
+					break;
+
+				uint32_t r0 = remap[collapse.V0];
+				uint32_t r1 = remap[collapse.V1];
+
+				if (collapseLocked[r0] || collapseLocked[r1])
+					continue;
+
+				// moving r0 onto r1 must not fold any of the triangles that survive
+				bool flipped = false;
+
+				for (uint32_t t = triangleOffsets[r0]; t < triangleOffsets[r0 + 1] && !flipped; t++) {
+					const uint32_t* triangle = &result[triangles[t] * 3];
+
+					glm::vec3 p[3], q[3];
+					bool degenerate = false;
+
+					for (size_t k = 0; k < 3; k++) {
+						uint32_t r = remap[triangle[k]];
+
+						degenerate	= degenerate || r == r1;
+						p[k]		= positions[r];
+						q[k]		= r == r0 ? positions[r1] : p[k];
+					}
+
+					if (degenerate)
+						continue;
+
+					glm::vec3 before	= glm::cross(p[1] - p[0], p[2] - p[0]);
+					glm::vec3 after		= glm::cross(q[1] - q[0], q[2] - q[0]);
+
+					float lengths = glm::length(before) * glm::length(after);
+
+					flipped = lengths <= 0.0f || glm::dot(before, after) < MIN_FLIP_COSINE * lengths;
+				}
+
+				if (flipped)
+					continue;
+
+				collapseRemap[collapse.V0] = collapse.V1;
+
+				if (kinds[collapse.V0] == tSeam) {
+					uint32_t twin = wedges[collapse.V0];
+					collapseRemap[twin] = findTwin(twin, collapse.V1);
+				}
+
+				for (uint32_t t = triangleOffsets[r0]; t < triangleOffsets[r0 + 1]; t++) {
+					for (size_t k = 0; k < 3; k++)
+						collapseLocked[remap[result[triangles[t] * 3 + k]]] = 1;
+				}
+
+				collapseLocked[r1] = 1;
+
+				quadrics[r1] += quadrics[r0];
+				worstCost = std::max(worstCost, collapse.Cost);
+
+				triangleCount -= 2;
+				applied++;
+			}
+
+			if (applied == 0)
+				break;
+
+			// remap the removed vertices and drop the triangles that collapsed
+			size_t write = 0;
+
+			for (size_t i = 0; i < result.size(); i += 3) {
+				uint32_t a = collapseRemap[result[i + 0]];
+				uint32_t b = collapseRemap[result[i + 1]];
+				uint32_t c = collapseRemap[result[i + 2]];
+
+				if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+					continue;
+
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+
+			result.resize(write);
+
+			BuildEdgeAdjacency(result, vertexCount, adjacency);
+			FindOpenEdges(result, adjacency, openOut, openIn);
+		}
+
+		if (resultError)
+			*resultError = std::sqrt(worstCost);
+
+		return result;
+	}
+
+	void MeshSimplifier::GenerateLods(Mesh& mesh, uint32_t lodCount, float reduction) {
+		mesh.Lods.clear();
+
+		const float extent = GetMeshExtent(mesh.Vertices);
+
+		if (lodCount < 2 || extent <= 0.0f)
+			return;
+
+		std::vector<uint32_t> current = mesh.Indices;
+		float error = 0.0f;
+
+		for (uint32_t level = 1; level < lodCount; level++) {
+			size_t target = static_cast<size_t>(current.size() / 3 * reduction) * 3;
+			float levelError = 0.0f;
+
+			std::vector<uint32_t> lod = Simplify(mesh.Vertices, current, target, LOD_MAX_ERROR, &levelError);
+
+			// not even a 10% reduction, the next levels would only repeat this one
+			if (lod.empty() || lod.size() * 10 > current.size() * 9)
+				break;
+
+			MeshOptimizer::OptimizeVertexCache(lod, mesh.Vertices.size());
+
+			// errors of consecutive levels add up, each one is measured against the previous level
+			error += levelError;
+
+			MeshLod meshLod = {};
+			meshLod.Indices = lod;
+			meshLod.Error	= error * extent;
+
+			mesh.Lods.push_back(std::move(meshLod));
+			current = std::move(lod);
+		}
+	}
+}
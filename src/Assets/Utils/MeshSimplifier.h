@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "../Mesh.h"
+
+namespace Assets {
+
+	class MeshSimplifier {
+	public:
+		MeshSimplifier() {};
+		~MeshSimplifier() {};
+
+		// Quadric error edge collapse down to 'targetIndexCount' (or until a collapse would exceed 'targetError'),
+		// the result indexes the same vertices. Errors are relative to the mesh extent, 'resultError' receives the
+		// largest distance introduced. Open borders are locked, so meshes (and with them material boundaries) never
+		// pull apart, and vertices split on UV/normal seams only collapse along the seam, together with their twin.
+		static std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+		// Fills mesh.Lods with up to 'lodCount - 1' levels, each with 'reduction' times the triangles of the previous one.
+		// Stops early when the simplification stalls (borders and seams can lock most of a small mesh).
+		static void GenerateLods(Mesh& mesh, uint32_t lodCount, float reduction = 0.5f);
+
+		// Largest axis of the mesh bounds, the scale relative errors are given in.
+		static float GetMeshExtent(const std::vector<Vertex>& vertices);
+	};
+}
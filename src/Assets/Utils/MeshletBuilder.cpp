@@ -0,0 +1,275 @@
+#include "./MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Assets {
+
+	namespace {
+		constexpr uint8_t UNASSIGNED = 0xff;
+
+		// vertex -> triangle lists in one flat array
+		struct Adjacency {
+			std::vector<uint32_t> Offsets;
+			std::vector<uint32_t> Triangles;
+			std::vector<uint32_t> LiveCount;		// triangles of the vertex not yet in a meshlet
+		};
+
+		void BuildAdjacency(const Mesh& mesh, Adjacency& adjacency) {
+			size_t vertexCount = mesh.Vertices.size();
+
+			adjacency.Offsets.assign(vertexCount + 1, 0);
+			adjacency.LiveCount.assign(vertexCount, 0);
+
+			for (uint32_t index : mesh.Indices)
+				adjacency.LiveCount[index]++;
+
+			for (size_t i = 0; i < vertexCount; i++)
+				adjacency.Offsets[i + 1] = adjacency.Offsets[i] + adjacency.LiveCount[i];
+
+			adjacency.Triangles.resize(mesh.Indices.size());
+
+			std::vector<uint32_t> cursor(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+				adjacency.Triangles[cursor[mesh.Indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	void MeshletBuilder::Build(Mesh& mesh, const MeshletLimits& limits) {
+		mesh.Meshlets.clear();
+		mesh.MeshletVertices.clear();
+		mesh.MeshletTriangles.clear();
+
+		if (mesh.Indices.size() < 3)
+			return;
+
+		uint32_t maxVertices	= std::clamp(limits.MaxVertices, 3u, 255u);
+		uint32_t maxTriangles	= std::clamp(limits.MaxTriangles, 1u, 512u);
+
+		Adjacency adjacency;
+		BuildAdjacency(mesh, adjacency);
+
+		size_t triangleCount = mesh.Indices.size() / 3;
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint8_t> slots(mesh.Vertices.size(), UNASSIGNED);
+
+		mesh.Meshlets.reserve(triangleCount / maxTriangles + 1);
+		mesh.MeshletVertices.reserve(mesh.Vertices.size() + mesh.Vertices.size() / 4);
+		mesh.MeshletTriangles.reserve(triangleCount);
+
+		Meshlet meshlet = {};
+
+		auto flush = [&]() {
+			if (meshlet.TriangleCount == 0)
+				return;
+
+			for (uint32_t i = 0; i < meshlet.VertexCount; i++)
+				slots[mesh.MeshletVertices[meshlet.VertexOffset + i]] = UNASSIGNED;
+
+			ComputeBounds(mesh, meshlet);
+			mesh.Meshlets.push_back(meshlet);
+
+			meshlet = {};
+			meshlet.VertexOffset	= static_cast<uint32_t>(mesh.MeshletVertices.size());
+			meshlet.TriangleOffset	= static_cast<uint32_t>(mesh.MeshletTriangles.size());
+		};
+
+		auto newVertices = [&](size_t triangle) {
+			uint32_t count = 0;
+
+			for (size_t k = 0; k < 3; k++)
+				count += slots[mesh.Indices[triangle * 3 + k]] == UNASSIGNED;
+
+			return count;
+		};
+
+		size_t seed = 0;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+			size_t best = triangleCount;
+			uint32_t bestNew = 4;
+			uint32_t bestLive = std::numeric_limits<uint32_t>::max();
+
+			// Note: Prefer triangles that add the fewest vertices, then the ones around vertices with few triangles left
+			// so the meshlet closes off its border instead of leaving scattered leftovers behind.
+			for (uint32_t i = 0; i < meshlet.VertexCount && bestNew > 0; i++) {
+				uint32_t vertex = mesh.MeshletVertices[meshlet.VertexOffset + i];
+
+				for (uint32_t a = adjacency.Offsets[vertex]; a < adjacency.Offsets[vertex + 1]; a++) {
+					uint32_t triangle = adjacency.Triangles[a];
+
+					if (emitted[triangle])
+						continue;
+
+					uint32_t added = newVertices(triangle);
+
+					if (meshlet.VertexCount + added > maxVertices)
+						continue;
+
+					uint32_t live = 0;
+					for (size_t k = 0; k < 3; k++)
+						live += adjacency.LiveCount[mesh.Indices[triangle * 3 + k]];
+
+					if (added < bestNew || (added == bestNew && live < bestLive)) {
+						best = triangle;
+						bestNew = added;
+						bestLive = live;
+					}
+				}
+			}
+
+			if (best == triangleCount) {
+				flush();
+
+				while (emitted[seed])
+					seed++;
+
+				best = seed;
+			}
+
+			emitted[best] = true;
+
+			uint32_t local[3];
+
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t vertex = mesh.Indices[best * 3 + k];
+
+				if (slots[vertex] == UNASSIGNED) {
+					slots[vertex] = static_cast<uint8_t>(meshlet.VertexCount++);
+					mesh.MeshletVertices.push_back(vertex);
+				}
+
+				local[k] = slots[vertex];
+				adjacency.LiveCount[vertex]--;
+			}
+
+			mesh.MeshletTriangles.push_back(PackTriangle(local[0], local[1], local[2]));
+			meshlet.TriangleCount++;
+
+			if (meshlet.TriangleCount == maxTriangles)
+				flush();
+		}
+
+		flush();
+	}
+
+	void MeshletBuilder::ComputeBounds(const Mesh& mesh, Meshlet& meshlet) {
+		auto position = [&](uint32_t local) {
+			return mesh.Vertices[mesh.MeshletVertices[meshlet.VertexOffset + local] + meshlet.BaseVertex].pos;
+		};
+
+		// Ritter: start from the two most distant points along a rough diameter, then grow over the outliers
+		glm::vec3 first = position(0);
+		glm::vec3 a = first, b = first;
+		float distance = 0.0f;
+
+		for (uint32_t i = 0; i < meshlet.VertexCount; i++) {
+			glm::vec3 p = position(i);
+			float d = glm::dot(p - first, p - first);
+			if (d > distance) { distance = d; a = p; }
+		}
+
+		distance = 0.0f;
+
+		for (uint32_t i = 0; i < meshlet.VertexCount; i++) {
+			glm::vec3 p = position(i);
+			float d = glm::dot(p - a, p - a);
+			if (d > distance) { distance = d; b = p; }
+		}
+
+		glm::vec3 center = (a + b) * 0.5f;
+		float radius = std::sqrt(distance) * 0.5f;
+
+		for (uint32_t i = 0; i < meshlet.VertexCount; i++) {
+			glm::vec3 p = position(i);
+			float d = glm::length(p - center);
+
+			if (d > radius) {
+				float grown = (radius + d) * 0.5f;
+				center += (p - center) * ((grown - radius) / d);
+				radius = grown;
+			}
+		}
+
+		meshlet.Center = center;
+		meshlet.Radius = radius;
+
+		// normal cone from the face normals, degenerate triangles don't vote
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.TriangleCount);
+
+		glm::vec3 axis = glm::vec3(0.0f);
+
+		for (uint32_t i = 0; i < meshlet.TriangleCount; i++) {
+			uint32_t triangle = mesh.MeshletTriangles[meshlet.TriangleOffset + i];
+
+			glm::vec3 p0 = position(UnpackTriangle(triangle, 0));
+			glm::vec3 n = glm::cross(position(UnpackTriangle(triangle, 1)) - p0, position(UnpackTriangle(triangle, 2)) - p0);
+
+			float length = glm::length(n);
+
+			if (length <= 0.0f || !std::isfinite(length)) {
+				normals.push_back(glm::vec3(0.0f));
+				continue;
+			}
+
+			normals.push_back(n / length);
+			axis += normals.back();
+		}
+
+		meshlet.ConeApex	= center;
+		meshlet.ConeAxis	= glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.ConeCutoff	= 1.0f;
+
+		float axisLength = glm::length(axis);
+
+		if (axisLength <= 0.0f)
+			return;
+
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+
+		for (const auto& n : normals) {
+			if (n != glm::vec3(0.0f))
+				minDot = std::min(minDot, glm::dot(n, axis));
+		}
+
+		meshlet.ConeAxis = axis;
+
+		// Note: Past roughly 84 degrees of spread the cone never culls anything in practice.
+		if (minDot <= 0.1f)
+			return;
+
+		// move the apex back until every triangle plane is in front of it
+		float maxT = 0.0f;
+
+		for (uint32_t i = 0; i < meshlet.TriangleCount; i++) {
+			const glm::vec3& n = normals[i];
+
+			if (n == glm::vec3(0.0f))
+				continue;
+
+			glm::vec3 p0 = position(UnpackTriangle(mesh.MeshletTriangles[meshlet.TriangleOffset + i], 0));
+			float t = glm::dot(center - p0, n) / glm::dot(axis, n);
+
+			maxT = std::max(maxT, t);
+		}
+
+		meshlet.ConeApex	= center - axis * maxT;
+		meshlet.ConeCutoff	= std::sqrt(1.0f - minDot * minDot);
+	}
+
+	bool MeshletBuilder::IsBackfacing(const Meshlet& meshlet, const glm::vec3& viewPosition) {
+		glm::vec3 view = meshlet.ConeApex - viewPosition;
+		float length = glm::length(view);
+
+		if (length <= 0.0f)
+			return false;
+
+		return glm::dot(view / length, meshlet.ConeAxis) >= meshlet.ConeCutoff;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "../Mesh.h"
+
+namespace Assets {
+
+	struct MeshletLimits {
+		uint32_t MaxVertices	= 64;
+		uint32_t MaxTriangles	= 124;		// 124 * 3 + 64 stays below the 512 byte budget of a mesh shader workgroup
+	};
+
+	class MeshletBuilder {
+	public:
+		MeshletBuilder() {};
+		~MeshletBuilder() {};
+
+		// Replaces mesh.Meshlets, MeshletVertices and MeshletTriangles. The triangles are grown greedily over shared
+		// vertices starting from the index order, so running the vertex cache optimization first gives tighter clusters.
+		static void Build(Mesh& mesh, const MeshletLimits& limits = {});
+
+		// Bounding sphere and normal cone of the meshlet from its vertices, called by Build.
+		static void ComputeBounds(const Mesh& mesh, Meshlet& meshlet);
+
+		// True when the whole meshlet faces away from 'viewPosition' (mesh space).
+		static bool IsBackfacing(const Meshlet& meshlet, const glm::vec3& viewPosition);
+
+		static inline uint32_t PackTriangle(uint32_t a, uint32_t b, uint32_t c) { return a | (b << 8) | (c << 16); }
+		static inline uint32_t UnpackTriangle(uint32_t triangle, uint32_t corner) { return (triangle >> (8 * corner)) & 0xff; }
+	};
+}
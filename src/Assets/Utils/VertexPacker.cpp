@@ -0,0 +1,135 @@
+#include "./VertexPacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <gtc/packing.hpp>
+
+namespace Assets {
+
+	namespace {
+		inline uint16_t QuantizeUnorm16(float value) {
+			return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+		}
+
+		inline int16_t QuantizeSnorm16(float value) {
+			return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		inline uint8_t QuantizeUnorm8(float value) {
+			return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+		}
+
+		template<class PackedType>
+		void PackCommon(const Vertex& vertex, const PositionQuantization& quantization, PackedType& packed) {
+			glm::vec3 position = (vertex.pos - quantization.Offset) / quantization.Scale;
+
+			packed.pos[0] = QuantizeUnorm16(position.x);
+			packed.pos[1] = QuantizeUnorm16(position.y);
+			packed.pos[2] = QuantizeUnorm16(position.z);
+			packed.pos[3] = 0;
+
+			glm::vec2 normal	= VertexPacker::EncodeOctahedral(vertex.normal);
+			glm::vec2 tangent	= VertexPacker::EncodeOctahedral(vertex.tangent);
+
+			packed.normal[0]	= QuantizeSnorm16(normal.x);
+			packed.normal[1]	= QuantizeSnorm16(normal.y);
+			packed.tangent[0]	= QuantizeSnorm16(tangent.x);
+			packed.tangent[1]	= QuantizeSnorm16(tangent.y);
+
+			packed.texCoord[0]	= glm::packHalf1x16(vertex.texCoord.x);
+			packed.texCoord[1]	= glm::packHalf1x16(vertex.texCoord.y);
+		}
+	}
+
+	PositionQuantization VertexPacker::ComputeQuantization(const std::vector<Mesh>& meshes) {
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		for (const auto& mesh : meshes) {
+			for (const auto& vertex : mesh.Vertices) {
+				min = glm::min(min, vertex.pos);
+				max = glm::max(max, vertex.pos);
+			}
+		}
+
+		PositionQuantization quantization = {};
+
+		if (min.x > max.x)
+			return quantization;
+
+		quantization.Offset = min;
+
+		for (int axis = 0; axis < 3; axis++) {
+			float extent = max[axis] - min[axis];
+			quantization.Scale[axis] = extent > 0.0f ? extent : 1.0f;
+		}
+
+		return quantization;
+	}
+
+	void VertexPacker::Pack(VertexLayout layout, const Vertex* vertices, size_t count, const PositionQuantization& quantization, void* dst) {
+
+		switch (layout) {
+		case tPackedLayout: {
+			PackedVertex* packed = static_cast<PackedVertex*>(dst);
+
+			for (size_t i = 0; i < count; i++) {
+				packed[i] = {};
+				PackCommon(vertices[i], quantization, packed[i]);
+			}
+
+			break;
+		}
+		case tPackedColorLayout: {
+			PackedColorVertex* packed = static_cast<PackedColorVertex*>(dst);
+
+			for (size_t i = 0; i < count; i++) {
+				packed[i] = {};
+				PackCommon(vertices[i], quantization, packed[i]);
+
+				packed[i].color[0] = QuantizeUnorm8(vertices[i].color.x);
+				packed[i].color[1] = QuantizeUnorm8(vertices[i].color.y);
+				packed[i].color[2] = QuantizeUnorm8(vertices[i].color.z);
+				packed[i].color[3] = 255;
+			}
+
+			break;
+		}
+		default:
+			std::memcpy(dst, vertices, sizeof(Vertex) * count);
+			break;
+		}
+	}
+
+	glm::vec2 VertexPacker::EncodeOctahedral(const glm::vec3& direction) {
+		float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+
+		if (length <= 0.0f || !std::isfinite(length))
+			return glm::vec2(0.0f);
+
+		glm::vec3 n = direction / length;
+
+		if (n.z >= 0.0f)
+			return glm::vec2(n.x, n.y);
+
+		// fold the lower hemisphere over the diagonals
+		return glm::vec2(
+			(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+
+	glm::vec3 VertexPacker::DecodeOctahedral(const glm::vec2& encoded) {
+		glm::vec3 n = glm::vec3(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+		float t = std::max(-n.z, 0.0f);
+
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+
+		return glm::normalize(n);
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "../Mesh.h"
+
+namespace Assets {
+
+	// Note: Dequantization of a packed position is 'offset + position * scale', with the unorm16 position already
+	// normalized to [0, 1] by the vertex fetch.
+	struct PositionQuantization {
+		glm::vec3 Offset	= glm::vec3(0.0f);
+		glm::vec3 Scale		= glm::vec3(1.0f);
+	};
+
+	class VertexPacker {
+	public:
+		VertexPacker() {};
+		~VertexPacker() {};
+
+		// Bounds of every vertex of every mesh, a degenerate axis gets a scale of 1 so it still decodes exactly.
+		static PositionQuantization ComputeQuantization(const std::vector<Mesh>& meshes);
+
+		// Converts 'count' vertices to the given layout, 'dst' must hold count * GetVertexStride(layout) bytes.
+		static void Pack(VertexLayout layout, const Vertex* vertices, size_t count, const PositionQuantization& quantization, void* dst);
+
+		// Octahedral mapping of a direction to the [-1, 1] square, zero length vectors map to +Z.
+		static glm::vec2 EncodeOctahedral(const glm::vec3& direction);
+		static glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+	};
+}
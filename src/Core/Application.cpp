@@ -97,6 +97,49 @@ void Application::RenderCoreUI() {
 		
 		ImGui::TreePop();
 	}
+
+	if (ImGui::TreeNode("Staging")) {
+		const Graphics::StagingRing::Stats& stats = m_GraphicsDevice->GetStagingStats();
+
+		ImGui::Text("Staged: %.2f MB", stats.BytesStaged / (1024.0 * 1024.0));
+		ImGui::Text("Submissions: %llu", static_cast<unsigned long long>(stats.Submissions));
+		ImGui::Text("Stalls: %llu", static_cast<unsigned long long>(stats.Stalls));
+		ImGui::Text("Wrap arounds: %llu", static_cast<unsigned long long>(stats.WrapArounds));
+		ImGui::Text("Dedicated: %llu", static_cast<unsigned long long>(stats.DedicatedAllocations));
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Async Uploads")) {
+		const Graphics::StagingRing::Stats& staging = m_GraphicsDevice->GetAsyncStagingStats();
+		const Graphics::AsyncUploader::Stats stats = m_GraphicsDevice->GetAsyncUploadStats();
+
+		ImGui::Text("Queue: %s", m_GraphicsDevice->HasTransferQueue() ? "dedicated transfer" : "graphics");
+		ImGui::Text("Textures: %llu", static_cast<unsigned long long>(stats.Textures));
+		ImGui::Text("Buffers: %llu", static_cast<unsigned long long>(stats.Buffers));
+		ImGui::Text("Staged: %.2f MB", staging.BytesStaged / (1024.0 * 1024.0));
+		ImGui::Text("Submissions: %llu", static_cast<unsigned long long>(staging.Submissions));
+		ImGui::Text("Stalls: %llu", static_cast<unsigned long long>(staging.Stalls));
+		ImGui::Text("Acquires: %llu", static_cast<unsigned long long>(stats.Acquires));
+		ImGui::Text("Pending: %llu", static_cast<unsigned long long>(stats.Pending));
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Memory")) {
+		const std::vector<Graphics::MemoryAllocator::HeapStats> heaps = m_GraphicsDevice->GetMemoryStats();
+		const double mb = 1024.0 * 1024.0;
+
+		for (size_t i = 0; i < heaps.size(); i++) {
+			const Graphics::MemoryAllocator::HeapStats& heap = heaps[i];
+
+			ImGui::Text("Heap %zu%s: %.0f MB", i, heap.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " (device local)" : "", heap.Size / mb);
+			ImGui::Text("  Blocks: %u, %.2f / %.2f MB used by %u allocations", heap.Blocks, heap.UsedBytes / mb, heap.BlockBytes / mb, heap.Allocations);
+			ImGui::Text("  Dedicated: %u, %.2f MB", heap.DedicatedAllocations, heap.DedicatedBytes / mb);
+		}
+
+		ImGui::TreePop();
+	}
 }
 
 bool Application::UpdateApplication(IScene& scene) {
@@ -0,0 +1,216 @@
+#include "AsyncUploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GraphicsDevice.h"
+
+namespace Graphics {
+
+	AsyncUploader::AsyncUploader(uint32_t queueFamily, VkQueue queue, uint32_t graphicsFamily)
+		: m_Ring(queueFamily, queue), m_QueueFamily(queueFamily), m_GraphicsFamily(graphicsFamily) {
+
+	}
+
+	VkImageMemoryBarrier AsyncUploader::GetOwnershipBarrier(const PendingAcquire& pending) const {
+		VkImageMemoryBarrier barrier			= {};
+		barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout						= VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout						= pending.Blit ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcQueueFamilyIndex				= HasDedicatedQueue() ? m_QueueFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex				= HasDedicatedQueue() ? m_GraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image							= pending.Image.Image;
+		barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel	= 0;
+		barrier.subresourceRange.levelCount		= pending.Image.Description.MipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount		= pending.Image.Description.LayerCount;
+
+		return barrier;
+	}
+
+	VkBufferMemoryBarrier AsyncUploader::GetBufferOwnershipBarrier(const PendingAcquire& pending) const {
+		VkBufferMemoryBarrier barrier	= {};
+		barrier.sType					= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex		= m_QueueFamily;
+		barrier.dstQueueFamilyIndex		= m_GraphicsFamily;
+		barrier.buffer					= pending.Buffer;
+		barrier.offset					= pending.Offset;
+		barrier.size					= pending.Size;
+
+		return barrier;
+	}
+
+	uint64_t AsyncUploader::UploadTextures(std::vector<TextureUpload>& uploads) {
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		// copy offsets have to be a multiple of the texel (or block) size, 16 covers every format we upload
+		const VkDeviceSize stagingAlignment = 16;
+
+		for (TextureUpload& upload : uploads) {
+			GPUImage& image = *upload.Target;
+
+			// a full ring submits what was recorded so far, so the command buffer is only fetched after the allocation
+			StagingRing::Allocation staging = m_Ring.Allocate(upload.DataSize, stagingAlignment);
+			memcpy(staging.Mapped, upload.Data, upload.DataSize);
+
+			VkCommandBuffer commandBuffer = m_Ring.GetCommandBuffer();
+
+			PendingAcquire pending	= {};
+			pending.Image			= image;
+			pending.Blit			= image.Description.MipLevels > 1 && upload.LevelOffsets.empty();
+
+			VkImageMemoryBarrier barrier = GetOwnershipBarrier(pending);
+			barrier.oldLayout				= VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout				= VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex		= VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex		= VK_QUEUE_FAMILY_IGNORED;
+			barrier.srcAccessMask			= 0;
+			barrier.dstAccessMask			= VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			// whole levels only, any minImageTransferGranularity of the transfer family allows those
+			std::vector<VkBufferImageCopy> regions;
+			const uint32_t levels = upload.LevelOffsets.empty() ? 1 : std::min<uint32_t>(image.Description.MipLevels, static_cast<uint32_t>(upload.LevelOffsets.size()));
+
+			for (uint32_t level = 0; level < levels; level++) {
+				VkBufferImageCopy region				= {};
+				region.bufferOffset						= staging.Offset + (upload.LevelOffsets.empty() ? 0 : upload.LevelOffsets[level]);
+				region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel		= level;
+				region.imageSubresource.baseArrayLayer	= 0;
+				region.imageSubresource.layerCount		= image.Description.LayerCount;
+				region.imageExtent						= { std::max(image.Description.Width >> level, 1u), std::max(image.Description.Height >> level, 1u), 1 };
+
+				regions.push_back(region);
+			}
+
+			vkCmdCopyBufferToImage(commandBuffer, staging.Buffer, image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+			image.ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			m_Stats.Textures++;
+
+			if (HasDedicatedQueue()) {
+				barrier = GetOwnershipBarrier(pending);
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				pending.Ticket = m_Ring.GetRecordedValue();
+				m_Pending.push_back(pending);
+
+				continue;
+			}
+
+			// a graphics queue, the image is done in the upload batch
+			if (pending.Blit) {
+				gfxDevice->RecordMipMaps(commandBuffer, pending.Image);
+				continue;
+			}
+
+			barrier = GetOwnershipBarrier(pending);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		return m_Ring.GetRecordedValue();
+	}
+
+	uint64_t AsyncUploader::UploadBuffer(const GPUBuffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset) {
+		if (data == nullptr || size == 0)
+			return m_Ring.GetRecordedValue();
+
+		m_Ring.CopyToBuffer(buffer, data, size, offset);
+		m_Stats.Buffers++;
+
+		if (HasDedicatedQueue()) {
+			PendingAcquire pending	= {};
+			pending.Ticket			= m_Ring.GetRecordedValue();
+			pending.Buffer			= buffer.Handle;
+			pending.Offset			= offset;
+			pending.Size			= size;
+
+			// the chunks copied by earlier batches of the ring come before it in queue order as well
+			VkBufferMemoryBarrier barrier = GetBufferOwnershipBarrier(pending);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+
+			vkCmdPipelineBarrier(m_Ring.GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+			m_Pending.push_back(pending);
+		}
+
+		return m_Ring.GetRecordedValue();
+	}
+
+	uint64_t AsyncUploader::Submit() {
+		return m_Ring.Submit();
+	}
+
+	void AsyncUploader::Require(uint64_t ticket) {
+		if (ticket <= m_Required)
+			return;
+
+		m_Required = ticket;
+
+		// still recording, it can't be waited for before it's submitted
+		if (ticket == m_Ring.GetRecordedValue())
+			m_Ring.Submit();
+	}
+
+	// Note: The acquire barriers have no first scope of their own (TOP_OF_PIPE, no access), the semaphore wait on
+	// ALL_COMMANDS is what orders them after the release on the transfer queue.
+	void AsyncUploader::Acquire(StagingRing& graphicsRing) {
+		if (m_Required <= m_Acquired)
+			return;
+
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		auto end = std::find_if(m_Pending.begin(), m_Pending.end(), [this](const PendingAcquire& pending) {
+			return pending.Ticket > m_Required;
+		});
+
+		if (m_Pending.begin() != end) {
+			VkCommandBuffer commandBuffer = graphicsRing.GetCommandBuffer();
+
+			for (auto it = m_Pending.begin(); it != end; it++) {
+				if (it->Buffer != VK_NULL_HANDLE) {
+					VkBufferMemoryBarrier barrier = GetBufferOwnershipBarrier(*it);
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+					vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+					continue;
+				}
+
+				VkImageMemoryBarrier barrier = GetOwnershipBarrier(*it);
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = it->Blit ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					it->Blit ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				if (it->Blit)
+					gfxDevice->RecordMipMaps(commandBuffer, it->Image);
+			}
+
+			m_Pending.erase(m_Pending.begin(), end);
+		}
+
+		graphicsRing.WaitSemaphore(m_Ring.GetSemaphore(), m_Required, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		m_Acquired = m_Required;
+		m_Stats.Acquires++;
+	}
+
+	AsyncUploader::Stats AsyncUploader::GetStats() const {
+		Stats stats = m_Stats;
+		stats.Pending = m_Pending.size();
+
+		return stats;
+	}
+}
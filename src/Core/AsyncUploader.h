@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "VulkanHeader.h"
+#include "Graphics.h"
+#include "StagingRing.h"
+
+namespace Graphics {
+	struct TextureUpload;
+
+	// Note: Uploads recorded on the transfer queue (a family without graphics when the device has one, the DMA engines
+	// that copy next to the frames) through a StagingRing of their own. Nothing waits for them on the CPU: every call
+	// returns a ticket, the value of the ring's timeline semaphore signaled once the copies are done. The graphics queue
+	// only waits for a ticket once it's Require()d, in the first graphics submission after that.
+	//
+	// Resources of an exclusive family are released at the end of their batch and acquired by the graphics queue when
+	// their ticket is required, mip chains that need blits are blitted after the acquire (transfer queues can't blit).
+	// On devices where the transfer family is the graphics one, everything is recorded in the upload batch and the
+	// acquire is only the semaphore wait.
+	class AsyncUploader {
+	public:
+		struct Stats {
+			uint64_t Textures	= 0;
+			uint64_t Buffers	= 0;
+			uint64_t Acquires	= 0;	// graphics submissions that waited for tickets
+			uint64_t Pending	= 0;	// resources released but not acquired yet
+		};
+
+		AsyncUploader(uint32_t queueFamily, VkQueue queue, uint32_t graphicsFamily);
+		~AsyncUploader() {};
+
+		// the targets must be created (in UNDEFINED) and end up in SHADER_READ_ONLY, the data can go once it returns
+		uint64_t UploadTextures(std::vector<TextureUpload>& uploads);
+		uint64_t UploadBuffer(const GPUBuffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset);
+
+		// starts the open batch, returns the ticket of every upload so far
+		uint64_t Submit();
+
+		// whether the copies of 'ticket' are done, never waits. Required or not, the graphics side still has to acquire.
+		bool IsComplete(uint64_t ticket)		{ return m_Ring.IsComplete(ticket); }
+
+		// the resources of 'ticket' and every earlier one are used by the next graphics submission
+		void Require(uint64_t ticket);
+
+		// records the acquires of the required tickets into the open batch of 'graphicsRing' and makes it wait for them
+		void Acquire(StagingRing& graphicsRing);
+
+		bool HasDedicatedQueue() const			{ return m_QueueFamily != m_GraphicsFamily; }
+		const StagingRing::Stats& GetStagingStats() const { return m_Ring.GetStats(); }
+		Stats GetStats() const;
+
+	private:
+		// an image or a buffer range released by the transfer queue
+		struct PendingAcquire {
+			uint64_t		Ticket	= 0;
+
+			GPUImage		Image	= {};
+			bool			Blit	= false;	// level 0 only, the rest is blitted after the acquire
+
+			VkBuffer		Buffer	= VK_NULL_HANDLE;
+			VkDeviceSize	Offset	= 0;
+			VkDeviceSize	Size	= 0;
+		};
+
+		// the release and the acquire of a resource use the same barrier, only the access masks differ
+		VkImageMemoryBarrier GetOwnershipBarrier(const PendingAcquire& pending) const;
+		VkBufferMemoryBarrier GetBufferOwnershipBarrier(const PendingAcquire& pending) const;
+
+	private:
+		StagingRing					m_Ring;
+
+		uint32_t					m_QueueFamily		= 0;
+		uint32_t					m_GraphicsFamily	= 0;
+
+		std::vector<PendingAcquire>	m_Pending;			// in ticket order
+		uint64_t					m_Required			= 0;
+		uint64_t					m_Acquired			= 0;
+
+		Stats						m_Stats;
+	};
+}
@@ -2,62 +2,194 @@
 
 #include "GraphicsDevice.h"
 
-Graphics::BufferManager::BufferManager() {
+static constexpr size_t TRANSIENT_PAGE_SIZE = 1024 * 1024;
+
+Graphics::BufferManager::BufferManager(VkDeviceSize alignment) : m_Alignment(std::max<VkDeviceSize>(alignment, 1)) {
 
 }
 
 Graphics::BufferManager::~BufferManager() {
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
-	gfxDevice->DestroyBuffer(m_MainBuffer);
+
+	for (std::unique_ptr<Block>& block : m_Blocks) {
+		if (block)
+			gfxDevice->DestroyBuffer(block->Buffer);
+	}
+
+	for (TransientRegion& region : m_TransientRegions) {
+		for (Graphics::GPUBuffer& page : region.Pages)
+			gfxDevice->DestroyBuffer(page);
+	}
 }
 
-void Graphics::BufferManager::CreateMainBuffer() {
+uint32_t Graphics::BufferManager::CreateBlock(size_t size) {
+	auto block = std::make_unique<Block>(size);
 
 	Graphics::BufferDescription desc = {};
-	desc.Capacity = m_Capacity;
+	desc.Capacity = size;
 	desc.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 	desc.MemoryProperty = static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
-	gfxDevice->CreateBuffer(desc, m_MainBuffer, desc.Capacity);
+	gfxDevice->CreateBuffer(desc, block->Buffer, desc.Capacity);
 
-	std::cout << "Main buffer capacity: " << m_Capacity << '\n';
-}
+	std::cout << "Main buffer capacity: " << size << '\n';
 
-Graphics::Buffer Graphics::BufferManager::SubAllocateBuffer(size_t size) {
-	if (m_MainBuffer.Handle == VK_NULL_HANDLE)
-		CreateMainBuffer();
+	auto slot = std::find(m_Blocks.begin(), m_Blocks.end(), nullptr);
 
-	assert(m_Size + size < m_Capacity && "Buffer size exceeded!");
+	if (slot != m_Blocks.end())
+		*slot = std::move(block);
+	else
+		slot = m_Blocks.insert(slot, std::move(block));
 
+	return static_cast<uint32_t>(slot - m_Blocks.begin());
+}
+
+Graphics::Buffer Graphics::BufferManager::SubAllocateBuffer(size_t size) {
 	Graphics::Buffer buffer = {};
-	buffer.Offset = m_Size;
 	buffer.Size = 0;
 	buffer.Capacity = size;
-	buffer.Handle = &m_MainBuffer.Handle;
 
-	m_Size += size;
+	VkDeviceSize offset = 0;
+
+	for (uint32_t i = 0; i < m_Blocks.size(); i++) {
+		if (m_Blocks[i] && m_Blocks[i]->Metadata.Allocate(size, m_Alignment, offset, buffer.Node)) {
+			buffer.Block = i;
+			break;
+		}
+	}
+
+	if (buffer.Node == TLSF::INVALID_NODE) {
+		buffer.Block = CreateBlock(std::max(m_Capacity, size));
+
+		bool success = m_Blocks[buffer.Block]->Metadata.Allocate(size, m_Alignment, offset, buffer.Node);
+		assert(success && "Buffer size exceeded!");
+	}
 
-	std::cout << "Main buffer suballocation: " << m_Size << '\n';
+	buffer.Offset = offset;
+	buffer.Handle = &m_Blocks[buffer.Block]->Buffer.Handle;
 
 	return buffer;
 }
 
+void Graphics::BufferManager::FreeBuffer(Graphics::Buffer& buffer) {
+	if (buffer.Node == TLSF::INVALID_NODE)
+		return;
+
+	// the frames in flight may still read it
+	m_PendingFrees.push_back({ buffer.Block, buffer.Node, m_FrameCount });
+
+	buffer = {};
+}
+
 void Graphics::BufferManager::WriteBuffer(Graphics::Buffer& buffer, void* data, size_t dataSize) {
 
+	// moving it would leave the descriptors written for it pointing at a freed range
 	if (buffer.Size + dataSize > buffer.Capacity) {
-		// TODO: better handle with realocation 
 		std::cout << "Buffer out of capacity!" << '\n';
+		assert(false && "Buffer out of capacity!");
 		return;
 	}
 
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
-	gfxDevice->WriteBuffer(m_MainBuffer, data, dataSize, buffer.Offset + buffer.Size);
-	
+	gfxDevice->UpdateBuffer(m_Blocks[buffer.Block]->Buffer, buffer.Offset + buffer.Size, data, dataSize);
+
 	buffer.Size += dataSize;
 }
 
 void Graphics::BufferManager::UpdateBuffer(const Graphics::Buffer& buffer, void* data) {
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
-	gfxDevice->UpdateBuffer(m_MainBuffer, buffer.Offset, data, buffer.Capacity);
+	gfxDevice->UpdateBuffer(m_Blocks[buffer.Block]->Buffer, buffer.Offset, data, buffer.Capacity);
+}
+
+void Graphics::BufferManager::BeginFrame(uint32_t frameIndex) {
+	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
+
+	m_FrameCount++;
+
+	// the frame that freed them was FRAMES_IN_FLIGHT frames ago, its fence was waited for
+	auto released = std::partition(m_PendingFrees.begin(), m_PendingFrees.end(), [this](const PendingFree& pending) {
+		return pending.Frame + Graphics::FRAMES_IN_FLIGHT > m_FrameCount;
+	});
+
+	for (auto it = released; it != m_PendingFrees.end(); it++) {
+		std::unique_ptr<Block>& block = m_Blocks[it->Block];
+		block->Metadata.Free(it->Node);
+
+		// extra backing buffers go as soon as nothing lives in them
+		if (block->Metadata.IsEmpty() && it->Block > 0) {
+			gfxDevice->DestroyBuffer(block->Buffer);
+			block.reset();
+		}
+	}
+
+	m_PendingFrees.erase(released, m_PendingFrees.end());
+
+	if (frameIndex >= m_TransientRegions.size())
+		m_TransientRegions.resize(frameIndex + 1);
+
+	TransientRegion& region = m_TransientRegions[frameIndex];
+
+	// the last frame with this index overflowed, one buffer that holds all of it from now on
+	if (region.Pages.size() > 1) {
+		size_t capacity = 0;
+
+		for (Graphics::GPUBuffer& page : region.Pages) {
+			capacity += page.Description.Capacity;
+			gfxDevice->DestroyBuffer(page);
+		}
+
+		region.Pages.clear();
+		region.Pages.push_back(CreateTransientPage(capacity));
+	}
+
+	region.Page = 0;
+	region.Used = 0;
+
+	m_TransientFrame = frameIndex;
+}
+
+Graphics::GPUBuffer Graphics::BufferManager::CreateTransientPage(size_t size) {
+	Graphics::BufferDescription desc = {};
+	desc.Capacity = size;
+	desc.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	desc.MemoryProperty = static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	Graphics::GPUBuffer page = {};
+
+	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
+	gfxDevice->CreateBuffer(desc, page, desc.Capacity);
+
+	return page;
+}
+
+Graphics::BufferManager::TransientAllocation Graphics::BufferManager::AllocateTransient(size_t size) {
+	if (m_TransientFrame >= m_TransientRegions.size())
+		m_TransientRegions.resize(m_TransientFrame + 1);
+
+	TransientRegion& region = m_TransientRegions[m_TransientFrame];
+
+	size_t offset = (region.Used + m_Alignment - 1) & ~(m_Alignment - 1);
+
+	if (region.Pages.empty() || offset + size > region.Pages[region.Page].Description.Capacity) {
+		if (!region.Pages.empty())
+			region.Page++;
+
+		if (region.Page == region.Pages.size())
+			region.Pages.push_back(CreateTransientPage(std::max(TRANSIENT_PAGE_SIZE, size)));
+
+		offset = 0;
+	}
+
+	region.Used = offset + size;
+
+	Graphics::GPUBuffer& page = region.Pages[region.Page];
+
+	TransientAllocation allocation = {};
+	allocation.Handle = page.Handle;
+	allocation.Offset = offset;
+	allocation.Size = size;
+	allocation.Mapped = static_cast<char*>(page.MemoryMapped) + offset;
+
+	return allocation;
 }
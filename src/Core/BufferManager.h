@@ -1,29 +1,79 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <vector>
 
 #include "VulkanHeader.h"
 #include "Graphics.h"
+#include "MemoryAllocator.h"
 
 namespace Graphics {
+	// Note: Uniform data in persistently mapped, host visible buffers, every write is a plain memcpy. Long lived sub
+	// buffers come from a free list (TLSF, free neighbours are merged) over backing buffers that are added when the
+	// existing ones are full; a freed range is only reused once the frames in flight that may still read it are done. A
+	// sub buffer never moves, descriptors keep pointing at it. Transient per frame constants come from a linear region per
+	// frame in flight, rewound when that frame starts again, their descriptors are written every frame. A region that
+	// overflowed is replaced by a single buffer of the size it needed, so space grows to what a frame uses instead of
+	// being reserved for the worst case up front.
 	class BufferManager {
 	public:
-		BufferManager();
+		struct TransientAllocation {
+			VkBuffer		Handle	= VK_NULL_HANDLE;
+			VkDeviceSize	Offset	= 0;
+			VkDeviceSize	Size	= 0;
+			void*			Mapped	= nullptr;
+		};
+
+		// 'alignment' of every range, minUniformBufferOffsetAlignment
+		BufferManager(VkDeviceSize alignment);
 		~BufferManager();
 
 		Graphics::Buffer SubAllocateBuffer(size_t size);
+		void FreeBuffer(Graphics::Buffer& buffer);
 
+		// appends to what was written so far, writing past the capacity asserts
 		void WriteBuffer(Graphics::Buffer& buffer, void* data, size_t dataSize);
 		void UpdateBuffer(const Graphics::Buffer& buffer, void* data);
 
-		// TODO: delete - when a buffer is not longer needed and we can get rid of its sub allocation
-		// TODO: resize - when a bigger/smaller buffer is needed and we need to resize the size of existing buffer
+		// called once the fence of 'frameIndex' signaled, transient allocations go to its region until the next call
+		void BeginFrame(uint32_t frameIndex);
+
+		// valid until the frame is recorded, the handle may change from one frame to the next
+		TransientAllocation AllocateTransient(size_t size);
+
 	private:
-		void CreateMainBuffer();
+		struct Block {
+			Graphics::GPUBuffer Buffer;
+			TLSF				Metadata;
+
+			Block(size_t size) : Metadata(size) {}
+		};
+
+		struct PendingFree {
+			uint32_t Block	= 0;
+			uint32_t Node	= 0;
+			uint64_t Frame	= 0;
+		};
+
+		struct TransientRegion {
+			std::vector<Graphics::GPUBuffer> Pages;
+			size_t Page = 0;
+			size_t Used = 0;
+		};
+
+		uint32_t CreateBlock(size_t size);
+		Graphics::GPUBuffer CreateTransientPage(size_t size);
 	private:
-		Graphics::GPUBuffer m_MainBuffer;
+		std::vector<std::unique_ptr<Block>> m_Blocks;		// empty slots are reused
+		std::vector<PendingFree> m_PendingFrees;
+
+		std::vector<TransientRegion> m_TransientRegions;
+		uint32_t m_TransientFrame = 0;
+
+		uint64_t m_FrameCount = 0;
 
-		size_t m_Size = 0;
-		size_t m_Capacity = 256 * 100000;
+		VkDeviceSize m_Alignment = 1;
+		size_t m_Capacity = 256 * 100000;		// of a backing buffer
 	};
-}
\ No newline at end of file
+}
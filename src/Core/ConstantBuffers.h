@@ -11,10 +11,11 @@ struct GlobalConstants {
 //	alignas(4) float minShadowBias = 0.005f;
 	alignas(4) float maxShadowBias = 0.05f;
 	alignas(4) float extra_s_0 = 0.0f;
-	alignas(4) float extra_s_1 = 0.0f;
+	alignas(4) float environmentIntensity = 0.0f;	// scale of the image based lighting, 0 turns it off
 	alignas(4) float extra_s_2 = 0.0f;
 	alignas(4) float extra_s_3 = 0.0f;
-	glm::vec4 extra[14];
+	glm::vec4 irradianceSH[9];						// Utils::SHIrradiance of the environment, w unused
+	glm::vec4 extra[5];
 //	glm::vec4 cameraPosition;
 //	glm::vec4 extra[6];
 //	glm::mat4 view = glm::mat4(1.0f);
@@ -22,7 +23,9 @@ struct GlobalConstants {
 };
 
 struct ModelConstants {
-	glm::vec4 extra[6] = {};
+	glm::vec4 extra[4] = {};
+	glm::vec4 positionOffset = glm::vec4(0.0f);		// dequantization of the packed vertex layouts
+	glm::vec4 positionScale = glm::vec4(1.0f);
 	glm::vec4 color = glm::vec4(1.0f);
 	glm::mat4 model = glm::mat4(1.0f);
 	glm::mat4 normalMatrix = glm::mat4(1.0f);
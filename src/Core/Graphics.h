@@ -44,6 +44,21 @@ namespace Graphics {
 		VkComponentMapping			ComponentMapping	= {};
 	};
 
+	// Note: Where the memory of a resource lives, filled in by the MemoryAllocator. 'Memory' is shared by every resource
+	// sub allocated from the same block, resources with a dedicated allocation own it (Block is DEDICATED).
+	struct MemoryAllocation {
+		static constexpr uint32_t DEDICATED = UINT32_MAX;
+
+		VkDeviceMemory	Memory		= VK_NULL_HANDLE;
+		VkDeviceSize	Offset		= 0;
+		VkDeviceSize	Size		= 0;
+		void*			Mapped		= nullptr;		// host visible memory only, already at 'Offset'
+		uint32_t		MemoryType	= 0;
+		uint32_t		Pool		= 0;
+		uint32_t		Block		= DEDICATED;
+		uint32_t		Node		= 0;
+	};
+
 	struct GPUImage {
 		VkImage			Image			= VK_NULL_HANDLE;
 		VkImageView		ImageView		= VK_NULL_HANDLE;
@@ -53,6 +68,8 @@ namespace Graphics {
 
 		void*			MemoryMapped;
 
+		MemoryAllocation Allocation		= {};
+
 		ImageDescription Description = {};
 	};
 
@@ -97,6 +114,8 @@ namespace Graphics {
 		VkDeviceMemory Memory			= VK_NULL_HANDLE;
 		void* MemoryMapped				= nullptr;
 
+		MemoryAllocation Allocation		= {};
+
 		BufferDescription Description	= {};
 	};
 
@@ -106,6 +125,10 @@ namespace Graphics {
 		size_t Offset		= 0;
 
 		VkBuffer* Handle = nullptr;
+
+		// where the BufferManager took the range from
+		uint32_t Block		= 0;
+		uint32_t Node		= UINT32_MAX;
 	};
 
 	struct PipelineLayoutDesc {
@@ -6,9 +6,12 @@
 #include "RenderTarget.h"
 
 #include "../Utils/Helper.h"
+#include "../Utils/ParallelFor.h"
+#include "../Utils/ShaderCache.h"
 
 #include <string>
 #include <fstream>
+#include <sstream>
 
 namespace Graphics {
 	VkPhysicalDevice GraphicsDevice::CreatePhysicalDevice(VkInstance& instance, VkSurfaceKHR& surface) {
@@ -87,6 +90,26 @@ namespace Graphics {
 			i++;
 		}
 
+		// a family with transfer but without graphics copies next to the frames (the DMA engines of discrete GPUs), 
+		// compute only families come next and the graphics family last
+		for (uint32_t family = 0; family < queueFamilyCount; family++) {
+			const VkQueueFlags flags = queueFamilies[family].queueFlags;
+
+			if (flags & VK_QUEUE_GRAPHICS_BIT)
+				continue;
+
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT)) {
+				indices.transferFamily = family;
+				break;
+			}
+
+			if ((flags & VK_QUEUE_COMPUTE_BIT) && !indices.transferFamily.has_value())
+				indices.transferFamily = family;
+		}
+
+		if (!indices.transferFamily.has_value())
+			indices.transferFamily = indices.graphicsFamily;
+
 		return indices;
 	}
 
@@ -278,7 +301,8 @@ namespace Graphics {
 		std::set<uint32_t> uniqueQueueFamilies = { 
 			indices.graphicsFamily.value(), 
 			indices.presentFamily.value(), 
-			indices.graphicsAndComputeFamily.value() 
+			indices.graphicsAndComputeFamily.value(),
+			indices.transferFamily.value()
 		};
 
 		float queuePriority = 1.0f;
@@ -319,14 +343,23 @@ namespace Graphics {
         separateLayoutsCreateInfo.separateDepthStencilLayouts                           = VK_TRUE;
         separateLayoutsCreateInfo.pNext                                                 = &descriptorIndexingCreateInfo;
 
+		// core in 1.2, the staging rings signal one and the async uploads are waited for through it
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreCreateInfo		= {};
+		timelineSemaphoreCreateInfo.sType											= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineSemaphoreCreateInfo.pNext											= &separateLayoutsCreateInfo;
+
 		VkPhysicalDeviceFeatures2 deviceFeatures2	= {};
 		deviceFeatures2.sType						= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 		deviceFeatures2.features					= deviceFeatures;
 //		deviceFeatures2.pNext						= &descriptorIndexingCreateInfo;
-		deviceFeatures2.pNext						= &separateLayoutsCreateInfo;
+		deviceFeatures2.pNext						= &timelineSemaphoreCreateInfo;
 
 		vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
 
+		if (!timelineSemaphoreCreateInfo.timelineSemaphore) {
+			throw std::runtime_error("Timeline semaphores are not supported!");
+		}
+
 		createInfo.pNext = &deviceFeatures2;
 
 		if (c_EnableValidationLayers) {
@@ -668,6 +701,9 @@ namespace Graphics {
 
 		vkEndCommandBuffer(commandBuffer);
 
+		// staged uploads were recorded first, they have to reach the queue first
+		SubmitGraphicsUploads();
+
 		VkSubmitInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		info.commandBufferCount = 1;
@@ -679,26 +715,6 @@ namespace Graphics {
 		vkFreeCommandBuffers(m_LogicalDevice, commandPool, 1, &commandBuffer);
 	}
 
-	uint32_t FindMemoryType(VkPhysicalDevice& physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-				return i;
-			}
-		}
-
-		throw std::runtime_error("Failed to find suitable memory type!");
-	}
-
-	VkMemoryRequirements GetMemoryRequirements(VkDevice& logicalDevice, const VkBuffer& buffer) {
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(logicalDevice, buffer, &memRequirements);
-
-		return memRequirements;
-	}
-
 	void GraphicsDevice::CreateImage(GPUImage& image) {
 		VkImageCreateInfo imageCreateInfo{};
 		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -765,11 +781,23 @@ namespace Graphics {
 		throw std::runtime_error("Failed to find supported format!");
 	}
 
+	bool GraphicsDevice::SupportsFormat(VkFormat format, VkFormatFeatureFlags features) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &properties);
+
+		return (properties.optimalTilingFeatures & features) == features;
+	}
+
 	bool GraphicsDevice::HasStencilComponent(VkFormat format) {
 		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 	}
 
 	GraphicsDevice::GraphicsDevice(Window& window) {
+#ifdef RUNTIME_SHADER_COMPILATION
+		// once for the whole process, CompileShader only builds the shaders
+		glslang::InitializeProcess();
+#endif
+
 		CreateInstance(m_VulkanInstance);
 		CreateSurface(m_VulkanInstance, *window.GetHandle(), m_Surface);
 		m_PhysicalDevice = CreatePhysicalDevice(m_VulkanInstance, m_Surface);
@@ -777,6 +805,11 @@ namespace Graphics {
 		m_PhysicalDeviceProperties = GetDeviceProperties(m_PhysicalDevice);
 		m_MsaaSamples = GetMaxSampleCount(m_PhysicalDeviceProperties);
 
+		VkPhysicalDeviceFeatures deviceFeatures = {};
+		vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &deviceFeatures);
+
+		m_SupportsBlockCompression = deviceFeatures.textureCompressionBC == VK_TRUE;
+
 		std::cout << "Selected device: " << m_PhysicalDeviceProperties.deviceName << '\n';
 		std::cout << "MSAA Samples: " << m_MsaaSamples << '\n';
 
@@ -786,6 +819,10 @@ namespace Graphics {
 		CreateQueue(m_LogicalDevice, m_QueueFamilyIndices.graphicsFamily.value(), m_GraphicsQueue);
 		CreateQueue(m_LogicalDevice, m_QueueFamilyIndices.presentFamily.value(), m_PresentQueue);
 		CreateQueue(m_LogicalDevice, m_QueueFamilyIndices.graphicsAndComputeFamily.value(), m_ComputeQueue);
+		CreateQueue(m_LogicalDevice, m_QueueFamilyIndices.transferFamily.value(), m_TransferQueue);
+
+		std::cout << "Transfer queue family: " << m_QueueFamilyIndices.transferFamily.value() 
+			<< (m_QueueFamilyIndices.transferFamily != m_QueueFamilyIndices.graphicsFamily ? " (dedicated)" : " (graphics)") << '\n';
 
         if (c_EnableValidationLayers) {
             CreateDebugMessenger(m_VulkanInstance, m_DebugMessenger);
@@ -793,7 +830,16 @@ namespace Graphics {
 
 		CreateCommandPool(m_CommandPool, m_QueueFamilyIndices.graphicsFamily.value());
 
-		m_BufferManager = std::make_unique<BufferManager>();
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memoryProperties);
+
+		m_MemoryAllocator = std::make_unique<MemoryAllocator>(m_LogicalDevice, memoryProperties, m_PhysicalDeviceProperties.limits.bufferImageGranularity, m_PhysicalDeviceProperties.limits.nonCoherentAtomSize);
+
+		m_BufferManager = std::make_unique<BufferManager>(m_PhysicalDeviceProperties.limits.minUniformBufferOffsetAlignment);
+		m_StagingRing = std::make_unique<StagingRing>(m_QueueFamilyIndices.graphicsFamily.value(), m_GraphicsQueue);
+		m_AsyncUploader = std::make_unique<AsyncUploader>(m_QueueFamilyIndices.transferFamily.value(), m_TransferQueue, m_QueueFamilyIndices.graphicsFamily.value());
+		m_PipelineCache = std::make_unique<PipelineCache>(m_LogicalDevice, m_PhysicalDeviceProperties, c_PipelineCachePath);
+		m_ShaderCompiler = std::make_unique<ShaderCompiler>();
 
 		for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
 			CreateFrameResources(m_Frames[i]);
@@ -806,6 +852,12 @@ namespace Graphics {
 	GraphicsDevice::~GraphicsDevice() {
 		DestroyDebugUtilsMessengerEXT(m_VulkanInstance, m_DebugMessenger, nullptr);
 
+		// loads still queued create their modules first
+		m_ShaderCompiler.reset();
+
+		// the graphics ring may wait for the async uploads, it goes first
+		m_StagingRing.reset();
+		m_AsyncUploader.reset();
 		m_BufferManager.reset();
 
 		for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
@@ -816,9 +868,24 @@ namespace Graphics {
 		DestroySwapChain(m_SwapChain);
 
 		vkDestroyCommandPool(m_LogicalDevice, m_CommandPool, nullptr);
+
+		m_MemoryAllocator.reset();
+
+		for (auto& [key, pso] : m_PipelineStates)
+			DestroyPipeline(pso);
+
+		m_PipelineStates.clear();
+
+		// written back to disk with everything created during the run
+		m_PipelineCache.reset();
+
 		vkDestroyDevice(m_LogicalDevice, nullptr);
 		vkDestroySurfaceKHR(m_VulkanInstance, m_Surface, nullptr);
 		vkDestroyInstance(m_VulkanInstance, nullptr);
+
+#ifdef RUNTIME_SHADER_COMPILATION
+		glslang::FinalizeProcess();
+#endif
 	}
 
 	void GraphicsDevice::RecreateSwapChain(Window& window) {
@@ -902,6 +969,8 @@ namespace Graphics {
 
 		vkResetFences(m_LogicalDevice, 1, &frame.renderFence);
 
+		m_BufferManager->BeginFrame(m_CurrentFrame);
+
 		BeginCommandBuffer(frame.commandBuffer);
 
 		return true;
@@ -912,6 +981,10 @@ namespace Graphics {
 		VkResult result = vkEndCommandBuffer(frame.commandBuffer);
 		assert(result == VK_SUCCESS);
 
+		// uploads made while recording the frame, the async ones start copying right away
+		m_AsyncUploader->Submit();
+		SubmitGraphicsUploads();
+
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		std::vector<VkCommandBuffer> cmdBuffers = { frame.commandBuffer };
 
@@ -1064,10 +1137,10 @@ namespace Graphics {
 
 		assert(result == VK_SUCCESS);
 
-		AllocateMemory(image, description.MemoryProperty);
-
 		image.Description = description;
 		image.ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		AllocateMemory(image, description.MemoryProperty);
 	}
 
 	void GraphicsDevice::CreateImageView(const VkImage& image, VkImageView& imageView, const ImageDescription& description) {
@@ -1125,19 +1198,9 @@ namespace Graphics {
 	void GraphicsDevice::AllocateMemory(GPUImage& image, VkMemoryPropertyFlagBits memoryProperty) {
 		image.Description.MemoryProperty = memoryProperty;
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(m_LogicalDevice, image.Image, &memRequirements);
-		
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(m_PhysicalDevice, memRequirements.memoryTypeBits, image.Description.MemoryProperty);
-
-		VkResult result = vkAllocateMemory(m_LogicalDevice, &allocInfo, nullptr, &image.Memory);
-
-		assert(result == VK_SUCCESS);
-
-		vkBindImageMemory(m_LogicalDevice, image.Image, image.Memory, 0);
+		image.Allocation = m_MemoryAllocator->AllocateImage(image.Image, image.Description, memoryProperty);
+		image.Memory = image.Allocation.Memory;
+		image.MemoryMapped = image.Allocation.Mapped;
 	}
 
 	void GraphicsDevice::TransitionImageLayout(
@@ -1379,6 +1442,14 @@ namespace Graphics {
 
 		VkCommandBuffer commandBuffer = BeginSingleTimeCommandBuffer(m_CommandPool);
 
+		RecordMipMaps(commandBuffer, image);
+
+		EndSingleTimeCommandBuffer(commandBuffer, m_CommandPool);
+	}
+
+	// Note: Expects the whole image in TRANSFER_DST with level 0 filled, leaves it in SHADER_READ_ONLY.
+	void GraphicsDevice::RecordMipMaps(const VkCommandBuffer& commandBuffer, GPUImage& image) {
+
 		VkImageMemoryBarrier barrier = {};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.image = image.Image;
@@ -1440,8 +1511,6 @@ namespace Graphics {
 
 		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);		
 
-		EndSingleTimeCommandBuffer(commandBuffer, m_CommandPool);
-		
 		image.ImageLayout = barrier.newLayout;
 	}
 
@@ -1508,49 +1577,11 @@ namespace Graphics {
 		EndSingleTimeCommandBuffer(commandBuffer, m_CommandPool);
 	}
 
+	// Note: Expects the image in TRANSFER_DST, the copy runs with the next submission.
 	void GraphicsDevice::UploadDataToImage(GPUImage& dstImage, const void* data, const size_t dataSize) {
 		assert(dataSize != 0);
 
-		BufferDescription stagingDesc = {};
-		stagingDesc.Capacity = dataSize;
-		stagingDesc.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		stagingDesc.MemoryProperty = static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		GPUBuffer stagingBuffer = {};
-		stagingBuffer.Description = stagingDesc;
-
-		CreateBuffer(stagingDesc, stagingBuffer, dataSize);
-		vkMapMemory(m_LogicalDevice, stagingBuffer.Memory, 0, dataSize, 0, &stagingBuffer.MemoryMapped);
-		memcpy(stagingBuffer.MemoryMapped, data, dataSize);
-		vkUnmapMemory(m_LogicalDevice, stagingBuffer.Memory);
-
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommandBuffer(m_CommandPool);
-
-		const VkBufferImageCopy region = {
-			.bufferOffset = 0,
-			.bufferRowLength = 0,
-			.bufferImageHeight = 0,
-			.imageSubresource = {
-				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-				.mipLevel = 0,
-				.baseArrayLayer = 0,
-				.layerCount = dstImage.Description.LayerCount 
-			},
-			.imageOffset = {
-				.x = 0,
-				.y = 0,
-				.z = 0
-			},
-			.imageExtent = {
-				.width = dstImage.Description.Width,
-				.height = dstImage.Description.Height,
-				.depth = 1
-			}
-		};
-
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.Handle, dstImage.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-		EndSingleTimeCommandBuffer(commandBuffer, m_CommandPool);
-		DestroyBuffer(stagingBuffer);
+		m_StagingRing->CopyToImage(dstImage, data, dataSize);
 	}
 
 	void GraphicsDevice::DestroyImage(GPUImage& image) {
@@ -1563,7 +1594,8 @@ namespace Graphics {
 
 		image.ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-		vkFreeMemory(m_LogicalDevice, image.Memory, nullptr);
+		m_MemoryAllocator->Free(image.Allocation);
+		image.Memory = VK_NULL_HANDLE;
 	}
 
 	void GraphicsDevice::DestroyAndDeallocateImage(GPUImage& image) {
@@ -1571,7 +1603,8 @@ namespace Graphics {
 			return;
 
 		vkDestroyImage(m_LogicalDevice, image.Image, nullptr);
-		vkFreeMemory(m_LogicalDevice, image.Memory, nullptr);
+		m_MemoryAllocator->Free(image.Allocation);
+		image.Memory = VK_NULL_HANDLE;
 		image.ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	}
 		
@@ -1811,18 +1844,10 @@ namespace Graphics {
 	void GraphicsDevice::AllocateMemory(GPUBuffer& buffer, VkMemoryPropertyFlagBits memoryProperty) {
 		buffer.Description.MemoryProperty = memoryProperty;
 
-		VkMemoryRequirements memRequirements = GetMemoryRequirements(m_LogicalDevice, buffer.Handle);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size == 0 ? 256 : memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(m_PhysicalDevice, memRequirements.memoryTypeBits, buffer.Description.MemoryProperty);
-
-		VkResult result = vkAllocateMemory(m_LogicalDevice, &allocInfo, nullptr, &buffer.Memory);
-
-		assert(result == VK_SUCCESS);
-
-		vkBindBufferMemory(m_LogicalDevice, buffer.Handle, buffer.Memory, 0);
+		// host visible memory comes mapped and stays mapped until the buffer is destroyed
+		buffer.Allocation = m_MemoryAllocator->AllocateBuffer(buffer.Handle, memoryProperty);
+		buffer.Memory = buffer.Allocation.Memory;
+		buffer.MemoryMapped = buffer.Allocation.Mapped;
 	}
 
 	void GraphicsDevice::CopyBuffer(GPUBuffer& srcBuffer, GPUBuffer& dstBuffer, VkDeviceSize size, size_t srcOffset, size_t dstOffset) {
@@ -1840,27 +1865,15 @@ namespace Graphics {
 
 	void GraphicsDevice::DestroyBuffer(GPUBuffer& buffer) {
 		vkDestroyBuffer(m_LogicalDevice, buffer.Handle, nullptr);
-		vkFreeMemory(m_LogicalDevice, buffer.Memory, nullptr);
+		m_MemoryAllocator->Free(buffer.Allocation);
+
+		buffer.Memory = VK_NULL_HANDLE;
+		buffer.MemoryMapped = nullptr;
 	}
 
 	template <class T>
 	void GraphicsDevice::CopyDataFromStaging(GPUBuffer& dstBuffer, T* data, size_t dataSize, size_t offset) {
-		BufferDescription stagingDesc = {};
-		stagingDesc.Size = dataSize;
-		stagingDesc.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		stagingDesc.MemoryProperty = static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		GPUBuffer stagingBuffer = {};
-		stagingBuffer.Description = stagingDesc;
-
-		CreateBuffer(stagingDesc, stagingBuffer, dataSize);
-
-		vkMapMemory(m_LogicalDevice, stagingBuffer.Memory, 0, dataSize, 0, &stagingBuffer.MemoryMapped);
-		memcpy(stagingBuffer.MemoryMapped, data, dataSize);
-		vkUnmapMemory(m_LogicalDevice, stagingBuffer.Memory);
-
-		CopyBuffer(stagingBuffer, dstBuffer, dataSize, 0, offset);
-		DestroyBuffer(stagingBuffer);
+		m_StagingRing->CopyToBuffer(dstBuffer, data, dataSize, offset);
 	}
 
 	void GraphicsDevice::CreateBuffer(BufferDescription& desc, GPUBuffer& buffer, size_t bufferSize) {
@@ -1923,15 +1936,24 @@ namespace Graphics {
 	}
 
 	void GraphicsDevice::UpdateBuffer(GPUBuffer& buffer, VkDeviceSize offset, void* data, size_t dataSize) {
-		vkMapMemory(m_LogicalDevice, buffer.Memory, offset, dataSize, 0, &buffer.MemoryMapped);
-		memcpy(buffer.MemoryMapped, data, dataSize);
-		vkUnmapMemory(m_LogicalDevice, buffer.Memory);
+		assert(buffer.MemoryMapped != nullptr && "Buffer must be host visible!");
+
+		memcpy(static_cast<char*>(buffer.MemoryMapped) + offset, data, dataSize);
+		m_MemoryAllocator->Flush(buffer.Allocation, offset, dataSize);
 	}
 
 	void GraphicsDevice::UpdateBuffer(Buffer& buffer, void* data) {
 		m_BufferManager->UpdateBuffer(buffer, data);
 	}
 
+	void GraphicsDevice::FreeBuffer(Buffer& buffer) {
+		m_BufferManager->FreeBuffer(buffer);
+	}
+
+	BufferManager::TransientAllocation GraphicsDevice::AllocateTransient(size_t size) {
+		return m_BufferManager->AllocateTransient(size);
+	}
+
 	void GraphicsDevice::CreateTexture(ImageDescription& desc, Texture& texture, Texture::TextureType textureType, void* initialData, size_t dataSize) {
 		texture.Description = desc;
 
@@ -1943,6 +1965,60 @@ namespace Graphics {
 		CreateImageSampler(texture);
 	}
 
+	void GraphicsDevice::CreateTextures(std::vector<TextureUpload>& uploads) {
+		RequireUploads(CreateTexturesAsync(uploads));
+	}
+
+	uint64_t GraphicsDevice::CreateTexturesAsync(std::vector<TextureUpload>& uploads) {
+		for (TextureUpload& upload : uploads) {
+			GPUImage& image = *upload.Target;
+			image.Description = upload.Description;
+
+			if (image.Description.MipLevels > 1 && upload.LevelOffsets.empty()) {
+				VkFormatProperties formatProperties;
+				vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, image.Description.Format, &formatProperties);
+
+				if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+					throw std::runtime_error("Texture image format does not support linear blitting!");
+				}
+			}
+
+			CreateImage(image);
+			CreateImageView(image);
+		}
+
+		uint64_t ticket = m_AsyncUploader->UploadTextures(uploads);
+
+		// the copies start right away, the acquire waits for whoever requires them
+		m_AsyncUploader->Submit();
+
+		for (TextureUpload& upload : uploads)
+			CreateImageSampler(*upload.Target);
+
+		return ticket;
+	}
+
+	uint64_t GraphicsDevice::WriteBufferAsync(GPUBuffer& buffer, const void* data, size_t size, size_t offset) {
+		return m_AsyncUploader->UploadBuffer(buffer, data, std::min(buffer.Description.Capacity, size), offset);
+	}
+
+	uint64_t GraphicsDevice::SubmitAsyncUploads() {
+		return m_AsyncUploader->Submit();
+	}
+
+	void GraphicsDevice::RequireUploads(uint64_t ticket) {
+		m_AsyncUploader->Require(ticket);
+	}
+
+	void GraphicsDevice::SubmitGraphicsUploads() {
+		m_AsyncUploader->Acquire(*m_StagingRing);
+		m_StagingRing->Submit();
+	}
+
+	void GraphicsDevice::SubmitUploads() {
+		SubmitGraphicsUploads();
+	}
+
 	void GraphicsDevice::CreateRenderPass(RenderPass& renderPass) {
 	
 		std::vector<VkAttachmentReference> colorAttachmentReferences;
@@ -2576,6 +2652,27 @@ namespace Graphics {
 		vkUpdateDescriptorSets(m_LogicalDevice, 1, &descriptorWrite, 0, nullptr);
 	}
 
+	void GraphicsDevice::WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, const BufferManager::TransientAllocation& allocation) {
+
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = allocation.Handle;
+		bufferInfo.offset = allocation.Offset;
+		bufferInfo.range = allocation.Size;
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSet;
+		descriptorWrite.dstBinding = binding.binding;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = binding.descriptorType;
+		descriptorWrite.descriptorCount = binding.descriptorCount;
+		descriptorWrite.pBufferInfo = &bufferInfo;
+		descriptorWrite.pImageInfo = nullptr;
+		descriptorWrite.pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(m_LogicalDevice, 1, &descriptorWrite, 0, nullptr);
+	}
+
 	void GraphicsDevice::WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, std::vector<Texture>& textures) {
 
 		if (textures.size() == 0)
@@ -2714,6 +2811,10 @@ namespace Graphics {
 		}
 	}
 
+	// everything but the source, stage and preamble that changes the SPIR-V, part of the shader cache key
+	static const EShMessages	c_ShaderMessages		= (EShMessages)(EShMsgSpvRules | EShMsgVulkanRules);
+	static const int			c_ShaderDefaultVersion	= 100;
+
 	static void InitResources(TBuiltInResource &Resources) {
 		Resources.maxLights = 32;
 		Resources.maxClipPlanes = 6;
@@ -2819,8 +2920,6 @@ namespace Graphics {
 	}
 
 	bool GraphicsDevice::CompileShader(Shader& shader) {
-		glslang::InitializeProcess();
-
 		EShLanguage stage = FindLanguage(shader);
 
 		glslang::TShader compiledShader(stage);
@@ -2831,12 +2930,15 @@ namespace Graphics {
 		TBuiltInResource resources = {};
 		InitResources(resources);
 
-		EShMessages messages = (EShMessages)(EShMsgSpvRules | EShMsgVulkanRules);
+		EShMessages messages = c_ShaderMessages;
 
 		shaderStrings[0] = shader.sourceCode.data();
 		compiledShader.setStrings(shaderStrings, 1);
 
-		if (!compiledShader.parse(&resources, 100, false, messages)) {
+		if (!shader.preamble.empty())
+			compiledShader.setPreamble(shader.preamble.c_str());
+
+		if (!compiledShader.parse(&resources, c_ShaderDefaultVersion, false, messages)) {
 			std::cout << compiledShader.getInfoLog() << '\n';
 			std::cout << compiledShader.getInfoDebugLog() << '\n';
 			return false;
@@ -2852,35 +2954,127 @@ namespace Graphics {
 
 		glslang::GlslangToSpv(*program.getIntermediate(stage), shader.spirv);
 
-		glslang::FinalizeProcess();
-
 		return true;
 	}
 #endif
 
-	void GraphicsDevice::LoadShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename) {
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	void GraphicsDevice::LoadShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename, const std::vector<std::string>& defines) {
+		WaitForShader(shader);
+
+		PrepareShader(shaderStage, shader, defines);
+		BuildShader(shader, filename);
+	}
+
+	std::shared_future<void> GraphicsDevice::LoadShaderAsync(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename, const std::vector<std::string>& defines) {
+		WaitForShader(shader);
+
+		PrepareShader(shaderStage, shader, defines);
+
+		shader.ready = m_ShaderCompiler->Enqueue([this, &shader, filename]() {
+			BuildShader(shader, filename);
+		});
+
+		return shader.ready;
+	}
+
+	void GraphicsDevice::WaitForShader(const Shader& shader) {
+		// a copy per caller, pipelines of one batch may wait for the same shader on several threads
+		std::shared_future<void> ready = shader.ready;
+
+		// rethrows what the load threw (e.g. a missing file)
+		if (ready.valid())
+			ready.get();
+	}
+
+	// Note: Looks for an OpDecorate with SpecId in the SPIR-V. A binary compiled before the shader declared its 
+	// constant_ids gives the same pipeline for every value, specializing it would only build duplicates.
+	bool GraphicsDevice::HasSpecializationConstants(const Shader& shader) {
+		constexpr uint32_t OP_DECORATE			= 71;
+		constexpr uint32_t DECORATION_SPEC_ID	= 1;
+
+		WaitForShader(shader);
+
+		// compiled at runtime into 'spirv', or read as it is into 'sourceCode'
+		const uint32_t* words	= shader.spirv.data();
+		size_t count			= shader.spirv.size();
 
+		if (shader.spirv.empty()) {
+			words	= reinterpret_cast<const uint32_t*>(shader.sourceCode.data());
+			count	= shader.sourceCode.size() / sizeof(uint32_t);
+		}
+
+		// after the 5 word header every instruction starts with its word count << 16 | opcode
+		for (size_t i = 5; i < count;) {
+			const uint32_t length = words[i] >> 16;
+			const uint32_t opcode = words[i] & 0xFFFF;
+
+			if (length == 0)
+				break;
+
+			if (opcode == OP_DECORATE && length >= 4 && i + 2 < count && words[i + 2] == DECORATION_SPEC_ID)
+				return true;
+
+			i += length;
+		}
+
+		return false;
+	}
+
+	void GraphicsDevice::PrepareShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::vector<std::string>& defines) {
 		shader.stage = shaderStage;
 		shader.shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shader.shaderStageInfo.stage = shaderStage;
 		shader.shaderStageInfo.pName = "main";
 		
+		shader.preamble.clear();
+
+		for (const auto& define : defines)
+			shader.preamble += "#define " + define + "\n";
+	}
+
+	// Note: Runs on the shader compiler threads for LoadShaderAsync, only touches 'shader'. The log line is put 
+	// together first so the lines of concurrent loads don't interleave.
+	void GraphicsDevice::BuildShader(Shader& shader, const std::string& filename) {
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+
 		shader.sourceCode = ReadFile(filename);
+
+		std::ostringstream log;
 #ifdef RUNTIME_SHADER_COMPILATION
-		std::cout << "Compiling shader: " << filename << '\n';
+		Timestep compileBegin = glfwGetTime();
+
+		const uint64_t options	= static_cast<uint64_t>(c_ShaderDefaultVersion) << 32 | static_cast<uint64_t>(c_ShaderMessages);
+		const uint64_t key		= ShaderCache::GetShaderKey(filename, shader.sourceCode, shader.stage, shader.preamble, options);
+
+		if (ShaderCache::Read(key, shader.spirv)) {
+			Timestep compileEnd = glfwGetTime();
+
+			log << "Loaded cached shader: " << filename << " (" << compileEnd.GetMilliseconds() - compileBegin.GetMilliseconds() << " ms)\n";
+		}
+		else {
+			bool compiled = CompileShader(shader);
+			assert(compiled);
 
-		assert(CompileShader(shader));
+			if (compiled)
+				ShaderCache::Write(key, shader.spirv);
+
+			Timestep compileEnd = glfwGetTime();
+
+			log << "Compiled shader: " << filename << " (" << compileEnd.GetMilliseconds() - compileBegin.GetMilliseconds() << " ms)\n";
+		}
 
 		createInfo.codeSize = shader.spirv.size() * sizeof(unsigned int);
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(shader.spirv.data());
 #else
-		std::cout << "Loading pre-compiled shader: " << filename << '\n';
+		log << "Loading pre-compiled shader: " << filename << '\n';
 		// already contains the SPIRV code
 		createInfo.codeSize = shader.sourceCode.size();
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(shader.sourceCode.data());
 #endif
+		std::cout << log.str();
+
+		shader.codeHash = Helper::hash_bytes(createInfo.pCode, createInfo.codeSize);
 	
 		VkResult result = vkCreateShaderModule(m_LogicalDevice, &createInfo, nullptr, &shader.shaderModule);
 		assert(result == VK_SUCCESS);
@@ -2889,6 +3083,11 @@ namespace Graphics {
 	}
 
 	void GraphicsDevice::DestroyShader(Shader& shader) {
+		if (shader.ready.valid())
+			shader.ready.wait();
+
+		shader.ready = {};
+
 		if (shader.shaderModule == VK_NULL_HANDLE)
 			return;
 
@@ -2899,12 +3098,153 @@ namespace Graphics {
 
 		shader.shaderModule = VK_NULL_HANDLE;
 		shader.shaderStageInfo.module = VK_NULL_HANDLE;
+		shader.codeHash = 0;
 	}
 
 	void GraphicsDevice::CreatePipelineState(PipelineStateDescription& desc, PipelineState& pso, const IRenderTarget& renderTarget) {
 
 		std::cout << "PSO Name: " << desc.Name << '\n';
 
+		BuildPipelineState(desc, pso, renderTarget);
+	}
+
+	void GraphicsDevice::CreatePipelineStates(const std::vector<PipelineStateRequest>& requests) {
+		for (const PipelineStateRequest& request : requests)
+			std::cout << "PSO Name: " << request.Description->Name << '\n';
+
+		Utils::ParallelFor(requests.size(), [&](size_t i) {
+			BuildPipelineState(*requests[i].Description, *requests[i].PSO, *requests[i].RenderTarget);
+		});
+	}
+
+	static void AddKeyBytes(std::vector<uint8_t>& fields, const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		fields.insert(fields.end(), bytes, bytes + size);
+	}
+
+	// everything BuildPipelineState reads from the description, Name and pipelineExtent aren't. Shaders count by their
+	// code, a reloaded or destroyed and recreated Shader never hits a pipeline built from what it held before.
+	static void AddPipelineStateDescription(const PipelineStateDescription& desc, std::vector<uint8_t>& fields) {
+		auto add = [&fields](const auto& value) { AddKeyBytes(fields, &value, sizeof(value)); };
+
+		for (const Shader* shader : { desc.vertexShader, desc.fragmentShader, desc.geometryShader, desc.computeShader, desc.tessellationControlShader, desc.tessellationEvaluationShader })
+			add(shader ? shader->codeHash : 0);
+
+		add(desc.noVertex);
+		add(desc.vertexLayout);
+		add(desc.depthTestEnable);
+		add(desc.depthWriteEnable);
+		add(desc.stencilTestEnable);
+		add(desc.colorBlendingEnable);
+		add(desc.stencilState);
+		add(desc.topology);
+		add(desc.polygonMode);
+		add(desc.cullMode);
+		add(desc.frontFace);
+		add(desc.lineWidth);
+		add(desc.attachmentCount);
+		add(desc.tessellationPatchControlPoints);
+
+		// every variable length list is preceded by its size, two descriptions never write the same bytes
+		add(desc.psoInputLayout.size());
+
+		for (const InputLayout& inputLayout : desc.psoInputLayout) {
+			add(inputLayout.pushConstants.size());
+			add(inputLayout.bindings.size());
+
+			for (const VkPushConstantRange& range : inputLayout.pushConstants)
+				add(range);
+
+			for (const VkDescriptorSetLayoutBinding& binding : inputLayout.bindings) {
+				add(binding.binding);
+				add(binding.descriptorType);
+				add(binding.descriptorCount);
+				add(binding.stageFlags);
+			}
+		}
+
+		add(desc.specializationConstants.size());
+		AddKeyBytes(fields, desc.specializationConstants.data(), desc.specializationConstants.size() * sizeof(uint32_t));
+
+		const uint32_t blendAttachments = desc.attachmentCount > 1 ? std::min<uint32_t>(desc.attachmentCount, 6) : 1;
+
+		for (uint32_t i = 0; i < blendAttachments; i++)
+			add(desc.attachmentCount > 1 ? desc.colorBlendingDescArray[i] : desc.colorBlendingDesc);
+	}
+
+	// Note: Render passes are compatible when their attachments match in format and sample count (load/store ops and
+	// layouts don't matter), a pipeline created with one can be used with any other of the same class.
+	static void AddRenderPassCompatibility(const IRenderTarget& renderTarget, std::vector<uint8_t>& fields) {
+		const RenderPass& renderPass = renderTarget.GetRenderPass();
+
+		auto add = [&fields](const auto& value) { AddKeyBytes(fields, &value, sizeof(value)); };
+
+		add(renderTarget.GetColorAttachmentCount());
+		add(renderPass.Attachments.size());
+
+		for (const VkAttachmentDescription& attachment : renderPass.Attachments) {
+			add(attachment.format);
+			add(attachment.samples);
+		}
+
+		// targets whose render pass wasn't built from the attachment list
+		if (renderPass.Attachments.empty()) {
+			add(renderPass.Description.Flags & (eColorAttachment | eDepthAttachment | eResolveAttachment));
+			add(renderPass.Description.ColorImageFormat);
+			add(renderPass.Description.DepthImageFormat);
+			add(renderPass.Description.SampleCount);
+		}
+	}
+
+	// Note: The lock is only held for the lookup and the insert, pipelines of different keys build at the same time. Two
+	// threads missing the same key both build it, the one inserting second destroys its copy and returns the first.
+	const PipelineState& GraphicsDevice::GetPipelineState(const PipelineStateDescription& desc, const IRenderTarget& renderTarget) {
+		// the key needs the code of every shader
+		for (const Shader* shader : { desc.vertexShader, desc.fragmentShader, desc.geometryShader, desc.computeShader, desc.tessellationControlShader, desc.tessellationEvaluationShader }) {
+			if (shader)
+				WaitForShader(*shader);
+		}
+
+		PipelineStateKey key = {};
+		AddPipelineStateDescription(desc, key.Fields);
+		AddRenderPassCompatibility(renderTarget, key.Fields);
+
+		key.Hash = Helper::hash_bytes(key.Fields.data(), key.Fields.size());
+
+		{
+			std::lock_guard<std::mutex> lock(m_PipelineStatesMutex);
+
+			auto it = m_PipelineStates.find(key);
+
+			if (it != m_PipelineStates.end())
+				return it->second;
+		}
+
+		std::cout << "PSO Name: " << desc.Name << '\n';
+
+		PipelineState pso = {};
+		BuildPipelineState(desc, pso, renderTarget);
+
+		std::lock_guard<std::mutex> lock(m_PipelineStatesMutex);
+
+		// elements of an unordered_map never move, the reference stays valid while others are inserted
+		auto [it, inserted] = m_PipelineStates.try_emplace(std::move(key), std::move(pso));
+
+		if (!inserted)
+			DestroyPipeline(pso);
+
+		return it->second;
+	}
+
+	// Note: Only reads 'desc' and touches nothing but 'pso' and the (internally synchronized) pipeline cache, so 
+	// CreatePipelineStates can run it on several threads at once.
+	void GraphicsDevice::BuildPipelineState(const PipelineStateDescription& desc, PipelineState& pso, const IRenderTarget& renderTarget) {
+
+		for (const Shader* shader : { desc.vertexShader, desc.fragmentShader, desc.geometryShader, desc.computeShader, desc.tessellationControlShader, desc.tessellationEvaluationShader }) {
+			if (shader)
+				WaitForShader(*shader);
+		}
+
 		pso.inputAssembly.sType						= VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 		pso.inputAssembly.topology					= desc.topology;
 		pso.inputAssembly.primitiveRestartEnable	= VK_FALSE;
@@ -2946,16 +3286,18 @@ namespace Graphics {
 		pso.colorBlending.logicOp			= VK_LOGIC_OP_COPY;
 		pso.colorBlending.attachmentCount	= desc.attachmentCount;
 
-		if (desc.attachmentCount > 1) {
-			for (uint32_t i = 0; i < desc.attachmentCount; ++i)
-				desc.colorBlendingDescArray[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		// a copy with every channel written, the description may be shared by requests built at the same time
+		std::array<VkPipelineColorBlendAttachmentState, 6> colorBlendAttachments = {};
 
-			pso.colorBlending.pAttachments = desc.colorBlendingDescArray.data();
-		}
-		else {
-			pso.colorBlending.pAttachments = &desc.colorBlendingDesc;
-			desc.colorBlendingDesc.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		}
+		if (desc.attachmentCount > 1)
+			colorBlendAttachments = desc.colorBlendingDescArray;
+		else
+			colorBlendAttachments[0] = desc.colorBlendingDesc;
+
+		for (uint32_t i = 0; i < desc.attachmentCount; ++i)
+			colorBlendAttachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+		pso.colorBlending.pAttachments = colorBlendAttachments.data();
 
 //		pso.colorBlending.pAttachments		= desc.attachmentCount == 1 ? &desc.colorBlendingDesc : desc.colorBlendingDescArray.data();
 		pso.colorBlending.blendConstants[0] = 0.0f;
@@ -2975,8 +3317,7 @@ namespace Graphics {
 
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 
-		VkVertexInputBindingDescription bindingDescription						= Assets::Vertex::GetBindingDescription();
-		std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions	= Assets::Vertex::GetAttributeDescriptions();
+		Assets::VertexInputDescription vertexInput = Assets::GetVertexInputDescription(static_cast<Assets::VertexLayout>(desc.vertexLayout));
 
 		if (desc.vertexShader) {
 
@@ -2987,9 +3328,9 @@ namespace Graphics {
 			}
 			else {
 				pso.vertexInputInfo.vertexBindingDescriptionCount	= 1;
-				pso.vertexInputInfo.pVertexBindingDescriptions		= &bindingDescription;
-				pso.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-				pso.vertexInputInfo.pVertexAttributeDescriptions	= attributeDescriptions.data();
+				pso.vertexInputInfo.pVertexBindingDescriptions		= &vertexInput.Binding;
+				pso.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInput.Attributes.size());
+				pso.vertexInputInfo.pVertexAttributeDescriptions	= vertexInput.Attributes.data();
 			}
 			pso.pipelineInfo.pVertexInputState = &pso.vertexInputInfo;
 			
@@ -3016,9 +3357,24 @@ namespace Graphics {
 			shaderStages.push_back(desc.geometryShader->shaderStageInfo);
         }
 
-		for (auto stage : shaderStages) {
-			stage.pNext = nullptr;
-			stage.pSpecializationInfo = nullptr;
+		std::vector<VkSpecializationMapEntry> specializationEntries(desc.specializationConstants.size());
+
+		for (uint32_t i = 0; i < specializationEntries.size(); i++) {
+			specializationEntries[i].constantID = i;
+			specializationEntries[i].offset		= i * sizeof(uint32_t);
+			specializationEntries[i].size		= sizeof(uint32_t);
+		}
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount		= static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries			= specializationEntries.data();
+		specializationInfo.dataSize				= desc.specializationConstants.size() * sizeof(uint32_t);
+		specializationInfo.pData				= desc.specializationConstants.data();
+
+		// ids a stage doesn't declare are ignored, so every stage gets the same constants
+		for (auto& stage : shaderStages) {
+			stage.pNext					= nullptr;
+			stage.pSpecializationInfo	= specializationEntries.empty() ? nullptr : &specializationInfo;
 		}
 
 		pso.depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
@@ -3103,18 +3459,37 @@ namespace Graphics {
             tessellationDomainOriginCreateInfo.domainOrigin = VK_TESSELLATION_DOMAIN_ORIGIN_UPPER_LEFT;
             */
 
-            VkPipelineTessellationStateCreateInfo tessellationCreateInfo = {};
-            tessellationCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
-            tessellationCreateInfo.pNext = 0;
-            tessellationCreateInfo.flags = 0;
-            tessellationCreateInfo.patchControlPoints = desc.tessellationPatchControlPoints;
+            pso.tessellationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+            pso.tessellationInfo.pNext = 0;
+            pso.tessellationInfo.flags = 0;
+            pso.tessellationInfo.patchControlPoints = desc.tessellationPatchControlPoints;
 
-            pso.pipelineInfo.pTessellationState = &tessellationCreateInfo;
+            pso.pipelineInfo.pTessellationState = &pso.tessellationInfo;
         }
 
-		result = vkCreateGraphicsPipelines(m_LogicalDevice, VK_NULL_HANDLE, 1, &pso.pipelineInfo, nullptr, &pso.pipeline);
+		result = vkCreateGraphicsPipelines(m_LogicalDevice, m_PipelineCache->GetHandle(), 1, &pso.pipelineInfo, nullptr, &pso.pipeline);
 		assert(result == VK_SUCCESS);
 
+		// Note: The create infos stay in the PSO as a record of its state, but the viewport, blend attachments, dynamic
+		// states, stages and vertex input they point to are locals of this function and a PipelineState is copied
+		// around (the pointers into itself would go stale too), so none of them outlives the call.
+		pso.viewportState.pViewports						= nullptr;
+		pso.viewportState.pScissors							= nullptr;
+		pso.colorBlending.pAttachments						= nullptr;
+		pso.vertexInputInfo.pVertexBindingDescriptions		= nullptr;
+		pso.vertexInputInfo.pVertexAttributeDescriptions	= nullptr;
+
+		pso.pipelineInfo.pStages				= nullptr;
+		pso.pipelineInfo.pVertexInputState		= nullptr;
+		pso.pipelineInfo.pInputAssemblyState	= nullptr;
+		pso.pipelineInfo.pTessellationState		= nullptr;
+		pso.pipelineInfo.pViewportState			= nullptr;
+		pso.pipelineInfo.pRasterizationState	= nullptr;
+		pso.pipelineInfo.pMultisampleState		= nullptr;
+		pso.pipelineInfo.pDepthStencilState		= nullptr;
+		pso.pipelineInfo.pColorBlendState		= nullptr;
+		pso.pipelineInfo.pDynamicState			= nullptr;
+
 		pso.description = desc;
 	}
 
@@ -9,10 +9,19 @@
 #include <algorithm>
 #include <assert.h>
 #include <memory>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 
 #include "VulkanHeader.h"
 #include "Window.h"
 #include "Graphics.h"
+#include "StagingRing.h"
+#include "AsyncUploader.h"
+#include "PipelineCache.h"
+#include "ShaderCompiler.h"
+#include "MemoryAllocator.h"
+#include "BufferManager.h"
 
 #include "../Assets/Mesh.h"
 
@@ -34,6 +43,7 @@ namespace Graphics {
 		std::optional<uint32_t>graphicsFamily;
 		std::optional<uint32_t>presentFamily;
 		std::optional<uint32_t>graphicsAndComputeFamily;
+		std::optional<uint32_t>transferFamily;		// the graphics family when there's no other one
 
 		bool isComplete() {
 			return graphicsFamily.has_value() && presentFamily.has_value() && graphicsAndComputeFamily.has_value();
@@ -50,6 +60,9 @@ namespace Graphics {
 		"VK_LAYER_KHRONOS_validation"
 	};
 
+	// relative to the working directory, like the pre-compiled shaders
+	const char* const c_PipelineCachePath = "pipeline.cache";
+
 	VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger);
 	void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator);
 	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -128,6 +141,15 @@ namespace Graphics {
 
 		std::vector<char> sourceCode;
 		std::vector<unsigned int> spirv;
+
+		// of the code the module was created from, pipelines are cached by it instead of the Shader's address
+		uint64_t codeHash = 0;
+
+		// "#define X" lines injected before the source, only used by the runtime compilation
+		std::string preamble;
+
+		// set by LoadShaderAsync, ready once the module exists
+		std::shared_future<void> ready;
 	};
 
 	struct InputLayout {
@@ -144,6 +166,7 @@ namespace Graphics {
 		const Shader* tessellationEvaluationShader  = nullptr;
 
 		bool noVertex					= false;
+		uint8_t vertexLayout			= 0;		// Assets::VertexLayout, picks the vertex input when noVertex is false
 		bool depthTestEnable			= true;
 		bool depthWriteEnable			= true;
 		bool stencilTestEnable			= false;
@@ -161,6 +184,10 @@ namespace Graphics {
 
 		std::vector<InputLayout> psoInputLayout;
 
+		// constant_id i of every stage is set to specializationConstants[i] (32 bit scalars, bools as VkBool32),
+		// empty keeps the defaults declared in the shaders
+		std::vector<uint32_t> specializationConstants;
+
 		std::string Name;
 
 		uint32_t attachmentCount = 1;
@@ -199,6 +226,38 @@ namespace Graphics {
 		PipelineStateDescription description = {};
 	};
 
+	// One pipeline of a CreatePipelineStates batch, everything pointed to must stay alive until it returns.
+	struct PipelineStateRequest {
+		const PipelineStateDescription*	Description		= nullptr;
+		PipelineState*					PSO				= nullptr;
+		const IRenderTarget*			RenderTarget	= nullptr;
+	};
+
+	// Note: Everything GetPipelineState builds a cached pipeline from, written field after field (shaders by the hash of
+	// their code). Equal hashes still compare the fields, a collision builds its own pipeline instead of returning the
+	// other one.
+	struct PipelineStateKey {
+		std::vector<uint8_t>	Fields;
+		uint64_t				Hash	= 0;
+
+		bool operator==(const PipelineStateKey& other) const { return Hash == other.Hash && Fields == other.Fields; }
+	};
+
+	struct PipelineStateKeyHasher {
+		size_t operator()(const PipelineStateKey& key) const { return static_cast<size_t>(key.Hash); }
+	};
+
+	// Note: One texture of a batched upload, the data must stay alive until GraphicsDevice::CreateTextures (or
+	// CreateTexturesAsync) returns.
+	// With 'LevelOffsets' the data already holds every mip level (e.g. block compressed) and nothing is blitted.
+	struct TextureUpload {
+		Texture*				Target		= nullptr;
+		ImageDescription		Description = {};
+		const void*				Data		= nullptr;
+		size_t					DataSize	= 0;
+		std::vector<uint64_t>	LevelOffsets;
+	};
+
 	struct Frame {
 		VkFence renderFence;
 
@@ -211,8 +270,6 @@ namespace Graphics {
 		VkDescriptorSet bindlessSet;
 	};
 
-	class BufferManager;
-
 	class GraphicsDevice {
 	public:
 		GraphicsDevice(Window& window);
@@ -258,6 +315,7 @@ namespace Graphics {
 		void TransitionImageLayout(const VkImage& image, const VkImageLayout oldLayout, const VkImageLayout newLayout, const VkImageSubresourceRange subresourceRange, const VkAccessFlags srcAccessMask, const VkAccessFlags dstAccessMask, const VkPipelineStageFlags srcPipelineStage, const VkPipelineStageFlags dstPipelineStage);
 		void TransitionCubeImageLayout(GPUImage& cubeImage, VkImageLayout newLayout);
 		void GenerateMipMaps(GPUImage& image);
+		void RecordMipMaps(const VkCommandBuffer& commandBuffer, GPUImage& image);
 		void CreateImageSampler(GPUImage& image);
 		void ResizeImage(GPUImage& image, uint32_t width, uint32_t height);
 		void CopyBufferToImage(GPUImage& image, GPUBuffer& srcBuffer);
@@ -289,8 +347,37 @@ namespace Graphics {
 		void UpdateBuffer(Buffer& buffer, void* data);
 		void WriteBuffer(GPUBuffer& buffer, const void* data, size_t size = 0, size_t offset = 0);
 		void WriteSubBuffer(Buffer& buffer, void* data, size_t dataSize);
+		void FreeBuffer(Buffer& buffer);
+
+		// Note: Per draw constants for the frame being recorded, the range stays untouched until the frame is done on
+		// the GPU. The buffer behind it may change from frame to frame, bind it with the allocation's handle and offset.
+		BufferManager::TransientAllocation AllocateTransient(size_t size);
 
 		void CreateTexture(ImageDescription& desc, Texture& texture, Texture::TextureType textureType, void* initialData, size_t dataSize);
+		// Note: Creates every texture of the batch through the transfer queue in one submission (CreateTexturesAsync),
+		// usable right away: the next graphics submission waits for the copies on the GPU, the CPU never does.
+		void CreateTextures(std::vector<TextureUpload>& uploads);
+
+		// Note: WriteBuffer and UploadDataToImage stage through the ring and only record their copies, the open batch 
+		// goes out with the next submission to the graphics queue (or right away with SubmitUploads).
+		void SubmitUploads();
+		const StagingRing::Stats& GetStagingStats() const { return m_StagingRing->GetStats(); }
+
+		// Note: Uploads on the transfer queue, see AsyncUploader. They return a ticket and never wait; the resources may
+		// only be used by the GPU once their ticket was passed to RequireUploads, the next graphics submission then waits
+		// for the copies (on the GPU) and takes the resources over. IsUploadComplete tells when that wait costs nothing.
+		// Buffers must be device local with TRANSFER_DST, and must not be used before their ticket is required.
+		uint64_t CreateTexturesAsync(std::vector<TextureUpload>& uploads);
+		uint64_t WriteBufferAsync(GPUBuffer& buffer, const void* data, size_t size, size_t offset = 0);
+		uint64_t SubmitAsyncUploads();
+		bool IsUploadComplete(uint64_t ticket) { return m_AsyncUploader->IsComplete(ticket); }
+		void RequireUploads(uint64_t ticket);
+		const StagingRing::Stats& GetAsyncStagingStats() const { return m_AsyncUploader->GetStagingStats(); }
+		AsyncUploader::Stats GetAsyncUploadStats() const { return m_AsyncUploader->GetStats(); }
+		bool HasTransferQueue() const { return m_AsyncUploader->HasDedicatedQueue(); }
+
+		// per memory heap, every image and buffer of the device is sub allocated by the MemoryAllocator
+		std::vector<MemoryAllocator::HeapStats> GetMemoryStats() const { return m_MemoryAllocator->GetHeapStats(); }
 
 		void CopyBuffer(GPUBuffer& srcBuffer, GPUBuffer& dstBuffer, VkDeviceSize size, size_t srcOffset, size_t dstOffset);
 		void DestroyBuffer(GPUBuffer& buffer);
@@ -323,6 +410,7 @@ namespace Graphics {
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet);
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, const GPUBuffer& buffer);
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, const Buffer& buffer);
+		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, const BufferManager::TransientAllocation& allocation);
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, std::vector<Texture>& textures);
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, Texture& texture);
 		void WriteDescriptor(const VkDescriptorSetLayoutBinding binding, const VkDescriptorSet& descriptorSet, const GPUImage& image);
@@ -338,9 +426,32 @@ namespace Graphics {
 #endif
 
 		std::vector<char> ReadFile(const std::string& filename);
-		void LoadShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename);
+		// Note: 'defines' are only applied when compiling at runtime, pre-compiled variants must be built with the 
+		// same defines (glslc -D, see compile.bat) and loaded from their own .spv file.
+		void LoadShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename, const std::vector<std::string>& defines = {});
+
+		// Note: LoadShader on the shader compiler threads, returns right away. Pipelines wait for the shaders they use
+		// when they are created, so a batch of LoadShaderAsync calls followed by the pipelines costs about the slowest
+		// shader. 'shader' must stay alive (and untouched) until it's ready.
+		std::shared_future<void> LoadShaderAsync(VkShaderStageFlagBits shaderStage, Shader& shader, const std::string filename, const std::vector<std::string>& defines = {});
+		void WaitForShader(const Shader& shader);
+
+		// whether the module declares any constant_id, waits for the shader
+		bool HasSpecializationConstants(const Shader& shader);
 		void DestroyShader(Shader& shader);
 		void CreatePipelineState(PipelineStateDescription& desc, PipelineState& pso, const IRenderTarget& renderTarget);
+
+		// Note: Creates every pipeline of the batch on worker threads, the calling thread included, and returns once they
+		// all exist. Pipelines go through the device wide pipeline cache (see PipelineCache.h) either way, so on a warm 
+		// run most of the time left is the driver looking them up.
+		void CreatePipelineStates(const std::vector<PipelineStateRequest>& requests);
+		VkPipelineCache GetPipelineCache() const { return m_PipelineCache->GetHandle(); }
+
+		// Note: The pipeline of 'desc' for every render target compatible with 'renderTarget' (same attachment formats and
+		// sample counts, same number of color attachments), built the first time it's asked for and owned by the device
+		// from then on. The shaders are keyed by their code, 'desc.Name' is left out. Safe to call from several threads.
+		const PipelineState& GetPipelineState(const PipelineStateDescription& desc, const IRenderTarget& renderTarget);
+
 		void DestroyPipelineLayout(VkPipelineLayout& pipelineLayout);
 		void DestroyPipeline(PipelineState& pso);
 
@@ -359,6 +470,12 @@ namespace Graphics {
 		VkFormat GetDepthFormat()		{ return FindDepthFormat(m_PhysicalDevice); }
 		VkFormat GetDepthOnlyFormat()	{ return VK_FORMAT_D32_SFLOAT; }
 
+		// BC1-BC7 sampling, every supported feature is enabled when the device is created
+		bool SupportsBlockCompression() { return m_SupportsBlockCompression; }
+
+		// every bit of 'features' with optimal tiling
+		bool SupportsFormat(VkFormat format, VkFormatFeatureFlags features);
+
 	public:
 		VkDevice					m_LogicalDevice		= VK_NULL_HANDLE;
 		VkPhysicalDevice			m_PhysicalDevice	= VK_NULL_HANDLE;
@@ -373,8 +490,10 @@ namespace Graphics {
 		VkQueue m_GraphicsQueue;
 		VkQueue m_PresentQueue;
 		VkQueue m_ComputeQueue;
+		VkQueue m_TransferQueue;
 	private:
 		VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
+		bool m_SupportsBlockCompression = false;
 
 		VkDescriptorPool m_DescriptorPool;
 
@@ -385,7 +504,15 @@ namespace Graphics {
 		
 		Frame m_Frames[FRAMES_IN_FLIGHT] = {};
 		
+		std::unique_ptr<MemoryAllocator> m_MemoryAllocator;
 		std::unique_ptr<class BufferManager> m_BufferManager;
+		std::unique_ptr<StagingRing> m_StagingRing;
+		std::unique_ptr<AsyncUploader> m_AsyncUploader;
+		std::unique_ptr<PipelineCache> m_PipelineCache;
+		std::unique_ptr<ShaderCompiler> m_ShaderCompiler;
+
+		std::unordered_map<PipelineStateKey, PipelineState, PipelineStateKeyHasher> m_PipelineStates;
+		std::mutex m_PipelineStatesMutex;
 	
 		Graphics::SwapChain m_SwapChain;
 	private:
@@ -400,6 +527,11 @@ namespace Graphics {
 		
 		void CreateCommandPool(VkCommandPool& commandPool, uint32_t queueFamilyIndex);
 		void CreateCommandBuffer(VkCommandPool& commandPool, VkCommandBuffer& commandBuffer);
+
+		void BuildPipelineState(const PipelineStateDescription& desc, PipelineState& pso, const IRenderTarget& renderTarget);
+
+		void PrepareShader(VkShaderStageFlagBits shaderStage, Shader& shader, const std::vector<std::string>& defines);
+		void BuildShader(Shader& shader, const std::string& filename);
 		
 
 		SwapChainSupportDetails QuerySwapChainSupportDetails(VkPhysicalDevice& device, VkSurfaceKHR& surface);
@@ -412,6 +544,9 @@ namespace Graphics {
 		VkFormat FindDepthOnlyFormat();
 		void CreateSwapChainInternal(VkPhysicalDevice& physicalDevice, VkDevice& logicalDevice, VkSurfaceKHR& surface, SwapChain& swapChain, VkExtent2D currentExtent);
 		void CreateImage(GPUImage& image);
+
+		// the acquires of required async uploads and the staged copies, before any other graphics submission
+		void SubmitGraphicsUploads();
 	};
 
 	inline GraphicsDevice*& GetDevice() {
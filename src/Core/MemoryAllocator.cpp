@@ -0,0 +1,500 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace Graphics {
+
+	static constexpr VkDeviceSize MAX_BLOCK_SIZE				= 256ull * 1024 * 1024;
+	static constexpr VkDeviceSize DEDICATED_RENDER_TARGET_SIZE	= 8ull * 1024 * 1024;
+
+	static inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static inline uint32_t mostSignificantBit(uint64_t value) {
+		return 63 - static_cast<uint32_t>(std::countl_zero(value));
+	}
+
+	TLSF::TLSF(uint64_t size) : m_Size(size & ~static_cast<uint64_t>(GRANULARITY - 1)) {
+		assert(m_Size > 0);
+
+		for (uint32_t fl = 0; fl < FL_COUNT; fl++)
+			std::fill(m_Heads[fl], m_Heads[fl] + SL_COUNT, INVALID_NODE);
+
+		const uint32_t root = NewNode();
+		m_Nodes[root].Size = m_Size;
+
+		InsertFree(root);
+	}
+
+	void TLSF::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+		if (size < (1ull << FL_SHIFT)) {
+			fl = 0;
+			sl = static_cast<uint32_t>(size / ((1ull << FL_SHIFT) / SL_COUNT));
+		}
+		else {
+			const uint32_t msb = mostSignificantBit(size);
+
+			fl = msb - FL_SHIFT + 1;
+			sl = static_cast<uint32_t>(size >> (msb - SL_BITS)) ^ SL_COUNT;
+		}
+	}
+
+	uint32_t TLSF::NewNode() {
+		if (!m_Unused.empty()) {
+			const uint32_t node = m_Unused.back();
+			m_Unused.pop_back();
+
+			m_Nodes[node] = {};
+			return node;
+		}
+
+		m_Nodes.emplace_back();
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+
+	void TLSF::InsertFree(uint32_t node) {
+		uint32_t fl, sl;
+		Mapping(m_Nodes[node].Size, fl, sl);
+
+		Node& n		= m_Nodes[node];
+		n.Free		= true;
+		n.PrevFree	= INVALID_NODE;
+		n.NextFree	= m_Heads[fl][sl];
+
+		if (n.NextFree != INVALID_NODE)
+			m_Nodes[n.NextFree].PrevFree = node;
+
+		m_Heads[fl][sl] = node;
+		m_SLBitmaps[fl] |= 1u << sl;
+		m_FLBitmap |= 1ull << fl;
+	}
+
+	void TLSF::RemoveFree(uint32_t node) {
+		uint32_t fl, sl;
+		Mapping(m_Nodes[node].Size, fl, sl);
+
+		Node& n = m_Nodes[node];
+
+		if (n.PrevFree != INVALID_NODE)
+			m_Nodes[n.PrevFree].NextFree = n.NextFree;
+		else
+			m_Heads[fl][sl] = n.NextFree;
+
+		if (n.NextFree != INVALID_NODE)
+			m_Nodes[n.NextFree].PrevFree = n.PrevFree;
+
+		n.Free = false;
+		n.PrevFree = n.NextFree = INVALID_NODE;
+
+		if (m_Heads[fl][sl] == INVALID_NODE) {
+			m_SLBitmaps[fl] &= ~(1u << sl);
+
+			if (m_SLBitmaps[fl] == 0)
+				m_FLBitmap &= ~(1ull << fl);
+		}
+	}
+
+	// Note: Looks in the first list whose every node fits even with the worst padding, only when there is none every
+	// node that might fit is checked with its actual offset.
+	uint32_t TLSF::FindFree(uint64_t size, uint64_t alignment) {
+		uint64_t request = size + (alignment - GRANULARITY);
+
+		if (request >= (1ull << FL_SHIFT))
+			request += (1ull << (mostSignificantBit(request) - SL_BITS)) - 1;
+
+		uint32_t fl, sl;
+		Mapping(request, fl, sl);
+
+		if (fl < FL_COUNT) {
+			uint32_t slMap = m_SLBitmaps[fl] & (~0u << sl);
+
+			if (slMap == 0) {
+				const uint64_t flMap = fl + 1 < FL_COUNT ? m_FLBitmap & (~0ull << (fl + 1)) : 0;
+
+				if (flMap != 0) {
+					fl = static_cast<uint32_t>(std::countr_zero(flMap));
+					slMap = m_SLBitmaps[fl];
+				}
+			}
+
+			if (slMap != 0)
+				return m_Heads[fl][std::countr_zero(slMap)];
+		}
+
+		Mapping(size, fl, sl);
+
+		for (; fl < FL_COUNT; fl++, sl = 0) {
+			for (uint32_t slMap = m_SLBitmaps[fl] & (~0u << sl); slMap != 0; slMap &= slMap - 1) {
+				for (uint32_t node = m_Heads[fl][std::countr_zero(slMap)]; node != INVALID_NODE; node = m_Nodes[node].NextFree) {
+					const Node& n = m_Nodes[node];
+
+					if (alignUp(n.Offset, alignment) + size <= n.Offset + n.Size)
+						return node;
+				}
+			}
+		}
+
+		return INVALID_NODE;
+	}
+
+	// the first 'size' bytes stay in 'node', the rest becomes the returned node
+	uint32_t TLSF::Split(uint32_t node, uint64_t size) {
+		const uint32_t rest = NewNode();
+
+		Node& n = m_Nodes[node];
+		Node& r = m_Nodes[rest];
+
+		r.Offset	= n.Offset + size;
+		r.Size		= n.Size - size;
+		r.PrevPhys	= node;
+		r.NextPhys	= n.NextPhys;
+
+		if (n.NextPhys != INVALID_NODE)
+			m_Nodes[n.NextPhys].PrevPhys = rest;
+
+		n.NextPhys	= rest;
+		n.Size		= size;
+
+		return rest;
+	}
+
+	void TLSF::Merge(uint32_t node, uint32_t next) {
+		Node& n = m_Nodes[node];
+		const Node& x = m_Nodes[next];
+
+		n.Size += x.Size;
+		n.NextPhys = x.NextPhys;
+
+		if (x.NextPhys != INVALID_NODE)
+			m_Nodes[x.NextPhys].PrevPhys = node;
+
+		m_Unused.push_back(next);
+	}
+
+	bool TLSF::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& node) {
+		assert((alignment & (alignment - 1)) == 0);
+
+		size = alignUp(std::max<uint64_t>(size, 1), GRANULARITY);
+		alignment = std::max<uint64_t>(alignment, GRANULARITY);
+
+		if (size > m_Size - m_Used)
+			return false;
+
+		uint32_t found = FindFree(size, alignment);
+
+		if (found == INVALID_NODE)
+			return false;
+
+		RemoveFree(found);
+
+		// the padding in front stays free, its physical neighbour before is always in use
+		const uint64_t padding = alignUp(m_Nodes[found].Offset, alignment) - m_Nodes[found].Offset;
+
+		if (padding > 0) {
+			const uint32_t rest = Split(found, padding);
+			InsertFree(found);
+			found = rest;
+		}
+
+		if (m_Nodes[found].Size > size)
+			InsertFree(Split(found, size));
+
+		m_Used += size;
+		m_AllocationCount++;
+
+		offset = m_Nodes[found].Offset;
+		node = found;
+
+		return true;
+	}
+
+	void TLSF::Free(uint32_t node) {
+		assert(node < m_Nodes.size() && !m_Nodes[node].Free && "Freed twice");
+
+		m_Used -= m_Nodes[node].Size;
+		m_AllocationCount--;
+
+		const uint32_t prev = m_Nodes[node].PrevPhys;
+
+		if (prev != INVALID_NODE && m_Nodes[prev].Free) {
+			RemoveFree(prev);
+			Merge(prev, node);
+			node = prev;
+		}
+
+		const uint32_t next = m_Nodes[node].NextPhys;
+
+		if (next != INVALID_NODE && m_Nodes[next].Free) {
+			RemoveFree(next);
+			Merge(node, next);
+		}
+
+		InsertFree(node);
+	}
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize bufferImageGranularity, VkDeviceSize nonCoherentAtomSize) :
+		m_Device(device), m_MemoryProperties(memoryProperties), m_SeparateLinear(bufferImageGranularity > 1), m_AtomSize(std::max<VkDeviceSize>(nonCoherentAtomSize, 1)) {
+
+		m_Pools.resize(m_MemoryProperties.memoryTypeCount * (m_SeparateLinear ? 2 : 1));
+	}
+
+	MemoryAllocator::~MemoryAllocator() {
+		for (Pool& pool : m_Pools) {
+			for (std::unique_ptr<Block>& block : pool.Blocks) {
+				if (block)
+					vkFreeMemory(m_Device, block->Memory, nullptr);
+			}
+		}
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++) {
+			if ((typeBits & (1 << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+
+		throw std::runtime_error("Failed to find suitable memory type!");
+	}
+
+	VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryType) const {
+		const VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+		return std::min(MAX_BLOCK_SIZE, alignUp(heapSize / 8, 1024));
+	}
+
+	uint32_t MemoryAllocator::GetPoolIndex(uint32_t memoryType, bool linear) const {
+		return m_SeparateLinear ? memoryType * 2 + (linear ? 0 : 1) : memoryType;
+	}
+
+	bool MemoryAllocator::AllocateMemory(VkDeviceSize size, uint32_t memoryType, const void* next, VkDeviceMemory& memory, void*& mapped) {
+		VkMemoryAllocateInfo allocInfo	= {};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext					= next;
+		allocInfo.allocationSize		= size;
+		allocInfo.memoryTypeIndex		= memoryType;
+
+		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+			return false;
+
+		mapped = nullptr;
+
+		if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			VkResult result = vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+			assert(result == VK_SUCCESS);
+		}
+
+		return true;
+	}
+
+	MemoryAllocation MemoryAllocator::AllocateDedicated(VkDeviceSize size, uint32_t memoryType, const VkMemoryDedicatedAllocateInfo& dedicatedInfo) {
+		MemoryAllocation allocation = {};
+		allocation.Size				= size;
+		allocation.MemoryType		= memoryType;
+
+		const bool bound = dedicatedInfo.image != VK_NULL_HANDLE || dedicatedInfo.buffer != VK_NULL_HANDLE;
+
+		if (!AllocateMemory(size, memoryType, bound ? &dedicatedInfo : nullptr, allocation.Memory, allocation.Mapped))
+			throw std::runtime_error("Failed to allocate device memory!");
+
+		const uint32_t heap = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+
+		m_DedicatedCount[heap]++;
+		m_DedicatedBytes[heap] += size;
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated, const VkMemoryDedicatedAllocateInfo& dedicatedInfo) {
+		const uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+		const VkDeviceSize blockSize = GetBlockSize(memoryType);
+
+		if (dedicated || requirements.size > blockSize / 2)
+			return AllocateDedicated(requirements.size, memoryType, dedicatedInfo);
+
+		const uint32_t poolIndex = GetPoolIndex(memoryType, linear);
+		Pool& pool = m_Pools[poolIndex];
+
+		MemoryAllocation allocation = {};
+		allocation.Size				= requirements.size;
+		allocation.MemoryType		= memoryType;
+		allocation.Pool				= poolIndex;
+
+		for (uint32_t i = 0; i < pool.Blocks.size(); i++) {
+			Block* block = pool.Blocks[i].get();
+
+			if (block && block->Metadata.Allocate(requirements.size, requirements.alignment, allocation.Offset, allocation.Node)) {
+				allocation.Memory	= block->Memory;
+				allocation.Mapped	= block->Mapped ? static_cast<char*>(block->Mapped) + allocation.Offset : nullptr;
+				allocation.Block	= i;
+
+				return allocation;
+			}
+		}
+
+		auto block = std::make_unique<Block>(blockSize);
+
+		// the heap may still have room for the resource itself
+		if (!AllocateMemory(blockSize, memoryType, nullptr, block->Memory, block->Mapped))
+			return AllocateDedicated(requirements.size, memoryType, dedicatedInfo);
+
+		bool success = block->Metadata.Allocate(requirements.size, requirements.alignment, allocation.Offset, allocation.Node);
+		assert(success);
+
+		allocation.Memory	= block->Memory;
+		allocation.Mapped	= block->Mapped ? static_cast<char*>(block->Mapped) + allocation.Offset : nullptr;
+
+		auto slot = std::find(pool.Blocks.begin(), pool.Blocks.end(), nullptr);
+
+		if (slot != pool.Blocks.end())
+			*slot = std::move(block);
+		else
+			slot = pool.Blocks.insert(slot, std::move(block));
+
+		allocation.Block = static_cast<uint32_t>(slot - pool.Blocks.begin());
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::AllocateImage(VkImage image, const ImageDescription& description, VkMemoryPropertyFlags properties) {
+		VkMemoryDedicatedRequirements dedicatedRequirements = {};
+		dedicatedRequirements.sType							= VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements	= {};
+		requirements.sType					= VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext					= &dedicatedRequirements;
+
+		VkImageMemoryRequirementsInfo2 info = {};
+		info.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		info.image							= image;
+
+		vkGetImageMemoryRequirements2(m_Device, &info, &requirements);
+
+		// render targets are recreated with the window, keeping them out of the blocks avoids fragmenting them
+		const bool renderTarget = (description.Usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) &&
+			requirements.memoryRequirements.size >= DEDICATED_RENDER_TARGET_SIZE;
+
+		const bool dedicated = renderTarget || dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+
+		VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+		dedicatedInfo.sType							= VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.image							= image;
+
+		MemoryAllocation allocation = Allocate(requirements.memoryRequirements, properties, description.Tiling == VK_IMAGE_TILING_LINEAR, dedicated, dedicatedInfo);
+
+		VkResult result = vkBindImageMemory(m_Device, image, allocation.Memory, allocation.Offset);
+		assert(result == VK_SUCCESS);
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+		VkMemoryDedicatedRequirements dedicatedRequirements = {};
+		dedicatedRequirements.sType							= VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements	= {};
+		requirements.sType					= VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext					= &dedicatedRequirements;
+
+		VkBufferMemoryRequirementsInfo2 info	= {};
+		info.sType								= VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		info.buffer								= buffer;
+
+		vkGetBufferMemoryRequirements2(m_Device, &info, &requirements);
+
+		VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+		dedicatedInfo.sType							= VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.buffer						= buffer;
+
+		MemoryAllocation allocation = Allocate(requirements.memoryRequirements, properties, true, dedicatedRequirements.requiresDedicatedAllocation, dedicatedInfo);
+
+		VkResult result = vkBindBufferMemory(m_Device, buffer, allocation.Memory, allocation.Offset);
+		assert(result == VK_SUCCESS);
+
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(MemoryAllocation& allocation) {
+		if (allocation.Memory == VK_NULL_HANDLE)
+			return;
+
+		if (allocation.Block == MemoryAllocation::DEDICATED) {
+			const uint32_t heap = m_MemoryProperties.memoryTypes[allocation.MemoryType].heapIndex;
+
+			m_DedicatedCount[heap]--;
+			m_DedicatedBytes[heap] -= allocation.Size;
+
+			vkFreeMemory(m_Device, allocation.Memory, nullptr);
+			allocation = {};
+			return;
+		}
+
+		Pool& pool = m_Pools[allocation.Pool];
+		std::unique_ptr<Block>& block = pool.Blocks[allocation.Block];
+
+		assert(block && block->Memory == allocation.Memory);
+
+		block->Metadata.Free(allocation.Node);
+
+		// an empty block stays as long as it is the only one, so a pool doesn't allocate and free a block over and over
+		if (block->Metadata.IsEmpty() && std::count_if(pool.Blocks.begin(), pool.Blocks.end(), [](const auto& b) { return b != nullptr; }) > 1) {
+			vkFreeMemory(m_Device, block->Memory, nullptr);
+			block.reset();
+		}
+
+		allocation = {};
+	}
+
+	void MemoryAllocator::Flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const {
+		if (allocation.Memory == VK_NULL_HANDLE || size == 0)
+			return;
+
+		if (m_MemoryProperties.memoryTypes[allocation.MemoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			return;
+
+		// the range has to start and end on nonCoherentAtomSize (or at the end of the memory object)
+		const VkDeviceSize memorySize = allocation.Block == MemoryAllocation::DEDICATED ? allocation.Size : GetBlockSize(allocation.MemoryType);
+		const VkDeviceSize begin = (allocation.Offset + offset) & ~(m_AtomSize - 1);
+		const VkDeviceSize end = alignUp(allocation.Offset + offset + size, m_AtomSize);
+
+		VkMappedMemoryRange range	= {};
+		range.sType					= VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory				= allocation.Memory;
+		range.offset				= begin;
+		range.size					= end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+
+		VkResult result = vkFlushMappedMemoryRanges(m_Device, 1, &range);
+		assert(result == VK_SUCCESS);
+	}
+
+	std::vector<MemoryAllocator::HeapStats> MemoryAllocator::GetHeapStats() const {
+		std::vector<HeapStats> stats(m_MemoryProperties.memoryHeapCount);
+
+		for (uint32_t heap = 0; heap < m_MemoryProperties.memoryHeapCount; heap++) {
+			stats[heap].Size					= m_MemoryProperties.memoryHeaps[heap].size;
+			stats[heap].Flags					= m_MemoryProperties.memoryHeaps[heap].flags;
+			stats[heap].DedicatedAllocations	= m_DedicatedCount[heap];
+			stats[heap].DedicatedBytes			= m_DedicatedBytes[heap];
+		}
+
+		for (uint32_t i = 0; i < m_Pools.size(); i++) {
+			const uint32_t memoryType = m_SeparateLinear ? i / 2 : i;
+			HeapStats& heap = stats[m_MemoryProperties.memoryTypes[memoryType].heapIndex];
+
+			for (const std::unique_ptr<Block>& block : m_Pools[i].Blocks) {
+				if (!block)
+					continue;
+
+				heap.Blocks++;
+				heap.BlockBytes		+= block->Metadata.GetSize();
+				heap.UsedBytes		+= block->Metadata.GetUsed();
+				heap.Allocations	+= block->Metadata.GetAllocationCount();
+			}
+		}
+
+		return stats;
+	}
+}
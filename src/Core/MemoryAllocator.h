@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "VulkanHeader.h"
+#include "Graphics.h"
+
+namespace Graphics {
+
+	// Note: Two level segregated fit bookkeeping of one memory block, CPU only (no Vulkan calls). Free ranges are kept in
+	// lists by size class (a power of two split into SL_COUNT linear steps), a bitmap per level finds the first list
+	// large enough in constant time. Freed ranges are merged with their free neighbours right away.
+	class TLSF {
+	public:
+		static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+		TLSF(uint64_t size);
+		~TLSF() {};
+
+		// 'alignment' must be a power of two, returns false when no free range fits
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& node);
+		void Free(uint32_t node);
+
+		uint64_t GetSize() const			{ return m_Size; }
+		uint64_t GetUsed() const			{ return m_Used; }
+		uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		bool IsEmpty() const				{ return m_AllocationCount == 0; }
+
+	private:
+		static constexpr uint32_t GRANULARITY	= 16;						// every node size and offset is a multiple of it
+		static constexpr uint32_t SL_BITS		= 5;
+		static constexpr uint32_t SL_COUNT		= 1u << SL_BITS;
+		static constexpr uint32_t FL_SHIFT		= SL_BITS + 4;				// sizes below 1 << FL_SHIFT share the first level
+		static constexpr uint32_t FL_COUNT		= 64 - FL_SHIFT + 1;
+
+		struct Node {
+			uint64_t Offset		= 0;
+			uint64_t Size		= 0;
+			uint32_t PrevPhys	= INVALID_NODE;		// neighbours in the block
+			uint32_t NextPhys	= INVALID_NODE;
+			uint32_t PrevFree	= INVALID_NODE;		// neighbours in the free list of its size class
+			uint32_t NextFree	= INVALID_NODE;
+			bool	 Free		= false;
+		};
+
+		static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+		uint32_t FindFree(uint64_t size, uint64_t alignment);
+		uint32_t NewNode();
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		uint32_t Split(uint32_t node, uint64_t size);
+		void Merge(uint32_t node, uint32_t next);
+
+	private:
+		uint64_t				m_Size				= 0;
+		uint64_t				m_Used				= 0;
+		uint32_t				m_AllocationCount	= 0;
+
+		uint64_t				m_FLBitmap			= 0;
+		uint32_t				m_SLBitmaps[FL_COUNT] = {};
+		uint32_t				m_Heads[FL_COUNT][SL_COUNT];
+
+		std::vector<Node>		m_Nodes;
+		std::vector<uint32_t>	m_Unused;		// recycled node slots
+	};
+
+	// Note: Sub allocates device memory out of large blocks instead of one vkAllocateMemory per resource (drivers cap
+	// the count at maxMemoryAllocationCount and every call is slow). Blocks are 256 MB, or an eighth of heaps smaller than
+	// 2 GB, and are kept per memory type; host visible blocks are mapped once for their whole lifetime. When
+	// bufferImageGranularity is larger than 1, linear resources (buffers, linear images) and optimal images get separate
+	// blocks so they never share a page. Resources larger than half a block, big render targets and whatever the driver
+	// asks for go to dedicated allocations. Empty blocks are released except the last one of each pool.
+	//
+	// Writes through the mapping of memory without HOST_COHERENT only reach the device after Flush().
+	class MemoryAllocator {
+	public:
+		struct HeapStats {
+			VkDeviceSize		Size					= 0;
+			VkMemoryHeapFlags	Flags					= 0;
+			uint32_t			Blocks					= 0;
+			VkDeviceSize		BlockBytes				= 0;	// allocated for blocks
+			VkDeviceSize		UsedBytes				= 0;	// handed out of the blocks
+			uint32_t			Allocations				= 0;	// sub allocations
+			uint32_t			DedicatedAllocations	= 0;
+			VkDeviceSize		DedicatedBytes			= 0;
+		};
+
+		MemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize bufferImageGranularity, VkDeviceSize nonCoherentAtomSize);
+		~MemoryAllocator();
+
+		// queries the requirements, allocates and binds
+		MemoryAllocation AllocateImage(VkImage image, const ImageDescription& description, VkMemoryPropertyFlags properties);
+		MemoryAllocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+
+		void Free(MemoryAllocation& allocation);
+
+		// makes host writes to 'size' bytes at 'offset' in the allocation visible to the device, nothing for coherent memory
+		void Flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+		// the first type of 'typeBits' with every flag of 'properties', throws when there is none
+		uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+		std::vector<HeapStats> GetHeapStats() const;
+
+	private:
+		struct Block {
+			VkDeviceMemory	Memory	= VK_NULL_HANDLE;
+			void*			Mapped	= nullptr;
+			TLSF			Metadata;
+
+			Block(VkDeviceSize size) : Metadata(size) {}
+		};
+
+		// a memory type, split in two when linear and optimal resources can't share blocks
+		struct Pool {
+			std::vector<std::unique_ptr<Block>> Blocks;		// empty slots are reused
+		};
+
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated, const VkMemoryDedicatedAllocateInfo& dedicatedInfo);
+		MemoryAllocation AllocateDedicated(VkDeviceSize size, uint32_t memoryType, const VkMemoryDedicatedAllocateInfo& dedicatedInfo);
+		bool AllocateMemory(VkDeviceSize size, uint32_t memoryType, const void* next, VkDeviceMemory& memory, void*& mapped);
+		VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+		uint32_t GetPoolIndex(uint32_t memoryType, bool linear) const;
+
+	private:
+		VkDevice							m_Device		= VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties	m_MemoryProperties;
+		bool								m_SeparateLinear = false;
+		VkDeviceSize						m_AtomSize		= 1;
+
+		std::vector<Pool>					m_Pools;
+
+		uint32_t							m_DedicatedCount[VK_MAX_MEMORY_HEAPS]	= {};
+		VkDeviceSize						m_DedicatedBytes[VK_MAX_MEMORY_HEAPS]	= {};
+	};
+}
@@ -0,0 +1,165 @@
+#include "PipelineCache.h"
+
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../Utils/Helper.h"
+#include "../Utils/MappedFile.h"
+
+namespace Graphics {
+
+	constexpr uint32_t CACHE_MAGIC		= 0x4f535056;	// "VPSO"
+	constexpr uint32_t CACHE_VERSION	= 1;
+
+	struct Header {
+		uint32_t	Magic				= CACHE_MAGIC;
+		uint32_t	Version				= CACHE_VERSION;
+		uint32_t	VendorID			= 0;
+		uint32_t	DeviceID			= 0;
+		uint32_t	DriverVersion		= 0;
+		uint8_t		PipelineCacheUUID[VK_UUID_SIZE] = {};
+		uint64_t	DataSize			= 0;
+		uint64_t	DataHash			= 0;
+	};
+
+	static Header GetHeader(const VkPhysicalDeviceProperties& properties) {
+		Header header			= {};
+		header.VendorID			= properties.vendorID;
+		header.DeviceID			= properties.deviceID;
+		header.DriverVersion	= properties.driverVersion;
+
+		memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		return header;
+	}
+
+	// the driver checks the header at the start of the data as well, but some don't survive data they didn't write
+	static bool IsCompatible(const VkPhysicalDeviceProperties& properties, const uint8_t* file, size_t fileSize) {
+		if (fileSize < sizeof(Header))
+			return false;
+
+		Header header;
+		memcpy(&header, file, sizeof(Header));
+
+		const Header expected	= GetHeader(properties);
+		const uint8_t* data		= file + sizeof(Header);
+
+		bool valid = header.Magic		== expected.Magic
+			&& header.Version			== expected.Version
+			&& header.VendorID			== expected.VendorID
+			&& header.DeviceID			== expected.DeviceID
+			&& header.DriverVersion		== expected.DriverVersion
+			&& memcmp(header.PipelineCacheUUID, expected.PipelineCacheUUID, VK_UUID_SIZE) == 0
+			&& header.DataSize			== fileSize - sizeof(Header)
+			&& header.DataSize			>= sizeof(VkPipelineCacheHeaderVersionOne);
+
+		if (!valid)
+			return false;
+
+		VkPipelineCacheHeaderVersionOne vkHeader;
+		memcpy(&vkHeader, data, sizeof(VkPipelineCacheHeaderVersionOne));
+
+		valid = vkHeader.headerVersion	== VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& vkHeader.vendorID		== properties.vendorID
+			&& vkHeader.deviceID		== properties.deviceID
+			&& memcmp(vkHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+		return valid && header.DataHash == Helper::hash_bytes(data, header.DataSize);
+	}
+
+	PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path)
+		: m_Device(device), m_Properties(properties), m_Path(path) {
+
+		Utils::MappedFile file;
+
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		if (file.Open(m_Path)) {
+			if (IsCompatible(m_Properties, file.GetData(), file.GetSize())) {
+				cacheInfo.initialDataSize	= file.GetSize() - sizeof(Header);
+				cacheInfo.pInitialData		= file.GetData() + sizeof(Header);
+			}
+			else {
+				std::cout << "Pipeline cache " << m_Path << " was written by another device or driver, starting empty\n";
+			}
+		}
+
+		VkResult result = vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache);
+
+		// the driver may still refuse data it wrote itself (e.g. a corrupted file with a matching hash)
+		if (result != VK_SUCCESS && cacheInfo.pInitialData != nullptr) {
+			cacheInfo.initialDataSize	= 0;
+			cacheInfo.pInitialData		= nullptr;
+
+			result = vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache);
+		}
+
+		assert(result == VK_SUCCESS);
+
+		m_Loaded = cacheInfo.pInitialData != nullptr;
+
+		std::cout << "Pipeline cache: " << (m_Loaded ? "loaded " : "created ") << m_Path << '\n';
+	}
+
+	PipelineCache::~PipelineCache() {
+		if (m_Cache == VK_NULL_HANDLE)
+			return;
+
+		Save();
+
+		vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+	}
+
+	bool PipelineCache::Save() {
+		size_t size = 0;
+
+		if (vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr) != VK_SUCCESS || size == 0)
+			return false;
+
+		std::vector<uint8_t> data(size);
+
+		if (vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()) != VK_SUCCESS)
+			return false;
+
+		Header header	= GetHeader(m_Properties);
+		header.DataSize = size;
+		header.DataHash = Helper::hash_bytes(data.data(), size);
+
+		// write to a temporary file first so an interrupted write never leaves a truncated cache behind
+		const std::string tempPath = m_Path + ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!stream.is_open()) {
+				std::cout << "Failed to create pipeline cache: " << m_Path << '\n';
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			stream.write(reinterpret_cast<const char*>(data.data()), size);
+
+			if (!stream.good()) {
+				stream.close();
+				std::filesystem::remove(tempPath);
+				std::cout << "Failed to write pipeline cache: " << m_Path << '\n';
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, m_Path, error);
+
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "VulkanHeader.h"
+
+namespace Graphics {
+
+	// Note: The device wide VkPipelineCache, loaded from disk when created and written back when destroyed so warm
+	// runs get their pipelines out of the cache instead of compiling them again. The file starts with a header of its
+	// own (vendor, device, driver version and pipelineCacheUUID of the device that wrote it, plus a hash of the data)
+	// and a cache written by any other device or driver is thrown away before it ever reaches the driver.
+	//
+	// vkCreate*Pipelines may be called with it from several threads at once, the cache is synchronized internally.
+	class PipelineCache {
+	public:
+		PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path);
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache& other) = delete;
+		void operator=(const PipelineCache& other) = delete;
+
+		// writes the current content to disk, through a temporary file
+		bool Save();
+
+		VkPipelineCache GetHandle() const	{ return m_Cache; }
+		bool WasLoaded() const				{ return m_Loaded; }
+
+	private:
+		VkDevice					m_Device		= VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties	m_Properties	= {};
+		std::string					m_Path;
+
+		VkPipelineCache				m_Cache			= VK_NULL_HANDLE;
+		bool						m_Loaded		= false;
+	};
+}
@@ -12,6 +12,7 @@ void ShadowRenderer::CleanUp() {
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
 
 	gfxDevice->DestroyPipeline(m_PSO);
+
 	gfxDevice->DestroyShader(m_VertexShader);
 	gfxDevice->DestroyShader(m_GeometryShader);
 	gfxDevice->DestroyShader(m_FragmentShader);
@@ -67,18 +68,26 @@ void ShadowRenderer::Render(const VkCommandBuffer& commandBuffer, const std::vec
 		
 
 	for (int i = 0; i < models.size(); i++) {
-		m_ModelGPUData[i].Model = models[i]->GetModelMatrix();
+		// the shadow pass only reads positions, packed layouts are dequantized through the model matrix
+		m_ModelGPUData[i].Model = models[i]->GetModelMatrix() * models[i]->GetPositionDecodeMatrix();
 	}
 
 	gfxDevice->UpdateBuffer		(m_ShadowMappingUBO[gfxDevice->GetCurrentFrameIndex()], m_ShadowMappingGPUData.data());
 	gfxDevice->UpdateBuffer		(m_ModelUBO[gfxDevice->GetCurrentFrameIndex()],			m_ModelGPUData.data());
 	gfxDevice->BindDescriptorSet(m_Set, commandBuffer, m_PSO.pipelineLayout, 0, 1);
 			
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PSO.pipeline);
+	const Graphics::PipelineState* pipeline = nullptr;
 	
 	for (int i = 0; i < models.size(); i++) {
 		
 		std::shared_ptr<Assets::Model> model = models[i];
+
+		const Graphics::PipelineState* modelPipeline = model->Layout == Assets::tStandardLayout ? &m_PSO : GetPackedPSO(model->Layout);
+
+		if (modelPipeline != pipeline) {
+			pipeline = modelPipeline;
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+		}
 	
 		VkDeviceSize offsets[] = { sizeof(uint32_t) * model->TotalIndices };
 
@@ -103,6 +112,22 @@ void ShadowRenderer::Render(const VkCommandBuffer& commandBuffer, const std::vec
 	m_RenderTarget->End(commandBuffer);
 }
 
+// Note: Built the first time a model with the layout is drawn, nothing pays for them when no model is packed. They 
+// come from the device's pipeline cache, which also destroys them.
+const Graphics::PipelineState* ShadowRenderer::GetPackedPSO(uint8_t layout) {
+	const Graphics::PipelineState*& pso = m_PackedPSOs[layout - 1];
+
+	if (!pso) {
+		Graphics::PipelineStateDescription packedDesc = m_PSODesc;
+		packedDesc.Name			+= " (Packed)";
+		packedDesc.vertexLayout = layout;
+
+		pso = &Graphics::GetDevice()->GetPipelineState(packedDesc, *m_RenderTarget);
+	}
+
+	return pso;
+}
+
 void ShadowRenderer::LoadResources() {
 	m_RenderTarget = std::make_unique<Graphics::DepthOnlyRenderTarget>(m_Width, m_Height, m_Precision, m_Layers);
 
@@ -136,6 +161,7 @@ void ShadowRenderer::LoadResources() {
 	m_PSODesc.psoInputLayout	.push_back(m_PSOInputLayout);
 
 	gfxDevice->CreatePipelineState(m_PSODesc, m_PSO, *m_RenderTarget);
+
 	gfxDevice->CreateDescriptorSet(m_PSO.descriptorSetLayout, m_Set);
 
 	for (int i = 0; i < Graphics::FRAMES_IN_FLIGHT; i++) {
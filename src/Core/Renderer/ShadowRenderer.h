@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "../../Assets/ShadowCamera.h"
+#include "../../Assets/Mesh.h"
 #include "../SceneComponents.h"
 
 #define MAX_MODELS 10
@@ -63,6 +64,7 @@ public:
 
 private:
 	void LoadResources();
+	const Graphics::PipelineState* GetPackedPSO(uint8_t layout);
 private:
 
 	struct ModelGPUData {
@@ -94,6 +96,7 @@ private:
 	Graphics::Buffer					m_ShadowMappingUBO[Graphics::FRAMES_IN_FLIGHT]	= {};
 	Graphics::PipelineStateDescription	m_PSODesc										= {};
 	Graphics::PipelineState				m_PSO											= {};
+	const Graphics::PipelineState*		m_PackedPSOs[Assets::tNumVertexLayouts - 1]		= {};	// same shaders, packed vertex input
 	Graphics::Shader					m_VertexShader									= {};
 	Graphics::Shader					m_GeometryShader								= {};	// for multilayer rendering
 	Graphics::Shader					m_FragmentShader								= {};
@@ -36,6 +36,8 @@ void ResourceManager::Destroy() {
 	}
 
 	m_Textures.clear();
+	m_TextureKeys.clear();
+	m_TextureNames.clear();
 	m_Materials.clear();
 
 	delete m_Instance;
@@ -46,9 +48,9 @@ Graphics::Buffer& ResourceManager::GetMaterialBuffer() {
 }
 
 int ResourceManager::AddTexture(Graphics::Texture texture) {
-	// TODO: Use hash code instead of Name
 
 	if (m_Textures.size() < TEXTURES_LIMIT) {
+		m_TextureNames.emplace(texture.Name, static_cast<int>(m_Textures.size()));
 		m_Textures.push_back(texture);
 
 		return m_Textures.size() - 1;
@@ -59,6 +61,26 @@ int ResourceManager::AddTexture(Graphics::Texture texture) {
 	}
 }
 
+int ResourceManager::AddTexture(Graphics::Texture texture, uint64_t key) {
+	int index = AddTexture(texture);
+
+	if (index != -1)
+		m_TextureKeys[key] = index;
+
+	return index;
+}
+
+int ResourceManager::FindTexture(uint64_t key) {
+	auto it = m_TextureKeys.find(key);
+
+	if (it == m_TextureKeys.end())
+		return -1;
+
+	m_TextureCacheHits++;
+
+	return it->second;
+}
+
 int ResourceManager::AddMaterial(Material material) {
 
 	// TODO: Update buffer when inserting a new material
@@ -89,10 +111,7 @@ int ResourceManager::GetMaterialIndex(const std::string& materialName) {
 }
 
 int ResourceManager::GetTextureIndex(const std::string& textureName) {
-	for (int i = 0; i < m_Textures.size(); i++) {
-		if (m_Textures[i].Name == textureName)
-			return i;
-	}
+	auto it = m_TextureNames.find(textureName);
 
-	return -1;
+	return it == m_TextureNames.end() ? -1 : it->second;
 }
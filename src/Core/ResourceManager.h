@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
 
 #include "./Graphics.h"
 #include "./GraphicsDevice.h"
@@ -21,6 +24,13 @@ public:
 	int AddMaterial(Material material);
 	int AddTexture(Graphics::Texture texture);
 
+	// Note: Shared textures are registered under a key (see TextureLoader::GetTextureKey) so every unique image 
+	// is decoded and uploaded once, FindTexture returns -1 on a miss.
+	int AddTexture(Graphics::Texture texture, uint64_t key);
+	int FindTexture(uint64_t key);
+
+	size_t GetTextureCacheHits() const	{ return m_TextureCacheHits; }
+
 	int GetMaterialIndex(const std::string& materialName);
 	int GetTextureIndex(const std::string& textureName);
 
@@ -37,6 +47,11 @@ private:
 	std::vector<Material> m_Materials;
 	std::vector<Graphics::Texture> m_Textures;
 
+	std::unordered_map<uint64_t, int> m_TextureKeys;
+	std::unordered_map<std::string, int> m_TextureNames;	// first texture of each name
+
+	size_t m_TextureCacheHits = 0;
+
 	Graphics::Buffer m_MaterialUBO;			// double buffer?
 
 	static ResourceManager* m_Instance;
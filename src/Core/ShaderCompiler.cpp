@@ -0,0 +1,78 @@
+#include "ShaderCompiler.h"
+
+#include "../Utils/ParallelFor.h"
+
+namespace Graphics {
+
+	ShaderCompiler::ShaderCompiler(uint32_t workers) {
+		if (workers == 0)
+			workers = Utils::GetWorkerCount();
+
+		m_Workers.reserve(workers);
+
+		for (uint32_t i = 0; i < workers; i++)
+			m_Workers.emplace_back(&ShaderCompiler::Work, this);
+	}
+
+	ShaderCompiler::~ShaderCompiler() {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_JobAdded.notify_all();
+
+		// the queue is drained first, nobody is left waiting on a future that never becomes ready
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	std::shared_future<void> ShaderCompiler::Enqueue(std::function<void()> job) {
+		std::packaged_task<void()> task(std::move(job));
+		std::shared_future<void> future = task.get_future().share();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push_back(std::move(task));
+		}
+
+		m_JobAdded.notify_one();
+
+		return future;
+	}
+
+	void ShaderCompiler::WaitIdle() {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_JobDone.wait(lock, [this]() { return m_Jobs.empty() && m_Running == 0; });
+	}
+
+	void ShaderCompiler::Work() {
+		for (;;) {
+			std::packaged_task<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_JobAdded.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+
+				if (m_Jobs.empty())
+					return;
+
+				task = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+				m_Running++;
+			}
+
+			// exceptions end up in the future
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Running--;
+			}
+
+			m_JobDone.notify_all();
+		}
+	}
+}
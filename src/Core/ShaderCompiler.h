@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Graphics {
+
+	// Note: Worker threads the shaders are loaded and compiled on, so a scene loading a dozen shaders waits for the
+	// slowest one instead of their sum. Jobs start in the order they were queued, each one hands back a future that
+	// becomes ready (or holds its exception) once it ran. glslang is initialized once per process by the device, its
+	// compilations are independent of each other, one TShader/TProgram per job.
+	class ShaderCompiler {
+	public:
+		// 0 workers, one per hardware thread
+		ShaderCompiler(uint32_t workers = 0);
+		~ShaderCompiler();
+
+		ShaderCompiler(const ShaderCompiler& other) = delete;
+		void operator=(const ShaderCompiler& other) = delete;
+
+		std::shared_future<void> Enqueue(std::function<void()> job);
+
+		// blocks until every queued job ran
+		void WaitIdle();
+
+	private:
+		void Work();
+
+	private:
+		std::vector<std::thread>				m_Workers;
+
+		std::mutex								m_Mutex;
+		std::condition_variable					m_JobAdded;
+		std::condition_variable					m_JobDone;
+
+		std::deque<std::packaged_task<void()>>	m_Jobs;
+		uint32_t								m_Running	= 0;
+		bool									m_Stop		= false;
+	};
+}
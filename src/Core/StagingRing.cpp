@@ -0,0 +1,366 @@
+#include "StagingRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GraphicsDevice.h"
+
+namespace Graphics {
+
+	StagingRing::StagingRing(uint32_t queueFamily, VkQueue queue, VkDeviceSize capacity) : m_QueueFamily(queueFamily), m_Queue(queue), m_Capacity(capacity) {
+		assert(capacity > 0);
+	}
+
+	StagingRing::~StagingRing() {
+		if (m_Buffer.Handle == VK_NULL_HANDLE)
+			return;
+
+		Flush();
+
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		vkDestroySemaphore(gfxDevice->m_LogicalDevice, m_Semaphore, nullptr);
+
+		// the command buffers go with their pool
+		vkDestroyCommandPool(gfxDevice->m_LogicalDevice, m_CommandPool, nullptr);
+
+		gfxDevice->DestroyBuffer(m_Buffer);
+	}
+
+	void StagingRing::Create() {
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		BufferDescription desc	= {};
+		desc.Capacity			= m_Capacity;
+		desc.Usage				= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		desc.MemoryProperty		= static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		gfxDevice->CreateBuffer(desc, m_Buffer, m_Capacity);
+		assert(m_Buffer.MemoryMapped != nullptr);
+
+		VkCommandPoolCreateInfo poolInfo	= {};
+		poolInfo.sType						= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags						= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex			= m_QueueFamily;
+
+		VkResult result = vkCreateCommandPool(gfxDevice->m_LogicalDevice, &poolInfo, nullptr, &m_CommandPool);
+		assert(result == VK_SUCCESS);
+
+		VkSemaphoreTypeCreateInfo typeInfo	= {};
+		typeInfo.sType						= VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType				= VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue				= m_Submitted;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType					= VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext					= &typeInfo;
+
+		result = vkCreateSemaphore(gfxDevice->m_LogicalDevice, &semaphoreInfo, nullptr, &m_Semaphore);
+		assert(result == VK_SUCCESS);
+	}
+
+	VkSemaphore StagingRing::GetSemaphore() {
+		if (m_Buffer.Handle == VK_NULL_HANDLE)
+			Create();
+
+		return m_Semaphore;
+	}
+
+	void StagingRing::BeginBatch() {
+		if (m_Recording)
+			return;
+
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		if (!m_Free.empty()) {
+			m_Current = std::move(m_Free.back());
+			m_Free.pop_back();
+		}
+		else {
+			VkCommandBufferAllocateInfo allocInfo	= {};
+			allocInfo.sType							= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool					= m_CommandPool;
+			allocInfo.level							= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount			= 1;
+
+			VkResult result = vkAllocateCommandBuffers(gfxDevice->m_LogicalDevice, &allocInfo, &m_Current.CommandBuffer);
+			assert(result == VK_SUCCESS);
+		}
+
+		m_Current.End = m_Head;
+
+		VkCommandBufferBeginInfo beginInfo	= {};
+		beginInfo.sType						= VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags						= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult result = vkBeginCommandBuffer(m_Current.CommandBuffer, &beginInfo);
+		assert(result == VK_SUCCESS);
+
+		// copies may overwrite what earlier submissions (e.g. the frames in flight) still read
+		VkMemoryBarrier barrier = {};
+		barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask	= VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(m_Current.CommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		m_Recording = true;
+	}
+
+	// Note: Releases the finished batches in submission order, with 'wait' the oldest one is waited for first.
+	void StagingRing::Retire(bool wait) {
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		while (!m_InFlight.empty()) {
+			Batch& batch = m_InFlight.front();
+
+			if (wait) {
+				Wait(batch.Value);
+				wait = false;
+			}
+			else if (!IsComplete(batch.Value)) {
+				break;
+			}
+
+			for (GPUBuffer& buffer : batch.Dedicated)
+				gfxDevice->DestroyBuffer(buffer);
+
+			batch.Dedicated.clear();
+			batch.WaitSemaphores.clear();
+			batch.WaitValues.clear();
+			batch.WaitStages.clear();
+
+			m_Tail = batch.End;
+
+			m_Free.push_back(std::move(batch));
+			m_InFlight.pop_front();
+		}
+	}
+
+	StagingRing::Allocation StagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment) {
+		assert(size > 0 && (alignment & (alignment - 1)) == 0);
+
+		if (m_Buffer.Handle == VK_NULL_HANDLE)
+			Create();
+
+		m_Stats.BytesStaged += size;
+
+		if (size > m_Capacity)
+			return AllocateDedicated(size);
+
+		Retire(false);
+
+		while (true) {
+			uint64_t offset = (m_Head + alignment - 1) & ~(alignment - 1);
+			bool wraps = offset % m_Capacity + size > m_Capacity;
+
+			if (wraps)
+				offset = (offset / m_Capacity + 1) * m_Capacity;
+
+			// nothing alive, the skipped end of the ring is free as well
+			if (m_Head == m_Tail && m_InFlight.empty())
+				m_Tail = m_Head = offset;
+
+			if (offset + size - m_Tail <= m_Capacity) {
+				if (wraps)
+					m_Stats.WrapArounds++;
+
+				BeginBatch();
+
+				m_Head = offset + size;
+				m_Current.End = m_Head;
+
+				return { m_Buffer.Handle, offset % m_Capacity, static_cast<char*>(m_Buffer.MemoryMapped) + offset % m_Capacity };
+			}
+
+			// the open batch holds the rest of the ring, it has to go before its space can come back
+			if (m_InFlight.empty())
+				Submit();
+
+			m_Stats.Stalls++;
+			Retire(true);
+		}
+	}
+
+	StagingRing::Allocation StagingRing::AllocateDedicated(VkDeviceSize size) {
+		GraphicsDevice* gfxDevice = GetDevice();
+
+		BufferDescription desc	= {};
+		desc.Capacity			= size;
+		desc.Usage				= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		desc.MemoryProperty		= static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		GPUBuffer buffer = {};
+		gfxDevice->CreateBuffer(desc, buffer, size);
+		assert(buffer.MemoryMapped != nullptr);
+
+		BeginBatch();
+		m_Current.Dedicated.push_back(buffer);
+
+		m_Stats.DedicatedAllocations++;
+
+		return { buffer.Handle, 0, buffer.MemoryMapped };
+	}
+
+	VkCommandBuffer StagingRing::GetCommandBuffer() {
+		if (m_Buffer.Handle == VK_NULL_HANDLE)
+			Create();
+
+		BeginBatch();
+
+		return m_Current.CommandBuffer;
+	}
+
+	void StagingRing::CopyToBuffer(const GPUBuffer& dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+		const uint8_t* src = static_cast<const uint8_t*>(data);
+
+		// a quarter of the ring per chunk keeps a few chunks in flight while a big buffer streams through
+		const VkDeviceSize chunkSize = std::max<VkDeviceSize>(m_Capacity / 4, 1);
+
+		while (size > 0) {
+			const VkDeviceSize chunk = std::min(size, chunkSize);
+
+			Allocation allocation = Allocate(chunk);
+			memcpy(allocation.Mapped, src, chunk);
+
+			VkBufferCopy region = {};
+			region.srcOffset	= allocation.Offset;
+			region.dstOffset	= dstOffset;
+			region.size			= chunk;
+
+			vkCmdCopyBuffer(GetCommandBuffer(), allocation.Buffer, dstBuffer.Handle, 1, &region);
+
+			src += chunk;
+			dstOffset += chunk;
+			size -= chunk;
+		}
+	}
+
+	void StagingRing::CopyToImage(const GPUImage& dstImage, const void* data, VkDeviceSize size) {
+		Allocation allocation = Allocate(size);
+		memcpy(allocation.Mapped, data, size);
+
+		const VkBufferImageCopy region = {
+			.bufferOffset = allocation.Offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = dstImage.Description.LayerCount
+			},
+			.imageOffset = {
+				.x = 0,
+				.y = 0,
+				.z = 0
+			},
+			.imageExtent = {
+				.width = dstImage.Description.Width,
+				.height = dstImage.Description.Height,
+				.depth = 1
+			}
+		};
+
+		vkCmdCopyBufferToImage(GetCommandBuffer(), allocation.Buffer, dstImage.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+
+	void StagingRing::WaitSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage) {
+		if (m_Buffer.Handle == VK_NULL_HANDLE)
+			Create();
+
+		BeginBatch();
+
+		m_Current.WaitSemaphores.push_back(semaphore);
+		m_Current.WaitValues.push_back(value);
+		m_Current.WaitStages.push_back(stage);
+	}
+
+	uint64_t StagingRing::Submit() {
+		if (!m_Recording)
+			return m_Submitted;
+
+		// everything submitted later sees the copies
+		VkMemoryBarrier barrier = {};
+		barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask	= VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+		vkCmdPipelineBarrier(m_Current.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkResult result = vkEndCommandBuffer(m_Current.CommandBuffer);
+		assert(result == VK_SUCCESS);
+
+		m_Current.Value = m_Submitted + 1;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo	= {};
+		timelineInfo.sType							= VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount		= static_cast<uint32_t>(m_Current.WaitValues.size());
+		timelineInfo.pWaitSemaphoreValues			= m_Current.WaitValues.data();
+		timelineInfo.signalSemaphoreValueCount		= 1;
+		timelineInfo.pSignalSemaphoreValues			= &m_Current.Value;
+
+		VkSubmitInfo submitInfo			= {};
+		submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext				= &timelineInfo;
+		submitInfo.waitSemaphoreCount	= static_cast<uint32_t>(m_Current.WaitSemaphores.size());
+		submitInfo.pWaitSemaphores		= m_Current.WaitSemaphores.data();
+		submitInfo.pWaitDstStageMask	= m_Current.WaitStages.data();
+		submitInfo.commandBufferCount	= 1;
+		submitInfo.pCommandBuffers		= &m_Current.CommandBuffer;
+		submitInfo.signalSemaphoreCount	= 1;
+		submitInfo.pSignalSemaphores	= &m_Semaphore;
+
+		result = vkQueueSubmit(m_Queue, 1, &submitInfo, VK_NULL_HANDLE);
+		assert(result == VK_SUCCESS);
+
+		m_Submitted = m_Current.Value;
+
+		m_InFlight.push_back(std::move(m_Current));
+		m_Current = {};
+		m_Recording = false;
+
+		m_Stats.Submissions++;
+
+		return m_Submitted;
+	}
+
+	void StagingRing::Flush() {
+		Submit();
+
+		while (!m_InFlight.empty())
+			Retire(true);
+	}
+
+	bool StagingRing::IsComplete(uint64_t value) {
+		if (value == 0)
+			return true;
+
+		if (value > m_Submitted)
+			return false;
+
+		uint64_t counter = 0;
+		vkGetSemaphoreCounterValue(GetDevice()->m_LogicalDevice, m_Semaphore, &counter);
+
+		return counter >= value;
+	}
+
+	void StagingRing::Wait(uint64_t value) {
+		if (value == 0)
+			return;
+
+		if (value > m_Submitted)
+			Submit();
+
+		assert(value <= m_Submitted);
+
+		VkSemaphoreWaitInfo waitInfo	= {};
+		waitInfo.sType					= VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount			= 1;
+		waitInfo.pSemaphores			= &m_Semaphore;
+		waitInfo.pValues				= &value;
+
+		VkResult result = vkWaitSemaphores(GetDevice()->m_LogicalDevice, &waitInfo, UINT64_MAX);
+		assert(result == VK_SUCCESS);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "VulkanHeader.h"
+#include "Graphics.h"
+
+namespace Graphics {
+
+	// Note: One persistently mapped, host coherent staging buffer used as a ring for uploads on one queue. Allocations
+	// are handed out in order and recorded into the command buffer of the open batch. Submit() sends the whole batch in
+	// one submission that signals the next value of the ring's timeline semaphore and never waits; the ring space of a
+	// batch is reused once its value is reached. Only a full ring blocks, on the oldest batch (counted as a stall).
+	// Uploads larger than the ring get a dedicated staging buffer that is released with the batch.
+	//
+	// The device submits the open batch of its graphics ring before any other submission to the graphics queue (single
+	// time command buffers, EndFrame), so queue order matches recording order, and every batch ends with a transfer ->
+	// all commands barrier. Other queues synchronize with a ring through its semaphore and values.
+	class StagingRing {
+	public:
+		struct Allocation {
+			VkBuffer		Buffer	= VK_NULL_HANDLE;
+			VkDeviceSize	Offset	= 0;
+			void*			Mapped	= nullptr;
+		};
+
+		struct Stats {
+			uint64_t BytesStaged			= 0;
+			uint64_t Submissions			= 0;
+			uint64_t Stalls					= 0;	// blocking waits on a batch because the ring was full
+			uint64_t WrapArounds			= 0;
+			uint64_t DedicatedAllocations	= 0;	// uploads that didn't fit in the ring
+		};
+
+		// copies are recorded for and submitted to 'queue', of 'queueFamily'
+		StagingRing(uint32_t queueFamily, VkQueue queue, VkDeviceSize capacity = 64ull * 1024 * 1024);
+		~StagingRing();
+
+		// 'size' bytes of the open batch, 'alignment' must be a power of two
+		Allocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		// where copies out of the allocations of the open batch are recorded, only valid until the next Allocate or Submit
+		VkCommandBuffer GetCommandBuffer();
+
+		// stages 'data' and records the copy, large writes are streamed through the ring in chunks
+		void CopyToBuffer(const GPUBuffer& dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset);
+
+		// level 0 of every layer, 'dstImage' must be in TRANSFER_DST
+		void CopyToImage(const GPUImage& dstImage, const void* data, VkDeviceSize size);
+
+		// the open batch waits for 'semaphore' (a timeline) to reach 'value' before 'stage'
+		void WaitSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage);
+
+		// submits the open batch (nothing when empty), returns the value signaled once everything recorded so far is done
+		uint64_t Submit();
+
+		// submits and waits for every batch
+		void Flush();
+
+		// the value signaled once everything recorded so far is done, the open batch included
+		uint64_t GetRecordedValue() const	{ return m_Recording ? m_Submitted + 1 : m_Submitted; }
+
+		// whether the GPU is past 'value', never waits
+		bool IsComplete(uint64_t value);
+
+		// blocks until 'value' is reached, submits the open batch first when it's part of it
+		void Wait(uint64_t value);
+
+		VkSemaphore GetSemaphore();
+		uint32_t GetQueueFamily() const		{ return m_QueueFamily; }
+
+		VkDeviceSize GetCapacity() const	{ return m_Capacity; }
+		VkDeviceSize GetUsed() const		{ return m_Head - m_Tail; }
+		const Stats& GetStats() const		{ return m_Stats; }
+		void ResetStats()					{ m_Stats = {}; }
+
+	private:
+		struct Batch {
+			VkCommandBuffer						CommandBuffer	= VK_NULL_HANDLE;
+			uint64_t							Value			= 0;	// signaled when the batch is done
+			uint64_t							End				= 0;	// ring position after the last allocation of the batch
+			std::vector<GPUBuffer>				Dedicated;
+
+			std::vector<VkSemaphore>			WaitSemaphores;
+			std::vector<uint64_t>				WaitValues;
+			std::vector<VkPipelineStageFlags>	WaitStages;
+		};
+
+		void Create();
+		void BeginBatch();
+		void Retire(bool wait);
+		Allocation AllocateDedicated(VkDeviceSize size);
+
+	private:
+		GPUBuffer				m_Buffer;
+		VkCommandPool			m_CommandPool	= VK_NULL_HANDLE;
+		VkSemaphore				m_Semaphore		= VK_NULL_HANDLE;		// timeline, one value per batch
+
+		uint32_t				m_QueueFamily	= 0;
+		VkQueue					m_Queue			= VK_NULL_HANDLE;
+		uint64_t				m_Submitted		= 0;					// value of the last submitted batch
+
+		VkDeviceSize			m_Capacity		= 0;
+
+		// positions only ever grow, the offset in the buffer is position % capacity
+		uint64_t				m_Head			= 0;
+		uint64_t				m_Tail			= 0;
+
+		Batch					m_Current;
+		bool					m_Recording		= false;
+
+		std::deque<Batch>		m_InFlight;
+		std::vector<Batch>		m_Free;				// retired command buffers
+
+		Stats					m_Stats;
+	};
+}
@@ -28,7 +28,7 @@ UI::UI(GLFWwindow& window, const Graphics::RenderPass& uiRenderPass) {
 	init_info.Device = gfxDevice->m_LogicalDevice;
 	init_info.QueueFamily = gfxDevice->m_QueueFamilyIndices.graphicsFamily.value();
 	init_info.Queue = gfxDevice->m_GraphicsQueue;
-	init_info.PipelineCache = VK_NULL_HANDLE;
+	init_info.PipelineCache = gfxDevice->GetPipelineCache();
 	init_info.DescriptorPool = m_UIDescriptorPool;
 	init_info.MinImageCount = Graphics::FRAMES_IN_FLIGHT;
 	init_info.ImageCount = Graphics::FRAMES_IN_FLIGHT;
@@ -62,6 +62,7 @@ private:
 	uint32_t m_ScreenHeight			= 0;
 
 	float m_MaxShadowBias = 0.01f;
+	float m_EnvironmentIntensity = 1.0f;
 	
 	bool m_RenderSkybox				= false;
 	bool m_RenderWireframe			= false;
@@ -206,17 +207,17 @@ void ModelViewer::StartUp() {
 		mesh.MaterialIndex	= materialIndex;
 	}
 
-	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/backpack/backpack.obj"));
+	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/backpack/backpack.obj", { .CompressTextures = true }));
 	m_Models[m_Models.size() - 1]->Transformations.scaleHandler		= 0.3f;
 	m_Models[m_Models.size() - 1]->Transformations.translation		= glm::vec3(0.0f, -3.75f, 0.0f);
 	m_Models[m_Models.size() - 1]->FlipUvVertically					= true;
 	
-	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/stanford_dragon_sss_test/scene.gltf"));
+	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/stanford_dragon_sss_test/scene.gltf", { .LodCount = 4 }));
 	m_Models[m_Models.size() - 1]->Transformations.scaleHandler		= 11.2f;
 	m_Models[m_Models.size() - 1]->Transformations.translation		= glm::vec3(2.5f, -3.75f, -2.5f);
 	m_Models[m_Models.size() - 1]->Transformations.rotation			= glm::vec3(0.0f, -46.9f, 0.0f);
 
-	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/Sponza-master/sponza.obj"));
+	m_Models.emplace_back(Renderer::LoadModel("C:/Users/felip/Documents/current_projects/models/actual_models/Sponza-master/sponza.obj", { .CompressTextures = true }));
 	m_Models[m_Models.size() - 1]->Transformations.scaleHandler		= 0.008f;
 	m_Models[m_Models.size() - 1]->Transformations.rotation.y		= 45.0f;
 
@@ -285,8 +286,9 @@ void ModelViewer::RenderScene(const uint32_t currentFrame, const VkCommandBuffer
 		m_ShadowDebugRenderer.Render(commandBuffer, m_ShadowRenderer.GetDepthBuffer());
 	}
 
-	Renderer::UpdateGlobalDescriptors(commandBuffer, { m_Camera, m_SecondCamera }, m_RenderNormalMap, m_MaxShadowBias, m_LightManager.TotalLights);
-	
+	Renderer::UpdateGlobalDescriptors(commandBuffer, { m_Camera, m_SecondCamera }, m_RenderNormalMap, m_MaxShadowBias, m_LightManager.TotalLights, m_EnvironmentIntensity);
+	Renderer::UpdateShaderFeatures(m_RenderNormalMap, m_LightManager.TotalLights, m_LightManager.Lights);
+
 	Renderer::MeshSorter sorter(Renderer::MeshSorter::BatchType::tDefault);
 	sorter.SetCamera(m_Camera);
 
@@ -367,6 +369,7 @@ void ModelViewer::RenderUI() {
 	ImGui::Checkbox				("Render Light Sources",	&m_RenderLightSources);
 	ImGui::Checkbox				("Render Normal Map",		&m_RenderNormalMap);
 	ImGui::DragFloat			("Max Shadow Bias",			&m_MaxShadowBias, 0.002f, -2.0f, 2.0f);
+	ImGui::SliderFloat			("Environment Lighting",	&m_EnvironmentIntensity, 0.0f, 2.0f);
 
 	PostEffects::RenderUI();
 
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
 
 #include "../Core/Graphics.h"
 #include "../Core/GraphicsDevice.h"
@@ -13,6 +14,7 @@
 #include "../Utils/TextureLoader.h"
 #include "../Utils/ModelLoader.h"
 #include "../Utils/Helper.h"
+#include "../Utils/ParallelFor.h"
 
 #include "../Assets/Material.h"
 #include "../Assets/Model.h"
@@ -25,6 +27,9 @@ namespace Renderer {
 
 	Graphics::Texture m_Skybox;
 
+	// diffuse SH, prefiltered specular cube and BRDF LUT of the skybox's environment, see color_ps.frag
+	TextureLoader::EnvironmentLighting m_Environment;
+
 	Graphics::Shader m_SkyboxVertexShader		= {};
 	Graphics::Shader m_SkyboxFragShader			= {};
 	Graphics::Shader m_DefaultVertShader		= {};
@@ -37,12 +42,17 @@ namespace Renderer {
 	Graphics::Shader m_TransparentFragShader	= {};
 	Graphics::Shader m_DepthFragShader			= {};
 	Graphics::Shader m_NormalsFragShader		= {};
+	Graphics::Shader m_PackedVertShader			= {};
+	Graphics::Shader m_PackedColorVertShader	= {};
+	Graphics::Shader m_PackedOutlineVertShader	= {};
 
-	Graphics::Buffer m_ModelBuffer				= {};
 	Graphics::Buffer m_SkyboxBuffer				= {};
 	Graphics::Buffer m_CamerasBuffer[Graphics::FRAMES_IN_FLIGHT]		= {};
 	Graphics::Buffer m_GlobalDataBuffer[Graphics::FRAMES_IN_FLIGHT]		= {};
 
+	// the model constants live in the frame's transient region, the descriptor is written again every frame
+	VkDescriptorSetLayoutBinding m_ModelBinding = {};
+
 	Graphics::PipelineState m_SkyboxPSO				= {};
 	Graphics::PipelineState m_ColorPSO				= {};
 	Graphics::PipelineState m_ColorStencilPSO		= {};
@@ -54,6 +64,33 @@ namespace Renderer {
 	Graphics::PipelineState m_RenderDepthPSO		= {};
 	Graphics::PipelineState m_RenderNormalsPSO		= {};
 
+	// Note: Same pipelines as above built for the packed vertex layouts, only the vertex shader (which decodes the 
+	// packed attributes) and the vertex input differ. Indexed by Assets::VertexLayout - 1, see GetLayoutPSO.
+	struct PackedPipelines {
+		Graphics::PipelineState Color				= {};
+		Graphics::PipelineState ColorStencil		= {};
+		Graphics::PipelineState Outline				= {};
+		Graphics::PipelineState Wireframe			= {};
+		Graphics::PipelineState Transparent			= {};
+		Graphics::PipelineState TransparentStencil	= {};
+		Graphics::PipelineState RenderDepth			= {};
+		Graphics::PipelineState RenderNormals		= {};
+	};
+
+	std::array<PackedPipelines, Assets::tNumVertexLayouts - 1> m_PackedPSOs;
+
+	// Note: Standard pipelines specialized with some of the shader features off, keyed by GetPermutationKey and all
+	// built by LoadResources so none is compiled while a frame is recorded (see GetPSO). The standard ones above have
+	// every feature on, the permutations are owned by the device's pipeline state cache.
+	std::unordered_map<uint32_t, const Graphics::PipelineState*> m_PermutationPSOs;
+
+	const Graphics::IRenderTarget* m_PermutationTarget	= nullptr;
+
+	// the features the color shader can turn off, none when its binary has no specialization constants
+	uint32_t m_ColorFeatures							= ShaderFeatures::tAll;
+
+	uint32_t m_SceneFeatures							= ShaderFeatures::tAll;
+
 	GlobalConstants m_GlobalConstants				= {};
 
 	VkPipelineLayout m_GlobalPipelineLayout				= VK_NULL_HANDLE;
@@ -67,6 +104,79 @@ namespace Renderer {
 	int m_CameraIndex		= 0;
 }
 
+// Note: Pre-compiled builds only get the packed pipelines when compile.bat produced their shaders, models asking for a
+// packed layout without them are loaded with the standard one.
+static bool HasPackedShaders() {
+#ifdef RUNTIME_SHADER_COMPILATION
+	return true;
+#else
+	static const bool available = Helper::file_exists("./Shaders/default_packed_vert.spv")
+		&& Helper::file_exists("./Shaders/default_packed_color_vert.spv")
+		&& Helper::file_exists("./Shaders/outline_packed_vert.spv");
+
+	return available;
+#endif
+}
+
+// Note: BC5 normal maps need the fragment shaders that rebuild Z from X and Y, the only sqrt either of them calls. The 
+// committed binaries may predate that and are copied as they are when CMake has no glslc, models asking for compressed 
+// textures are loaded uncompressed then.
+static bool HasNormalReconstruction() {
+#ifdef RUNTIME_SHADER_COMPILATION
+	return true;
+#else
+	constexpr uint32_t OP_EXT_INST	= 12;
+	constexpr uint32_t GLSL_SQRT	= 31;
+
+	auto callsSqrt = [](const std::string& path) {
+		if (!Helper::file_exists(path))
+			return false;
+
+		std::vector<char> code = Graphics::GetDevice()->ReadFile(path);
+
+		const uint32_t* words	= reinterpret_cast<const uint32_t*>(code.data());
+		const size_t count		= code.size() / sizeof(uint32_t);
+
+		// after the 5 word header every instruction starts with its word count << 16 | opcode
+		for (size_t i = 5; i < count;) {
+			const uint32_t length = words[i] >> 16;
+			const uint32_t opcode = words[i] & 0xFFFF;
+
+			if (length == 0)
+				break;
+
+			// OpExtInst: result type, result, set, instruction
+			if (opcode == OP_EXT_INST && length >= 5 && i + 4 < count && words[i + 4] == GLSL_SQRT)
+				return true;
+
+			i += length;
+		}
+
+		return false;
+	};
+
+	static const bool available = callsSqrt("./Shaders/color_ps.spv") && callsSqrt("./Shaders/transparent_frag.spv");
+
+	return available;
+#endif
+}
+
+// the standard pipeline (before its layout variant is picked), the layout and the features
+static uint32_t GetPermutationKey(const Graphics::PipelineState& base, Assets::VertexLayout layout, uint32_t features) {
+	return (&base == &Renderer::m_ColorStencilPSO ? 1u : 0u) | static_cast<uint32_t>(layout) << 1 | features << 8;
+}
+
+static Graphics::PipelineStateDescription GetPermutationDescription(const Graphics::PipelineState& pso, uint32_t features) {
+	Graphics::PipelineStateDescription desc = pso.description;
+	desc.Name += " (Features " + std::to_string(features) + ")";
+	desc.specializationConstants.resize(Renderer::ShaderFeatures::tCount);
+
+	for (uint32_t i = 0; i < Renderer::ShaderFeatures::tCount; i++)
+		desc.specializationConstants[i] = (features >> i) & 1;
+
+	return desc;
+}
+
 std::shared_ptr<Assets::Model> Renderer::LoadModel(ModelType modelType) {
 	if (m_TotalModels == MAX_MODELS)
 		return nullptr;
@@ -81,11 +191,25 @@ std::shared_ptr<Assets::Model> Renderer::LoadModel(ModelType modelType) {
 
 }
 
-std::shared_ptr<Assets::Model> Renderer::LoadModel(const std::string& path) {
+std::shared_ptr<Assets::Model> Renderer::LoadModel(const std::string& path, const ModelLoader::ImportSettings& settings) {
 	if (m_TotalModels == MAX_MODELS)
 		return nullptr;
 
-	m_Models[m_TotalModels++] = ModelLoader::LoadModel(path);
+	// every model here is drawn through Model::Render, the first frame that does waits for the copies
+	ModelLoader::ImportSettings asyncSettings = settings;
+	asyncSettings.AsyncUpload = true;
+
+	if (asyncSettings.Layout != Assets::tStandardLayout && !HasPackedShaders()) {
+		std::cout << "Packed vertex shaders not found, loading " << path << " with the standard vertex layout\n";
+		asyncSettings.Layout = Assets::tStandardLayout;
+	}
+
+	if (asyncSettings.CompressTextures && !HasNormalReconstruction()) {
+		std::cout << "Fragment shaders can't decode BC5 normal maps (stale color_ps.spv/transparent_frag.spv, run compile.bat), loading " << path << " with uncompressed textures\n";
+		asyncSettings.CompressTextures = false;
+	}
+
+	m_Models[m_TotalModels++] = ModelLoader::LoadModel(path, asyncSettings);
 
 	uint32_t modelIdx = m_TotalModels - 1;
 
@@ -108,6 +232,8 @@ void Renderer::Shutdown() {
 	
 	gfxDevice->DestroyDescriptorSetLayout(m_GlobalDescriptorSetLayout);
 	gfxDevice->DestroyImage(m_Skybox);
+	gfxDevice->DestroyImage(m_Environment.Specular);
+	gfxDevice->DestroyImage(m_Environment.BRDF);
 	gfxDevice->DestroyShader(m_DefaultVertShader);
 	gfxDevice->DestroyShader(m_ColorFragShader);
 	gfxDevice->DestroyShader(m_WireframeFragShader);
@@ -120,6 +246,9 @@ void Renderer::Shutdown() {
 	gfxDevice->DestroyShader(m_TransparentFragShader);
 	gfxDevice->DestroyShader(m_DepthFragShader);
 	gfxDevice->DestroyShader(m_NormalsFragShader);
+	gfxDevice->DestroyShader(m_PackedVertShader);
+	gfxDevice->DestroyShader(m_PackedColorVertShader);
+	gfxDevice->DestroyShader(m_PackedOutlineVertShader);
 
 	gfxDevice->DestroyPipeline(m_ColorPSO);
 	gfxDevice->DestroyPipeline(m_ColorStencilPSO);
@@ -132,8 +261,28 @@ void Renderer::Shutdown() {
 	gfxDevice->DestroyPipeline(m_RenderDepthPSO);
 	gfxDevice->DestroyPipeline(m_RenderNormalsPSO);
 
+	for (auto& psos : m_PackedPSOs) {
+		gfxDevice->DestroyPipeline(psos.Color);
+		gfxDevice->DestroyPipeline(psos.ColorStencil);
+		gfxDevice->DestroyPipeline(psos.Outline);
+		gfxDevice->DestroyPipeline(psos.Wireframe);
+		gfxDevice->DestroyPipeline(psos.Transparent);
+		gfxDevice->DestroyPipeline(psos.TransparentStencil);
+		gfxDevice->DestroyPipeline(psos.RenderDepth);
+		gfxDevice->DestroyPipeline(psos.RenderNormals);
+	}
+
+	m_PermutationPSOs.clear();
+	m_PermutationTarget = nullptr;
+	m_ColorFeatures = ShaderFeatures::tAll;
+
 	gfxDevice->DestroyPipelineLayout(m_GlobalPipelineLayout);
 
+	for (int i = 0; i < Graphics::FRAMES_IN_FLIGHT; i++) {
+		gfxDevice->FreeBuffer(m_CamerasBuffer[i]);
+		gfxDevice->FreeBuffer(m_GlobalDataBuffer[i]);
+	}
+
 	m_Initialized = false;
 }
 
@@ -155,36 +304,52 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 		"./Textures/back.jpg",
 	};
 
-	m_Skybox = TextureLoader::LoadCubemapTexture("./Textures/immenstadter_horn_2k.hdr");
-
+	// the shaders load on the compiler threads while the skybox is baked, the pipelines below wait for them
 #ifdef RUNTIME_SHADER_COMPILATION
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_SkyboxVertexShader,		"../src/Assets/Shaders/skybox.vert"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_SkyboxFragShader,			"../src/Assets/Shaders/skybox.frag"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_DefaultVertShader,		"../src/Assets/Shaders/default.vert"		);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_ColorFragShader,			"../src/Assets/Shaders/color_ps.frag"		);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_WireframeFragShader,		"../src/Assets/Shaders/wireframe.frag"		);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_LightSourceVertShader,	"../src/Assets/Shaders/light_source.vert"	);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_LightSourceFragShader,	"../src/Assets/Shaders/light_source.frag"	);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_OutlineVertShader,		"../src/Assets/Shaders/outline.vert"		);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_OutlineFragShader,		"../src/Assets/Shaders/outline.frag"		);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_TransparentFragShader,	"../src/Assets/Shaders/transparent_ps.frag"	);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_DepthFragShader,			"../src/Assets/Shaders/depth.frag"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_NormalsFragShader,		"../src/Assets/Shaders/debug_normals.frag"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_SkyboxVertexShader,		"../src/Assets/Shaders/skybox.vert"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_SkyboxFragShader,			"../src/Assets/Shaders/skybox.frag"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_DefaultVertShader,		"../src/Assets/Shaders/default.vert"		);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_ColorFragShader,			"../src/Assets/Shaders/color_ps.frag"		);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_WireframeFragShader,		"../src/Assets/Shaders/wireframe.frag"		);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_LightSourceVertShader,	"../src/Assets/Shaders/light_source.vert"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_LightSourceFragShader,	"../src/Assets/Shaders/light_source.frag"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_OutlineVertShader,		"../src/Assets/Shaders/outline.vert"		);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_OutlineFragShader,		"../src/Assets/Shaders/outline.frag"		);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_TransparentFragShader,	"../src/Assets/Shaders/transparent_ps.frag"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_DepthFragShader,			"../src/Assets/Shaders/depth.frag"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_NormalsFragShader,		"../src/Assets/Shaders/debug_normals.frag"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_PackedVertShader,			"../src/Assets/Shaders/default_packed.vert"	);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_PackedColorVertShader,	"../src/Assets/Shaders/default_packed.vert", { "VERTEX_COLOR" });
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_PackedOutlineVertShader,	"../src/Assets/Shaders/outline_packed.vert"	);
 #else 
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_SkyboxVertexShader,		"./Shaders/skybox_vert.spv"					);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_SkyboxFragShader,			"./Shaders/skybox_frag.spv"					);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_DefaultVertShader,		"./Shaders/default_vert.spv"				);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_ColorFragShader,			"./Shaders/color_ps.spv"					);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_WireframeFragShader,		"./Shaders/wireframe_frag.spv"				);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_LightSourceVertShader,	"./Shaders/light_source_vert.spv"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_LightSourceFragShader,	"./Shaders/light_source_frag.spv"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_VERTEX_BIT,	m_OutlineVertShader,		"./Shaders/outline_vert.spv"				);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_OutlineFragShader,		"./Shaders/outline_frag.spv"				);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_TransparentFragShader,	"./Shaders/transparent_frag.spv"			);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_DepthFragShader,			"./Shaders/depth_frag.spv"					);
-	gfxDevice->LoadShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_NormalsFragShader,		"./Shaders/debug_normals_frag.spv"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_SkyboxVertexShader,		"./Shaders/skybox_vert.spv"					);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_SkyboxFragShader,			"./Shaders/skybox_frag.spv"					);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_DefaultVertShader,		"./Shaders/default_vert.spv"				);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_ColorFragShader,			"./Shaders/color_ps.spv"					);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_WireframeFragShader,		"./Shaders/wireframe_frag.spv"				);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_LightSourceVertShader,	"./Shaders/light_source_vert.spv"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_LightSourceFragShader,	"./Shaders/light_source_frag.spv"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,		m_OutlineVertShader,		"./Shaders/outline_vert.spv"				);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_OutlineFragShader,		"./Shaders/outline_frag.spv"				);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_TransparentFragShader,	"./Shaders/transparent_frag.spv"			);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_DepthFragShader,			"./Shaders/depth_frag.spv"					);
+	gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_FRAGMENT_BIT,	m_NormalsFragShader,		"./Shaders/debug_normals_frag.spv"			);
+
+	if (HasPackedShaders()) {
+		gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,	m_PackedVertShader,			"./Shaders/default_packed_vert.spv"			);
+		gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,	m_PackedColorVertShader,	"./Shaders/default_packed_color_vert.spv"	);
+		gfxDevice->LoadShaderAsync(VK_SHADER_STAGE_VERTEX_BIT,	m_PackedOutlineVertShader,	"./Shaders/outline_packed_vert.spv"			);
+	}
 #endif
 
+	m_Skybox = TextureLoader::LoadCubemapTexture("./Textures/immenstadter_horn_2k.hdr", TextureLoader::HDRFormat::E5B9G9R9, true);
+
+	// baked on the first launch only, read back from the .ibl cache next to the image afterwards
+	m_Environment = TextureLoader::LoadEnvironmentLighting("./Textures/immenstadter_horn_2k.hdr");
+
+	for (int i = 0; i < 9; i++)
+		m_GlobalConstants.irradianceSH[i] = glm::vec4(m_Environment.Irradiance.Coefficients[i], 0.0f);
+
 	InputLayout globalInputLayout = {
 		.pushConstants = {
 			{ VK_SHADER_STAGE_ALL_GRAPHICS, 0, sizeof(PipelinePushConstants) },
@@ -197,11 +362,13 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 			{ 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT },
 			{ 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL_GRAPHICS },
 			{ 6, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL_GRAPHICS },			// Multiple cameras UBO 
-			{ 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT }	// Shadow Mapping
+			{ 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT },	// Shadow Mapping
+			{ 8, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT },	// Environment specular
+			{ 9, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT }	// Environment BRDF LUT
 		}
 	};
 
-	m_ModelBuffer = gfxDevice->CreateBuffer(sizeof(ModelConstants) * MAX_MODELS);
+	m_ModelBinding = globalInputLayout.bindings[5];
 
 	for (int i = 0; i < Graphics::FRAMES_IN_FLIGHT; i++) {
 		m_CamerasBuffer[i]		= gfxDevice->CreateBuffer(sizeof(CameraConstants) * MAX_CAMERAS);
@@ -213,13 +380,16 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	gfxDevice->CreateDescriptorSetLayout(m_GlobalDescriptorSetLayout, globalInputLayout.bindings);
 	gfxDevice->CreatePipelineLayout		(m_GlobalDescriptorSetLayout, m_GlobalPipelineLayout, globalInputLayout.pushConstants);
 	
+	// every pipeline is created at once on worker threads after the descriptions are filled in
+	std::vector<PipelineStateRequest> psoRequests;
+
 	PipelineStateDescription colorPSODesc			= {};
 	colorPSODesc.Name								= "Color Pipeline";
 	colorPSODesc.vertexShader						= &m_DefaultVertShader;
 	colorPSODesc.fragmentShader						= &m_ColorFragShader;
 	colorPSODesc.psoInputLayout						.push_back(globalInputLayout);
 
-	gfxDevice->CreatePipelineState(colorPSODesc, m_ColorPSO, renderTarget);
+	psoRequests.push_back({ &colorPSODesc, &m_ColorPSO, &renderTarget });
 
 	PipelineStateDescription colorStencilPSODesc	= {};
 	colorStencilPSODesc.Name						= "Color Stencil Pipeline";
@@ -236,7 +406,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	colorStencilPSODesc.stencilState.writeMask		= 0xff;
 	colorStencilPSODesc.stencilState.reference		= 1;
 	
-	gfxDevice->CreatePipelineState(colorStencilPSODesc, m_ColorStencilPSO, renderTarget);
+	psoRequests.push_back({ &colorStencilPSODesc, &m_ColorStencilPSO, &renderTarget });
 
 	PipelineStateDescription outlinePSODesc = {};
 	outlinePSODesc.Name = "Outline Pipeline";
@@ -254,7 +424,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	outlinePSODesc.stencilState.reference = 1;
 	outlinePSODesc.depthTestEnable = true;										// change to false if want to see through walls
 	
-	gfxDevice->CreatePipelineState(outlinePSODesc, m_OutlinePSO, renderTarget);
+	psoRequests.push_back({ &outlinePSODesc, &m_OutlinePSO, &renderTarget });
 
 	PipelineStateDescription skyboxPSODesc = {};
 	skyboxPSODesc.Name = "Skybox PSO";
@@ -263,7 +433,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	skyboxPSODesc.noVertex = true;
 	skyboxPSODesc.psoInputLayout.push_back(globalInputLayout);
 
-	gfxDevice->CreatePipelineState(skyboxPSODesc, m_SkyboxPSO, renderTarget);
+	psoRequests.push_back({ &skyboxPSODesc, &m_SkyboxPSO, &renderTarget });
 
 	PipelineStateDescription wireframePSODesc = {};
 	wireframePSODesc.Name = "Wireframe PSO";
@@ -273,7 +443,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	wireframePSODesc.polygonMode = VK_POLYGON_MODE_LINE;
 	wireframePSODesc.psoInputLayout.push_back(globalInputLayout);
 
-	gfxDevice->CreatePipelineState(wireframePSODesc, m_WireframePSO, renderTarget);
+	psoRequests.push_back({ &wireframePSODesc, &m_WireframePSO, &renderTarget });
 
 	PipelineStateDescription lightSourcePSODesc = {};
 	lightSourcePSODesc.Name = "Light Source PSO";
@@ -282,7 +452,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	lightSourcePSODesc.noVertex = true;
 	lightSourcePSODesc.psoInputLayout.push_back(globalInputLayout);
 	
-	gfxDevice->CreatePipelineState(lightSourcePSODesc, m_LightSourcePSO, renderTarget);
+	psoRequests.push_back({ &lightSourcePSODesc, &m_LightSourcePSO, &renderTarget });
 
 	PipelineStateDescription transparentPSODesc = {};
 	transparentPSODesc.Name = "Transparent PSO";
@@ -299,7 +469,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	transparentPSODesc.colorBlendingDesc.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	transparentPSODesc.colorBlendingDesc.alphaBlendOp = VK_BLEND_OP_ADD;
 	
-	gfxDevice->CreatePipelineState(transparentPSODesc, m_TransparentPSO, renderTarget);
+	psoRequests.push_back({ &transparentPSODesc, &m_TransparentPSO, &renderTarget });
 
 	PipelineStateDescription transparentStencilPSODesc = {};
 	transparentStencilPSODesc.Name = "Transparent Stencil Pipeline";
@@ -316,7 +486,7 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 	transparentStencilPSODesc.stencilState.writeMask = 0xff;
 	transparentStencilPSODesc.stencilState.reference = 1;
 
-	gfxDevice->CreatePipelineState(transparentPSODesc, m_TransparentStencilPSO, renderTarget);
+	psoRequests.push_back({ &transparentPSODesc, &m_TransparentStencilPSO, &renderTarget });
 
 	PipelineStateDescription renderDepthPSODesc = {};
 	renderDepthPSODesc.Name = "Render Depth";
@@ -334,6 +504,93 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 
 	m_RenderNormalsPSO.description = renderNormalsPSODesc;
 
+	struct PackedDescriptions {
+		PipelineStateDescription Color, ColorStencil, Outline, Wireframe, Transparent;
+	};
+
+	std::array<PackedDescriptions, Assets::tNumVertexLayouts - 1> packedDescs;
+
+	// without the shaders no model uses a packed layout (see LoadModel)
+	const uint8_t packedLayouts = HasPackedShaders() ? Assets::tNumVertexLayouts : Assets::tPackedLayout;
+
+	for (uint8_t layout = Assets::tPackedLayout; layout < packedLayouts; layout++) {
+		PackedPipelines& psos = m_PackedPSOs[layout - 1];
+
+		const Graphics::Shader* vertexShader = layout == Assets::tPackedColorLayout ? &m_PackedColorVertShader : &m_PackedVertShader;
+
+		auto makeVariant = [layout](PipelineStateDescription desc, const Graphics::Shader* shader) {
+			desc.Name			+= layout == Assets::tPackedColorLayout ? " (Packed Color)" : " (Packed)";
+			desc.vertexShader	= shader;
+			desc.vertexLayout	= layout;
+
+			return desc;
+		};
+
+		PackedDescriptions& descs	= packedDescs[layout - 1];
+		descs.Color					= makeVariant(colorPSODesc,			vertexShader);
+		descs.ColorStencil			= makeVariant(colorStencilPSODesc,	vertexShader);
+		descs.Outline				= makeVariant(outlinePSODesc,		&m_PackedOutlineVertShader);
+		descs.Wireframe				= makeVariant(wireframePSODesc,		vertexShader);
+		descs.Transparent			= makeVariant(transparentPSODesc,	vertexShader);
+
+		psoRequests.push_back({ &descs.Color,			&psos.Color,				&renderTarget });
+		psoRequests.push_back({ &descs.ColorStencil,	&psos.ColorStencil,			&renderTarget });
+		psoRequests.push_back({ &descs.Outline,			&psos.Outline,				&renderTarget });
+		psoRequests.push_back({ &descs.Wireframe,		&psos.Wireframe,			&renderTarget });
+		psoRequests.push_back({ &descs.Transparent,		&psos.Transparent,			&renderTarget });
+		psoRequests.push_back({ &descs.Transparent,		&psos.TransparentStencil,	&renderTarget });
+
+		psos.RenderDepth.description	= makeVariant(renderDepthPSODesc,	vertexShader);
+		psos.RenderNormals.description	= makeVariant(renderNormalsPSODesc, vertexShader);
+	}
+
+	gfxDevice->CreatePipelineStates(psoRequests);
+
+	m_PermutationTarget = &renderTarget;
+
+	if (!gfxDevice->HasSpecializationConstants(m_ColorFragShader)) {
+		std::cout << "color_ps has no specialization constants, shader feature permutations are disabled (rebuild the shaders)" << '\n';
+		m_ColorFeatures = 0;
+	}
+
+	// Note: Every permutation a mesh can ask for is built now on worker threads, at most the feature combinations of
+	// the two opaque pipelines per vertex layout, so GetPSO only looks them up. The pipeline cache makes the later
+	// launches cheap.
+	if (m_ColorFeatures != 0) {
+		struct Permutation {
+			uint32_t							Key			= 0;
+			PipelineStateDescription			Description = {};
+			const Graphics::PipelineState*		PSO			= nullptr;
+		};
+
+		std::vector<Permutation> permutations;
+
+		for (uint8_t layout = Assets::tStandardLayout; layout < packedLayouts; layout++) {
+			for (Graphics::PipelineState* base : { &m_ColorPSO, &m_ColorStencilPSO }) {
+				const Graphics::PipelineState& pso = GetLayoutPSO(*base, static_cast<Assets::VertexLayout>(layout));
+
+				for (uint32_t features = 0; features < m_ColorFeatures; features++)
+					permutations.push_back({ GetPermutationKey(*base, static_cast<Assets::VertexLayout>(layout), features), GetPermutationDescription(pso, features) });
+			}
+		}
+
+		Utils::ParallelFor(permutations.size(), [&](size_t i) {
+			permutations[i].PSO = &gfxDevice->GetPipelineState(permutations[i].Description, renderTarget);
+		});
+
+		for (const Permutation& permutation : permutations)
+			m_PermutationPSOs[permutation.Key] = permutation.PSO;
+	}
+
+	// the debug views draw these on their own targets, built up front so the first frame showing one doesn't, any
+	// target compatible with this one reuses them
+	gfxDevice->GetPipelineState(renderDepthPSODesc, renderTarget);
+	gfxDevice->GetPipelineState(renderNormalsPSODesc, renderTarget);
+
+	for (uint8_t layout = Assets::tPackedLayout; layout < packedLayouts; layout++) {
+		gfxDevice->GetPipelineState(m_PackedPSOs[layout - 1].RenderDepth.description, renderTarget);
+		gfxDevice->GetPipelineState(m_PackedPSOs[layout - 1].RenderNormals.description, renderTarget);
+	}
 
 //	gfxDevice->CreatePipelineState(renderDepthPSODesc, m_RenderDepthPSO, renderTarget);
 
@@ -345,9 +602,10 @@ void Renderer::LoadResources(const Graphics::IRenderTarget& renderTarget, const
 		gfxDevice->WriteDescriptor(globalInputLayout.bindings[2], gfxDevice->GetFrame(i).bindlessSet, lightBuffer);
 		gfxDevice->WriteDescriptor(globalInputLayout.bindings[3], gfxDevice->GetFrame(i).bindlessSet, rm->GetTextures());
 		gfxDevice->WriteDescriptor(globalInputLayout.bindings[4], gfxDevice->GetFrame(i).bindlessSet, m_Skybox);
-		gfxDevice->WriteDescriptor(globalInputLayout.bindings[5], gfxDevice->GetFrame(i).bindlessSet, m_ModelBuffer);
 		gfxDevice->WriteDescriptor(globalInputLayout.bindings[6], gfxDevice->GetFrame(i).bindlessSet, m_CamerasBuffer[i]);
 		gfxDevice->WriteDescriptor(globalInputLayout.bindings[7], gfxDevice->GetFrame(i).bindlessSet, shadowMappingImage);
+		gfxDevice->WriteDescriptor(globalInputLayout.bindings[8], gfxDevice->GetFrame(i).bindlessSet, m_Environment.Specular);
+		gfxDevice->WriteDescriptor(globalInputLayout.bindings[9], gfxDevice->GetFrame(i).bindlessSet, m_Environment.BRDF);
 	}
 }
 
@@ -364,12 +622,13 @@ void Renderer::RenderSkybox(const VkCommandBuffer& commandBuffer) {
 }
 
 // TODO: refactor this function
-void Renderer::UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, const std::array<Assets::Camera, MAX_CAMERAS> cameras, const bool renderNormalMap, float maxShadowBias, uint32_t totalLights) {
+void Renderer::UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, const std::array<Assets::Camera, MAX_CAMERAS> cameras, const bool renderNormalMap, float maxShadowBias, uint32_t totalLights, float environmentIntensity) {
 	GraphicsDevice* gfxDevice = GetDevice();
 	
 	m_GlobalConstants.totalLights = totalLights;
 	m_GlobalConstants.renderNormalMap = static_cast<int>(renderNormalMap);
 	m_GlobalConstants.maxShadowBias = maxShadowBias;
+	m_GlobalConstants.environmentIntensity = environmentIntensity;
 
 	gfxDevice->UpdateBuffer(m_GlobalDataBuffer[gfxDevice->GetCurrentFrameIndex()], &m_GlobalConstants);
 
@@ -381,11 +640,17 @@ void Renderer::UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, con
 		modelConstant.normalMatrix = glm::mat4(glm::mat3(glm::transpose(glm::inverse(modelConstant.model))));
 		modelConstant.flipUvVertically = m_Models[i]->FlipUvVertically;
 		modelConstant.outlineWidth = m_Models[i]->OutlineWidth;
+		modelConstant.positionOffset = glm::vec4(m_Models[i]->PositionOffset, 0.0f);
+		modelConstant.positionScale = glm::vec4(m_Models[i]->PositionScale, 1.0f);
 
 		modelConstants[i] = modelConstant;
 	}
 
-	gfxDevice->UpdateBuffer(m_ModelBuffer, modelConstants.data());
+	// the set isn't bound yet this frame and the fence of its last use was waited for, so it can be written
+	Graphics::BufferManager::TransientAllocation modelBuffer = gfxDevice->AllocateTransient(sizeof(modelConstants));
+	memcpy(modelBuffer.Mapped, modelConstants.data(), sizeof(modelConstants));
+
+	gfxDevice->WriteDescriptor(m_ModelBinding, gfxDevice->GetCurrentFrame().bindlessSet, modelBuffer);
 
 	std::array<CameraConstants, MAX_CAMERAS> cameraConstants;
 
@@ -403,6 +668,44 @@ void Renderer::UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, con
 	gfxDevice->BindDescriptorSet(gfxDevice->GetCurrentFrame().bindlessSet, commandBuffer, m_GlobalPipelineLayout, 0, 1);
 }
 
+// Note: The features the frame agrees on, each mesh further drops the ones its material doesn't use. Point lights
+// never sample their shadow map, only directional and spot lights count.
+void Renderer::UpdateShaderFeatures(bool renderNormalMap, uint32_t totalLights, const Scene::LightComponent* lights) {
+	uint32_t features = ShaderFeatures::tAlphaTest;
+
+	if (renderNormalMap)
+		features |= ShaderFeatures::tNormalMapping;
+
+	for (uint32_t i = 0; i < totalLights; i++) {
+		const Scene::LightComponent& light = lights[i];
+
+		if (!light.IsActive() || !light.IsShadowCastingEnabled() || light.type == Scene::LightComponent::LightType::POINT)
+			continue;
+
+		features |= ShaderFeatures::tShadows;
+
+		if (light.flags & (1 << 2))
+			features |= ShaderFeatures::tPCF;
+	}
+
+	m_SceneFeatures = features;
+}
+
+static uint32_t GetMaterialFeatures(uint32_t materialIndex) {
+	const MaterialData& material = ResourceManager::Get()->GetMaterial(materialIndex).MaterialData;
+
+	uint32_t features = Renderer::ShaderFeatures::tShadows | Renderer::ShaderFeatures::tPCF;
+
+	if (material.NormalTextureIndex != -1)
+		features |= Renderer::ShaderFeatures::tNormalMapping;
+
+	// without a diffuse texture there is no alpha to test
+	if (material.DiffuseTextureIndex != -1)
+		features |= Renderer::ShaderFeatures::tAlphaTest;
+
+	return features;
+}
+
 void Renderer::RenderOutline(const VkCommandBuffer& commandBuffer, Assets::Model& model) {
 	GraphicsDevice* gfxDevice = GetDevice();
 
@@ -410,7 +713,10 @@ void Renderer::RenderOutline(const VkCommandBuffer& commandBuffer, Assets::Model
 
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &model.DataBuffer.Handle, offsets);
 	vkCmdBindIndexBuffer(commandBuffer, model.DataBuffer.Handle, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_OutlinePSO.pipeline);
+
+	const Graphics::PipelineState& outlinePSO = GetLayoutPSO(m_OutlinePSO, model.Layout);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, outlinePSO.pipeline);
 
 	for (const auto& mesh : model.Meshes) {
 		PipelinePushConstants pushConstants = {
@@ -421,7 +727,7 @@ void Renderer::RenderOutline(const VkCommandBuffer& commandBuffer, Assets::Model
 
 		vkCmdPushConstants(
 			commandBuffer,
-			m_OutlinePSO.pipelineLayout,
+			outlinePSO.pipelineLayout,
 			VK_SHADER_STAGE_ALL_GRAPHICS,
 			0,
 			sizeof(PipelinePushConstants),
@@ -446,7 +752,10 @@ void Renderer::RenderWireframe(const VkCommandBuffer& commandBuffer, Assets::Mod
 
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &model.DataBuffer.Handle, offsets);
 	vkCmdBindIndexBuffer(commandBuffer, model.DataBuffer.Handle, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_WireframePSO.pipeline);
+
+	const Graphics::PipelineState& wireframePSO = GetLayoutPSO(m_WireframePSO, model.Layout);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, wireframePSO.pipeline);
 
 	for (const auto& mesh : model.Meshes) {
 		PipelinePushConstants pushConstants = {
@@ -457,7 +766,7 @@ void Renderer::RenderWireframe(const VkCommandBuffer& commandBuffer, Assets::Mod
 
 		vkCmdPushConstants(
 			commandBuffer,
-			m_WireframePSO.pipelineLayout,
+			wireframePSO.pipelineLayout,
 			VK_SHADER_STAGE_ALL_GRAPHICS,
 			0,
 			sizeof(PipelinePushConstants),
@@ -509,21 +818,71 @@ void Renderer::SetCameraIndex(int index) {
 	m_CameraIndex = index;
 }
 
-const Graphics::PipelineState& Renderer::GetPSO(uint16_t flags) {
+// Note: The flags pick one of the standard pipelines, the features it can't drop (the transparent shader has none)
+// are ignored. Any other combination is the standard description with the features as specialization constants,
+// LoadResources built every one of them on its render target.
+const Graphics::PipelineState& Renderer::GetPSO(uint16_t flags, uint32_t features) {
+
+	Assets::VertexLayout layout = PSOFlags::GetVertexLayout(flags);
+
+	Graphics::PipelineState* base = &m_ColorPSO;
 
 	if (flags & PSOFlags::tOpaque && flags & PSOFlags::tStencilTest) {
-		return m_ColorStencilPSO;
+		base = &m_ColorStencilPSO;
 	}
-
-	if (flags & PSOFlags::tTransparent && flags & PSOFlags::tStencilTest) {
-		return m_TransparentStencilPSO;
+	else if (flags & PSOFlags::tTransparent && flags & PSOFlags::tStencilTest) {
+		base = &m_TransparentStencilPSO;
 	}
-
-	if (flags & PSOFlags::tTransparent) {
-		return m_TransparentPSO;
+	else if (flags & PSOFlags::tTransparent) {
+		base = &m_TransparentPSO;
 	}
-	
-	return m_ColorPSO;
+
+	Graphics::PipelineState& pso = GetLayoutPSO(*base, layout);
+
+	const uint32_t supported = pso.description.fragmentShader == &m_ColorFragShader ? m_ColorFeatures : 0;
+
+	features &= supported;
+
+	if (features == supported)
+		return pso;
+
+	const uint32_t key = GetPermutationKey(*base, layout, features);
+
+	auto it = m_PermutationPSOs.find(key);
+
+	if (it != m_PermutationPSOs.end())
+		return *it->second;
+
+	// only when LoadResources didn't see this combination coming, e.g. a layout added since
+	std::cout << "Shader permutation built while recording: " << key << '\n';
+
+	assert(m_PermutationTarget != nullptr);
+
+	const Graphics::PipelineState& permutation = GetDevice()->GetPipelineState(GetPermutationDescription(pso, features), *m_PermutationTarget);
+
+	m_PermutationPSOs[key] = &permutation;
+
+	return permutation;
+}
+
+// Note: Maps one of the standard pipelines to its variant for the given vertex layout, pipelines without
+// a packed variant (skybox, light sources) are returned as they are.
+Graphics::PipelineState& Renderer::GetLayoutPSO(Graphics::PipelineState& pso, Assets::VertexLayout layout) {
+	if (layout == Assets::tStandardLayout || layout >= Assets::tNumVertexLayouts)
+		return pso;
+
+	PackedPipelines& psos = m_PackedPSOs[layout - 1];
+
+	if (&pso == &m_ColorPSO)				return psos.Color;
+	if (&pso == &m_ColorStencilPSO)			return psos.ColorStencil;
+	if (&pso == &m_OutlinePSO)				return psos.Outline;
+	if (&pso == &m_WireframePSO)			return psos.Wireframe;
+	if (&pso == &m_TransparentPSO)			return psos.Transparent;
+	if (&pso == &m_TransparentStencilPSO)	return psos.TransparentStencil;
+	if (&pso == &m_RenderDepthPSO)			return psos.RenderDepth;
+	if (&pso == &m_RenderNormalsPSO)		return psos.RenderNormals;
+
+	return pso;
 }
 
 const Assets::Camera& Renderer::MeshSorter::GetCamera() {
@@ -534,7 +893,7 @@ void Renderer::MeshSorter::SetCamera(const Assets::Camera& camera) {
 	m_Camera = &camera;
 }
 
-void Renderer::MeshSorter::AddMesh(const Assets::Mesh& mesh, float distance, uint32_t modelIndex, uint32_t totalIndices, Graphics::GPUBuffer& buffer) {
+void Renderer::MeshSorter::AddMesh(const Assets::Mesh& mesh, float distance, uint32_t modelIndex, uint32_t totalIndices, Graphics::GPUBuffer& buffer, uint32_t lod) {
 	
 	SortKey key = {};
 	key.value = m_SortMeshes.size();
@@ -550,8 +909,10 @@ void Renderer::MeshSorter::AddMesh(const Assets::Mesh& mesh, float distance, uin
 		m_PassCounts[DrawPass::tOpaque]++;
 	}
 
+	m_LayoutMask |= 1u << PSOFlags::GetVertexLayout(mesh.PSOFlags);
+
 	m_SortKeys.push_back(key);
-	m_SortMeshes.push_back({ &mesh, &buffer, distance, modelIndex, totalIndices });
+	m_SortMeshes.push_back({ &mesh, &buffer, distance, modelIndex, totalIndices, lod });
 }
 
 void Renderer::MeshSorter::Sort() {
@@ -580,7 +941,7 @@ void Renderer::MeshSorter::RenderMeshes(const VkCommandBuffer& commandBuffer, Dr
 			const SortMesh& sortMesh = m_SortMeshes[key.value];
 			const Assets::Mesh& mesh = *sortMesh.mesh;
 
-			const PipelineState* newMeshPipeline = &GetPSO(mesh.PSOFlags);
+			const PipelineState* newMeshPipeline = &GetPSO(mesh.PSOFlags, m_SceneFeatures & GetMaterialFeatures(mesh.MaterialIndex));
 
 			if (pipeline == nullptr || newMeshPipeline != pipeline) {
 				pipeline = newMeshPipeline;
@@ -616,9 +977,9 @@ void Renderer::MeshSorter::RenderMeshes(const VkCommandBuffer& commandBuffer, Dr
 
 			vkCmdDrawIndexed(
 				commandBuffer,
-				static_cast<uint32_t>(mesh.Indices.size()),
+				static_cast<uint32_t>(mesh.GetIndexCount(sortMesh.lod)),
 				1,
-				static_cast<uint32_t>(mesh.IndexOffset),
+				static_cast<uint32_t>(mesh.GetIndexOffset(sortMesh.lod)),
 				static_cast<int32_t>(mesh.VertexOffset),
 				0
 			);
@@ -639,12 +1000,16 @@ void Renderer::MeshSorter::RenderMeshes(const VkCommandBuffer& commandBuffer, Dr
 		if (passCount == 0)
 			continue;
 
-		if (pso->renderPass == nullptr 
-			|| pso->renderPass->Handle == VK_NULL_HANDLE 
-			|| pso->renderPass->Handle != renderTarget.GetRenderPass().Handle) {
+		// 'pso' only carries the descriptions, the device builds them once per compatible render target
+		std::array<const PipelineState*, Assets::tNumVertexLayouts> layoutPipelines = {};
+
+		for (uint8_t layout = 0; layout < Assets::tNumVertexLayouts; layout++) {
+			if (!(m_LayoutMask & (1u << layout)))
+				continue;
 
-			gfxDevice->DestroyPipeline(*pso);
-			gfxDevice->CreatePipelineState(pso->description, *pso, renderTarget);
+			const PipelineState& layoutPSO = GetLayoutPSO(*pso, static_cast<Assets::VertexLayout>(layout));
+
+			layoutPipelines[layout] = &gfxDevice->GetPipelineState(layoutPSO.description, renderTarget);
 		}
 
 		const PipelineState* pipeline = nullptr;
@@ -657,8 +1022,10 @@ void Renderer::MeshSorter::RenderMeshes(const VkCommandBuffer& commandBuffer, Dr
 			const SortMesh& sortMesh = m_SortMeshes[key.value];
 			const Assets::Mesh& mesh = *sortMesh.mesh;
 
-			if (pipeline == nullptr || pso != pipeline) {
-				pipeline = pso;
+			const PipelineState* meshPipeline = layoutPipelines[PSOFlags::GetVertexLayout(mesh.PSOFlags)];
+
+			if (pipeline == nullptr || meshPipeline != pipeline) {
+				pipeline = meshPipeline;
 				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
 				assert(pipeline != nullptr);
 			}
@@ -691,9 +1058,9 @@ void Renderer::MeshSorter::RenderMeshes(const VkCommandBuffer& commandBuffer, Dr
 
 			vkCmdDrawIndexed(
 				commandBuffer,
-				static_cast<uint32_t>(mesh.Indices.size()),
+				static_cast<uint32_t>(mesh.GetIndexCount(sortMesh.lod)),
 				1,
-				static_cast<uint32_t>(mesh.IndexOffset),
+				static_cast<uint32_t>(mesh.GetIndexOffset(sortMesh.lod)),
 				static_cast<int32_t>(mesh.VertexOffset),
 				0
 			);
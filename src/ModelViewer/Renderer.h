@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -8,6 +9,8 @@
 #include "../Core/VulkanHeader.h"
 #include "../Core/RenderTarget.h"
 
+#include "../Utils/ModelLoader.h"
+
 #include "glm.hpp"
 
 #define MAX_MODELS 10
@@ -18,6 +21,8 @@ namespace Assets {
 	class Model;
 
 	struct Mesh;
+
+	enum VertexLayout : uint8_t;
 }
 
 namespace Graphics {
@@ -58,6 +63,7 @@ namespace Renderer {
 
 			uint32_t modelIndex = 0;
 			uint32_t totalIndices = 0;
+			uint32_t lod = 0;
 		};
 
 		MeshSorter(BatchType type) {
@@ -65,13 +71,14 @@ namespace Renderer {
 			m_Camera = nullptr;
 			m_CurrentPass = tZPass;
 			m_CurrentDraw = 0;
+			m_LayoutMask = 0;
 
 			std::memset(m_PassCounts, 0, sizeof(m_PassCounts));
 		};
 
 		void SetCamera(const Assets::Camera& camera);
 		const Assets::Camera& GetCamera();
-		void AddMesh(const Assets::Mesh& mesh, float distance, uint32_t modelIndex, uint32_t totalIndices, Graphics::GPUBuffer& buffer);
+		void AddMesh(const Assets::Mesh& mesh, float distance, uint32_t modelIndex, uint32_t totalIndices, Graphics::GPUBuffer& buffer, uint32_t lod = 0);
 		void Sort();
 		void RenderMeshes(const VkCommandBuffer& commandBuffer, DrawPass pass);
 		void RenderMeshes(const VkCommandBuffer& commandBuffer, DrawPass pass, Graphics::IRenderTarget& renderTarget, Graphics::PipelineState* pso);
@@ -84,6 +91,7 @@ namespace Renderer {
 
 		uint32_t m_CurrentDraw;
 		uint32_t m_PassCounts[tNumPasses];
+		uint32_t m_LayoutMask;				// bit per Assets::VertexLayout added to the sorter
 
 		const Assets::Camera* m_Camera;
 
@@ -91,6 +99,20 @@ namespace Renderer {
 		std::vector<SortMesh> m_SortMeshes;
 	};
 
+	// Note: Feature toggles of the color shader, bit i is its specialization constant with constant_id = i. Pipelines
+	// with some of them off are derived from the standard ones when the resources load, see GetPSO.
+	namespace ShaderFeatures {
+		enum : uint32_t {
+			tNormalMapping	= 0x1,
+			tAlphaTest		= 0x2,
+			tShadows		= 0x4,
+			tPCF			= 0x8,
+
+			tAll			= 0xF,
+			tCount			= 4
+		};
+	}
+
 	struct PipelinePushConstants {
 		int MaterialIdx = 0;
 		int ModelIdx = 0;
@@ -110,14 +132,15 @@ namespace Renderer {
 	extern Graphics::PipelineState m_RenderNormalsPSO;
 
 	std::shared_ptr<Assets::Model> LoadModel(ModelType modelType);
-	std::shared_ptr<Assets::Model> LoadModel(const std::string& path);
+	std::shared_ptr<Assets::Model> LoadModel(const std::string& path, const ModelLoader::ImportSettings& settings = {});
 
 	void Init();
 	void Shutdown();
 	void LoadResources(const Graphics::IRenderTarget& renderTarget, const Graphics::GPUImage& shadowMappingImage, const Graphics::Buffer& lightBuffer);
 	void OnUIRender();
 
-	void UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, const std::array<Assets::Camera, MAX_CAMERAS> cameras, const bool renderNormalMap, float maxShadowBias, uint32_t totalLights);
+	void UpdateGlobalDescriptors(const VkCommandBuffer& commandBuffer, const std::array<Assets::Camera, MAX_CAMERAS> cameras, const bool renderNormalMap, float maxShadowBias, uint32_t totalLights, float environmentIntensity);
+	void UpdateShaderFeatures(bool renderNormalMap, uint32_t totalLights, const Scene::LightComponent* lights);
 	void RenderSkybox(const VkCommandBuffer& commandBuffer);
 	void RenderOutline(const VkCommandBuffer& commandBuffer, Assets::Model& model);
 	void RenderWireframe(const VkCommandBuffer& commandBuffer, Assets::Model& model);
@@ -125,5 +148,6 @@ namespace Renderer {
 	void RenderCube(const VkCommandBuffer& commandBuffer, const Graphics::PipelineState& PSO);
 	void SetCameraIndex(int index);
 
-	const Graphics::PipelineState& GetPSO(uint16_t flags);
+	const Graphics::PipelineState& GetPSO(uint16_t flags, uint32_t features = ShaderFeatures::tAll);
+	Graphics::PipelineState& GetLayoutPSO(Graphics::PipelineState& pso, Assets::VertexLayout layout);
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 
 #include "../Core/Application.h"
@@ -64,6 +65,9 @@ private:
 	};
 
 	std::vector<InstanceModelData> m_InstanceModelData;
+	std::vector<InstanceModelData> m_LodInstanceData;		// instances grouped by level of detail, rebuilt every frame
+	std::vector<uint32_t>			m_LodInstanceCounts;
+	std::vector<uint32_t>			m_InstanceLods;
 
 	std::shared_ptr<Assets::Model>	m_Model;
 
@@ -72,12 +76,13 @@ private:
 	uint32_t	m_DrawCalls			= 0;
 	uint32_t	m_TotalVertices		= 0;
 	uint32_t	m_ModelVertices		= 0;
+	uint32_t	m_TotalTriangles	= 0;
 
 	bool m_FirstPass				= true;
 
 	Assets::Camera	m_Camera		= {};
 
-	Graphics::GPUBuffer			m_StorageBuffer									= {};
+	Graphics::GPUBuffer			m_StorageBuffer[Graphics::FRAMES_IN_FLIGHT]		= {};
 	Graphics::Buffer			m_SceneDataBuffer[Graphics::FRAMES_IN_FLIGHT]	= {};
 	Graphics::Buffer			m_ModelDataBuffer								= {};
 	Graphics::Shader			m_VertexShader									= {};
@@ -89,12 +94,14 @@ private:
 };
 
 void Instancing::StartUp() {
-	m_Model									= ModelLoader::LoadModel("C:/Users/Felipe/Documents/current_projects/models/actual_models/stormtrooper/scene.gltf");
+	m_Model									= ModelLoader::LoadModel("C:/Users/Felipe/Documents/current_projects/models/actual_models/stormtrooper/scene.gltf", { .LodCount = 4 });
 	m_Model->Transformations.scaleHandler	= 0.009f;
 	m_Model->Transformations.translation	= glm::vec3(0.0f, 0.0f, 0.0f);
 	m_Model->Transformations.rotation		= glm::vec3(-100.0f, 0.0f, 0.0f);
 
 	m_InstanceModelData.resize(MAX_MODELS);
+	m_LodInstanceData.resize(MAX_MODELS);
+	m_InstanceLods.resize(MAX_MODELS);
 
 	int num = 20;
 	float offset_x = static_cast<float>(-num);
@@ -168,9 +175,12 @@ void Instancing::StartUp() {
 
 
 	m_ModelDataBuffer	= gfxDevice->CreateBuffer(sizeof(ModelGPUData));
-	m_StorageBuffer		= gfxDevice->CreateStorageBuffer(MAX_MODELS * sizeof(InstanceModelData));
 
-	gfxDevice->UpdateBuffer(m_StorageBuffer, 0, m_InstanceModelData.data(), sizeof(InstanceModelData) * MAX_MODELS);
+	// Note: One instance buffer per frame in flight, the instances are regrouped by level of detail every frame.
+	for (int i = 0; i < Graphics::FRAMES_IN_FLIGHT; i++) {
+		m_StorageBuffer[i] = gfxDevice->CreateStorageBuffer(MAX_MODELS * sizeof(InstanceModelData));
+		gfxDevice->UpdateBuffer(m_StorageBuffer[i], 0, m_InstanceModelData.data(), sizeof(InstanceModelData) * MAX_MODELS);
+	}
 
 	Graphics::PipelineStateDescription desc = {};
 	desc.Name								= "Color Pipeline";
@@ -189,14 +199,16 @@ void Instancing::StartUp() {
 		gfxDevice->WriteDescriptor(m_PSOInputLayout.bindings[1], m_Set[i], m_ModelDataBuffer);
 		gfxDevice->WriteDescriptor(m_PSOInputLayout.bindings[2], m_Set[i], rm->GetMaterialBuffer());
 		gfxDevice->WriteDescriptor(m_PSOInputLayout.bindings[3], m_Set[i], rm->GetTextures());
-		gfxDevice->WriteDescriptor(m_PSOInputLayout.bindings[4], m_Set[i], m_StorageBuffer);
+		gfxDevice->WriteDescriptor(m_PSOInputLayout.bindings[4], m_Set[i], m_StorageBuffer[i]);
 	}
 }
 
 void Instancing::CleanUp() {
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
 
-	gfxDevice->DestroyBuffer(m_StorageBuffer);
+	for (int i = 0; i < Graphics::FRAMES_IN_FLIGHT; i++)
+		gfxDevice->DestroyBuffer(m_StorageBuffer[i]);
+
 	gfxDevice->DestroyShader(m_VertexShader);
 	gfxDevice->DestroyShader(m_FragmentShader);
 	gfxDevice->DestroyPipeline(m_PSO);
@@ -220,11 +232,37 @@ void Instancing::Update(const float constantT, const float deltaT, InputSystem::
 
 	gfxDevice->UpdateBuffer(m_SceneDataBuffer[gfxDevice->GetCurrentFrameIndex()], &m_SceneGPUData);
 	gfxDevice->UpdateBuffer(m_ModelDataBuffer, &m_ModelGPUData);
+
+	// pick a level per instance and group them, each level is then one instanced draw per mesh
+	uint32_t lodCount = 1;
+
+	for (const auto& mesh : m_Model->Meshes)
+		lodCount = std::max(lodCount, mesh.GetLodCount());
+
+	m_LodInstanceCounts.assign(lodCount, 0);
+
+	for (int i = 0; i < MAX_MODELS; i++) {
+		float distance = glm::length(m_Camera.Position - glm::vec3(m_InstanceModelData[i].model[3]));
+
+		m_InstanceLods[i] = m_Model->SelectLod(m_Model->GetLodErrorLimit(m_Camera, distance));
+		m_LodInstanceCounts[m_InstanceLods[i]]++;
+	}
+
+	std::vector<uint32_t> lodOffsets(lodCount, 0);
+
+	for (uint32_t lod = 1; lod < lodCount; lod++)
+		lodOffsets[lod] = lodOffsets[lod - 1] + m_LodInstanceCounts[lod - 1];
+
+	for (int i = 0; i < MAX_MODELS; i++)
+		m_LodInstanceData[lodOffsets[m_InstanceLods[i]]++] = m_InstanceModelData[i];
 }
 
 void Instancing::RenderScene(const uint32_t currentFrame, const VkCommandBuffer& commandBuffer) {
 	Graphics::GraphicsDevice* gfxDevice = Graphics::GetDevice();
 
+	// written here rather than in Update, the frame fence guarantees the previous use of this buffer is done
+	gfxDevice->UpdateBuffer(m_StorageBuffer[currentFrame], 0, m_LodInstanceData.data(), sizeof(InstanceModelData) * MAX_MODELS);
+
 	gfxDevice->GetSwapChain().RenderTarget->Begin(commandBuffer);
 	gfxDevice->BindDescriptorSet(m_Set[currentFrame], commandBuffer, m_PSO.pipelineLayout, 0, 1);
 	
@@ -234,14 +272,31 @@ void Instancing::RenderScene(const uint32_t currentFrame, const VkCommandBuffer&
 	vkCmdBindIndexBuffer	(commandBuffer, m_Model->DataBuffer.Handle, 0, VK_INDEX_TYPE_UINT32);
 	vkCmdBindPipeline		(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PSO.pipeline);
 
+	m_DrawCalls			= 0;
+	m_TotalTriangles	= 0;
+
 	for (const auto& mesh : m_Model->Meshes) {
 		m_PushConstant.materialIndex = mesh.MaterialIndex;
 
 		vkCmdPushConstants	(commandBuffer, m_PSO.pipelineLayout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, sizeof(PushConstant), &m_PushConstant);
-		vkCmdDrawIndexed	(commandBuffer, static_cast<uint32_t>(mesh.Indices.size()), MAX_MODELS, static_cast<uint32_t>(mesh.IndexOffset), static_cast<int32_t>(mesh.VertexOffset), 0);
 
-		if (m_FirstPass) {
+		// gl_InstanceIndex includes firstInstance, so every level reads its own range of the instance buffer
+		uint32_t firstInstance = 0;
+
+		for (uint32_t lod = 0; lod < m_LodInstanceCounts.size(); lod++) {
+			uint32_t instanceCount = m_LodInstanceCounts[lod];
+
+			if (instanceCount == 0)
+				continue;
+
+			vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mesh.GetIndexCount(lod)), instanceCount, static_cast<uint32_t>(mesh.GetIndexOffset(lod)), static_cast<int32_t>(mesh.VertexOffset), firstInstance);
+
+			firstInstance		+= instanceCount;
+			m_TotalTriangles	+= static_cast<uint32_t>(mesh.GetIndexCount(lod) / 3) * instanceCount;
 			m_DrawCalls++;
+		}
+
+		if (m_FirstPass) {
 			m_ModelVertices += mesh.Vertices.size();
 		}
 	}
@@ -259,6 +314,10 @@ void Instancing::RenderUI() {
 	ImGui::Text("Total Draw Calls: %d", m_DrawCalls);
 	ImGui::Text("Model Vertices: %d", m_ModelVertices);
 	ImGui::Text("Total Vertices: %d", m_TotalVertices);
+	ImGui::Text("Total Triangles: %d", m_TotalTriangles);
+
+	for (uint32_t lod = 0; lod < m_LodInstanceCounts.size(); lod++)
+		ImGui::Text("LOD %d Instances: %d", lod, m_LodInstanceCounts[lod]);
 
 	ImGui::Separator();
 	ImGui::ColorPicker4("Light Color", (float*)&m_SceneGPUData.lightColor);
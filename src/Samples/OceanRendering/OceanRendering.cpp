@@ -358,7 +358,7 @@ void OceanRendering::StartUp() {
 		}
 	};
 
-    m_SkyboxTexture = TextureLoader::LoadCubemapTexture("./Textures/kloofendal_48d_partly_cloudy_puresky_8k.hdr");
+    m_SkyboxTexture = TextureLoader::LoadCubemapTexture("./Textures/kloofendal_48d_partly_cloudy_puresky_8k.hdr", TextureLoader::HDRFormat::E5B9G9R9, true);
     
 	gfxDevice->CreateDescriptorSetLayout(m_FrameDescriptorSetLayout, m_FrameInputLayout.bindings);
 
@@ -1,38 +1,33 @@
 #pragma once
 
 #include <string.h>
+#include <cassert>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "BitmapView.h"
+
 enum eBitmapType {
 	eBitmapType_2D,
 	eBitmapType_Cube
 };
 
-enum eBitmapFormat {
-	eBitmapFormat_UnsignedByte,
-	eBitmapFormat_Float
-};
-
 // R/RG/RGB/RGBA bitmaps
 class Bitmap {
 public:
 	Bitmap() = default;
 	Bitmap(int width, int height, int comp, eBitmapFormat format) : m_Width(width), m_Height(height), m_Comp(comp), m_Format(format),
 		Data(width * height * comp * getBytesPerComponent(format)) {
-		initGetSetFuncs();
 	}
 
 	Bitmap(int width, int height, int depth, int comp, eBitmapFormat format) : m_Width(width), m_Height(height), m_Depth(depth),
 		m_Comp(comp), m_Format(format), Data(width * height * depth * comp * getBytesPerComponent(format)) {
-		initGetSetFuncs();
 	}
 
 	Bitmap(int width, int height, int comp, eBitmapFormat format, const void* data) : m_Width(width), m_Height(height),
 		m_Comp(comp), m_Format(format), Data(width * height * comp * getBytesPerComponent(format)) {
 
-		initGetSetFuncs();
 		memcpy(Data.data(), data, Data.size());
 	}
 
@@ -53,72 +48,73 @@ public:
 		return 0;
 	}
 
-	void setPixel(int x, int y, const glm::vec4& color) {
-		(*this.*setPixelFunc)(x, y, color);
-	}
+	// Typed access to one layer (a cube face), the format and channel count have to match the bitmap.
+	template<eBitmapFormat Format, int Components>
+	BitmapView<Format, Components> view(int layer = 0) {
+		assert(Format == m_Format && Components == m_Comp && layer < m_Depth);
+		using Component = typename BitmapComponent<Format>::Type;
 
-	glm::vec4 getPixel(int x, int y) const {
-		return ((*this.*getPixelFunc)(x, y));
+		return BitmapView<Format, Components>(reinterpret_cast<Component*>(Data.data()) + size_t(layer) * m_Width * m_Height * Components, m_Width, m_Height);
 	}
 
-private:
-	using setPixel_t = void(Bitmap::*)(int, int, const glm::vec4&);
-	using getPixel_t = glm::vec4(Bitmap::*)(int, int) const;
-	setPixel_t setPixelFunc = &Bitmap::setPixelUnsignedByte;
-	getPixel_t getPixelFunc = &Bitmap::getPixelUnsignedByte;
-
-	void initGetSetFuncs() {
-		switch (m_Format) {
-		case eBitmapFormat_UnsignedByte:
-			setPixelFunc = &Bitmap::setPixelUnsignedByte;
-			getPixelFunc = &Bitmap::getPixelUnsignedByte;
-			break;
-		case eBitmapFormat_Float:
-			setPixelFunc = &Bitmap::setPixelFloat;
-			getPixelFunc = &Bitmap::getPixelFloat;
-			break;
-		}
+	template<eBitmapFormat Format, int Components>
+	ConstBitmapView<Format, Components> view(int layer = 0) const {
+		assert(Format == m_Format && Components == m_Comp && layer < m_Depth);
+		using Component = typename BitmapComponent<Format>::Type;
+
+		return ConstBitmapView<Format, Components>(reinterpret_cast<const Component*>(Data.data()) + size_t(layer) * m_Width * m_Height * Components, m_Width, m_Height);
 	}
 
-	void setPixelFloat(int x, int y, const glm::vec4& color) {
-		const int offset = m_Comp * (y * m_Width + x);
-		float* data = reinterpret_cast<float*>(Data.data());
-		if (m_Comp > 0) data[offset + 0] = color.x;
-		if (m_Comp > 1) data[offset + 1] = color.y;
-		if (m_Comp > 2) data[offset + 2] = color.z;
-		if (m_Comp > 3) data[offset + 3] = color.w;
+	// Note: Per pixel access with the format picked at runtime, fine for the odd texel. Loops over whole images should 
+	// go through view() or BitmapKernels instead, these switch on the format for every call.
+	void setPixel(int x, int y, const glm::vec4& color) {
+		if (m_Format == eBitmapFormat_Float)
+			storePixel<eBitmapFormat_Float>(x, y, color);
+		else
+			storePixel<eBitmapFormat_UnsignedByte>(x, y, color);
 	}
 
-	glm::vec4 getPixelFloat(int x, int y) const {
-		const int offset = m_Comp * (y * m_Width + x);
-		const float* data = reinterpret_cast<const float*>(Data.data());
+	glm::vec4 getPixel(int x, int y) const {
+		if (m_Format == eBitmapFormat_Float)
+			return loadPixel<eBitmapFormat_Float>(x, y);
+
+		return loadPixel<eBitmapFormat_UnsignedByte>(x, y);
+	}
 
-		return glm::vec4(
-			m_Comp > 0 ? data[offset + 0] : 0.0f,
-			m_Comp > 1 ? data[offset + 1] : 0.0f,
-			m_Comp > 2 ? data[offset + 2] : 0.0f,
-			m_Comp > 3 ? data[offset + 3] : 0.0f
-		);
+private:
+	// every layer stacked, rows past the first layer address the next ones like they always did
+	template<eBitmapFormat Format, int Components>
+	BitmapView<Format, Components> allLayers() {
+		using Component = typename BitmapComponent<Format>::Type;
+		return BitmapView<Format, Components>(reinterpret_cast<Component*>(Data.data()), m_Width, m_Height * m_Depth);
 	}
 
-	void setPixelUnsignedByte(int x, int y, const glm::vec4& color) {
-		const int offset = m_Comp * (y * m_Width + x);
+	template<eBitmapFormat Format, int Components>
+	ConstBitmapView<Format, Components> allLayers() const {
+		using Component = typename BitmapComponent<Format>::Type;
+		return ConstBitmapView<Format, Components>(reinterpret_cast<const Component*>(Data.data()), m_Width, m_Height * m_Depth);
+	}
 
-		if (m_Comp > 0) Data[offset + 0] = uint8_t(color.x * 255.0f);
-		if (m_Comp > 1) Data[offset + 1] = uint8_t(color.y * 255.0f);
-		if (m_Comp > 2) Data[offset + 2] = uint8_t(color.z * 255.0f);
-		if (m_Comp > 3) Data[offset + 3] = uint8_t(color.w * 255.0f);
+	template<eBitmapFormat Format>
+	void storePixel(int x, int y, const glm::vec4& color) {
+		switch (m_Comp) {
+		case 1: allLayers<Format, 1>().store(x, y, color); break;
+		case 2: allLayers<Format, 2>().store(x, y, color); break;
+		case 3: allLayers<Format, 3>().store(x, y, color); break;
+		case 4: allLayers<Format, 4>().store(x, y, color); break;
+		}
 	}
 
-	glm::vec4 getPixelUnsignedByte(int x, int y) const {
-		const int offset = m_Comp * (y * m_Width + x);
+	template<eBitmapFormat Format>
+	glm::vec4 loadPixel(int x, int y) const {
+		switch (m_Comp) {
+		case 1: return allLayers<Format, 1>().load(x, y);
+		case 2: return allLayers<Format, 2>().load(x, y);
+		case 3: return allLayers<Format, 3>().load(x, y);
+		case 4: return allLayers<Format, 4>().load(x, y);
+		}
 
-		return glm::vec4(
-			m_Comp > 0 ? float(Data[offset + 0]) / 255.0f : 0.0f,
-			m_Comp > 1 ? float(Data[offset + 1]) / 255.0f : 0.0f,
-			m_Comp > 2 ? float(Data[offset + 2]) / 255.0f : 0.0f,
-			m_Comp > 3 ? float(Data[offset + 3]) / 255.0f : 0.0f
-		);
+		return glm::vec4(0.0f);
 	}
 
 private:
@@ -0,0 +1,130 @@
+#include "BitmapView.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace BitmapKernels {
+
+	// linear values from 2^-13 up to 1 are looked up by their top float bits (8 exponent + 8 mantissa bits),
+	// below that the curve is linear and computed directly
+	static constexpr uint32_t SRGB_TABLE_FIRST	= 0x39000000;	// 2^-13
+	static constexpr uint32_t SRGB_TABLE_LAST	= 0x3f800000;	// 1.0
+	static constexpr uint32_t SRGB_TABLE_SHIFT	= 15;
+	static constexpr size_t SRGB_TABLE_SIZE		= (SRGB_TABLE_LAST - SRGB_TABLE_FIRST) >> SRGB_TABLE_SHIFT;
+
+	static float srgbToLinear(float value) {
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float linearToSRGB(float value) {
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	static const std::array<float, 256>& getLinearTable() {
+		static const std::array<float, 256> table = []() {
+			std::array<float, 256> values;
+
+			for (int i = 0; i < 256; i++)
+				values[i] = srgbToLinear(float(i) / 255.0f);
+
+			return values;
+		}();
+
+		return table;
+	}
+
+	static const std::array<uint8_t, SRGB_TABLE_SIZE>& getSRGBTable() {
+		static const std::array<uint8_t, SRGB_TABLE_SIZE> table = []() {
+			std::array<uint8_t, SRGB_TABLE_SIZE> values;
+
+			for (size_t i = 0; i < SRGB_TABLE_SIZE; i++) {
+				// middle of the bucket
+				const uint32_t bits = SRGB_TABLE_FIRST + uint32_t(i << SRGB_TABLE_SHIFT) + (1u << (SRGB_TABLE_SHIFT - 1));
+
+				float value;
+				memcpy(&value, &bits, sizeof(value));
+
+				values[i] = uint8_t(linearToSRGB(value) * 255.0f + 0.5f);
+			}
+
+			return values;
+		}();
+
+		return table;
+	}
+
+	static inline uint8_t toUnsignedByte(float value) {
+		return uint8_t(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+
+	static inline uint8_t toSRGB(float value, const uint8_t* table) {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		// the linear segment, positive values only
+		if (bits < SRGB_TABLE_FIRST)
+			return toUnsignedByte(value * 12.92f);
+
+		// negative values have the sign bit set and land here too
+		if (bits >= SRGB_TABLE_LAST)
+			return (bits & 0x80000000) ? 0 : 255;
+
+		return table[(bits - SRGB_TABLE_FIRST) >> SRGB_TABLE_SHIFT];
+	}
+
+	void unsignedByteToFloat(const uint8_t* src, float* dst, size_t count) {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = float(src[i]) * (1.0f / 255.0f);
+	}
+
+	void floatToUnsignedByte(const float* src, uint8_t* dst, size_t count) {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = toUnsignedByte(src[i]);
+	}
+
+	void rgbToRGBA(const float* src, float* dst, size_t pixels, float alpha) {
+		for (size_t i = 0; i < pixels; i++) {
+			dst[i * 4 + 0] = src[i * 3 + 0];
+			dst[i * 4 + 1] = src[i * 3 + 1];
+			dst[i * 4 + 2] = src[i * 3 + 2];
+			dst[i * 4 + 3] = alpha;
+		}
+	}
+
+	void rgbToRGBA(const uint8_t* src, uint8_t* dst, size_t pixels, uint8_t alpha) {
+		for (size_t i = 0; i < pixels; i++) {
+			dst[i * 4 + 0] = src[i * 3 + 0];
+			dst[i * 4 + 1] = src[i * 3 + 1];
+			dst[i * 4 + 2] = src[i * 3 + 2];
+			dst[i * 4 + 3] = alpha;
+		}
+	}
+
+	void srgbToLinear(const uint8_t* src, float* dst, size_t pixels, int components) {
+		const float* table = getLinearTable().data();
+		const int colors = std::min(components, 3);
+
+		for (size_t i = 0; i < pixels; i++) {
+			for (int c = 0; c < colors; c++)
+				dst[i * components + c] = table[src[i * components + c]];
+
+			if (components == 4)
+				dst[i * 4 + 3] = float(src[i * 4 + 3]) * (1.0f / 255.0f);
+		}
+	}
+
+	void linearToSRGB(const float* src, uint8_t* dst, size_t pixels, int components) {
+		const uint8_t* table = getSRGBTable().data();
+		const int colors = std::min(components, 3);
+
+		for (size_t i = 0; i < pixels; i++) {
+			for (int c = 0; c < colors; c++)
+				dst[i * components + c] = toSRGB(src[i * components + c], table);
+
+			if (components == 4)
+				dst[i * 4 + 3] = toUnsignedByte(src[i * 4 + 3]);
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include <glm/glm.hpp>
+
+enum eBitmapFormat {
+	eBitmapFormat_UnsignedByte,
+	eBitmapFormat_Float
+};
+
+template<eBitmapFormat Format> struct BitmapComponent;
+template<> struct BitmapComponent<eBitmapFormat_UnsignedByte>	{ using Type = uint8_t; };
+template<> struct BitmapComponent<eBitmapFormat_Float>			{ using Type = float; };
+
+// Note: Non owning, typed view of tightly packed pixels, the format and channel count are compile time constants so
+// pixel access inlines down to plain loads and stores. Rows are handed out as spans for loops the compiler can vectorize,
+// whole images go through the kernels below. Load/Store convert through glm::vec4 like Bitmap::getPixel/setPixel
+// (unsigned bytes as [0, 1]) for code that wants one texel at a time.
+template<eBitmapFormat Format, int Components, bool ReadOnly = false>
+class BitmapView {
+public:
+	using Component = std::conditional_t<ReadOnly, const typename BitmapComponent<Format>::Type, typename BitmapComponent<Format>::Type>;
+
+	static_assert(Components >= 1 && Components <= 4, "R/RG/RGB/RGBA only");
+
+	BitmapView() = default;
+	BitmapView(Component* data, int width, int height) : m_Data(data), m_Width(width), m_Height(height) {}
+
+	// a writable view converts to a read only one
+	operator BitmapView<Format, Components, true>() const requires (!ReadOnly) { return BitmapView<Format, Components, true>(m_Data, m_Width, m_Height); }
+
+	int getWidth() const { return m_Width; }
+	int getHeight() const { return m_Height; }
+	Component* data() const { return m_Data; }
+
+	std::span<Component> row(int y) const {
+		assert(y >= 0 && y < m_Height);
+		return std::span<Component>(m_Data + size_t(y) * m_Width * Components, size_t(m_Width) * Components);
+	}
+
+	Component* at(int x, int y) const {
+		return m_Data + (size_t(y) * m_Width + x) * Components;
+	}
+
+	glm::vec4 load(int x, int y) const {
+		const Component* pixel = at(x, y);
+		glm::vec4 color(0.0f);
+
+		for (int c = 0; c < Components; c++)
+			color[c] = toFloat(pixel[c]);
+
+		return color;
+	}
+
+	void store(int x, int y, const glm::vec4& color) const requires (!ReadOnly) {
+		Component* pixel = at(x, y);
+
+		for (int c = 0; c < Components; c++)
+			pixel[c] = fromFloat(color[c]);
+	}
+
+private:
+	static float toFloat(uint8_t value) { return float(value) / 255.0f; }
+	static float toFloat(float value) { return value; }
+
+	// truncates like Bitmap always did
+	static typename BitmapComponent<Format>::Type fromFloat(float value) {
+		if constexpr (Format == eBitmapFormat_UnsignedByte)
+			return uint8_t(value * 255.0f);
+		else
+			return value;
+	}
+
+private:
+	Component* m_Data = nullptr;
+	int m_Width = 0;
+	int m_Height = 0;
+};
+
+template<eBitmapFormat Format, int Components>
+using ConstBitmapView = BitmapView<Format, Components, true>;
+
+// Bulk conversions over 'count' components or 'pixels' pixels, straight loops without per pixel dispatch.
+namespace BitmapKernels {
+
+	// [0, 255] <-> [0, 1], the float to byte direction rounds to nearest and clamps
+	void unsignedByteToFloat(const uint8_t* src, float* dst, size_t count);
+	void floatToUnsignedByte(const float* src, uint8_t* dst, size_t count);
+
+	// appends 'alpha' to every pixel
+	void rgbToRGBA(const float* src, float* dst, size_t pixels, float alpha = 1.0f);
+	void rgbToRGBA(const uint8_t* src, uint8_t* dst, size_t pixels, uint8_t alpha = 255);
+
+	// table driven sRGB transfer, the fourth component (alpha) is always linear
+	void srgbToLinear(const uint8_t* src, float* dst, size_t pixels, int components);
+	void linearToSRGB(const float* src, uint8_t* dst, size_t pixels, int components);
+}
@@ -0,0 +1,673 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Utils {
+
+	namespace {
+		constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		struct BitWriter {
+			uint8_t* Data		= nullptr;
+			uint32_t Position	= 0;
+
+			void Write(uint32_t value, uint32_t bits) {
+				for (uint32_t i = 0; i < bits; i++, Position++) {
+					if ((value >> i) & 1)
+						Data[Position >> 3] |= static_cast<uint8_t>(1 << (Position & 7));
+				}
+			}
+		};
+
+		struct BitReader {
+			const uint8_t* Data = nullptr;
+			uint32_t Position	= 0;
+
+			uint32_t Read(uint32_t bits) {
+				uint32_t value = 0;
+
+				for (uint32_t i = 0; i < bits; i++, Position++)
+					value |= static_cast<uint32_t>((Data[Position >> 3] >> (Position & 7)) & 1) << i;
+
+				return value;
+			}
+		};
+
+		// Principal axis of the texels through their mean, a few power iterations are plenty for 16 points.
+		template<int Channels>
+		void ComputePrincipalAxis(const uint8_t* block, float* mean, float* axis) {
+			float covariance[Channels][Channels] = {};
+
+			for (int c = 0; c < Channels; c++) {
+				mean[c] = 0.0f;
+
+				for (int i = 0; i < 16; i++)
+					mean[c] += block[i * 4 + c];
+
+				mean[c] /= 16.0f;
+			}
+
+			for (int i = 0; i < 16; i++) {
+				for (int a = 0; a < Channels; a++) {
+					for (int b = 0; b < Channels; b++)
+						covariance[a][b] += (block[i * 4 + a] - mean[a]) * (block[i * 4 + b] - mean[b]);
+				}
+			}
+
+			for (int c = 0; c < Channels; c++)
+				axis[c] = 1.0f;
+
+			for (int iteration = 0; iteration < 8; iteration++) {
+				float next[Channels] = {};
+				float length = 0.0f;
+
+				for (int a = 0; a < Channels; a++) {
+					for (int b = 0; b < Channels; b++)
+						next[a] += covariance[a][b] * axis[b];
+
+					length = std::max(length, std::abs(next[a]));
+				}
+
+				if (length <= 0.0f) {
+					for (int c = 0; c < Channels; c++)
+						axis[c] = 0.0f;
+
+					return;
+				}
+
+				for (int c = 0; c < Channels; c++)
+					axis[c] = next[c] / length;
+			}
+		}
+
+		// Endpoints at the extremes of the projection on the principal axis.
+		template<int Channels>
+		void ComputeEndpoints(const uint8_t* block, float* low, float* high) {
+			float mean[Channels];
+			float axis[Channels];
+
+			ComputePrincipalAxis<Channels>(block, mean, axis);
+
+			// Note: the axis is scaled to its largest component, not to unit length, so the projections are divided 
+			// by its squared length to stay in texel units
+			float lengthSquared = 0.0f;
+
+			for (int c = 0; c < Channels; c++)
+				lengthSquared += axis[c] * axis[c];
+
+			float minT = 0.0f, maxT = 0.0f;
+
+			for (int i = 0; i < 16 && lengthSquared > 0.0f; i++) {
+				float t = 0.0f;
+
+				for (int c = 0; c < Channels; c++)
+					t += (block[i * 4 + c] - mean[c]) * axis[c];
+
+				t /= lengthSquared;
+
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (int c = 0; c < Channels; c++) {
+				low[c]	= std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+				high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+			}
+		}
+
+		// Least squares endpoints for fixed per texel weights (weight of 'high').
+		template<int Channels>
+		bool SolveEndpoints(const uint8_t* block, const float* weights, float* low, float* high) {
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[Channels] = {};
+			float bx[Channels] = {};
+
+			for (int i = 0; i < 16; i++) {
+				float b = weights[i];
+				float a = 1.0f - b;
+
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+
+				for (int c = 0; c < Channels; c++) {
+					ax[c] += a * block[i * 4 + c];
+					bx[c] += b * block[i * 4 + c];
+				}
+			}
+
+			float determinant = aa * bb - ab * ab;
+
+			if (std::abs(determinant) < 1e-6f)
+				return false;
+
+			for (int c = 0; c < Channels; c++) {
+				low[c]	= std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+				high[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+			}
+
+			return true;
+		}
+
+		// ------------------------------------------------------------------------------------------------------------
+		// BC1 color block
+
+		inline uint16_t PackRGB565(const float* color) {
+			uint32_t r = static_cast<uint32_t>(std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+			uint32_t g = static_cast<uint32_t>(std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+			uint32_t b = static_cast<uint32_t>(std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		inline void UnpackRGB565(uint16_t color, int* rgb) {
+			int r = (color >> 11) & 31;
+			int g = (color >> 5) & 63;
+			int b = color & 31;
+
+			rgb[0] = (r << 3) | (r >> 2);
+			rgb[1] = (g << 2) | (g >> 4);
+			rgb[2] = (b << 3) | (b >> 2);
+		}
+
+		void GetColorPalette(uint16_t c0, uint16_t c1, bool forceFourColors, int palette[4][3]) {
+			UnpackRGB565(c0, palette[0]);
+			UnpackRGB565(c1, palette[1]);
+
+			bool fourColors = forceFourColors || c0 > c1;
+
+			for (int c = 0; c < 3; c++) {
+				if (fourColors) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+				} else {
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+			}
+		}
+
+		// Fits the block with the quantized endpoints, returns the squared error. The endpoints are swapped when needed
+		// so c0 > c1 (four color mode), equal endpoints leave every index on c0.
+		uint32_t FitColorIndices(const uint8_t* block, uint16_t& c0, uint16_t& c1, uint8_t* indices) {
+			if (c0 < c1)
+				std::swap(c0, c1);
+
+			int palette[4][3];
+			GetColorPalette(c0, c1, true, palette);
+
+			uint32_t error = 0;
+			int paletteSize = c0 == c1 ? 1 : 4;
+
+			for (int i = 0; i < 16; i++) {
+				uint32_t best = std::numeric_limits<uint32_t>::max();
+
+				for (int p = 0; p < paletteSize; p++) {
+					uint32_t distance = 0;
+
+					for (int c = 0; c < 3; c++) {
+						int delta = block[i * 4 + c] - palette[p][c];
+						distance += delta * delta;
+					}
+
+					if (distance < best) {
+						best = distance;
+						indices[i] = static_cast<uint8_t>(p);
+					}
+				}
+
+				error += best;
+			}
+
+			return error;
+		}
+
+		void WriteColorBlock(uint16_t c0, uint16_t c1, const uint8_t* indices, uint8_t* dst) {
+			uint32_t bits = 0;
+
+			for (int i = 0; i < 16; i++)
+				bits |= static_cast<uint32_t>(indices[i]) << (2 * i);
+
+			dst[0] = static_cast<uint8_t>(c0);
+			dst[1] = static_cast<uint8_t>(c0 >> 8);
+			dst[2] = static_cast<uint8_t>(c1);
+			dst[3] = static_cast<uint8_t>(c1 >> 8);
+
+			std::memcpy(dst + 4, &bits, sizeof(bits));
+		}
+
+		void EncodeColorBlock(const uint8_t* block, uint8_t* dst) {
+			float low[3], high[3];
+			ComputeEndpoints<3>(block, low, high);
+
+			uint16_t c0 = PackRGB565(high);
+			uint16_t c1 = PackRGB565(low);
+			uint8_t indices[16];
+
+			uint32_t error = FitColorIndices(block, c0, c1, indices);
+
+			// one least squares pass over the chosen indices, kept only when it beats the principal axis fit
+			const float c1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float weights[16];
+
+			for (int i = 0; i < 16; i++)
+				weights[i] = c1Weights[indices[i]];
+
+			if (error > 0 && SolveEndpoints<3>(block, weights, high, low)) {
+				uint16_t refined0 = PackRGB565(high);
+				uint16_t refined1 = PackRGB565(low);
+				uint8_t refinedIndices[16];
+
+				uint32_t refinedError = FitColorIndices(block, refined0, refined1, refinedIndices);
+
+				if (refinedError < error) {
+					c0 = refined0;
+					c1 = refined1;
+					std::memcpy(indices, refinedIndices, sizeof(indices));
+				}
+			}
+
+			WriteColorBlock(c0, c1, indices, dst);
+		}
+
+		void DecodeColorBlock(const uint8_t* src, bool forceFourColors, uint8_t* block) {
+			uint16_t c0 = static_cast<uint16_t>(src[0] | (src[1] << 8));
+			uint16_t c1 = static_cast<uint16_t>(src[2] | (src[3] << 8));
+
+			uint32_t bits = 0;
+			std::memcpy(&bits, src + 4, sizeof(bits));
+
+			int palette[4][3];
+			GetColorPalette(c0, c1, forceFourColors, palette);
+
+			for (int i = 0; i < 16; i++) {
+				uint32_t index = (bits >> (2 * i)) & 3;
+
+				for (int c = 0; c < 3; c++)
+					block[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+			}
+		}
+
+		// ------------------------------------------------------------------------------------------------------------
+		// BC4 single channel block (also the alpha of BC3 and both channels of BC5)
+
+		void GetChannelPalette(uint8_t a0, uint8_t a1, int palette[8]) {
+			palette[0] = a0;
+			palette[1] = a1;
+
+			if (a0 > a1) {
+				for (int i = 1; i < 7; i++)
+					palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+			} else {
+				for (int i = 1; i < 5; i++)
+					palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		uint32_t FitChannelIndices(const uint8_t* values, uint8_t a0, uint8_t a1, uint8_t* indices) {
+			int palette[8];
+			GetChannelPalette(a0, a1, palette);
+
+			uint32_t error = 0;
+
+			for (int i = 0; i < 16; i++) {
+				uint32_t best = std::numeric_limits<uint32_t>::max();
+
+				for (int p = 0; p < 8; p++) {
+					int delta = values[i] - palette[p];
+					uint32_t distance = delta * delta;
+
+					if (distance < best) {
+						best = distance;
+						indices[i] = static_cast<uint8_t>(p);
+					}
+				}
+
+				error += best;
+			}
+
+			return error;
+		}
+
+		// Tries the eight value ramp between the extremes and the six value ramp with exact 0 and 255 (better for blocks
+		// mixing masked texels with a gradient), keeps the lower error.
+		void EncodeChannelBlock(const uint8_t* block, int channel, uint8_t* dst) {
+			uint8_t values[16];
+			uint8_t minValue = 255, maxValue = 0;
+			uint8_t minInner = 255, maxInner = 0;
+
+			for (int i = 0; i < 16; i++) {
+				values[i] = block[i * 4 + channel];
+
+				minValue = std::min(minValue, values[i]);
+				maxValue = std::max(maxValue, values[i]);
+
+				if (values[i] != 0 && values[i] != 255) {
+					minInner = std::min(minInner, values[i]);
+					maxInner = std::max(maxInner, values[i]);
+				}
+			}
+
+			if (minInner > maxInner)
+				minInner = maxInner = 0;
+
+			uint8_t a0 = minInner, a1 = maxInner;
+			uint8_t indices[16];
+			uint32_t error = FitChannelIndices(values, a0, a1, indices);
+
+			if (maxValue > minValue && error > 0) {
+				uint8_t rampIndices[16];
+				uint32_t rampError = FitChannelIndices(values, maxValue, minValue, rampIndices);
+
+				if (rampError < error) {
+					a0 = maxValue;
+					a1 = minValue;
+					std::memcpy(indices, rampIndices, sizeof(indices));
+				}
+			}
+
+			uint64_t bits = 0;
+
+			for (int i = 0; i < 16; i++)
+				bits |= static_cast<uint64_t>(indices[i]) << (3 * i);
+
+			dst[0] = a0;
+			dst[1] = a1;
+
+			for (int i = 0; i < 6; i++)
+				dst[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+		}
+
+		void DecodeChannelBlock(const uint8_t* src, int channel, uint8_t* block) {
+			int palette[8];
+			GetChannelPalette(src[0], src[1], palette);
+
+			uint64_t bits = 0;
+
+			for (int i = 0; i < 6; i++)
+				bits |= static_cast<uint64_t>(src[2 + i]) << (8 * i);
+
+			for (int i = 0; i < 16; i++)
+				block[i * 4 + channel] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+		}
+
+		// ------------------------------------------------------------------------------------------------------------
+		// BC7 mode 6: one subset, 7 bit RGBA endpoints plus a p-bit each, 4 bit indices
+
+		struct Mode6Endpoint {
+			uint8_t Value[4]	= {};		// 7 bits per channel
+			uint8_t PBit		= 0;
+		};
+
+		inline int ExpandMode6(const Mode6Endpoint& endpoint, int channel) {
+			return (endpoint.Value[channel] << 1) | endpoint.PBit;
+		}
+
+		Mode6Endpoint QuantizeMode6(const float* color) {
+			Mode6Endpoint best = {};
+			float bestError = std::numeric_limits<float>::max();
+
+			for (uint8_t p = 0; p < 2; p++) {
+				Mode6Endpoint endpoint = {};
+				endpoint.PBit = p;
+
+				float error = 0.0f;
+
+				for (int c = 0; c < 4; c++) {
+					endpoint.Value[c] = static_cast<uint8_t>(std::clamp<long>(std::lround((color[c] - p) * 0.5f), 0, 127));
+
+					float delta = color[c] - ExpandMode6(endpoint, c);
+					error += delta * delta;
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					best = endpoint;
+				}
+			}
+
+			return best;
+		}
+
+		uint32_t FitMode6Indices(const uint8_t* block, const Mode6Endpoint& e0, const Mode6Endpoint& e1, uint8_t* indices) {
+			int palette[16][4];
+
+			for (int w = 0; w < 16; w++) {
+				for (int c = 0; c < 4; c++)
+					palette[w][c] = ((64 - BC7_WEIGHTS[w]) * ExpandMode6(e0, c) + BC7_WEIGHTS[w] * ExpandMode6(e1, c) + 32) >> 6;
+			}
+
+			uint32_t error = 0;
+
+			for (int i = 0; i < 16; i++) {
+				uint32_t best = std::numeric_limits<uint32_t>::max();
+
+				for (int w = 0; w < 16; w++) {
+					uint32_t distance = 0;
+
+					for (int c = 0; c < 4; c++) {
+						int delta = block[i * 4 + c] - palette[w][c];
+						distance += delta * delta;
+					}
+
+					if (distance < best) {
+						best = distance;
+						indices[i] = static_cast<uint8_t>(w);
+					}
+				}
+
+				error += best;
+			}
+
+			return error;
+		}
+
+		void EncodeMode6Block(const uint8_t* block, uint8_t* dst) {
+			float low[4], high[4];
+			ComputeEndpoints<4>(block, low, high);
+
+			Mode6Endpoint e0 = QuantizeMode6(low);
+			Mode6Endpoint e1 = QuantizeMode6(high);
+			uint8_t indices[16];
+
+			uint32_t error = FitMode6Indices(block, e0, e1, indices);
+
+			float weights[16];
+
+			for (int i = 0; i < 16; i++)
+				weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+
+			if (error > 0 && SolveEndpoints<4>(block, weights, low, high)) {
+				Mode6Endpoint refined0 = QuantizeMode6(low);
+				Mode6Endpoint refined1 = QuantizeMode6(high);
+				uint8_t refinedIndices[16];
+
+				uint32_t refinedError = FitMode6Indices(block, refined0, refined1, refinedIndices);
+
+				if (refinedError < error) {
+					e0 = refined0;
+					e1 = refined1;
+					std::memcpy(indices, refinedIndices, sizeof(indices));
+				}
+			}
+
+			// the most significant index bit of the first texel is implicit zero
+			if (indices[0] & 8) {
+				std::swap(e0, e1);
+
+				for (int i = 0; i < 16; i++)
+					indices[i] = static_cast<uint8_t>(15 - indices[i]);
+			}
+
+			std::memset(dst, 0, 16);
+
+			BitWriter writer = { dst, 0 };
+			writer.Write(1 << 6, 7);
+
+			for (int c = 0; c < 4; c++) {
+				writer.Write(e0.Value[c], 7);
+				writer.Write(e1.Value[c], 7);
+			}
+
+			writer.Write(e0.PBit, 1);
+			writer.Write(e1.PBit, 1);
+
+			for (int i = 0; i < 16; i++)
+				writer.Write(indices[i], i == 0 ? 3 : 4);
+		}
+
+		void DecodeMode6Block(const uint8_t* src, uint8_t* block) {
+			BitReader reader = { src, 0 };
+
+			if (reader.Read(7) != (1 << 6)) {
+				std::memset(block, 0, 64);
+				return;
+			}
+
+			Mode6Endpoint e0 = {}, e1 = {};
+
+			for (int c = 0; c < 4; c++) {
+				e0.Value[c] = static_cast<uint8_t>(reader.Read(7));
+				e1.Value[c] = static_cast<uint8_t>(reader.Read(7));
+			}
+
+			e0.PBit = static_cast<uint8_t>(reader.Read(1));
+			e1.PBit = static_cast<uint8_t>(reader.Read(1));
+
+			for (int i = 0; i < 16; i++) {
+				int weight = BC7_WEIGHTS[reader.Read(i == 0 ? 3 : 4)];
+
+				for (int c = 0; c < 4; c++)
+					block[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * ExpandMode6(e0, c) + weight * ExpandMode6(e1, c) + 32) >> 6);
+			}
+		}
+	}
+
+	uint32_t BlockCompressor::GetBlockSize(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1:
+		case BlockFormat::BC4:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+
+	size_t BlockCompressor::GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+		size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+		size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+
+		return blocksX * blocksY * GetBlockSize(format);
+	}
+
+	void BlockCompressor::CompressBlock(BlockFormat format, const uint8_t* block, uint8_t* dst) {
+		switch (format) {
+		case BlockFormat::BC1:
+			EncodeColorBlock(block, dst);
+			break;
+		case BlockFormat::BC3:
+			EncodeChannelBlock(block, 3, dst);
+			EncodeColorBlock(block, dst + 8);
+			break;
+		case BlockFormat::BC4:
+			EncodeChannelBlock(block, 0, dst);
+			break;
+		case BlockFormat::BC5:
+			EncodeChannelBlock(block, 0, dst);
+			EncodeChannelBlock(block, 1, dst + 8);
+			break;
+		case BlockFormat::BC7:
+			EncodeMode6Block(block, dst);
+			break;
+		}
+	}
+
+	void BlockCompressor::DecompressBlock(BlockFormat format, const uint8_t* src, uint8_t* block) {
+		for (int i = 0; i < 16; i++) {
+			block[i * 4 + 0] = 0;
+			block[i * 4 + 1] = 0;
+			block[i * 4 + 2] = 0;
+			block[i * 4 + 3] = 255;
+		}
+
+		switch (format) {
+		case BlockFormat::BC1:
+			DecodeColorBlock(src, false, block);
+			break;
+		case BlockFormat::BC3:
+			DecodeChannelBlock(src, 3, block);
+			DecodeColorBlock(src + 8, true, block);
+			break;
+		case BlockFormat::BC4:
+			DecodeChannelBlock(src, 0, block);
+			break;
+		case BlockFormat::BC5:
+			DecodeChannelBlock(src, 0, block);
+			DecodeChannelBlock(src + 8, 1, block);
+			break;
+		case BlockFormat::BC7:
+			DecodeMode6Block(src, block);
+			break;
+		}
+	}
+
+	void BlockCompressor::Compress(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst) {
+		uint32_t blocksX	= (width + 3) / 4;
+		uint32_t blocksY	= (height + 3) / 4;
+		uint32_t blockSize	= GetBlockSize(format);
+
+		uint8_t block[64];
+
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				for (uint32_t y = 0; y < 4; y++) {
+					uint32_t sy = std::min(by * 4 + y, height - 1);
+
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t sx = std::min(bx * 4 + x, width - 1);
+						std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+					}
+				}
+
+				CompressBlock(format, block, dst + (static_cast<size_t>(by) * blocksX + bx) * blockSize);
+			}
+		}
+	}
+
+	void BlockCompressor::Decompress(BlockFormat format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* rgba) {
+		uint32_t blocksX	= (width + 3) / 4;
+		uint32_t blocksY	= (height + 3) / 4;
+		uint32_t blockSize	= GetBlockSize(format);
+
+		uint8_t block[64];
+
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				DecompressBlock(format, src + (static_cast<size_t>(by) * blocksX + bx) * blockSize, block);
+
+				for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+						std::memcpy(rgba + ((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	const char* BlockCompressor::GetFormatName(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return "BC1";
+		case BlockFormat::BC3: return "BC3";
+		case BlockFormat::BC4: return "BC4";
+		case BlockFormat::BC5: return "BC5";
+		case BlockFormat::BC7: return "BC7";
+		}
+
+		return "Unknown";
+	}
+}
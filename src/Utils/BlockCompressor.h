@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils {
+
+	enum class BlockFormat : uint32_t {
+		BC1 = 0,		// RGB, 4 bpp
+		BC3 = 1,		// RGB + BC4 alpha, 8 bpp
+		BC4 = 2,		// R, 4 bpp
+		BC5 = 3,		// RG, 8 bpp (normal maps, Z is rebuilt in the shader)
+		BC7 = 4			// RGBA, 8 bpp
+	};
+
+	// Note: CPU only encoder/decoder for 4x4 block compressed formats, no graphics API involved so it can run in
+	// tools and tests. Input and output pixels are always RGBA8, channels a format doesn't store decode as R=G=B=0
+	// (or 0 for B in BC5) and A=255. BC7 blocks are always written in mode 6 (one subset, RGBA endpoints with p-bits),
+	// the decoder only understands the blocks this encoder writes.
+	class BlockCompressor {
+	public:
+		BlockCompressor() {};
+		~BlockCompressor() {};
+
+		static uint32_t GetBlockSize(BlockFormat format);
+		static size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+		// 'block' is 16 RGBA8 texels in row order
+		static void CompressBlock(BlockFormat format, const uint8_t* block, uint8_t* dst);
+		static void DecompressBlock(BlockFormat format, const uint8_t* src, uint8_t* block);
+
+		// Partial blocks on the right and bottom edges repeat the last row/column.
+		static void Compress(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst);
+		static void Decompress(BlockFormat format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* rgba);
+
+		static const char* GetFormatName(BlockFormat format);
+	};
+}
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <fstream>
+#include <cstdint>
+#include <cstring>
 
 namespace Helper {
 
@@ -107,4 +109,47 @@ namespace Helper {
 		std::ifstream f(path.c_str());
 		return f.good();
 	}
+
+	// Note: 64-bit content hash used to validate on-disk caches, consumes 8 bytes per step so hashing 
+	// multi-megabyte source files stays cheap. Not meant to be cryptographically strong.
+	inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+		const uint64_t m = 0xc6a4a7935bd1e995ull;
+		const int r = 47;
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t h = seed ^ (size * m);
+
+		size_t blocks = size / 8;
+
+		for (size_t i = 0; i < blocks; i++) {
+			uint64_t k = 0;
+			memcpy(&k, bytes + i * 8, sizeof(uint64_t));
+
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+
+			h ^= k;
+			h *= m;
+		}
+
+		const uint8_t* tail = bytes + blocks * 8;
+
+		switch (size & 7) {
+		case 7: h ^= uint64_t(tail[6]) << 48; [[fallthrough]];
+		case 6: h ^= uint64_t(tail[5]) << 40; [[fallthrough]];
+		case 5: h ^= uint64_t(tail[4]) << 32; [[fallthrough]];
+		case 4: h ^= uint64_t(tail[3]) << 24; [[fallthrough]];
+		case 3: h ^= uint64_t(tail[2]) << 16; [[fallthrough]];
+		case 2: h ^= uint64_t(tail[1]) << 8;  [[fallthrough]];
+		case 1: h ^= uint64_t(tail[0]);
+				h *= m;
+		};
+
+		h ^= h >> r;
+		h *= m;
+		h ^= h >> r;
+
+		return h;
+	}
 }
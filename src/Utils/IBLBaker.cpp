@@ -0,0 +1,552 @@
+#include "IBLBaker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include "UtilsCubemap.h"
+
+namespace Utils {
+
+	static constexpr float PI = 3.14159265359f;
+
+	constexpr uint32_t CACHE_MAGIC		= 0x4c424956;	// "VIBL"
+	constexpr uint32_t CACHE_VERSION	= 1;
+
+	struct CacheHeader {
+		uint32_t Magic				= CACHE_MAGIC;
+		uint32_t Version			= CACHE_VERSION;
+		IBLSettings Settings		= {};
+		uint32_t SpecularSize		= 0;
+		uint32_t SpecularMipLevels	= 0;
+		uint32_t BRDFSize			= 0;
+
+		uint64_t SourceSize			= 0;
+		int64_t  SourceTime			= 0;
+		uint64_t SourceHash			= 0;
+
+		uint64_t SpecularCount		= 0;	// floats
+		uint64_t BRDFCount			= 0;	// floats
+
+		float Irradiance[27]		= {};
+	};
+
+	// specular levels follow the (16 bytes aligned) header, then the BRDF LUT
+	static uint64_t GetDataOffset() {
+		return (sizeof(CacheHeader) + 15) & ~uint64_t(15);
+	}
+
+	static bool SameSettings(const IBLSettings& a, const IBLSettings& b) {
+		return a.SpecularSize == b.SpecularSize
+			&& a.SpecularMipLevels == b.SpecularMipLevels
+			&& a.SpecularSamples == b.SpecularSamples
+			&& a.BRDFSize == b.BRDFSize
+			&& a.BRDFSamples == b.BRDFSamples;
+	}
+
+	static glm::vec2 hammersley(uint32_t i, uint32_t count) {
+		uint32_t bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+		return glm::vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10f);
+	}
+
+	// half vector around +Z distributed like GGX(alpha) * NdotH
+	static glm::vec3 importanceSampleGGX(const glm::vec2& xi, float alpha) {
+		const float phi = 2.0f * PI * xi.x;
+		const float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y));
+		const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+		return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+	}
+
+	static float areaElement(float x, float y) {
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+	}
+
+	// solid angle of texel (x, y) of a 'size' face
+	static float texelSolidAngle(uint32_t x, uint32_t y, uint32_t size) {
+		const float invSize = 1.0f / float(size);
+		const float u = (2.0f * (float(x) + 0.5f)) * invSize - 1.0f;
+		const float v = (2.0f * (float(y) + 0.5f)) * invSize - 1.0f;
+
+		const float x0 = u - invSize;
+		const float x1 = u + invSize;
+		const float y0 = v - invSize;
+		const float y1 = v + invSize;
+
+		return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+	}
+
+	static void evaluateSHBasis(const glm::vec3& n, float* basis) {
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * n.y;
+		basis[2] = 0.488603f * n.z;
+		basis[3] = 0.488603f * n.x;
+		basis[4] = 1.092548f * n.x * n.y;
+		basis[5] = 1.092548f * n.y * n.z;
+		basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+		basis[7] = 1.092548f * n.x * n.z;
+		basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+	}
+
+	// Source mip chain sampled by direction, bilinear inside a face (clamped at the face edges) and linear between levels.
+	class CubeSampler {
+	public:
+		explicit CubeSampler(const Bitmap& cubemap) {
+			m_Levels.push_back(&cubemap);
+
+			while (m_Levels.back()->getWidth() > 1) {
+				m_Storage.push_back(std::make_unique<Bitmap>(downsampleCubeMapFaces(*m_Levels.back())));
+				m_Levels.push_back(m_Storage.back().get());
+			}
+		}
+
+		uint32_t GetSize() const { return static_cast<uint32_t>(m_Levels[0]->getWidth()); }
+		uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+		const Bitmap& GetLevel(uint32_t level) const { return *m_Levels[level]; }
+
+		glm::vec3 Sample(const glm::vec3& dir, float lod) const {
+			lod = std::clamp(lod, 0.0f, float(m_Levels.size() - 1));
+
+			uint32_t face;
+			float s;
+			float t;
+			SelectFace(dir, face, s, t);
+
+			const uint32_t level0 = static_cast<uint32_t>(lod);
+			const uint32_t level1 = std::min(level0 + 1, GetLevelCount() - 1);
+			const float blend = lod - float(level0);
+
+			const glm::vec3 a = SampleFace(*m_Levels[level0], face, s, t);
+
+			if (blend <= 0.0f || level1 == level0)
+				return a;
+
+			return a * (1.0f - blend) + SampleFace(*m_Levels[level1], face, s, t) * blend;
+		}
+
+	private:
+		static void SelectFace(const glm::vec3& dir, uint32_t& face, float& s, float& t) {
+			const float ax = std::fabs(dir.x);
+			const float ay = std::fabs(dir.y);
+			const float az = std::fabs(dir.z);
+
+			float ma;
+			float sc;
+			float tc;
+
+			if (ax >= ay && ax >= az) {
+				face = dir.x > 0.0f ? 0 : 1;
+				ma = ax;
+				sc = dir.x > 0.0f ? -dir.z : dir.z;
+				tc = -dir.y;
+			}
+			else if (ay >= az) {
+				face = dir.y > 0.0f ? 2 : 3;
+				ma = ay;
+				sc = dir.x;
+				tc = dir.y > 0.0f ? dir.z : -dir.z;
+			}
+			else {
+				face = dir.z > 0.0f ? 4 : 5;
+				ma = az;
+				sc = dir.z > 0.0f ? dir.x : -dir.x;
+				tc = -dir.y;
+			}
+
+			s = 0.5f * (sc / ma + 1.0f);
+			t = 0.5f * (tc / ma + 1.0f);
+		}
+
+		static glm::vec3 SampleFace(const Bitmap& level, uint32_t face, float s, float t) {
+			const ConstBitmapView<eBitmapFormat_Float, 4> texels = level.view<eBitmapFormat_Float, 4>(face);
+			const int size = texels.getWidth();
+
+			const float x = std::clamp(s * float(size) - 0.5f, 0.0f, float(size - 1));
+			const float y = std::clamp(t * float(size) - 0.5f, 0.0f, float(size - 1));
+
+			const int x0 = int(x);
+			const int y0 = int(y);
+			const int x1 = std::min(x0 + 1, size - 1);
+			const int y1 = std::min(y0 + 1, size - 1);
+
+			const float fx = x - float(x0);
+			const float fy = y - float(y0);
+
+			auto fetch = [&](int px, int py) {
+				const float* texel = texels.at(px, py);
+				return glm::vec3(texel[0], texel[1], texel[2]);
+			};
+
+			return (fetch(x0, y0) * (1.0f - fx) + fetch(x1, y0) * fx) * (1.0f - fy)
+				+ (fetch(x0, y1) * (1.0f - fx) + fetch(x1, y1) * fx) * fy;
+		}
+
+	private:
+		std::vector<const Bitmap*> m_Levels;
+		std::vector<std::unique_ptr<Bitmap>> m_Storage;
+	};
+
+	glm::vec3 IBLBaker::GetTexelDirection(uint32_t face, float x, float y, uint32_t size) {
+		const float u = 2.0f * (x + 0.5f) / float(size) - 1.0f;
+		const float v = 2.0f * (y + 0.5f) / float(size) - 1.0f;
+
+		glm::vec3 dir;
+
+		switch (face) {
+		case 0:		dir = glm::vec3(1.0f, -v, -u);	break;
+		case 1:		dir = glm::vec3(-1.0f, -v, u);	break;
+		case 2:		dir = glm::vec3(u, 1.0f, v);	break;
+		case 3:		dir = glm::vec3(u, -1.0f, -v);	break;
+		case 4:		dir = glm::vec3(u, -v, 1.0f);	break;
+		default:	dir = glm::vec3(-u, -v, -1.0f);	break;
+		}
+
+		return glm::normalize(dir);
+	}
+
+	void IBLBaker::ComputeIrradiance(const Bitmap& cubemap, SHIrradiance& irradiance) {
+		// the projection only keeps low frequencies, a box filtered level of at most 128 texels loses nothing that matters
+		Bitmap reduced;
+		const Bitmap* source = &cubemap;
+
+		while (source->getWidth() > 128) {
+			reduced = downsampleCubeMapFaces(*source);
+			source = &reduced;
+		}
+
+		const uint32_t size = static_cast<uint32_t>(source->getWidth());
+
+		// one partial sum per row, added up in order afterwards so the result doesn't depend on the thread count
+		std::vector<SHIrradiance> rows(size_t(6) * size);
+
+		Utils::ParallelFor(rows.size(), [&](size_t row) {
+			const uint32_t face = static_cast<uint32_t>(row / size);
+			const uint32_t y = static_cast<uint32_t>(row % size);
+
+			const std::span<const float> texels = source->view<eBitmapFormat_Float, 4>(face).row(y);
+
+			float basis[9];
+
+			for (uint32_t x = 0; x < size; x++) {
+				const glm::vec3 radiance(texels[x * 4 + 0], texels[x * 4 + 1], texels[x * 4 + 2]);
+				const float solidAngle = texelSolidAngle(x, y, size);
+
+				evaluateSHBasis(GetTexelDirection(face, float(x), float(y), size), basis);
+
+				for (int i = 0; i < 9; i++)
+					rows[row].Coefficients[i] += radiance * (basis[i] * solidAngle);
+			}
+		});
+
+		// clamped cosine convolution per band
+		const float bands[9] = { PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f };
+
+		irradiance = {};
+
+		for (const SHIrradiance& row : rows)
+			for (int i = 0; i < 9; i++)
+				irradiance.Coefficients[i] += row.Coefficients[i];
+
+		for (int i = 0; i < 9; i++)
+			irradiance.Coefficients[i] = irradiance.Coefficients[i] * bands[i];
+	}
+
+	glm::vec3 IBLBaker::EvaluateIrradiance(const SHIrradiance& irradiance, const glm::vec3& normal) {
+		float basis[9];
+		evaluateSHBasis(normal, basis);
+
+		glm::vec3 result(0.0f);
+
+		for (int i = 0; i < 9; i++)
+			result += irradiance.Coefficients[i] * basis[i];
+
+		return glm::max(result, glm::vec3(0.0f));
+	}
+
+	void IBLBaker::PrefilterSpecular(const Bitmap& cubemap, const IBLSettings& settings, IBLData& data) {
+		assert(cubemap.getType() == eBitmapType_Cube && cubemap.getFormat() == eBitmapFormat_Float && cubemap.getComp() == 4);
+
+		const CubeSampler sampler(cubemap);
+
+		const uint32_t size = std::max(settings.SpecularSize, 1u);
+		const uint32_t maxLevels = static_cast<uint32_t>(std::floor(std::log2(float(size)))) + 1;
+		const uint32_t levels = std::clamp(settings.SpecularMipLevels, 1u, maxLevels);
+
+		// solid angle of one source texel, what the sample lod is measured against
+		const float sourceTexel = 4.0f * PI / (6.0f * float(sampler.GetSize()) * float(sampler.GetSize()));
+
+		data.SpecularSize = size;
+		data.SpecularLevelOffsets.resize(levels);
+
+		uint64_t total = 0;
+
+		for (uint32_t level = 0; level < levels; level++) {
+			const uint64_t levelSize = std::max(size >> level, 1u);
+
+			data.SpecularLevelOffsets[level] = total;
+			total += levelSize * levelSize * 6 * 4;
+		}
+
+		data.Specular.assign(total, 0.0f);
+
+		struct Sample {
+			glm::vec3	Direction;	// around +Z
+			float		Weight;
+			float		Lod;
+		};
+
+		for (uint32_t level = 0; level < levels; level++) {
+			const uint32_t levelSize = std::max(size >> level, 1u);
+			const float roughness = levels > 1 ? float(level) / float(levels - 1) : 0.0f;
+			const float alpha = roughness * roughness;
+
+			// the sample set only depends on the level, N = V = R so every texel reuses it in its own tangent frame
+			std::vector<Sample> samples;
+
+			if (level == 0) {
+				const float lod = std::max(std::log2(float(sampler.GetSize()) / float(levelSize)), 0.0f);
+				samples.push_back({ glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, lod });
+			}
+			else {
+				const uint32_t count = std::max(settings.SpecularSamples, 1u);
+
+				for (uint32_t i = 0; i < count; i++) {
+					const glm::vec3 H = importanceSampleGGX(hammersley(i, count), alpha);
+					const glm::vec3 L = glm::vec3(2.0f * H.z * H.x, 2.0f * H.z * H.y, 2.0f * H.z * H.z - 1.0f);
+
+					if (L.z <= 0.0f)
+						continue;
+
+					// pdf(L) = D * NdotH / (4 * VdotH) = D / 4 with N = V
+					const float alpha2 = alpha * alpha;
+					const float d = H.z * H.z * (alpha2 - 1.0f) + 1.0f;
+					const float D = alpha2 / (PI * d * d);
+					const float sampleSolidAngle = 1.0f / (float(count) * D * 0.25f + 0.0001f);
+
+					// one level blurrier than the footprint hides the sampling pattern (filtered importance sampling)
+					const float lod = 0.5f * std::log2(sampleSolidAngle / sourceTexel) + 1.0f;
+
+					samples.push_back({ L, L.z, lod });
+				}
+			}
+
+			float* dst = data.Specular.data() + data.SpecularLevelOffsets[level];
+
+			Utils::ParallelFor(size_t(6) * levelSize, [&](size_t row) {
+				const uint32_t face = static_cast<uint32_t>(row / levelSize);
+				const uint32_t y = static_cast<uint32_t>(row % levelSize);
+
+				for (uint32_t x = 0; x < levelSize; x++) {
+					const glm::vec3 N = GetTexelDirection(face, float(x), float(y), levelSize);
+					const glm::vec3 up = std::fabs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+					const glm::vec3 T = glm::normalize(glm::cross(up, N));
+					const glm::vec3 B = glm::cross(N, T);
+
+					glm::vec3 sum(0.0f);
+					float weight = 0.0f;
+
+					for (const Sample& sample : samples) {
+						const glm::vec3 L = T * sample.Direction.x + B * sample.Direction.y + N * sample.Direction.z;
+
+						sum += sampler.Sample(L, sample.Lod) * sample.Weight;
+						weight += sample.Weight;
+					}
+
+					float* texel = dst + (row * levelSize + x) * 4;
+					const glm::vec3 color = weight > 0.0f ? sum / weight : glm::vec3(0.0f);
+
+					texel[0] = color.x;
+					texel[1] = color.y;
+					texel[2] = color.z;
+					texel[3] = 1.0f;
+				}
+			});
+		}
+	}
+
+	void IBLBaker::ComputeBRDF(const IBLSettings& settings, IBLData& data) {
+		const uint32_t size = std::max(settings.BRDFSize, 1u);
+		const uint32_t count = std::max(settings.BRDFSamples, 1u);
+
+		data.BRDFSize = size;
+		data.BRDF.assign(size_t(size) * size * 2, 0.0f);
+
+		Utils::ParallelFor(size, [&](size_t y) {
+			const float roughness = (float(y) + 0.5f) / float(size);
+			const float alpha = roughness * roughness;
+
+			// Schlick-Smith with k = alpha / 2 for image based lighting
+			const float k = alpha * 0.5f;
+
+			for (uint32_t x = 0; x < size; x++) {
+				const float NdotV = (float(x) + 0.5f) / float(size);
+				const glm::vec3 V(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+
+				float scale = 0.0f;
+				float bias = 0.0f;
+
+				for (uint32_t i = 0; i < count; i++) {
+					const glm::vec3 H = importanceSampleGGX(hammersley(i, count), alpha);
+					const float VdotH = glm::dot(V, H);
+					const glm::vec3 L = H * (2.0f * VdotH) - V;
+
+					const float NdotL = L.z;
+					const float NdotH = H.z;
+
+					if (NdotL <= 0.0f)
+						continue;
+
+					const float G = (NdotV / (NdotV * (1.0f - k) + k)) * (NdotL / (NdotL * (1.0f - k) + k));
+					const float visibility = G * std::max(VdotH, 0.0f) / (NdotH * NdotV);
+					const float fresnel = std::pow(1.0f - std::max(VdotH, 0.0f), 5.0f);
+
+					scale += (1.0f - fresnel) * visibility;
+					bias += fresnel * visibility;
+				}
+
+				float* texel = data.BRDF.data() + (y * size + x) * 2;
+				texel[0] = scale / float(count);
+				texel[1] = bias / float(count);
+			}
+		});
+	}
+
+	void IBLBaker::Bake(const Bitmap& cubemap, const IBLSettings& settings, IBLData& data) {
+		ComputeIrradiance(cubemap, data.Irradiance);
+		PrefilterSpecular(cubemap, settings, data);
+		ComputeBRDF(settings, data);
+	}
+
+	std::string IBLBaker::GetCachePath(const std::string& sourcePath) {
+		return sourcePath + ".ibl";
+	}
+
+	bool IBLBaker::ReadCache(const std::string& sourcePath, const IBLSettings& settings, IBLData& data) {
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+
+		if (!Utils::GetFileStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		MappedFile file;
+
+		if (!file.Open(GetCachePath(sourcePath)) || file.GetSize() < GetDataOffset())
+			return false;
+
+		CacheHeader header;
+		memcpy(&header, file.GetData(), sizeof(CacheHeader));
+
+		bool valid = header.Magic == CACHE_MAGIC
+			&& header.Version == CACHE_VERSION
+			&& SameSettings(header.Settings, settings)
+			&& header.SourceSize == sourceSize
+			&& header.SpecularMipLevels >= 1
+			&& header.SpecularMipLevels <= 32
+			&& GetDataOffset() + (header.SpecularCount + header.BRDFCount) * sizeof(float) == file.GetSize();
+
+		// the file may have been touched without changing (e.g. checkout), only then pay for hashing the source
+		if (valid && header.SourceTime != sourceTime)
+			valid = header.SourceHash == Utils::HashFile(sourcePath);
+
+		if (!valid)
+			return false;
+
+		const float* floats = reinterpret_cast<const float*>(file.GetData() + GetDataOffset());
+
+		for (int i = 0; i < 9; i++)
+			data.Irradiance.Coefficients[i] = glm::vec3(header.Irradiance[i * 3 + 0], header.Irradiance[i * 3 + 1], header.Irradiance[i * 3 + 2]);
+
+		data.SpecularSize = header.SpecularSize;
+		data.SpecularLevelOffsets.resize(header.SpecularMipLevels);
+
+		uint64_t total = 0;
+
+		for (uint32_t level = 0; level < header.SpecularMipLevels; level++) {
+			const uint64_t levelSize = std::max(header.SpecularSize >> level, 1u);
+
+			data.SpecularLevelOffsets[level] = total;
+			total += levelSize * levelSize * 6 * 4;
+		}
+
+		if (total != header.SpecularCount || header.BRDFCount != uint64_t(header.BRDFSize) * header.BRDFSize * 2)
+			return false;
+
+		data.Specular.assign(floats, floats + header.SpecularCount);
+
+		data.BRDFSize = header.BRDFSize;
+		data.BRDF.assign(floats + header.SpecularCount, floats + header.SpecularCount + header.BRDFCount);
+
+		return true;
+	}
+
+	bool IBLBaker::WriteCache(const std::string& sourcePath, const IBLSettings& settings, const IBLData& data) {
+		CacheHeader header			= {};
+		header.Settings				= settings;
+		header.SpecularSize			= data.SpecularSize;
+		header.SpecularMipLevels	= static_cast<uint32_t>(data.SpecularLevelOffsets.size());
+		header.BRDFSize				= data.BRDFSize;
+		header.SpecularCount		= data.Specular.size();
+		header.BRDFCount			= data.BRDF.size();
+
+		for (int i = 0; i < 9; i++) {
+			header.Irradiance[i * 3 + 0] = data.Irradiance.Coefficients[i].x;
+			header.Irradiance[i * 3 + 1] = data.Irradiance.Coefficients[i].y;
+			header.Irradiance[i * 3 + 2] = data.Irradiance.Coefficients[i].z;
+		}
+
+		if (!Utils::GetFileStamp(sourcePath, header.SourceSize, header.SourceTime))
+			return false;
+
+		header.SourceHash = Utils::HashFile(sourcePath);
+
+		// write to a temporary file first so an interrupted write never leaves a truncated cache behind
+		const std::string cachePath = GetCachePath(sourcePath);
+		const std::string tempPath = cachePath + ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!stream.is_open()) {
+				std::cout << "Failed to create IBL cache: " << cachePath << '\n';
+				return false;
+			}
+
+			static const char zeros[16] = {};
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+			stream.write(zeros, GetDataOffset() - sizeof(CacheHeader));
+			stream.write(reinterpret_cast<const char*>(data.Specular.data()), data.Specular.size() * sizeof(float));
+			stream.write(reinterpret_cast<const char*>(data.BRDF.data()), data.BRDF.size() * sizeof(float));
+
+			if (!stream.good()) {
+				stream.close();
+				std::filesystem::remove(tempPath);
+				std::cout << "Failed to write IBL cache: " << cachePath << '\n';
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include "Bitmap.h"
+
+namespace Utils {
+
+	// Order 2 spherical harmonics of the irradiance (already convolved with the clamped cosine),
+	// E(n) = sum(Coefficients[i] * Y_i(n)) and the diffuse radiance is albedo / PI * E(n).
+	struct SHIrradiance {
+		glm::vec3 Coefficients[9] = {};
+	};
+
+	struct IBLSettings {
+		uint32_t SpecularSize		= 256;		// face size of the first specular level
+		uint32_t SpecularMipLevels	= 6;		// roughness of level i is i / (SpecularMipLevels - 1)
+		uint32_t SpecularSamples	= 128;
+		uint32_t BRDFSize			= 128;
+		uint32_t BRDFSamples		= 512;
+	};
+
+	struct IBLData {
+		SHIrradiance			Irradiance;
+
+		// RGBA32F, every level holds its six faces back to back, offsets are in floats
+		uint32_t				SpecularSize = 0;
+		std::vector<uint64_t>	SpecularLevelOffsets;
+		std::vector<float>		Specular;
+
+		// RG32F split sum, x = NdotV and y = roughness at texel centers, specular = F0 * R + G
+		uint32_t				BRDFSize = 0;
+		std::vector<float>		BRDF;
+	};
+
+	// Note: CPU image based lighting precomputation from an RGBA float cubemap (faces in Vulkan order and orientation,
+	// e.g. convertEquirectangularMapToCubeMapFaces): irradiance SH, GGX prefiltered specular mips (filtered importance
+	// sampling with a precomputed sample set per level) and the split sum BRDF LUT. Every pass is threaded per row.
+	// The results are cached next to the source ("<source>.ibl") so later launches skip decoding and baking.
+	class IBLBaker {
+	public:
+		IBLBaker() {};
+		~IBLBaker() {};
+
+		static void ComputeIrradiance(const Bitmap& cubemap, SHIrradiance& irradiance);
+		static glm::vec3 EvaluateIrradiance(const SHIrradiance& irradiance, const glm::vec3& normal);
+
+		static void PrefilterSpecular(const Bitmap& cubemap, const IBLSettings& settings, IBLData& data);
+		static void ComputeBRDF(const IBLSettings& settings, IBLData& data);
+
+		static void Bake(const Bitmap& cubemap, const IBLSettings& settings, IBLData& data);
+
+		// Keyed by the source file (size + modification time, content hash when only the time differs) and the settings.
+		static std::string GetCachePath(const std::string& sourcePath);
+		static bool ReadCache(const std::string& sourcePath, const IBLSettings& settings, IBLData& data);
+		static bool WriteCache(const std::string& sourcePath, const IBLSettings& settings, const IBLData& data);
+
+		// normalized direction through texel (x, y) of 'face', the inverse of the Vulkan cube face selection
+		static glm::vec3 GetTexelDirection(uint32_t face, float x, float y, uint32_t size);
+	};
+}
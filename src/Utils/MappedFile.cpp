@@ -0,0 +1,147 @@
+#include "MappedFile.h"
+
+#include <filesystem>
+
+#include "./Helper.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utils {
+
+	MappedFile::~MappedFile() {
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::string& path) {
+		Close();
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size = {};
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			return false;
+		}
+
+		const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (data == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File		= file;
+		m_Mapping	= mapping;
+		m_Data		= static_cast<const uint8_t*>(data);
+		m_Size		= static_cast<size_t>(size.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (m_Data != nullptr)
+			UnmapViewOfFile(m_Data);
+
+		if (m_Mapping != nullptr)
+			CloseHandle(m_Mapping);
+
+		if (m_File != nullptr)
+			CloseHandle(m_File);
+
+		m_Data		= nullptr;
+		m_Mapping	= nullptr;
+		m_File		= nullptr;
+		m_Size		= 0;
+	}
+#else
+	bool MappedFile::Open(const std::string& path) {
+		Close();
+
+		int file = open(path.c_str(), O_RDONLY);
+
+		if (file == -1)
+			return false;
+
+		struct stat info = {};
+
+		if (fstat(file, &info) != 0 || info.st_size == 0) {
+			close(file);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED) {
+			close(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = static_cast<size_t>(info.st_size);
+
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (m_Data != nullptr)
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+
+		if (m_File != -1)
+			close(m_File);
+
+		m_Data = nullptr;
+		m_File = -1;
+		m_Size = 0;
+	}
+#endif
+
+	bool GetFileStamp(const std::string& path, uint64_t& size, int64_t& time) {
+		std::error_code error;
+
+		size = std::filesystem::file_size(path, error);
+
+		if (error)
+			return false;
+
+		auto writeTime = std::filesystem::last_write_time(path, error);
+
+		if (error)
+			return false;
+
+		time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+		return true;
+	}
+
+	uint64_t HashFile(const std::string& path) {
+		MappedFile file;
+
+		if (!file.Open(path))
+			return 0;
+
+		return Helper::hash_bytes(file.GetData(), file.GetSize());
+	}
+}
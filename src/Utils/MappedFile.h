@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Utils {
+
+	// Note: Read-only view of a whole file mapped into the address space, the OS pages the data in on demand 
+	// so reading a cache file doesn't go through any intermediate copy.
+	class MappedFile {
+	public:
+		MappedFile() {};
+		~MappedFile();
+
+		MappedFile(const MappedFile& other) = delete;
+		void operator=(const MappedFile& other) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		const uint8_t* GetData()	const { return m_Data; }
+		size_t GetSize()			const { return m_Size; }
+		bool IsOpen()				const { return m_Data != nullptr; }
+
+	private:
+		const uint8_t* m_Data	= nullptr;
+		size_t m_Size			= 0;
+
+#ifdef _WIN32
+		void* m_File			= nullptr;
+		void* m_Mapping			= nullptr;
+#else
+		int m_File				= -1;
+#endif
+	};
+
+	// Size and modification time of a file, what the on-disk caches compare to notice a changed source.
+	bool GetFileStamp(const std::string& path, uint64_t& size, int64_t& time);
+
+	// Hash of the whole file content, read through a mapping (0 when it can't be opened).
+	uint64_t HashFile(const std::string& path);
+}
@@ -0,0 +1,526 @@
+#include "MeshCache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+#include "../Assets/Mesh.h"
+#include "../Assets/Model.h"
+
+#include "./Helper.h"
+
+namespace MeshCache {
+
+	constexpr uint32_t CACHE_MAGIC		= 0x48534d56;	// "VMSH"
+	constexpr uint32_t CACHE_VERSION	= 4;
+	constexpr uint64_t CACHE_ALIGNMENT	= 16;
+
+	struct Header {
+		uint32_t Magic				= CACHE_MAGIC;
+		uint32_t Version			= CACHE_VERSION;
+		uint32_t VertexStride		= sizeof(Assets::Vertex);
+		uint32_t MaterialDataSize	= sizeof(MaterialData);
+		uint32_t MeshletStride		= sizeof(Assets::Meshlet);
+		uint32_t HeaderPad			= 0;
+
+		uint64_t ImportKey			= 0;
+		uint64_t SourceSize			= 0;
+		int64_t  SourceTime			= 0;
+		uint64_t SourceHash			= 0;
+		uint64_t FileSize			= 0;
+
+		uint32_t MeshCount			= 0;
+		uint32_t MaterialCount		= 0;
+		uint32_t TextureCount		= 0;
+		float	 ImportTime			= 0.0f;
+		uint32_t LodCount			= 0;
+		uint32_t LodPad				= 0;
+
+		uint64_t TotalIndices		= 0;
+		uint64_t TotalVertices		= 0;
+		uint64_t TotalMeshlets		= 0;
+		uint64_t TotalMeshletVertices	= 0;
+		uint64_t TotalMeshletTriangles	= 0;
+
+		uint64_t MeshesOffset		= 0;
+		uint64_t LodsOffset			= 0;
+		uint64_t MaterialsOffset	= 0;
+		uint64_t TexturesOffset		= 0;
+		uint64_t StringsOffset		= 0;
+		uint64_t StringsSize		= 0;
+		uint64_t IndicesOffset		= 0;
+		uint64_t VerticesOffset		= 0;
+		uint64_t MeshletsOffset		= 0;
+		uint64_t MeshletVerticesOffset	= 0;
+		uint64_t MeshletTrianglesOffset	= 0;
+
+		float	 PivotVector[3]		= {};
+		uint32_t Pad				= 0;
+	};
+
+	struct MeshRecord {
+		uint64_t IndexOffset		= 0;
+		uint64_t IndexCount			= 0;
+		uint64_t VertexOffset		= 0;
+		uint64_t VertexCount		= 0;
+		uint64_t MeshletOffset		= 0;
+		uint64_t MeshletVertexOffset	= 0;
+		uint64_t MeshletTriangleOffset	= 0;
+		uint32_t MeshletCount		= 0;
+		uint32_t MeshletVertexCount	= 0;
+		uint32_t MeshletTriangleCount	= 0;
+		uint32_t FirstLod			= 0;
+		uint32_t LodCount			= 0;
+		uint32_t MaterialNameOffset = 0;
+		uint32_t MaterialNameLength = 0;
+		float	 PivotVector[3]		= {};
+	};
+
+	// the indices of a level live in the index stream like the full ones, see Assets::MeshLod
+	struct LodRecord {
+		uint64_t IndexOffset		= 0;
+		uint64_t IndexCount			= 0;
+		float	 Error				= 0.0f;
+		uint32_t Pad				= 0;
+	};
+
+	struct MaterialRecord {
+		MaterialData Data			= {};
+		uint32_t NameOffset			= 0;
+		uint32_t NameLength			= 0;
+		uint32_t FirstTexture		= 0;
+		uint32_t TextureCount		= 0;
+	};
+
+	struct TextureRecord {
+		uint32_t Type				= 0;
+		uint32_t PathOffset			= 0;
+		uint32_t PathLength			= 0;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Assets::Vertex>, "Vertex must be trivially copyable to be cached");
+	static_assert(std::is_trivially_copyable_v<Assets::Meshlet>, "Meshlet must be trivially copyable to be cached");
+	static_assert(std::is_trivially_copyable_v<MaterialData>,	"MaterialData must be trivially copyable to be cached");
+
+	static uint64_t Align(uint64_t value) {
+		return (value + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+	}
+
+	static void WriteBytes(std::ofstream& stream, uint64_t& cursor, const void* data, uint64_t size) {
+		stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		cursor += size;
+	}
+
+	static void WritePadding(std::ofstream& stream, uint64_t& cursor, uint64_t target) {
+		static const char zeros[CACHE_ALIGNMENT] = {};
+
+		while (cursor < target) {
+			uint64_t amount = std::min(target - cursor, CACHE_ALIGNMENT);
+			WriteBytes(stream, cursor, zeros, amount);
+		}
+	}
+
+	// one file per import key, loading the same source with other settings doesn't replace the cache of the first
+	std::string GetCachePath(const std::string& sourcePath, uint64_t importKey) {
+		char suffix[32] = {};
+		snprintf(suffix, sizeof(suffix), ".%016llx.meshcache", static_cast<unsigned long long>(importKey));
+
+		return sourcePath + suffix;
+	}
+
+	bool Write(const std::string& sourcePath, uint64_t importKey, const Assets::Model& model, const std::vector<MaterialEntry>& materials, float importTime) {
+		Header header = {};
+		header.ImportKey = importKey;
+
+		if (!Utils::GetFileStamp(sourcePath, header.SourceSize, header.SourceTime))
+			return false;
+
+		header.SourceHash = Utils::HashFile(sourcePath);
+
+		std::string strings;
+
+		auto addString = [&strings](const std::string& value) {
+			uint32_t offset = static_cast<uint32_t>(strings.size());
+			strings += value;
+			return offset;
+		};
+
+		std::vector<MeshRecord>		meshRecords;
+		std::vector<LodRecord>		lodRecords;
+		std::vector<MaterialRecord> materialRecords;
+		std::vector<TextureRecord>	textureRecords;
+
+		meshRecords.reserve(model.Meshes.size());
+
+		// meshlets keep their mesh local offsets, the records locate each mesh's slice of the streams
+		uint64_t totalMeshlets			= 0;
+		uint64_t totalMeshletVertices	= 0;
+		uint64_t totalMeshletTriangles	= 0;
+
+		for (const auto& mesh : model.Meshes) {
+			MeshRecord record			= {};
+			record.IndexOffset			= mesh.IndexOffset;
+			record.IndexCount			= mesh.Indices.size();
+			record.VertexOffset			= mesh.VertexOffset;
+			record.VertexCount			= mesh.Vertices.size();
+			record.MeshletOffset		= totalMeshlets;
+			record.MeshletVertexOffset	= totalMeshletVertices;
+			record.MeshletTriangleOffset = totalMeshletTriangles;
+			record.MeshletCount			= static_cast<uint32_t>(mesh.Meshlets.size());
+			record.MeshletVertexCount	= static_cast<uint32_t>(mesh.MeshletVertices.size());
+			record.MeshletTriangleCount = static_cast<uint32_t>(mesh.MeshletTriangles.size());
+			record.FirstLod				= static_cast<uint32_t>(lodRecords.size());
+			record.LodCount				= static_cast<uint32_t>(mesh.Lods.size());
+			record.MaterialNameOffset	= addString(mesh.MaterialName);
+			record.MaterialNameLength	= static_cast<uint32_t>(mesh.MaterialName.size());
+			record.PivotVector[0]		= mesh.PivotVector.x;
+			record.PivotVector[1]		= mesh.PivotVector.y;
+			record.PivotVector[2]		= mesh.PivotVector.z;
+
+			for (const auto& lod : mesh.Lods) {
+				LodRecord lodRecord		= {};
+				lodRecord.IndexOffset	= lod.IndexOffset;
+				lodRecord.IndexCount	= lod.Indices.size();
+				lodRecord.Error			= lod.Error;
+
+				lodRecords.push_back(lodRecord);
+			}
+
+			totalMeshlets			+= record.MeshletCount;
+			totalMeshletVertices	+= record.MeshletVertexCount;
+			totalMeshletTriangles	+= record.MeshletTriangleCount;
+
+			meshRecords.push_back(record);
+		}
+
+		for (const auto& entry : materials) {
+			MaterialRecord record	= {};
+			record.Data				= entry.Material.MaterialData;
+			record.NameOffset		= addString(entry.Material.Name);
+			record.NameLength		= static_cast<uint32_t>(entry.Material.Name.size());
+			record.FirstTexture		= static_cast<uint32_t>(textureRecords.size());
+			record.TextureCount		= static_cast<uint32_t>(entry.Textures.size());
+
+			for (const auto& texture : entry.Textures) {
+				TextureRecord textureRecord = {};
+				textureRecord.Type			= static_cast<uint32_t>(texture.Type);
+				textureRecord.PathOffset	= addString(texture.Path);
+				textureRecord.PathLength	= static_cast<uint32_t>(texture.Path.size());
+
+				textureRecords.push_back(textureRecord);
+			}
+
+			materialRecords.push_back(record);
+		}
+
+		header.MeshCount		= static_cast<uint32_t>(meshRecords.size());
+		header.LodCount			= static_cast<uint32_t>(lodRecords.size());
+		header.MaterialCount	= static_cast<uint32_t>(materialRecords.size());
+		header.TextureCount		= static_cast<uint32_t>(textureRecords.size());
+		header.ImportTime		= importTime;
+		header.TotalIndices		= model.TotalIndices;
+		header.TotalVertices	= model.TotalVertices;
+		header.TotalMeshlets			= totalMeshlets;
+		header.TotalMeshletVertices		= totalMeshletVertices;
+		header.TotalMeshletTriangles	= totalMeshletTriangles;
+		header.PivotVector[0]	= model.PivotVector.x;
+		header.PivotVector[1]	= model.PivotVector.y;
+		header.PivotVector[2]	= model.PivotVector.z;
+
+		header.MeshesOffset		= Align(sizeof(Header));
+		header.LodsOffset		= Align(header.MeshesOffset		+ sizeof(MeshRecord)		* meshRecords.size());
+		header.MaterialsOffset	= Align(header.LodsOffset		+ sizeof(LodRecord)			* lodRecords.size());
+		header.TexturesOffset	= Align(header.MaterialsOffset	+ sizeof(MaterialRecord)	* materialRecords.size());
+		header.StringsOffset	= Align(header.TexturesOffset	+ sizeof(TextureRecord)		* textureRecords.size());
+		header.StringsSize		= strings.size();
+		header.IndicesOffset	= Align(header.StringsOffset	+ header.StringsSize);
+		header.VerticesOffset	= Align(header.IndicesOffset	+ sizeof(uint32_t)			* header.TotalIndices);
+		header.MeshletsOffset	= Align(header.VerticesOffset	+ sizeof(Assets::Vertex)	* header.TotalVertices);
+		header.MeshletVerticesOffset	= Align(header.MeshletsOffset			+ sizeof(Assets::Meshlet)	* header.TotalMeshlets);
+		header.MeshletTrianglesOffset	= Align(header.MeshletVerticesOffset	+ sizeof(uint32_t)			* header.TotalMeshletVertices);
+		header.FileSize					= header.MeshletTrianglesOffset			+ sizeof(uint32_t)			* header.TotalMeshletTriangles;
+
+		// write to a temporary file first so an interrupted write never leaves a truncated cache behind
+		const std::string cachePath = GetCachePath(sourcePath, importKey);
+		const std::string tempPath	= cachePath + ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!stream.is_open()) {
+				std::cout << "Failed to create mesh cache: " << cachePath << '\n';
+				return false;
+			}
+
+			uint64_t cursor = 0;
+
+			WriteBytes	(stream, cursor, &header, sizeof(Header));
+			WritePadding(stream, cursor, header.MeshesOffset);
+			WriteBytes	(stream, cursor, meshRecords.data(), sizeof(MeshRecord) * meshRecords.size());
+			WritePadding(stream, cursor, header.LodsOffset);
+			WriteBytes	(stream, cursor, lodRecords.data(), sizeof(LodRecord) * lodRecords.size());
+			WritePadding(stream, cursor, header.MaterialsOffset);
+			WriteBytes	(stream, cursor, materialRecords.data(), sizeof(MaterialRecord) * materialRecords.size());
+			WritePadding(stream, cursor, header.TexturesOffset);
+			WriteBytes	(stream, cursor, textureRecords.data(), sizeof(TextureRecord) * textureRecords.size());
+			WritePadding(stream, cursor, header.StringsOffset);
+			WriteBytes	(stream, cursor, strings.data(), strings.size());
+			WritePadding(stream, cursor, header.IndicesOffset);
+
+			// meshes are laid out back to back by CompileMesh (each followed by its levels), so streaming them in order 
+			// rebuilds the concatenated buffers
+			for (const auto& mesh : model.Meshes) {
+				WriteBytes(stream, cursor, mesh.Indices.data(), sizeof(uint32_t) * mesh.Indices.size());
+
+				for (const auto& lod : mesh.Lods)
+					WriteBytes(stream, cursor, lod.Indices.data(), sizeof(uint32_t) * lod.Indices.size());
+			}
+
+			WritePadding(stream, cursor, header.VerticesOffset);
+
+			for (const auto& mesh : model.Meshes)
+				WriteBytes(stream, cursor, mesh.Vertices.data(), sizeof(Assets::Vertex) * mesh.Vertices.size());
+
+			WritePadding(stream, cursor, header.MeshletsOffset);
+
+			for (const auto& mesh : model.Meshes)
+				WriteBytes(stream, cursor, mesh.Meshlets.data(), sizeof(Assets::Meshlet) * mesh.Meshlets.size());
+
+			WritePadding(stream, cursor, header.MeshletVerticesOffset);
+
+			for (const auto& mesh : model.Meshes)
+				WriteBytes(stream, cursor, mesh.MeshletVertices.data(), sizeof(uint32_t) * mesh.MeshletVertices.size());
+
+			WritePadding(stream, cursor, header.MeshletTrianglesOffset);
+
+			for (const auto& mesh : model.Meshes)
+				WriteBytes(stream, cursor, mesh.MeshletTriangles.data(), sizeof(uint32_t) * mesh.MeshletTriangles.size());
+
+			if (!stream.good() || cursor != header.FileSize) {
+				stream.close();
+				std::filesystem::remove(tempPath);
+				std::cout << "Failed to write mesh cache: " << cachePath << '\n';
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	// offset + count <= total, without wrapping around on a damaged record
+	static bool InRange(uint64_t offset, uint64_t count, uint64_t total) {
+		return count <= total && offset <= total - count;
+	}
+
+	static bool SectionFits(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize) {
+		return count <= fileSize / stride && InRange(offset, count * stride, fileSize);
+	}
+
+	// Note: Patches the header in place, the mapping must be closed first (it doesn't share write access on Windows).
+	static bool RestampSource(const std::string& cachePath, int64_t sourceTime) {
+		std::fstream stream(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+
+		if (!stream.is_open())
+			return false;
+
+		stream.seekp(offsetof(Header, SourceTime));
+		stream.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+
+		return stream.good();
+	}
+
+	bool CachedModel::Open(const std::string& sourcePath, uint64_t importKey) {
+		uint64_t sourceSize = 0;
+		int64_t sourceTime	= 0;
+
+		if (!Utils::GetFileStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		const std::string cachePath = GetCachePath(sourcePath, importKey);
+
+		if (!m_File.Open(cachePath))
+			return false;
+
+		if (m_File.GetSize() < sizeof(Header)) {
+			m_File.Close();
+			return false;
+		}
+
+		const Header* header = Section<Header>(0);
+
+		bool valid = header->Magic		== CACHE_MAGIC
+			&& header->Version			== CACHE_VERSION
+			&& header->VertexStride		== sizeof(Assets::Vertex)
+			&& header->MaterialDataSize == sizeof(MaterialData)
+			&& header->MeshletStride	== sizeof(Assets::Meshlet)
+			&& header->ImportKey		== importKey
+			&& header->FileSize			== m_File.GetSize()
+			&& header->SourceSize		== sourceSize;
+
+		// the file may have been touched without changing (e.g. checkout), only then pay for hashing the source
+		const bool touched = valid && header->SourceTime != sourceTime;
+
+		if (touched)
+			valid = header->SourceHash == Utils::HashFile(sourcePath);
+
+		valid = valid
+			&& SectionFits(header->MeshesOffset,			header->MeshCount,				sizeof(MeshRecord),			header->FileSize)
+			&& SectionFits(header->LodsOffset,				header->LodCount,				sizeof(LodRecord),			header->FileSize)
+			&& SectionFits(header->MaterialsOffset,			header->MaterialCount,			sizeof(MaterialRecord),		header->FileSize)
+			&& SectionFits(header->TexturesOffset,			header->TextureCount,			sizeof(TextureRecord),		header->FileSize)
+			&& SectionFits(header->StringsOffset,			header->StringsSize,			1,							header->FileSize)
+			&& SectionFits(header->IndicesOffset,			header->TotalIndices,			sizeof(uint32_t),			header->FileSize)
+			&& SectionFits(header->VerticesOffset,			header->TotalVertices,			sizeof(Assets::Vertex),		header->FileSize)
+			&& SectionFits(header->MeshletsOffset,			header->TotalMeshlets,			sizeof(Assets::Meshlet),	header->FileSize)
+			&& SectionFits(header->MeshletVerticesOffset,	header->TotalMeshletVertices,	sizeof(uint32_t),			header->FileSize)
+			&& SectionFits(header->MeshletTrianglesOffset,	header->TotalMeshletTriangles,	sizeof(uint32_t),			header->FileSize);
+
+		// ReadMeshes copies each record's slice of the streams as it is, none may reach past the section it points into
+		if (valid) {
+			const MeshRecord* records	= Section<MeshRecord>(header->MeshesOffset);
+			const LodRecord* lods		= Section<LodRecord>(header->LodsOffset);
+
+			for (uint32_t i = 0; i < header->MeshCount && valid; i++) {
+				valid = InRange(records[i].IndexOffset,				records[i].IndexCount,				header->TotalIndices)
+					&& InRange(records[i].VertexOffset,				records[i].VertexCount,				header->TotalVertices)
+					&& InRange(records[i].MeshletOffset,			records[i].MeshletCount,			header->TotalMeshlets)
+					&& InRange(records[i].MeshletVertexOffset,		records[i].MeshletVertexCount,		header->TotalMeshletVertices)
+					&& InRange(records[i].MeshletTriangleOffset,	records[i].MeshletTriangleCount,	header->TotalMeshletTriangles)
+					&& InRange(records[i].FirstLod,					records[i].LodCount,				header->LodCount);
+			}
+
+			for (uint32_t i = 0; i < header->LodCount && valid; i++)
+				valid = InRange(lods[i].IndexOffset, lods[i].IndexCount, header->TotalIndices);
+		}
+
+		if (!valid) {
+			m_File.Close();
+			return false;
+		}
+
+		// take the new time so the next launch doesn't hash the source again, failing to only costs that hash
+		if (touched) {
+			const uint64_t fileSize = header->FileSize;
+
+			m_File.Close();
+			RestampSource(cachePath, sourceTime);
+
+			if (!m_File.Open(cachePath) || m_File.GetSize() != fileSize) {
+				m_File.Close();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::string CachedModel::ReadString(uint32_t offset, uint32_t length) const {
+		const Header* header = Section<Header>(0);
+
+		if (static_cast<uint64_t>(offset) + length > header->StringsSize)
+			return "";
+
+		return std::string(Section<char>(header->StringsOffset + offset), length);
+	}
+
+	void CachedModel::ReadMeshes(Assets::Model& model) const {
+		const Header* header			= Section<Header>(0);
+		const MeshRecord* records		= Section<MeshRecord>(header->MeshesOffset);
+		const LodRecord* lods			= Section<LodRecord>(header->LodsOffset);
+		const uint32_t* indices			= GetIndices();
+		const Assets::Vertex* vertices	= GetVertices();
+		const Assets::Meshlet* meshlets	= Section<Assets::Meshlet>(header->MeshletsOffset);
+		const uint32_t* meshletVertices	= Section<uint32_t>(header->MeshletVerticesOffset);
+		const uint32_t* meshletTriangles = Section<uint32_t>(header->MeshletTrianglesOffset);
+
+		model.Meshes.resize(header->MeshCount);
+
+		for (uint32_t i = 0; i < header->MeshCount; i++) {
+			const MeshRecord& record	= records[i];
+			Assets::Mesh& mesh			= model.Meshes[i];
+
+			mesh.MaterialName	= ReadString(record.MaterialNameOffset, record.MaterialNameLength);
+			mesh.IndexOffset	= record.IndexOffset;
+			mesh.VertexOffset	= record.VertexOffset;
+			mesh.PivotVector	= glm::vec3(record.PivotVector[0], record.PivotVector[1], record.PivotVector[2]);
+
+			mesh.Indices	.assign(indices + record.IndexOffset, indices + record.IndexOffset + record.IndexCount);
+			mesh.Vertices	.assign(vertices + record.VertexOffset, vertices + record.VertexOffset + record.VertexCount);
+
+			mesh.Meshlets			.assign(meshlets + record.MeshletOffset, meshlets + record.MeshletOffset + record.MeshletCount);
+			mesh.MeshletVertices	.assign(meshletVertices + record.MeshletVertexOffset, meshletVertices + record.MeshletVertexOffset + record.MeshletVertexCount);
+			mesh.MeshletTriangles	.assign(meshletTriangles + record.MeshletTriangleOffset, meshletTriangles + record.MeshletTriangleOffset + record.MeshletTriangleCount);
+
+			mesh.Lods.clear();
+
+			for (uint32_t l = record.FirstLod; l < record.FirstLod + record.LodCount && l < header->LodCount; l++) {
+				Assets::MeshLod lod = {};
+				lod.IndexOffset		= lods[l].IndexOffset;
+				lod.Error			= lods[l].Error;
+				lod.Indices			.assign(indices + lods[l].IndexOffset, indices + lods[l].IndexOffset + lods[l].IndexCount);
+
+				mesh.Lods.push_back(std::move(lod));
+			}
+		}
+
+		model.TotalIndices	= header->TotalIndices;
+		model.TotalVertices = header->TotalVertices;
+		model.PivotVector	= glm::vec3(header->PivotVector[0], header->PivotVector[1], header->PivotVector[2]);
+	}
+
+	void CachedModel::ReadMaterials(std::vector<MaterialEntry>& materials) const {
+		const Header* header			= Section<Header>(0);
+		const MaterialRecord* records	= Section<MaterialRecord>(header->MaterialsOffset);
+		const TextureRecord* textures	= Section<TextureRecord>(header->TexturesOffset);
+
+		materials.resize(header->MaterialCount);
+
+		for (uint32_t i = 0; i < header->MaterialCount; i++) {
+			const MaterialRecord& record	= records[i];
+			MaterialEntry& entry			= materials[i];
+
+			entry.Material.Name			= ReadString(record.NameOffset, record.NameLength);
+			entry.Material.MaterialData = record.Data;
+
+			for (uint32_t t = record.FirstTexture; t < record.FirstTexture + record.TextureCount && t < header->TextureCount; t++) {
+				MaterialTexture texture = {};
+				texture.Type			= static_cast<Graphics::Texture::TextureType>(textures[t].Type);
+				texture.Path			= ReadString(textures[t].PathOffset, textures[t].PathLength);
+
+				entry.Textures.push_back(texture);
+			}
+		}
+	}
+
+	const uint32_t* CachedModel::GetIndices() const {
+		return Section<uint32_t>(Section<Header>(0)->IndicesOffset);
+	}
+
+	const Assets::Vertex* CachedModel::GetVertices() const {
+		return Section<Assets::Vertex>(Section<Header>(0)->VerticesOffset);
+	}
+
+	size_t CachedModel::GetTotalIndices() const {
+		return Section<Header>(0)->TotalIndices;
+	}
+
+	size_t CachedModel::GetTotalVertices() const {
+		return Section<Header>(0)->TotalVertices;
+	}
+
+	float CachedModel::GetImportTime() const {
+		return Section<Header>(0)->ImportTime;
+	}
+}
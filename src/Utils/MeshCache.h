@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../Assets/Material.h"
+#include "../Core/Graphics.h"
+
+#include "./MappedFile.h"
+
+namespace Assets {
+	class Model;
+	struct Vertex;
+}
+
+// Binary cache of an imported model, written next to the source file ("<source>.<import key>.meshcache") after the 
+// first Assimp import. Warm loads map the file and upload the vertex/index streams straight from the 
+// mapping, no parsing involved. The meshes still get their own CPU copies (see ReadMeshes).
+//
+// Layout (every section 16 bytes aligned):
+//	[Header][Mesh records][LOD records][Material records][Texture records][String table][Index stream][Vertex stream]
+//	[Meshlets][Meshlet vertices][Meshlet triangles]		(empty unless the import built meshlets)
+//
+// The cache is invalidated when the format version, the vertex layout, the import options or the source file changes 
+// (size + modification time, falling back to a content hash when only the time differs).
+// Note: Only the source file itself is tracked, side files (e.g. .mtl) aren't, delete the cache after editing them.
+namespace MeshCache {
+
+	struct MaterialTexture {
+		Graphics::Texture::TextureType Type = Graphics::Texture::TextureType::UNKNOWN;
+		std::string Path = "";
+	};
+
+	struct MaterialEntry {
+		::Material Material = {};
+		std::vector<MaterialTexture> Textures;
+	};
+
+	std::string GetCachePath(const std::string& sourcePath, uint64_t importKey);
+
+	// Note: Expects a compiled model (mesh offsets and pivots already resolved). The import key identifies
+	// the import options that produced the data, a cache is only used with a matching key.
+	bool Write(const std::string& sourcePath, uint64_t importKey, const Assets::Model& model, const std::vector<MaterialEntry>& materials, float importTime);
+
+	class CachedModel {
+	public:
+		bool Open(const std::string& sourcePath, uint64_t importKey);
+
+		// Note: Copies each mesh's streams out of the mapping, Assets::Mesh owns std::vectors that the draw calls
+		// (index counts), the LOD selection and the meshlet builder read. Only the GPU upload (GetIndices/GetVertices)
+		// works on the mapping itself.
+		void ReadMeshes		(Assets::Model& model)					const;
+		void ReadMaterials	(std::vector<MaterialEntry>& materials) const;
+
+		const uint32_t*			GetIndices()		const;
+		const Assets::Vertex*	GetVertices()		const;
+		size_t					GetTotalIndices()	const;
+		size_t					GetTotalVertices()	const;
+
+		// time spent on the Assimp import that produced this cache
+		float					GetImportTime()		const;
+	private:
+		template<class T>
+		const T* Section(uint64_t offset) const { return reinterpret_cast<const T*>(m_File.GetData() + offset); }
+
+		std::string ReadString(uint32_t offset, uint32_t length) const;
+	private:
+		Utils::MappedFile m_File;
+	};
+}
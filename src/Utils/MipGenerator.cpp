@@ -0,0 +1,222 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "BitmapView.h"
+#include "ParallelFor.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MIP_GENERATOR_SSE2
+#endif
+
+namespace Utils {
+
+	static constexpr double KAISER_WIDTH		= 3.0;		// filter radius in destination texels
+	static constexpr double KAISER_ALPHA		= 4.0;
+	static constexpr double PI					= 3.14159265358979323846;
+
+	static constexpr uint32_t ROWS_PER_TASK		= 8;
+
+	// Taps of a 2:1 reduction, destination texel x reads source texels 2x + First + k with Weights[k]. A source row is
+	// padded with PadLeft/PadRight copies of its edge texels so the taps never have to be clamped.
+	struct Kernel {
+		int					First		= 0;
+		int					PadLeft		= 0;
+		int					PadRight	= 0;
+		std::vector<float>	Weights;
+	};
+
+	static double besselI0(double x) {
+		double sum = 1.0;
+		double term = 1.0;
+
+		for (int k = 1; k < 32; k++) {
+			const double factor = x / (2.0 * k);
+			term *= factor * factor;
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	static double sinc(double x) {
+		return x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+	}
+
+	static Kernel makeKernel(MipFilter filter) {
+		Kernel kernel;
+
+		if (filter == MipFilter::Box) {
+			kernel.Weights = { 0.5f, 0.5f };
+		}
+		else {
+			// source texel 2x + k is centered (k - 0.5) / 2 destination texels away from x
+			const int radius = static_cast<int>(KAISER_WIDTH * 2.0);
+
+			std::vector<double> weights;
+			double sum = 0.0;
+
+			for (int k = 1 - radius; k <= radius; k++) {
+				const double t = (k - 0.5) / 2.0;
+				const double window = besselI0(KAISER_ALPHA * std::sqrt(std::max(0.0, 1.0 - (t / KAISER_WIDTH) * (t / KAISER_WIDTH)))) / besselI0(KAISER_ALPHA);
+
+				weights.push_back(sinc(t) * window);
+				sum += weights.back();
+			}
+
+			kernel.First = 1 - radius;
+
+			for (double weight : weights)
+				kernel.Weights.push_back(static_cast<float>(weight / sum));
+		}
+
+		// odd and single texel sources read past their last texel as well
+		kernel.PadLeft	= std::max(0, -kernel.First);
+		kernel.PadRight = std::max(0, kernel.First + static_cast<int>(kernel.Weights.size()) - 1);
+
+		return kernel;
+	}
+
+	// dst += src * weight over 'count' floats (a multiple of 4)
+	static inline void accumulate(float* dst, const float* src, float weight, size_t count) {
+#ifdef MIP_GENERATOR_SSE2
+		const __m128 w = _mm_set1_ps(weight);
+
+		for (size_t i = 0; i < count; i += 4)
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), w)));
+#else
+		for (size_t i = 0; i < count; i++)
+			dst[i] += src[i] * weight;
+#endif
+	}
+
+	// 'padded' points at texel First of the padded row, output is clamped to [0, 1] to keep the ringing of the next levels down
+	static inline void filterRow(const float* padded, const Kernel& kernel, uint32_t dstWidth, float* dst) {
+		const size_t taps = kernel.Weights.size();
+
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			const float* src = padded + static_cast<size_t>(x) * 8;
+
+#ifdef MIP_GENERATOR_SSE2
+			__m128 sum = _mm_setzero_ps();
+
+			for (size_t k = 0; k < taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + k * 4), _mm_set1_ps(kernel.Weights[k])));
+
+			sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+			_mm_storeu_ps(dst + static_cast<size_t>(x) * 4, sum);
+#else
+			float sum[4] = {};
+
+			for (size_t k = 0; k < taps; k++)
+				for (int c = 0; c < 4; c++)
+					sum[c] += src[k * 4 + c] * kernel.Weights[k];
+
+			for (int c = 0; c < 4; c++)
+				dst[static_cast<size_t>(x) * 4 + c] = std::clamp(sum[c], 0.0f, 1.0f);
+#endif
+		}
+	}
+
+	// vertical pass into the middle of 'padded', then the horizontal pass out of it
+	static void downsampleRow(const float* src, uint32_t width, uint32_t height, const Kernel& kernel, uint32_t y, std::vector<float>& padded, uint32_t dstWidth, float* dst) {
+		const size_t rowSize = static_cast<size_t>(width) * 4;
+		float* row = padded.data() + static_cast<size_t>(kernel.PadLeft) * 4;
+
+		std::fill(row, row + rowSize, 0.0f);
+
+		for (size_t k = 0; k < kernel.Weights.size(); k++) {
+			const int64_t sy = std::clamp<int64_t>(static_cast<int64_t>(y) * 2 + kernel.First + static_cast<int64_t>(k), 0, height - 1);
+			accumulate(row, src + sy * rowSize, kernel.Weights[k], rowSize);
+		}
+
+		for (int i = 0; i < kernel.PadLeft; i++)
+			memcpy(padded.data() + static_cast<size_t>(i) * 4, row, sizeof(float) * 4);
+
+		for (int i = 0; i < kernel.PadRight; i++)
+			memcpy(row + rowSize + static_cast<size_t>(i) * 4, row + rowSize - 4, sizeof(float) * 4);
+
+		filterRow(row + static_cast<ptrdiff_t>(kernel.First) * 4, kernel, dstWidth, dst);
+	}
+
+	uint32_t MipGenerator::GetLevelCount(uint32_t width, uint32_t height) {
+		uint32_t levels = 1;
+
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+			levels++;
+
+		return levels;
+	}
+
+	void MipGenerator::Generate(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, MipFilter filter, MipChain& chain, uint32_t maxWorkers) {
+		const uint32_t levels = GetLevelCount(width, height);
+
+		chain.Width = width;
+		chain.Height = height;
+		chain.LevelOffsets.resize(levels);
+
+		uint64_t size = 0;
+
+		for (uint32_t level = 0; level < levels; level++) {
+			chain.LevelOffsets[level] = size;
+			size += static_cast<uint64_t>(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4;
+		}
+
+		chain.Data.resize(size);
+		memcpy(chain.Data.data(), rgba, static_cast<size_t>(width) * height * 4);
+
+		if (levels == 1)
+			return;
+
+		const Kernel kernel = makeKernel(filter);
+
+		// linear float copies of the level being read and of the one being written
+		std::vector<float> current(static_cast<size_t>(width) * height * 4);
+		std::vector<float> next;
+
+		ParallelFor((height + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](size_t task) {
+			const size_t first = task * ROWS_PER_TASK * width * 4;
+			const size_t count = std::min<size_t>(ROWS_PER_TASK, height - task * ROWS_PER_TASK) * width * 4;
+
+			if (srgb)
+				BitmapKernels::srgbToLinear(rgba + first, current.data() + first, count / 4, 4);
+			else
+				BitmapKernels::unsignedByteToFloat(rgba + first, current.data() + first, count);
+		}, maxWorkers);
+
+		for (uint32_t level = 1; level < levels; level++) {
+			const uint32_t srcWidth		= std::max(width >> (level - 1), 1u);
+			const uint32_t srcHeight	= std::max(height >> (level - 1), 1u);
+			const uint32_t dstWidth		= std::max(width >> level, 1u);
+			const uint32_t dstHeight	= std::max(height >> level, 1u);
+
+			next.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+			uint8_t* output = chain.Data.data() + chain.LevelOffsets[level];
+
+			ParallelFor((dstHeight + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](size_t task) {
+				std::vector<float> padded((static_cast<size_t>(srcWidth) + kernel.PadLeft + kernel.PadRight) * 4);
+
+				const uint32_t first = static_cast<uint32_t>(task) * ROWS_PER_TASK;
+				const uint32_t last = std::min(first + ROWS_PER_TASK, dstHeight);
+
+				for (uint32_t y = first; y < last; y++) {
+					const size_t offset = static_cast<size_t>(y) * dstWidth * 4;
+
+					downsampleRow(current.data(), srcWidth, srcHeight, kernel, y, padded, dstWidth, next.data() + offset);
+
+					if (srgb)
+						BitmapKernels::linearToSRGB(next.data() + offset, output + offset, dstWidth, 4);
+					else
+						BitmapKernels::floatToUnsignedByte(next.data() + offset, output + offset, static_cast<size_t>(dstWidth) * 4);
+				}
+			}, maxWorkers);
+
+			current.swap(next);
+		}
+	}
+}
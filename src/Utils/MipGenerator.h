@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Utils {
+
+	enum class MipFilter {
+		Box,		// 2x2 average, what the GPU blit chain does
+		Kaiser		// Kaiser windowed sinc (width 3, alpha 4), sharper minification with less aliasing
+	};
+
+	// RGBA8 levels back to back down to 1x1, 'LevelOffsets' are relative to the start of 'Data'
+	// (the layout GraphicsDevice::CreateTextures takes with TextureUpload::LevelOffsets).
+	struct MipChain {
+		uint32_t				Width		= 0;
+		uint32_t				Height		= 0;
+		std::vector<uint64_t>	LevelOffsets;
+		std::vector<uint8_t>	Data;
+	};
+
+	// Note: CPU mip chain of an RGBA8 image, for formats the device can't blit and for data that is processed further
+	// on the CPU (block compression). Levels are filtered from the previous level kept in linear float, so sRGB images
+	// are decoded once, filtered gamma correct and only rounded when written out (alpha is always linear). The filter
+	// is separable and runs four channels at a time with SSE2 when available, every level is split across workers by rows.
+	// Level i is max(width >> i, 1) x max(height >> i, 1) like Vulkan expects, edges are clamped.
+	class MipGenerator {
+	public:
+		MipGenerator() {};
+		~MipGenerator() {};
+
+		static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+		// level 0 is 'rgba' as is
+		static void Generate(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, MipFilter filter, MipChain& chain, uint32_t maxWorkers = 0);
+	};
+}
@@ -1,7 +1,10 @@
 #include "ModelLoader.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <limits>
 
 #include <assimp/mesh.h>
@@ -12,6 +15,10 @@
 #include "../Assets/Model.h"
 #include "../Assets/Mesh.h"
 #include "../Assets/Utils/MeshGenerator.h"
+#include "../Assets/Utils/MeshletBuilder.h"
+#include "../Assets/Utils/MeshOptimizer.h"
+#include "../Assets/Utils/MeshSimplifier.h"
+#include "../Assets/Utils/VertexPacker.h"
 
 #include "../Core/Graphics.h"
 #include "../Core/GraphicsDevice.h"
@@ -19,6 +26,8 @@
 #include "../Core/ResourceManager.h"
 
 #include "./Helper.h"
+#include "./MeshCache.h"
+#include "./ParallelFor.h"
 
 #include "./TextureLoader.h"
 
@@ -82,6 +91,139 @@ Assets::Mesh ProcessMesh(const aiMesh* mesh, const aiScene* scene) {
 	return newMesh;
 }
 
+// Note: Merges bitwise identical vertices through an open addressing table, the vertex bytes are hashed 
+// as a whole so the distribution doesn't depend on the weak std::hash<glm::vec> combination.
+static void WeldVertices(Assets::Mesh& mesh) {
+	const uint32_t empty = std::numeric_limits<uint32_t>::max();
+
+	size_t tableSize = 1;
+
+	while (tableSize < mesh.Vertices.size() * 2)
+		tableSize <<= 1;
+
+	std::vector<uint32_t>		table(tableSize, empty);
+	std::vector<uint32_t>		remap(mesh.Vertices.size());
+	std::vector<Assets::Vertex> welded;
+
+	welded.reserve(mesh.Vertices.size());
+
+	for (size_t i = 0; i < mesh.Vertices.size(); i++) {
+		const Assets::Vertex& vertex = mesh.Vertices[i];
+
+		size_t slot = Helper::hash_bytes(&vertex, sizeof(Assets::Vertex)) & (tableSize - 1);
+
+		while (true) {
+			if (table[slot] == empty) {
+				table[slot] = static_cast<uint32_t>(welded.size());
+				remap[i]	= table[slot];
+				welded.push_back(vertex);
+				break;
+			}
+
+			if (memcmp(&welded[table[slot]], &vertex, sizeof(Assets::Vertex)) == 0) {
+				remap[i] = table[slot];
+				break;
+			}
+
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	for (auto& index : mesh.Indices)
+		index = remap[index];
+
+	mesh.Vertices.swap(welded);
+}
+
+// Gram-Schmidt of the axis least aligned with the normal, for vertices whose uvs give no tangent
+static glm::vec3 GetOrthogonalTangent(const glm::vec3& normal) {
+	glm::vec3 axis		= std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 tangent	= axis - normal * glm::dot(normal, axis);
+	float length		= glm::length(tangent);
+
+	return length > 1e-8f && std::isfinite(length) ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+// Note: Index preserving import, reads the aiMesh vertex arrays and face indices as they are instead of 
+// rebuilding and hashing a vertex per face corner. Tangents are accumulated per vertex from every 
+// triangle sharing it and orthogonalized against the vertex normal.
+Assets::Mesh ProcessMeshIndexed(const aiMesh* mesh, const aiScene* scene, bool weldVertices) {
+	Assets::Mesh newMesh = {};
+
+	const bool hasNormals	= mesh->HasNormals();
+	const bool hasTexCoords = mesh->mTextureCoords[0] != nullptr;
+
+	newMesh.Vertices.resize(mesh->mNumVertices);
+
+	for (size_t i = 0; i < mesh->mNumVertices; i++) {
+		Assets::Vertex& vertex = newMesh.Vertices[i];
+
+		vertex.pos = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+
+		if (hasNormals)
+			vertex.normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
+
+		if (hasTexCoords)
+			vertex.texCoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+
+		if (hasNormals && hasTexCoords)
+			vertex.tangent = glm::vec3(0.0f);
+	}
+
+	newMesh.Indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+
+	for (size_t i = 0; i < mesh->mNumFaces; i++) {
+		const aiFace& face = mesh->mFaces[i];
+
+		// points and lines left over by aiProcess_Triangulate can't be drawn as triangle lists
+		if (face.mNumIndices != 3)
+			continue;
+
+		newMesh.Indices.push_back(face.mIndices[0]);
+		newMesh.Indices.push_back(face.mIndices[1]);
+		newMesh.Indices.push_back(face.mIndices[2]);
+	}
+
+	if (weldVertices)
+		WeldVertices(newMesh);
+
+	if (hasNormals && hasTexCoords) {
+		for (size_t i = 0; i + 2 < newMesh.Indices.size(); i += 3) {
+			Assets::Vertex& v0 = newMesh.Vertices[newMesh.Indices[i + 0]];
+			Assets::Vertex& v1 = newMesh.Vertices[newMesh.Indices[i + 1]];
+			Assets::Vertex& v2 = newMesh.Vertices[newMesh.Indices[i + 2]];
+
+			glm::vec3 edge1		= v1.pos - v0.pos;
+			glm::vec3 edge2		= v2.pos - v0.pos;
+			glm::vec2 deltaUv1	= v1.texCoord - v0.texCoord;
+			glm::vec2 deltaUv2	= v2.texCoord - v0.texCoord;
+
+			float determinant = deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x;
+
+			// degenerate uv mapping, the face has no defined tangent direction
+			if (std::abs(determinant) < 1e-12f)
+				continue;
+
+			glm::vec3 tangent = (deltaUv2.y * edge1 - deltaUv1.y * edge2) / determinant;
+
+			v0.tangent += tangent;
+			v1.tangent += tangent;
+			v2.tangent += tangent;
+		}
+
+		for (auto& vertex : newMesh.Vertices) {
+			glm::vec3 tangent = vertex.tangent - vertex.normal * glm::dot(vertex.normal, vertex.tangent);
+			float length = glm::length(tangent);
+
+			vertex.tangent = length > 1e-8f && std::isfinite(length) ? tangent / length : GetOrthogonalTangent(vertex.normal);
+		}
+	}
+
+	newMesh.MaterialName = scene->mMaterials[mesh->mMaterialIndex]->GetName().C_Str();
+
+	return newMesh;
+}
+
 void ProcessNode(Assets::Model& model, const aiNode* node, const aiScene* scene) {
 	for (size_t i = 0; i < node->mNumMeshes; i++) {
 		const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
@@ -93,9 +235,41 @@ void ProcessNode(Assets::Model& model, const aiNode* node, const aiScene* scene)
 	}
 }
 
-static void LoadMaterialTextures(aiMaterial* assimpMaterial, Material& material, const std::string& materialPath) {
-	ResourceManager* rm = ResourceManager::Get();
+static void CollectNodeMeshes(std::vector<const aiMesh*>& meshes, const aiNode* node, const aiScene* scene) {
+	for (size_t i = 0; i < node->mNumMeshes; i++) {
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+	}
 
+	for (size_t i = 0; i < node->mNumChildren; i++) {
+		CollectNodeMeshes(meshes, node->mChildren[i], scene);
+	}
+}
+
+// Note: Job based version of ProcessNode, the node tree is flattened first (same traversal order) and each
+// aiMesh is processed on a worker into its own slot, so the output is identical to the serial path.
+static void ProcessSceneMeshes(Assets::Model& model, const aiNode* node, const aiScene* scene, const ModelLoader::ImportSettings& settings) {
+	std::vector<const aiMesh*> meshes;
+	CollectNodeMeshes(meshes, node, scene);
+
+	size_t firstMesh = model.Meshes.size();
+	model.Meshes.resize(firstMesh + meshes.size());
+
+	auto process = [&](size_t i) {
+		if (settings.PreserveIndices)
+			model.Meshes[firstMesh + i] = ProcessMeshIndexed(meshes[i], scene, settings.WeldVertices);
+		else
+			model.Meshes[firstMesh + i] = ProcessMesh(meshes[i], scene);
+	};
+
+	if (settings.ParallelMeshProcessing) {
+		Utils::ParallelFor(meshes.size(), process);
+	} else {
+		for (size_t i = 0; i < meshes.size(); i++)
+			process(i);
+	}
+}
+
+static std::vector<MeshCache::MaterialTexture> CollectMaterialTextures(aiMaterial* assimpMaterial, const std::string& materialPath) {
 	// TODO: Turn these arrays into constants or enums
 
 	const int numTextureTypes = 5;
@@ -116,70 +290,92 @@ static void LoadMaterialTextures(aiMaterial* assimpMaterial, Material& material,
 		Texture::TextureType::BUMP,
 	};
 
+	std::vector<MeshCache::MaterialTexture> textures;
+
 	for (uint32_t tt = 0; tt < numTextureTypes; tt++) {
 		for (uint32_t t = 0; t < assimpMaterial->GetTextureCount(assimpTextureTypes[tt]); t++) {
-			aiString materialName;
 			aiString util;
 
-			assimpMaterial->Get(AI_MATKEY_NAME, materialName);
 			assimpMaterial->GetTexture(assimpTextureTypes[tt], t, &util);
 			
 			std::string texturePath = (materialPath + util.C_Str()).c_str();
-			std::string path = materialPath;
 
-			if (util.C_Str()  == "" || !Helper::file_exists(texturePath)) {
+			if (util.length == 0 || !Helper::file_exists(texturePath)) {
 				std::cout << "File: " << texturePath << " doesn't exists! Loading custom texture!" << '\n';
 				texturePath = "error_texture.jpg";
-				path = "./Textures/";
 			}
-			else {
-			}
-
-			rm->AddTexture(
-				TextureLoader::LoadTexture(
-					texturePath.c_str(),
-					textureTypes[tt],
-					false,
-					true //model.GenerateMipMaps	
-				)
-			);
-
-			int textureIndex = rm->GetTextureIndex(Helper::get_filename(texturePath));
-
-			switch (textureTypes[tt]) {
-			case Texture::TextureType::AMBIENT:
-				material.MaterialData.AmbientTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::DIFFUSE:
-				material.MaterialData.DiffuseTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::SPECULAR:
-				material.MaterialData.SpecularTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::BUMP:
-				material.MaterialData.BumpTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::ROUGHNESS:
-				material.MaterialData.RoughnessTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::METALLIC:
-				material.MaterialData.MetallicTextureIndex = textureIndex;
-				break;
-			case Texture::TextureType::NORMAL:
-				material.MaterialData.NormalTextureIndex = textureIndex;
-				break;
-			default:
-				break;
-			};
 
+			textures.push_back({ textureTypes[tt], texturePath });
 		}
 	}
+
+	return textures;
 }
 
-static void ProcessMaterials(Assets::Model& model, const aiScene* scene) {
+static void SetMaterialTexture(Material& material, Texture::TextureType textureType, int textureIndex) {
+
+	switch (textureType) {
+	case Texture::TextureType::AMBIENT:
+		material.MaterialData.AmbientTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::DIFFUSE:
+		material.MaterialData.DiffuseTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::SPECULAR:
+		material.MaterialData.SpecularTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::BUMP:
+		material.MaterialData.BumpTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::ROUGHNESS:
+		material.MaterialData.RoughnessTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::METALLIC:
+		material.MaterialData.MetallicTextureIndex = textureIndex;
+		break;
+	case Texture::TextureType::NORMAL:
+		material.MaterialData.NormalTextureIndex = textureIndex;
+		break;
+	default:
+		break;
+	};
+}
 
+// Note: Gathers the textures of every material not registered yet and loads them in one batch, decoded in parallel 
+// and uploaded in a single submission. Textures are shared through the ResourceManager cache, a file referenced by 
+// several materials (or models, or the error texture fallback) is decoded and uploaded once.
+static void RegisterMaterials(const std::vector<MeshCache::MaterialEntry>& materials, bool compressTextures, bool asyncUpload) {
 	ResourceManager* rm = ResourceManager::Get();
 
+	std::vector<const MeshCache::MaterialEntry*> entries;
+	std::vector<TextureLoader::TextureRequest> requests;
+	std::unordered_set<std::string> names;
+
+	for (const auto& entry : materials) {
+		if (rm->GetMaterialIndex(entry.Material.Name) != -1 || !names.insert(entry.Material.Name).second)
+			continue;
+
+		entries.push_back(&entry);
+
+		for (const auto& texture : entry.Textures)
+			requests.push_back({ .Path = texture.Path, .Type = texture.Type, .FlipVertically = false, .GenerateMipMaps = true, .Compress = compressTextures });
+	}
+
+	std::vector<int> textureIndices = TextureLoader::LoadSharedTextures(requests, asyncUpload);
+	size_t request = 0;
+
+	for (const auto* entry : entries) {
+		Material newMaterial = entry->Material;
+
+		for (const auto& texture : entry->Textures)
+			SetMaterialTexture(newMaterial, texture.Type, textureIndices[request++]);
+
+		rm->AddMaterial(newMaterial);
+	}
+}
+
+static void ProcessMaterials(Assets::Model& model, const aiScene* scene, std::vector<MeshCache::MaterialEntry>& materials, bool compressTextures, bool asyncUpload) {
+
 	for (size_t i = 0; i < scene->mNumMaterials; i++) {
 		aiMaterial* material = scene->mMaterials[i];
 
@@ -203,26 +399,235 @@ static void ProcessMaterials(Assets::Model& model, const aiScene* scene) {
 		material->Get(AI_MATKEY_SHININESS,			shininess);
 		material->Get(AI_MATKEY_SHININESS_STRENGTH, shininessStrength);
 
-		if (rm->GetMaterialIndex(materialName.C_Str()) == -1) {
-			Material newMaterial						= {};
-			newMaterial.Name							= materialName.C_Str();
-			newMaterial.MaterialData.Ambient			= glm::vec4(ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a);
-			newMaterial.MaterialData.Diffuse			= glm::vec4(diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a);
-			newMaterial.MaterialData.Specular			= glm::vec4(specularColor.r, specularColor.g, specularColor.b, specularColor.a);
-			newMaterial.MaterialData.Emission			= glm::vec4(emissiveColor.r, emissiveColor.g, emissiveColor.b, emissiveColor.a);
-			newMaterial.MaterialData.Transparency		= glm::vec4(transparentColor.r, transparentColor.g, transparentColor.b, transparentColor.a);
-			newMaterial.MaterialData.Opacity			= opacity;
-			newMaterial.MaterialData.Shininess			= shininess;
-			newMaterial.MaterialData.ShininessStrength	= shininessStrength;
-
-			LoadMaterialTextures(material, newMaterial, model.MaterialPath);
-			
-			rm->AddMaterial(newMaterial);
+		MeshCache::MaterialEntry entry						= {};
+		entry.Material.Name									= materialName.C_Str();
+		entry.Material.MaterialData.Ambient					= glm::vec4(ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a);
+		entry.Material.MaterialData.Diffuse					= glm::vec4(diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a);
+		entry.Material.MaterialData.Specular				= glm::vec4(specularColor.r, specularColor.g, specularColor.b, specularColor.a);
+		entry.Material.MaterialData.Emission				= glm::vec4(emissiveColor.r, emissiveColor.g, emissiveColor.b, emissiveColor.a);
+		entry.Material.MaterialData.Transparency			= glm::vec4(transparentColor.r, transparentColor.g, transparentColor.b, transparentColor.a);
+		entry.Material.MaterialData.Opacity					= opacity;
+		entry.Material.MaterialData.Shininess				= shininess;
+		entry.Material.MaterialData.ShininessStrength		= shininessStrength;
+		entry.Textures										= CollectMaterialTextures(material, model.MaterialPath);
+
+		materials.push_back(entry);
+	}
+
+	RegisterMaterials(materials, compressTextures, asyncUpload);
+}
+
+static void ResolveMeshMaterial(Assets::Mesh& mesh) {
+	ResourceManager* rm = ResourceManager::Get();
+
+	int materialIndex = rm->GetMaterialIndex(mesh.MaterialName);
+
+	if (materialIndex == -1) {
+		std::string customMaterialName = "Custom_Material";
+
+		materialIndex = rm->GetMaterialIndex(customMaterialName);
+
+		if (materialIndex == -1) {
+			rm->AddMaterial(Material(customMaterialName));
+			mesh.MaterialName = customMaterialName;
+			mesh.MaterialIndex = rm->GetLastMaterialIndex();
 		}
+		else {
+			mesh.MaterialName = customMaterialName;
+			mesh.MaterialIndex = materialIndex;
+		}
+	}
+	else {
+		mesh.MaterialIndex = materialIndex;
+	}
+
+	if (rm->GetMaterial(mesh.MaterialIndex).MaterialData.Diffuse.a < 1.0f) {
+		mesh.PSOFlags |= PSOFlags::tTransparent;
+		mesh.PSOFlags |= PSOFlags::tTwoSided;
+	} else {
+		mesh.PSOFlags |= PSOFlags::tOpaque;
 	}
 }
 
-void CompileMesh(Assets::Model& model) {
+// Note: Concatenates the meshlets of every mesh into the model wide streams uploaded after the vertices. The GPU copy
+// is rebased: offsets index the model streams and BaseVertex is the mesh's vertex offset, so a meshlet alone is 
+// enough to fetch its vertices from DataBuffer.
+static void GatherMeshlets(Assets::Model& model, std::vector<Assets::Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint32_t>& meshletTriangles) {
+	for (auto& mesh : model.Meshes) {
+		mesh.MeshletOffset = meshlets.size();
+
+		for (Assets::Meshlet meshlet : mesh.Meshlets) {
+			meshlet.VertexOffset	+= static_cast<uint32_t>(meshletVertices.size());
+			meshlet.TriangleOffset	+= static_cast<uint32_t>(meshletTriangles.size());
+			meshlet.BaseVertex		= static_cast<uint32_t>(mesh.VertexOffset);
+
+			meshlets.push_back(meshlet);
+		}
+
+		meshletVertices	.insert(meshletVertices.end(),	mesh.MeshletVertices.begin(),	mesh.MeshletVertices.end());
+		meshletTriangles.insert(meshletTriangles.end(), mesh.MeshletTriangles.begin(), mesh.MeshletTriangles.end());
+	}
+
+	model.TotalMeshlets = meshlets.size();
+}
+
+// Note: The vertices are always given in the standard layout, packed layouts are converted here so the mesh cache 
+// and every CPU side pass keep working on Assets::Vertex. The layout is also tagged on the meshes PSO flags, 
+// which is how the renderer picks the matching pipeline variant.
+static void UploadMeshData(Assets::Model& model, const uint32_t* indices, const Assets::Vertex* vertices, bool async) {
+	GraphicsDevice* gfxDevice = GetDevice();
+
+	const size_t vertexStride = Assets::GetVertexStride(model.Layout);
+
+	for (auto& mesh : model.Meshes) {
+		mesh.PSOFlags &= ~(PSOFlags::tPackedVertex | PSOFlags::tVertexColor);
+		mesh.PSOFlags |= PSOFlags::FromVertexLayout(model.Layout);
+	}
+
+	std::vector<uint8_t> packedVertices;
+
+	if (model.Layout != Assets::tStandardLayout) {
+		Assets::PositionQuantization quantization = Assets::VertexPacker::ComputeQuantization(model.Meshes);
+
+		model.PositionOffset	= quantization.Offset;
+		model.PositionScale		= quantization.Scale;
+
+		packedVertices.resize(vertexStride * model.TotalVertices);
+		Assets::VertexPacker::Pack(model.Layout, vertices, model.TotalVertices, quantization, packedVertices.data());
+
+		std::cout << "\tVertex data: " << sizeof(Assets::Vertex) * model.TotalVertices / 1024 << " KB -> " << packedVertices.size() / 1024 
+			<< " KB\t| Stride: " << sizeof(Assets::Vertex) << " -> " << vertexStride << " bytes" << '\n';
+	} else {
+		model.PositionOffset	= glm::vec3(0.0f);
+		model.PositionScale		= glm::vec3(1.0f);
+	}
+
+	const void* vertexData = packedVertices.empty() ? static_cast<const void*>(vertices) : packedVertices.data();
+
+	std::vector<Assets::Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> meshletTriangles;
+
+	GatherMeshlets(model, meshlets, meshletVertices, meshletTriangles);
+
+	// 256 bytes covers every minStorageBufferOffsetAlignment, so each stream can be bound on its own
+	auto align = [](VkDeviceSize offset) { return (offset + 255) & ~VkDeviceSize(255); };
+
+	const VkDeviceSize vertexEnd = sizeof(uint32_t) * model.TotalIndices + vertexStride * model.TotalVertices;
+
+	model.MeshletsOffset			= meshlets.empty() ? vertexEnd : align(vertexEnd);
+	model.MeshletVerticesOffset		= meshlets.empty() ? vertexEnd : align(model.MeshletsOffset + sizeof(Assets::Meshlet) * meshlets.size());
+	model.MeshletTrianglesOffset	= meshlets.empty() ? vertexEnd : align(model.MeshletVerticesOffset + sizeof(uint32_t) * meshletVertices.size());
+
+	BufferDescription desc	= {};
+	desc.Capacity			= model.MeshletTrianglesOffset + sizeof(uint32_t) * meshletTriangles.size();
+	desc.MemoryProperty		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	desc.Usage				= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	gfxDevice->CreateBuffer		(desc, model.DataBuffer, desc.Capacity);
+	gfxDevice->WriteBufferAsync	(model.DataBuffer, indices, sizeof(uint32_t) * model.TotalIndices, 0);
+	gfxDevice->WriteBufferAsync	(model.DataBuffer, vertexData, vertexStride * model.TotalVertices, sizeof(uint32_t) * model.TotalIndices);
+
+	if (!meshlets.empty()) {
+		gfxDevice->WriteBufferAsync	(model.DataBuffer, meshlets.data(), sizeof(Assets::Meshlet) * meshlets.size(), model.MeshletsOffset);
+		gfxDevice->WriteBufferAsync	(model.DataBuffer, meshletVertices.data(), sizeof(uint32_t) * meshletVertices.size(), model.MeshletVerticesOffset);
+		gfxDevice->WriteBufferAsync	(model.DataBuffer, meshletTriangles.data(), sizeof(uint32_t) * meshletTriangles.size(), model.MeshletTrianglesOffset);
+	}
+
+	// the textures of the model were uploaded before, the ticket covers them as well
+	uint64_t ticket = gfxDevice->SubmitAsyncUploads();
+
+	if (async)
+		model.UploadTicket = ticket;
+	else
+		gfxDevice->RequireUploads(ticket);
+}
+
+// Note: Reorders every mesh for the post-transform vertex cache, overdraw and vertex fetch, the ACMR/ATVR 
+// printed before and after are summed over the whole model.
+static void OptimizeMeshes(Assets::Model& model) {
+	std::vector<Assets::VertexCacheStatistics> before(model.Meshes.size());
+	std::vector<Assets::VertexCacheStatistics> after(model.Meshes.size());
+
+	Utils::ParallelFor(model.Meshes.size(), [&](size_t i) {
+		Assets::Mesh& mesh = model.Meshes[i];
+
+		before[i] = Assets::MeshOptimizer::AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size());
+		Assets::MeshOptimizer::Optimize(mesh);
+		after[i] = Assets::MeshOptimizer::AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size());
+	});
+
+	Assets::VertexCacheStatistics totalBefore	= {};
+	Assets::VertexCacheStatistics totalAfter	= {};
+
+	for (size_t i = 0; i < model.Meshes.size(); i++) {
+		totalBefore += before[i];
+		totalAfter	+= after[i];
+	}
+
+	std::cout << "\tVertex cache ACMR: " << totalBefore.GetACMR() << " -> " << totalAfter.GetACMR()
+		<< "\t| ATVR: " << totalBefore.GetATVR() << " -> " << totalAfter.GetATVR() << "\t| Model: " << model.Name << '\n';
+}
+
+// Note: Runs after the optimization, the vertex cache order is what keeps the greedily grown meshlets compact.
+static void BuildMeshlets(Assets::Model& model) {
+	Utils::ParallelFor(model.Meshes.size(), [&](size_t i) {
+		Assets::MeshletBuilder::Build(model.Meshes[i]);
+	});
+
+	size_t meshlets = 0, vertices = 0, triangles = 0, cullable = 0;
+
+	for (const auto& mesh : model.Meshes) {
+		meshlets += mesh.Meshlets.size();
+
+		for (const auto& meshlet : mesh.Meshlets) {
+			vertices	+= meshlet.VertexCount;
+			triangles	+= meshlet.TriangleCount;
+			cullable	+= meshlet.ConeCutoff < 1.0f;
+		}
+	}
+
+	if (meshlets == 0)
+		return;
+
+	std::cout << "\tMeshlets: " << meshlets << "\t| Avg vertices: " << vertices / float(meshlets) << "\t| Avg triangles: " << triangles / float(meshlets)
+		<< "\t| Cone cullable: " << cullable * 100 / meshlets << "%\t| Model: " << model.Name << '\n';
+}
+
+// Note: Runs after the optimization, vertex fetch reordering renumbers the vertices the levels index.
+static void GenerateLods(Assets::Model& model, uint32_t lodCount) {
+	Utils::ParallelFor(model.Meshes.size(), [&](size_t i) {
+		Assets::MeshSimplifier::GenerateLods(model.Meshes[i], lodCount);
+	});
+
+	std::vector<size_t> triangles(lodCount, 0);
+	uint32_t levels = 1;
+
+	for (const auto& mesh : model.Meshes) {
+		levels = std::max(levels, mesh.GetLodCount());
+
+		for (uint32_t lod = 0; lod < lodCount; lod++)
+			triangles[lod] += mesh.GetIndexCount(lod) / 3;
+	}
+
+	std::cout << "\tLODs: " << levels << "\t| Triangles: " << triangles[0];
+
+	for (uint32_t lod = 1; lod < levels; lod++)
+		std::cout << " -> " << triangles[lod];
+
+	std::cout << "\t| Model: " << model.Name << '\n';
+}
+
+void CompileMesh(Assets::Model& model, bool optimize = false, bool buildMeshlets = false, uint32_t lodCount = 1, bool asyncUpload = false) {
+
+	if (optimize)
+		OptimizeMeshes(model);
+
+	if (lodCount > 1)
+		GenerateLods(model, lodCount);
+
+	if (buildMeshlets)
+		BuildMeshlets(model);
 
 	std::vector<Assets::Vertex> vertices;
 	std::vector<uint32_t>		indices;
@@ -236,44 +641,23 @@ void CompileMesh(Assets::Model& model) {
 	float min_z = std::numeric_limits<float>::max();
 	float max_z = std::numeric_limits<float>::min();
 
-	ResourceManager* rm = ResourceManager::Get();
-
 	for (auto& mesh : model.Meshes) {
 
-		int materialIndex = rm->GetMaterialIndex(mesh.MaterialName);
-
-		if (materialIndex == -1) {
-			std::string customMaterialName = "Custom_Material";
-
-			materialIndex = rm->GetMaterialIndex(customMaterialName);
-
-			if (materialIndex == -1) {
-				rm->AddMaterial(Material(customMaterialName));
-				mesh.MaterialName = customMaterialName;
-				mesh.MaterialIndex = rm->GetLastMaterialIndex();
-			}
-			else {
-				mesh.MaterialName = customMaterialName;
-				mesh.MaterialIndex = materialIndex;
-			}
-		}
-		else {
-			mesh.MaterialIndex = materialIndex;
-		}
+		ResolveMeshMaterial(mesh);
 
 		mesh.IndexOffset = indices.size();
 		mesh.VertexOffset = vertices.size();
 
 		indices.insert(indices.end(), mesh.Indices.begin(), mesh.Indices.end());
-		vertices.insert(vertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
 
-		if (rm->GetMaterial(mesh.MaterialIndex).MaterialData.Diffuse.a < 1.0f) {
-			mesh.PSOFlags |= PSOFlags::tTransparent;
-			mesh.PSOFlags |= PSOFlags::tTwoSided;
-		} else {
-			mesh.PSOFlags |= PSOFlags::tOpaque;
+		// the levels follow the full index buffer of their mesh, drawn with the same vertex offset
+		for (auto& lod : mesh.Lods) {
+			lod.IndexOffset = indices.size();
+			indices.insert(indices.end(), lod.Indices.begin(), lod.Indices.end());
 		}
 
+		vertices.insert(vertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+
 		float mesh_max_x = std::numeric_limits<float>::min();
 		float mesh_min_x = std::numeric_limits<float>::max();
 		
@@ -311,16 +695,7 @@ void CompileMesh(Assets::Model& model) {
 	model.TotalVertices = vertices.size();
 	model.TotalIndices	= indices.size();
 
-	GraphicsDevice* gfxDevice = GetDevice();
-
-	BufferDescription desc	= {};
-	desc.Capacity			= sizeof(Assets::Vertex) * vertices.size() + sizeof(uint32_t) * indices.size();
-	desc.MemoryProperty		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	desc.Usage				= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-
-	gfxDevice->CreateBuffer	(desc, model.DataBuffer, desc.Capacity);
-	gfxDevice->WriteBuffer	(model.DataBuffer, indices.data(), sizeof(uint32_t) * indices.size(), 0);
-	gfxDevice->WriteBuffer	(model.DataBuffer, vertices.data(), sizeof(Assets::Vertex) * vertices.size(), sizeof(uint32_t) * indices.size());
+	UploadMeshData(model, indices.data(), vertices.data(), asyncUpload);
 }
 
 void ModelLoader::FlipModelUvVertically(Assets::Model& model) {
@@ -337,7 +712,55 @@ void ModelLoader::FlipModelUvVertically(Assets::Model& model) {
 	CompileMesh(model);
 }
 
-std::shared_ptr<Assets::Model> ModelLoader::LoadModel(const std::string& path) {
+// Note: Only the settings that change the imported data, the cache is rebuilt when they differ.
+static uint64_t GetImportKey(const ModelLoader::ImportSettings& settings) {
+	uint64_t key = 0;
+
+	key |= settings.PreserveIndices						? 0x1 : 0x0;
+	key |= settings.PreserveIndices && settings.WeldVertices	? 0x2 : 0x0;
+	key |= settings.OptimizeMeshes						? 0x4 : 0x0;
+	key |= settings.BuildMeshlets						? 0x8 : 0x0;
+	key |= static_cast<uint64_t>(settings.LodCount > 1 ? settings.LodCount : 0) << 8;
+
+	return key;
+}
+
+// Note: Warm loads skip Assimp entirely and read the binary cache written by the previous cold load, see MeshCache.h.
+static std::shared_ptr<Assets::Model> LoadCachedModel(const MeshCache::CachedModel& cache, std::shared_ptr<Assets::Model> model, const ModelLoader::ImportSettings& settings, Timestep loadingBegin) {
+	Timestep materialBegin = glfwGetTime();
+	size_t sharedTextures = ResourceManager::Get()->GetTextureCacheHits();
+
+	std::vector<MeshCache::MaterialEntry> materials;
+	cache.ReadMaterials(materials);
+
+	RegisterMaterials(materials, settings.CompressTextures, settings.AsyncUpload);
+
+	Timestep materialEnd = glfwGetTime();
+
+	Timestep geometryBegin = glfwGetTime();
+
+	cache.ReadMeshes(*model.get());
+
+	for (auto& mesh : model->Meshes)
+		ResolveMeshMaterial(mesh);
+
+	UploadMeshData(*model.get(), cache.GetIndices(), cache.GetVertices(), settings.AsyncUpload);
+
+	Timestep geometryEnd = glfwGetTime();
+
+	float loadingTime	= geometryEnd.GetSeconds() - loadingBegin.GetSeconds();
+	float geometryTime	= geometryEnd.GetSeconds() - geometryBegin.GetSeconds();
+	float speedup		= geometryTime > 0.0f ? cache.GetImportTime() / geometryTime : 0.0f;
+
+	std::cout << "Loading time: " << loadingTime << "\t| Model: " << model->Name << " (warm, mesh cache)" << '\n';
+	std::cout << "\tCached Geometry Loading time: " << geometryTime << "\t| Cold import: " << cache.GetImportTime() << " (" << speedup << "x)" << '\n';
+	std::cout << "\tMaterial and Textures time: " << materialEnd.GetSeconds() - materialBegin.GetSeconds() 
+		<< "\t| Shared textures: " << ResourceManager::Get()->GetTextureCacheHits() - sharedTextures << "\t| Decode workers: " << Utils::GetWorkerCount() << '\n';
+
+	return model;
+}
+
+std::shared_ptr<Assets::Model> ModelLoader::LoadModel(const std::string& path, const ImportSettings& settings) {
 
 	Timestep geometryBegin = glfwGetTime();
 
@@ -345,32 +768,50 @@ std::shared_ptr<Assets::Model> ModelLoader::LoadModel(const std::string& path) {
 	model->ModelPath = path.c_str();
 	model->MaterialPath = Helper::get_directory(path);
 	model->Name = Helper::get_directory_name(path);
+	model->Layout = settings.Layout;
 	
 	loadedFileNames[model->Name]++;
 
+	MeshCache::CachedModel cache;
+
+	if (cache.Open(path, GetImportKey(settings)))
+		return LoadCachedModel(cache, model, settings, geometryBegin);
+
 	const aiScene* scene = aiImportFile(path.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs);
 
 	assert(scene && scene->HasMeshes());
 
-	ProcessNode(*model.get(), scene->mRootNode, scene);
+	if (settings.ParallelMeshProcessing || settings.PreserveIndices)
+		ProcessSceneMeshes(*model.get(), scene->mRootNode, scene, settings);
+	else
+		ProcessNode(*model.get(), scene->mRootNode, scene);
 
 	Timestep geometryEnd = glfwGetTime();
 
 	Timestep materialBegin = glfwGetTime();
+	size_t sharedTextures = ResourceManager::Get()->GetTextureCacheHits();
+
+	std::vector<MeshCache::MaterialEntry> materials;
+	ProcessMaterials(*model.get(), scene, materials, settings.CompressTextures, settings.AsyncUpload);
 
-	ProcessMaterials(*model.get(), scene);
+	aiReleaseImport(scene);
 
 	Timestep materialEnd = glfwGetTime();
 	
 	Timestep compilingBegin = glfwGetTime();
 
-	CompileMesh(*model.get());
+	CompileMesh(*model.get(), settings.OptimizeMeshes, settings.BuildMeshlets, settings.LodCount, settings.AsyncUpload);
 
 	Timestep compilingEnd = glfwGetTime();
 
-	std::cout << "Loading time: " << compilingEnd.GetSeconds() - geometryBegin.GetSeconds() << "\t| Model: " << model->Name << '\n';
-	std::cout << "\tGeometry Loading time: " << geometryEnd.GetSeconds() - geometryBegin.GetSeconds() << '\n';
-	std::cout << "\tMaterial and Textures time: " << materialEnd.GetSeconds() - materialBegin.GetSeconds() << '\n';
+	float importTime = (geometryEnd.GetSeconds() - geometryBegin.GetSeconds()) + (compilingEnd.GetSeconds() - compilingBegin.GetSeconds());
+
+	bool cacheWritten = MeshCache::Write(path, GetImportKey(settings), *model.get(), materials, importTime);
+
+	std::cout << "Loading time: " << compilingEnd.GetSeconds() - geometryBegin.GetSeconds() << "\t| Model: " << model->Name << (cacheWritten ? " (cold, mesh cache written)" : " (cold)") << '\n';
+	std::cout << "\tGeometry Loading time: " << geometryEnd.GetSeconds() - geometryBegin.GetSeconds() << "\t| Workers: " << (settings.ParallelMeshProcessing ? Utils::GetWorkerCount() : 1) << '\n';
+	std::cout << "\tMaterial and Textures time: " << materialEnd.GetSeconds() - materialBegin.GetSeconds() 
+		<< "\t| Shared textures: " << ResourceManager::Get()->GetTextureCacheHits() - sharedTextures << "\t| Decode workers: " << Utils::GetWorkerCount() << '\n';
 	std::cout << "\tMesh Compiling time: " << compilingEnd.GetSeconds() - compilingBegin.GetSeconds() << '\n';
 
 	return model;
@@ -440,6 +881,7 @@ std::shared_ptr<Assets::Model> ModelLoader::DuplicateModel(std::shared_ptr<Asset
 
 	std::shared_ptr<Assets::Model> newModel = std::make_shared<Assets::Model>();
 	newModel->Meshes = model->Meshes;
+	newModel->Layout = model->Layout;
 
 	newModel->Name = model->Name + "_" + std::to_string(loadedFileNames[model->Name]);
 	loadedFileNames[model->Name]++;
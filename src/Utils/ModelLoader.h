@@ -7,6 +7,8 @@
 
 #include <glm.hpp>
 
+#include "../Assets/Mesh.h"
+
 namespace Assets {
 	class Model;
 }
@@ -25,9 +27,43 @@ namespace {
 
 namespace ModelLoader {
 
+	struct ImportSettings {
+		// process each aiMesh on a worker thread, output is identical to the serial import
+		bool ParallelMeshProcessing = true;
+
+		// read Assimp's vertex arrays and face indices directly instead of rebuilding a vertex per face corner
+		bool PreserveIndices		= false;
+
+		// merge bitwise identical vertices after an index preserving import (e.g. OBJ files, which come unindexed)
+		bool WeldVertices			= false;
+
+		// vertex cache, overdraw and vertex fetch reordering when compiling the meshes, prints ACMR/ATVR before and after
+		bool OptimizeMeshes			= false;
+
+		// levels of detail per mesh including the full one, each level halves the triangles of the previous one 
+		// (quadric error simplification, the levels share the vertex buffer)
+		uint32_t LodCount			= 1;
+
+		// split every mesh into meshlets (64 vertices / 124 triangles) with bounding spheres and normal cones, 
+		// uploaded after the vertices in the model's DataBuffer for cluster culling
+		bool BuildMeshlets			= false;
+
+		// GPU vertex format, the packed layouts decode in the vertex shader (see Assets::VertexLayout)
+		Assets::VertexLayout Layout	= Assets::tStandardLayout;
+
+		// block compress the material textures (BC7 albedo, BC5 normals, BC4 single channel, BC1/BC3 otherwise) with 
+		// precomputed mips, cached next to each image (see TextureCache.h). Devices without BC support keep RGBA8.
+		// Note: lossy, so it is opt in per model
+		bool CompressTextures		= false;
+
+		// copy the geometry and textures on the transfer queue without making the next frame wait for them, the first 
+		// Model::Render does (on the GPU). Only for models that are drawn through Model::Render.
+		bool AsyncUpload			= false;
+	};
+
 	void FlipModelUvVertically(Assets::Model& model);
 
-	std::shared_ptr<Assets::Model> LoadModel(const std::string& path);
+	std::shared_ptr<Assets::Model> LoadModel(const std::string& path, const ImportSettings& settings = {});
 	std::shared_ptr<Assets::Model> LoadModel(ModelType modelType, glm::vec3 position = glm::vec3(0.0), float size = 1.0f);
     std::shared_ptr<Assets::Model> LoadMultiQuadModel(int verticalVerticesCount, int horizontalVerticesCount, glm::vec3 position = glm::vec3(0.0f), float size = 1.0f);
 	std::shared_ptr<Assets::Model> LoadSphere(ModelType modelType, size_t sphereSubdivisions);
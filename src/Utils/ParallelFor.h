@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+
+	inline uint32_t GetWorkerCount() {
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Note: Runs function(i) for every i in [0, count), items are handed out one at a time from a shared 
+	// counter so uneven items (e.g. a huge mesh next to many tiny ones) still balance across workers. 
+	// The calling thread takes part in the work and the call only returns once every item is done.
+	template<class Function>
+	void ParallelFor(size_t count, Function&& function, uint32_t maxWorkers = 0) {
+		uint32_t workers = maxWorkers == 0 ? GetWorkerCount() : std::min(maxWorkers, GetWorkerCount());
+		workers = static_cast<uint32_t>(std::min<size_t>(workers, count));
+
+		if (workers <= 1) {
+			for (size_t i = 0; i < count; i++)
+				function(i);
+
+			return;
+		}
+
+		std::atomic<size_t> next = 0;
+
+		auto worker = [&]() {
+			for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+				function(i);
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(workers - 1);
+
+		for (uint32_t i = 1; i < workers; i++)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+}
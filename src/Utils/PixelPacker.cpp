@@ -0,0 +1,194 @@
+#include "PixelPacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define PIXEL_PACKER_SSE2
+#endif
+
+namespace Utils {
+
+	static constexpr float HALF_MAX				= 65504.0f;
+	static constexpr float SHARED_EXP_MAX		= 65408.0f;		// (2^9 - 1) / 2^9 * 2^(31 - 15)
+
+	static constexpr uint32_t HALF_MIN_NORMAL	= 0x38800000;	// 2^-14 as float bits
+	static constexpr uint32_t HALF_REBIAS		= 0xc8000fff;	// ((15 - 127) << 23) + rounding bias
+	static constexpr uint32_t DENORM_MAGIC		= 0x3f000000;	// 0.5f, lines the half denormal ulp up with the float ulp
+
+	static inline uint32_t asUint(float value) {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static inline float asFloat(uint32_t bits) {
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	static inline uint16_t packHalf(float value) {
+		const uint32_t sign = (asUint(value) >> 16) & 0x8000;
+
+		// NaN -> 0, inf and anything past the half range -> HALF_MAX (same operand order as _mm_max_ps/_mm_min_ps)
+		const float a = std::min(std::max(0.0f, std::fabs(value)), HALF_MAX);
+		const uint32_t f = asUint(a);
+
+		uint32_t result;
+
+		if (f < HALF_MIN_NORMAL) {
+			result = asUint(a + asFloat(DENORM_MAGIC)) - DENORM_MAGIC;
+		}
+		else {
+			const uint32_t mantissaOdd = (f >> 13) & 1;
+			result = (f + HALF_REBIAS + mantissaOdd) >> 13;
+		}
+
+		return static_cast<uint16_t>(result | sign);
+	}
+
+	static inline uint32_t packE5B9G9R9(float r, float g, float b) {
+		r = std::min(std::max(0.0f, r), SHARED_EXP_MAX);
+		g = std::min(std::max(0.0f, g), SHARED_EXP_MAX);
+		b = std::min(std::max(0.0f, b), SHARED_EXP_MAX);
+
+		const float maxComponent = std::max(r, std::max(g, b));
+
+		// floor(log2(max)) straight from the float exponent, limited to the smallest shared exponent (-15 - 1)
+		int32_t sharedExponent = std::max(-16, static_cast<int32_t>(asUint(maxComponent) >> 23) - 127) + 16;
+
+		// 2^(15 + 9 - sharedExponent)
+		float scale = asFloat(static_cast<uint32_t>(151 - sharedExponent) << 23);
+
+		if (static_cast<uint32_t>(maxComponent * scale + 0.5f) == 512) {
+			sharedExponent++;
+			scale *= 0.5f;
+		}
+
+		return static_cast<uint32_t>(r * scale + 0.5f)
+			| static_cast<uint32_t>(g * scale + 0.5f) << 9
+			| static_cast<uint32_t>(b * scale + 0.5f) << 18
+			| static_cast<uint32_t>(sharedExponent) << 27;
+	}
+
+#ifdef PIXEL_PACKER_SSE2
+	static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	static inline void packHalf4(const float* src, uint16_t* dst) {
+		const __m128 value = _mm_loadu_ps(src);
+		const __m128i sign = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(value), 16), _mm_set1_epi32(0x8000));
+
+		__m128 a = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+		a = _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(HALF_MAX));
+
+		const __m128i f = _mm_castps_si128(a);
+
+		const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(a, _mm_castsi128_ps(_mm_set1_epi32(DENORM_MAGIC)))), _mm_set1_epi32(DENORM_MAGIC));
+
+		const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(f, 13), _mm_set1_epi32(1));
+		const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, _mm_set1_epi32(static_cast<int32_t>(HALF_REBIAS))), mantissaOdd), 13);
+
+		__m128i result = select(_mm_cmplt_epi32(f, _mm_set1_epi32(HALF_MIN_NORMAL)), denormal, normal);
+		result = _mm_or_si128(result, sign);
+
+		// sign extend the low 16 bits so the saturating pack keeps them as they are
+		result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(result, result));
+	}
+
+	static inline void packE5B9G9R9x4(const float* rgba, uint32_t* dst) {
+		__m128 r = _mm_loadu_ps(rgba + 0);
+		__m128 g = _mm_loadu_ps(rgba + 4);
+		__m128 b = _mm_loadu_ps(rgba + 8);
+		__m128 a = _mm_loadu_ps(rgba + 12);
+
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maxValue = _mm_set1_ps(SHARED_EXP_MAX);
+
+		r = _mm_min_ps(_mm_max_ps(r, zero), maxValue);
+		g = _mm_min_ps(_mm_max_ps(g, zero), maxValue);
+		b = _mm_min_ps(_mm_max_ps(b, zero), maxValue);
+
+		const __m128 maxComponent = _mm_max_ps(r, _mm_max_ps(g, b));
+
+		__m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxComponent), 23), _mm_set1_epi32(127));
+		exponent = select(_mm_cmplt_epi32(exponent, _mm_set1_epi32(-16)), _mm_set1_epi32(-16), exponent);
+
+		__m128i sharedExponent = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(151), sharedExponent), 23));
+
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		const __m128i maxScaled = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(maxComponent, scale), half));
+		const __m128i overflow = _mm_cmpeq_epi32(maxScaled, _mm_set1_epi32(512));
+
+		sharedExponent = _mm_sub_epi32(sharedExponent, overflow);
+		scale = _mm_mul_ps(scale, _mm_castsi128_ps(select(overflow, _mm_castps_si128(half), _mm_castps_si128(_mm_set1_ps(1.0f)))));
+
+		const __m128i rs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+		const __m128i gs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+		const __m128i bs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+
+		__m128i result = _mm_or_si128(rs, _mm_slli_epi32(gs, 9));
+		result = _mm_or_si128(result, _mm_slli_epi32(bs, 18));
+		result = _mm_or_si128(result, _mm_slli_epi32(sharedExponent, 27));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+	}
+#endif
+
+	void PixelPacker::PackHalf(const float* src, size_t count, uint16_t* dst) {
+		size_t i = 0;
+
+#ifdef PIXEL_PACKER_SSE2
+		for (; i + 4 <= count; i += 4)
+			packHalf4(src + i, dst + i);
+#endif
+
+		for (; i < count; i++)
+			dst[i] = packHalf(src[i]);
+	}
+
+	void PixelPacker::PackE5B9G9R9(const float* rgba, size_t count, uint32_t* dst) {
+		size_t i = 0;
+
+#ifdef PIXEL_PACKER_SSE2
+		for (; i + 4 <= count; i += 4)
+			packE5B9G9R9x4(rgba + i * 4, dst + i);
+#endif
+
+		for (; i < count; i++)
+			dst[i] = packE5B9G9R9(rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+	}
+
+	float PixelPacker::UnpackHalf(uint16_t value) {
+		const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		const uint32_t exponent = (value >> 10) & 0x1f;
+		const uint32_t mantissa = value & 0x3ff;
+
+		if (exponent == 0)
+			return asFloat(sign | asUint(static_cast<float>(mantissa) * asFloat(0x33800000)));	// mantissa * 2^-24
+
+		if (exponent == 31)
+			return asFloat(sign | 0x7f800000 | (mantissa << 13));
+
+		return asFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	}
+
+	void PixelPacker::UnpackE5B9G9R9(uint32_t value, float* rgb) {
+		const int32_t exponent = static_cast<int32_t>(value >> 27);
+		const float scale = asFloat(static_cast<uint32_t>(exponent - 24 + 127) << 23);
+
+		rgb[0] = static_cast<float>(value & 0x1ff) * scale;
+		rgb[1] = static_cast<float>((value >> 9) & 0x1ff) * scale;
+		rgb[2] = static_cast<float>((value >> 18) & 0x1ff) * scale;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils {
+
+	// Note: Packs linear float texels into the compact HDR storage formats. Both packers take 'count' texels and
+	// process them four at a time with SSE2 when available (scalar loop otherwise), the output is bit exact with
+	// the scalar path. Non finite inputs are flushed to 0, out of range values clamp to the largest finite value.
+	class PixelPacker {
+	public:
+		PixelPacker() {};
+		~PixelPacker() {};
+
+		// IEEE half, round to nearest even. 'count' floats in, 'count' halfs out (any channel count).
+		static void PackHalf(const float* src, size_t count, uint16_t* dst);
+
+		// VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 (9 bit mantissas sharing a 5 bit exponent, unsigned), 'src' is RGBA and
+		// alpha is dropped. 'count' texels.
+		static void PackE5B9G9R9(const float* rgba, size_t count, uint32_t* dst);
+
+		static float UnpackHalf(uint16_t value);
+		static void UnpackE5B9G9R9(uint32_t value, float* rgb);
+	};
+}
@@ -0,0 +1,177 @@
+#include "ShaderCache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "./Helper.h"
+#include "./MappedFile.h"
+
+namespace ShaderCache {
+
+	constexpr uint32_t CACHE_MAGIC		= 0x56505356;	// "VSPV"
+	constexpr uint32_t CACHE_VERSION	= 1;
+
+	const char* const CACHE_DIRECTORY	= "ShaderCache";
+
+	struct Header {
+		uint32_t Magic		= CACHE_MAGIC;
+		uint32_t Version	= CACHE_VERSION;
+		uint64_t Key		= 0;
+		uint64_t WordCount	= 0;
+		uint64_t SpirvHash	= 0;
+	};
+
+	// the "name" (or <name>) of an #include line, empty for every other line
+	static std::string GetIncludeName(const std::string& line) {
+		size_t start = line.find_first_not_of(" \t");
+
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+			return "";
+
+		size_t open = line.find_first_of("\"<", start + 8);
+
+		if (open == std::string::npos)
+			return "";
+
+		size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+
+		if (close == std::string::npos)
+			return "";
+
+		return line.substr(open + 1, close - open - 1);
+	}
+
+	static void HashIncludes(const std::filesystem::path& directory, const char* source, size_t size, std::set<std::string>& visited, uint64_t& hash) {
+		std::istringstream stream(std::string(source, size));
+		std::string line;
+
+		while (std::getline(stream, line)) {
+			const std::string name = GetIncludeName(line);
+
+			if (name.empty())
+				continue;
+
+			const std::filesystem::path path = (directory / name).lexically_normal();
+
+			// include guards and diamonds, every file counts once
+			if (!visited.insert(path.generic_string()).second)
+				continue;
+
+			hash = Helper::hash_bytes(name.data(), name.size(), hash);
+
+			Utils::MappedFile file;
+
+			// a missing include fails the compilation, the name alone keys it
+			if (!file.Open(path.string()))
+				continue;
+
+			const char* data = reinterpret_cast<const char*>(file.GetData());
+
+			hash = Helper::hash_bytes(data, file.GetSize(), hash);
+
+			HashIncludes(path.parent_path(), data, file.GetSize(), visited, hash);
+		}
+	}
+
+	uint64_t GetShaderKey(const std::string& sourcePath, const std::vector<char>& source, uint32_t stage, const std::string& preamble, uint64_t options) {
+		uint64_t hash = Helper::hash_bytes(source.data(), source.size(), CACHE_VERSION);
+
+		hash = Helper::hash_bytes(preamble.data(), preamble.size(), hash);
+		hash = Helper::hash_bytes(&stage, sizeof(stage), hash);
+		hash = Helper::hash_bytes(&options, sizeof(options), hash);
+
+		std::set<std::string> visited;
+		HashIncludes(std::filesystem::path(sourcePath).parent_path(), source.data(), source.size(), visited, hash);
+
+		return hash;
+	}
+
+	std::string GetCachePath(uint64_t key) {
+		char name[32] = {};
+		snprintf(name, sizeof(name), "%016llx.spvcache", static_cast<unsigned long long>(key));
+
+		return (std::filesystem::path(CACHE_DIRECTORY) / name).string();
+	}
+
+	bool Read(uint64_t key, std::vector<unsigned int>& spirv) {
+		Utils::MappedFile file;
+
+		if (!file.Open(GetCachePath(key)) || file.GetSize() < sizeof(Header))
+			return false;
+
+		Header header;
+		memcpy(&header, file.GetData(), sizeof(Header));
+
+		const uint8_t* words = file.GetData() + sizeof(Header);
+
+		bool valid = header.Magic	== CACHE_MAGIC
+			&& header.Version		== CACHE_VERSION
+			&& header.Key			== key
+			&& header.WordCount		> 0
+			&& header.WordCount * sizeof(unsigned int) == file.GetSize() - sizeof(Header);
+
+		if (!valid || header.SpirvHash != Helper::hash_bytes(words, file.GetSize() - sizeof(Header)))
+			return false;
+
+		spirv.resize(header.WordCount);
+		memcpy(spirv.data(), words, header.WordCount * sizeof(unsigned int));
+
+		return true;
+	}
+
+	bool Write(uint64_t key, const std::vector<unsigned int>& spirv) {
+		Header header		= {};
+		header.Key			= key;
+		header.WordCount	= spirv.size();
+		header.SpirvHash	= Helper::hash_bytes(spirv.data(), spirv.size() * sizeof(unsigned int));
+
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_DIRECTORY, error);
+
+		// write to a temporary file first so an interrupted write never leaves a truncated cache behind, shaders compile
+		// on worker threads and two of them may write the same key at once, so every write gets its own file
+		static std::atomic<uint32_t> writeCount = 0;
+
+		const std::string cachePath = GetCachePath(key);
+
+		std::ostringstream tempName;
+		tempName << cachePath << '.' << std::this_thread::get_id() << '.' << writeCount++ << ".tmp";
+
+		const std::string tempPath	= tempName.str();
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!stream.is_open()) {
+				std::cout << "Failed to create shader cache: " << cachePath << '\n';
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			stream.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(unsigned int));
+
+			if (!stream.good()) {
+				stream.close();
+				std::filesystem::remove(tempPath);
+				std::cout << "Failed to write shader cache: " << cachePath << '\n';
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
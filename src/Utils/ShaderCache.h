@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// SPIR-V of the shaders compiled at runtime (RUNTIME_SHADER_COMPILATION), content addressed: the file name is the
+// key of everything that goes into the compilation, so an unchanged shader is read back instead of going through
+// glslang and a changed one simply gets a new file. Files live in one directory relative to the working directory
+// ("ShaderCache/<key>.spvcache"), stale entries are never read again and can be deleted at any time.
+//
+// Layout:
+//	[Header][SPIR-V words]
+namespace ShaderCache {
+
+	// Note: Hash of the source, of every file it #includes (resolved relative to the including file, recursively), of
+	// the stage, of the preamble (defines) and of 'options' (whatever else changes the compiler output, e.g. the
+	// glslang messages and default version).
+	uint64_t GetShaderKey(const std::string& sourcePath, const std::vector<char>& source, uint32_t stage, const std::string& preamble, uint64_t options);
+
+	std::string GetCachePath(uint64_t key);
+
+	bool Read(uint64_t key, std::vector<unsigned int>& spirv);
+	bool Write(uint64_t key, const std::vector<unsigned int>& spirv);
+}
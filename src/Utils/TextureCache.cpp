@@ -0,0 +1,237 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace TextureCache {
+
+	constexpr uint32_t CACHE_MAGIC		= 0x58455456;	// "VTEX"
+	constexpr uint32_t CACHE_VERSION	= 2;
+	constexpr uint64_t CACHE_ALIGNMENT	= 16;
+
+	struct Header {
+		uint32_t Magic				= CACHE_MAGIC;
+		uint32_t Version			= CACHE_VERSION;
+		uint32_t Format				= 0;
+		uint32_t Flags				= 0;
+		uint32_t Width				= 0;
+		uint32_t Height				= 0;
+		uint32_t MipLevels			= 0;
+		uint32_t Pad				= 0;
+
+		uint64_t SourceSize			= 0;
+		int64_t  SourceTime			= 0;
+		uint64_t SourceHash			= 0;
+		uint64_t FileSize			= 0;
+
+		uint64_t LevelsOffset		= 0;
+		uint64_t DataOffset			= 0;
+		uint64_t DataSize			= 0;
+	};
+
+	// offsets are relative to Header::DataOffset
+	struct LevelRecord {
+		uint64_t Offset				= 0;
+		uint64_t Size				= 0;
+	};
+
+	static uint64_t Align(uint64_t value) {
+		return (value + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+	}
+
+	std::string GetCachePath(const std::string& sourcePath, const std::string& profile) {
+		return sourcePath + "." + profile + ".texcache";
+	}
+
+	void Compress(const uint8_t* rgba, uint32_t width, uint32_t height, Utils::BlockFormat format, bool srgb, bool generateMipMaps, CompressedTexture& texture, uint32_t maxWorkers) {
+		texture.Format	= format;
+		texture.Width	= width;
+		texture.Height	= height;
+		texture.LevelOffsets.clear();
+		texture.Data.clear();
+
+		Utils::MipChain mips;
+
+		if (generateMipMaps)
+			Utils::MipGenerator::Generate(rgba, width, height, srgb, Utils::MipFilter::Kaiser, mips, maxWorkers);
+		else
+			mips.LevelOffsets = { 0 };
+
+		for (size_t level = 0; level < mips.LevelOffsets.size(); level++) {
+			const uint8_t* pixels = generateMipMaps ? mips.Data.data() + mips.LevelOffsets[level] : rgba;
+			uint64_t offset = Align(texture.Data.size());
+
+			texture.LevelOffsets.push_back(offset);
+			texture.Data.resize(offset + Utils::BlockCompressor::GetCompressedSize(format, width, height));
+
+			Utils::BlockCompressor::Compress(format, pixels, width, height, texture.Data.data() + offset);
+
+			width	= std::max(width / 2, 1u);
+			height	= std::max(height / 2, 1u);
+		}
+	}
+
+	bool Write(const std::string& sourcePath, const std::string& profile, uint32_t flags, const CompressedTexture& texture) {
+		Header header		= {};
+		header.Format		= static_cast<uint32_t>(texture.Format);
+		header.Flags		= flags;
+		header.Width		= texture.Width;
+		header.Height		= texture.Height;
+		header.MipLevels	= static_cast<uint32_t>(texture.LevelOffsets.size());
+
+		if (!Utils::GetFileStamp(sourcePath, header.SourceSize, header.SourceTime))
+			return false;
+
+		header.SourceHash = Utils::HashFile(sourcePath);
+
+		std::vector<LevelRecord> levels(header.MipLevels);
+
+		for (uint32_t i = 0; i < header.MipLevels; i++) {
+			uint64_t end = i + 1 < header.MipLevels ? texture.LevelOffsets[i + 1] : texture.Data.size();
+
+			levels[i].Offset	= texture.LevelOffsets[i];
+			levels[i].Size		= Utils::BlockCompressor::GetCompressedSize(texture.Format, std::max(texture.Width >> i, 1u), std::max(texture.Height >> i, 1u));
+
+			if (levels[i].Offset + levels[i].Size > end)
+				return false;
+		}
+
+		header.LevelsOffset = Align(sizeof(Header));
+		header.DataOffset	= Align(header.LevelsOffset + sizeof(LevelRecord) * levels.size());
+		header.DataSize		= texture.Data.size();
+		header.FileSize		= header.DataOffset + header.DataSize;
+
+		// write to a temporary file first so an interrupted write never leaves a truncated cache behind
+		const std::string cachePath = GetCachePath(sourcePath, profile);
+		const std::string tempPath	= cachePath + ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!stream.is_open()) {
+				std::cout << "Failed to create texture cache: " << cachePath << '\n';
+				return false;
+			}
+
+			static const char zeros[CACHE_ALIGNMENT] = {};
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			stream.write(zeros, header.LevelsOffset - sizeof(Header));
+			stream.write(reinterpret_cast<const char*>(levels.data()), sizeof(LevelRecord) * levels.size());
+			stream.write(zeros, header.DataOffset - header.LevelsOffset - sizeof(LevelRecord) * levels.size());
+			stream.write(reinterpret_cast<const char*>(texture.Data.data()), texture.Data.size());
+
+			if (!stream.good()) {
+				stream.close();
+				std::filesystem::remove(tempPath);
+				std::cout << "Failed to write texture cache: " << cachePath << '\n';
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CachedTexture::Open(const std::string& sourcePath, const std::string& profile, uint32_t flags) {
+		uint64_t sourceSize = 0;
+		int64_t sourceTime	= 0;
+
+		if (!Utils::GetFileStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		if (!m_File.Open(GetCachePath(sourcePath, profile)))
+			return false;
+
+		if (m_File.GetSize() < sizeof(Header)) {
+			m_File.Close();
+			return false;
+		}
+
+		const Header* header = Section<Header>(0);
+
+		bool valid = header->Magic	== CACHE_MAGIC
+			&& header->Version		== CACHE_VERSION
+			&& header->Flags		== flags
+			&& header->Format		<= static_cast<uint32_t>(Utils::BlockFormat::BC7)
+			&& header->MipLevels	>= 1
+			&& header->MipLevels	<= 32
+			&& header->FileSize		== m_File.GetSize()
+			&& header->SourceSize	== sourceSize;
+
+		// the file may have been touched without changing (e.g. checkout), only then pay for hashing the source
+		if (valid && header->SourceTime != sourceTime)
+			valid = header->SourceHash == Utils::HashFile(sourcePath);
+
+		valid = valid
+			&& header->LevelsOffset + sizeof(LevelRecord) * header->MipLevels	<= header->FileSize
+			&& header->DataOffset + header->DataSize							<= header->FileSize;
+
+		if (valid) {
+			const LevelRecord* levels = Section<LevelRecord>(header->LevelsOffset);
+
+			Utils::BlockFormat format = static_cast<Utils::BlockFormat>(header->Format);
+
+			for (uint32_t i = 0; i < header->MipLevels && valid; i++) {
+				uint64_t size = Utils::BlockCompressor::GetCompressedSize(format, std::max(header->Width >> i, 1u), std::max(header->Height >> i, 1u));
+
+				valid = levels[i].Size == size
+					&& levels[i].Offset % CACHE_ALIGNMENT == 0 
+					&& levels[i].Offset + levels[i].Size <= header->DataSize;
+			}
+		}
+
+		if (!valid) {
+			m_File.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	Utils::BlockFormat CachedTexture::GetFormat() const {
+		return static_cast<Utils::BlockFormat>(Section<Header>(0)->Format);
+	}
+
+	uint32_t CachedTexture::GetWidth() const {
+		return Section<Header>(0)->Width;
+	}
+
+	uint32_t CachedTexture::GetHeight() const {
+		return Section<Header>(0)->Height;
+	}
+
+	uint32_t CachedTexture::GetMipLevels() const {
+		return Section<Header>(0)->MipLevels;
+	}
+
+	const uint8_t* CachedTexture::GetData() const {
+		return Section<uint8_t>(Section<Header>(0)->DataOffset);
+	}
+
+	size_t CachedTexture::GetDataSize() const {
+		return Section<Header>(0)->DataSize;
+	}
+
+	std::vector<uint64_t> CachedTexture::GetLevelOffsets() const {
+		const Header* header = Section<Header>(0);
+		const LevelRecord* levels = Section<LevelRecord>(header->LevelsOffset);
+
+		std::vector<uint64_t> offsets(header->MipLevels);
+
+		for (uint32_t i = 0; i < header->MipLevels; i++)
+			offsets[i] = levels[i].Offset;
+
+		return offsets;
+	}
+}
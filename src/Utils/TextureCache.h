@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "./BlockCompressor.h"
+#include "./MappedFile.h"
+#include "./MipGenerator.h"
+
+// Block compressed copy of a texture with its whole mip chain, written next to the source image
+// ("<source>.<profile>.texcache") the first time the texture is compressed. Warm loads map the file and
+// copy the blocks straight into the staging buffer, no decoding, encoding or mip generation involved.
+//
+// Layout (KTX2 like, every section 16 bytes aligned):
+//	[Header][Level records][Level 0 blocks][Level 1 blocks]...
+//
+// The cache is invalidated when the format version, the options or the source file changes
+// (size + modification time, falling back to a content hash when only the time differs).
+namespace TextureCache {
+
+	enum Flags : uint32_t {
+		eFlipVertically		= 1 << 0,
+		eMipMaps			= 1 << 1
+	};
+
+	// Blocks of every level back to back, 'LevelOffsets' are relative to the start of 'Data'.
+	struct CompressedTexture {
+		Utils::BlockFormat		Format		= Utils::BlockFormat::BC1;
+		uint32_t				Width		= 0;
+		uint32_t				Height		= 0;
+		std::vector<uint64_t>	LevelOffsets;
+		std::vector<uint8_t>	Data;
+	};
+
+	// 'profile' names the kind of compression (see TextureLoader), one source can be cached once per profile.
+	std::string GetCachePath(const std::string& sourcePath, const std::string& profile);
+
+	// Encodes 'rgba' and, with 'generateMipMaps', its mip chain down to 1x1 (Utils::MipGenerator, Kaiser filtered and
+	// gamma correct when 'srgb'). 'maxWorkers' bounds the threads of the mip generation, 1 when already on a worker.
+	void Compress(const uint8_t* rgba, uint32_t width, uint32_t height, Utils::BlockFormat format, bool srgb, bool generateMipMaps, CompressedTexture& texture, uint32_t maxWorkers = 0);
+
+	bool Write(const std::string& sourcePath, const std::string& profile, uint32_t flags, const CompressedTexture& texture);
+
+	class CachedTexture {
+	public:
+		bool Open(const std::string& sourcePath, const std::string& profile, uint32_t flags);
+
+		Utils::BlockFormat	GetFormat()		const;
+		uint32_t			GetWidth()		const;
+		uint32_t			GetHeight()		const;
+		uint32_t			GetMipLevels()	const;
+
+		// every level, laid out like CompressedTexture::Data
+		const uint8_t*			GetData()			const;
+		size_t					GetDataSize()		const;
+		std::vector<uint64_t>	GetLevelOffsets()	const;
+	private:
+		template<class T>
+		const T* Section(uint64_t offset) const { return reinterpret_cast<const T*>(m_File.GetData() + offset); }
+	private:
+		Utils::MappedFile m_File;
+	};
+}
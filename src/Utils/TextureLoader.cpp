@@ -1,5 +1,8 @@
 #include "./TextureLoader.h"
 
+#include <filesystem>
+#include <unordered_map>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -8,9 +11,16 @@
 #include "./Bitmap.h"
 #include "./UtilsCubemap.h"
 #include "./Helper.h"
+#include "./ParallelFor.h"
+#include "./BlockCompressor.h"
+#include "./TextureCache.h"
+#include "./MipGenerator.h"
+#include "./PixelPacker.h"
+#include "./IBLBaker.h"
 
 #include "../Core/GraphicsDevice.h"
 #include "../Core/Graphics.h"
+#include "../Core/ResourceManager.h"
 
 using namespace Utils;
 
@@ -26,36 +36,66 @@ namespace TextureLoader {
 		}
 	}
 
-	Texture LoadTexture(const char* texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps) {
-
-		Texture texture = {};
+	// Note: Color maps keep their sRGB encoding, normal maps only store X and Y (the shaders rebuild Z) and single 
+	// channel maps go to BC4. Albedo gets BC7 for quality, the other color maps BC1, or BC3 when they have alpha.
+	static BlockFormat GetBlockFormat(Texture::TextureType textureType, bool hasAlpha) {
+		switch (textureType) {
+			case Texture::TextureType::NORMAL:
+				return BlockFormat::BC5;
+			case Texture::TextureType::BUMP:
+			case Texture::TextureType::DISPLACEMENT:
+			case Texture::TextureType::ALPHA:
+			case Texture::TextureType::ROUGHNESS:
+			case Texture::TextureType::METALLIC:
+				return BlockFormat::BC4;
+			case Texture::TextureType::AMBIENT:
+			case Texture::TextureType::DIFFUSE:
+				return BlockFormat::BC7;
+			default:
+				return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+		}
+	}
 
-		int texWidth = 0;
-		int texHeight = 0;
-		int texChannels = 0;
+	// the texture cache file of each GetBlockFormat outcome, BC1 and BC3 share one since alpha isn't known up front
+	static const char* GetCompressionProfile(Texture::TextureType textureType) {
+		switch (GetBlockFormat(textureType, false)) {
+			case BlockFormat::BC5:	return "bc5";
+			case BlockFormat::BC4:	return "bc4";
+			case BlockFormat::BC7:	return "bc7";
+			default:				return "bc1";
+		}
+	}
 
-		stbi_set_flip_vertically_on_load(flipTextureVertically);
-		stbi_uc* pixels = stbi_load(texturePath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	static VkFormat GetBlockCompressedFormat(BlockFormat format, Texture::TextureType textureType) {
+		bool srgb = GetTextureFormat(textureType) == VK_FORMAT_R8G8B8A8_SRGB;
 
-		VkDeviceSize imageSize = texWidth * texHeight * 4;
+		switch (format) {
+			case BlockFormat::BC1:	return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK	: VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+			case BlockFormat::BC3:	return srgb ? VK_FORMAT_BC3_SRGB_BLOCK		: VK_FORMAT_BC3_UNORM_BLOCK;
+			case BlockFormat::BC4:	return VK_FORMAT_BC4_UNORM_BLOCK;
+			case BlockFormat::BC5:	return VK_FORMAT_BC5_UNORM_BLOCK;
+			case BlockFormat::BC7:	return srgb ? VK_FORMAT_BC7_SRGB_BLOCK		: VK_FORMAT_BC7_UNORM_BLOCK;
+		}
 
-		uint32_t mipLevels = 1;
+		return VK_FORMAT_UNDEFINED;
+	}
 
-		if (generateMipMaps)
-			mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+	static uint32_t GetMipLevelCount(int width, int height, bool generateMipMaps) {
+		if (!generateMipMaps)
+			return 1;
 
-		if (!pixels) {
-			throw std::runtime_error("Failed to load texture image!");
-		}
+		return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	}
 
-		ImageDescription desc = {
-			.Width				= static_cast<uint32_t>(texWidth),
-			.Height				= static_cast<uint32_t>(texHeight),
+	static ImageDescription GetTextureDescription(int width, int height, VkFormat format, uint32_t mipLevels, VkImageUsageFlags usage) {
+		return {
+			.Width				= static_cast<uint32_t>(width),
+			.Height				= static_cast<uint32_t>(height),
 			.MipLevels			= static_cast<uint32_t>(mipLevels),
 			.LayerCount			= 1,
-			.Format				= GetTextureFormat(textureType),
+			.Format				= format,
 			.Tiling				= VK_IMAGE_TILING_OPTIMAL,
-			.Usage				= static_cast<VkImageUsageFlagBits>(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT),
+			.Usage				= static_cast<VkImageUsageFlagBits>(usage),
 			.MemoryProperty		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			.AspectFlags		= VK_IMAGE_ASPECT_COLOR_BIT,
 			.ViewType			= VK_IMAGE_VIEW_TYPE_2D,
@@ -63,9 +103,67 @@ namespace TextureLoader {
 			.ImageType			= VK_IMAGE_TYPE_2D,
 			.AddressMode		= VK_SAMPLER_ADDRESS_MODE_REPEAT
 		};
+	}
+
+	// mips are blitted on the GPU from level 0
+	static ImageDescription GetTextureDescription(int width, int height, Texture::TextureType textureType, bool generateMipMaps) {
+		return GetTextureDescription(width, height, GetTextureFormat(textureType), GetMipLevelCount(width, height, generateMipMaps),
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+	}
+
+	// the blit chain needs linear filtering and blits from and to the format, anything else gets its mips from the CPU
+	static bool UseCPUMipMaps(VkFormat format, bool requested) {
+		return requested || !GetDevice()->SupportsFormat(format, 
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT);
+	}
+
+	static void GenerateMipChain(const uint8_t* pixels, int width, int height, VkFormat format, MipChain& mips, uint32_t maxWorkers = 0) {
+		MipGenerator::Generate(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), format == VK_FORMAT_R8G8B8A8_SRGB, MipFilter::Kaiser, mips, maxWorkers);
+	}
+
+	static TextureUpload GetMipChainUpload(const MipChain& mips, VkFormat format, Texture& target) {
+		TextureUpload upload = {};
+		upload.Target		= &target;
+		upload.Data			= mips.Data.data();
+		upload.DataSize		= mips.Data.size();
+		upload.LevelOffsets = mips.LevelOffsets;
+		upload.Description	= GetTextureDescription(mips.Width, mips.Height, format, static_cast<uint32_t>(mips.LevelOffsets.size()), 
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+		return upload;
+	}
+
+	Texture LoadTexture(const char* texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps, bool cpuMipMaps) {
+
+		Texture texture = {};
+
+		int texWidth = 0;
+		int texHeight = 0;
+		int texChannels = 0;
+
+		stbi_set_flip_vertically_on_load(flipTextureVertically);
+		stbi_uc* pixels = stbi_load(texturePath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+		VkDeviceSize imageSize = texWidth * texHeight * 4;
+
+		if (!pixels) {
+			throw std::runtime_error("Failed to load texture image!");
+		}
 
 		GraphicsDevice* device = GetDevice();
-		device->CreateTexture(desc, texture, textureType, pixels, imageSize);
+		VkFormat format = GetTextureFormat(textureType);
+
+		if (generateMipMaps && UseCPUMipMaps(format, cpuMipMaps)) {
+			MipChain mips;
+			GenerateMipChain(pixels, texWidth, texHeight, format, mips);
+
+			std::vector<TextureUpload> uploads = { GetMipChainUpload(mips, format, texture) };
+			device->CreateTextures(uploads);
+		}
+		else {
+			ImageDescription desc = GetTextureDescription(texWidth, texHeight, textureType, generateMipMaps);
+			device->CreateTexture(desc, texture, textureType, pixels, imageSize);
+		}
 
 		stbi_image_free(pixels);
 
@@ -75,6 +173,227 @@ namespace TextureLoader {
 		return texture;
 	}
 
+	uint64_t GetTextureKey(const std::string& texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps, bool compress) {
+		std::string path = std::filesystem::path(texturePath).lexically_normal().generic_string();
+
+		// the type only matters through the format (and compression profile), a file used as ambient and diffuse map is the same image
+		uint64_t options[] = { 
+			static_cast<uint64_t>(GetTextureFormat(textureType)), 
+			static_cast<uint64_t>(flipTextureVertically), 
+			static_cast<uint64_t>(generateMipMaps),
+			compress ? static_cast<uint64_t>(GetBlockFormat(textureType, false)) + 1 : 0
+		};
+
+		return Helper::hash_bytes(options, sizeof(options), Helper::hash_bytes(path.data(), path.size()));
+	}
+
+	int LoadSharedTexture(const std::string& texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps) {
+		ResourceManager* rm = ResourceManager::Get();
+
+		uint64_t key = GetTextureKey(texturePath, textureType, flipTextureVertically, generateMipMaps);
+		int index = rm->FindTexture(key);
+
+		if (index != -1)
+			return index;
+
+		Texture texture = LoadTexture(texturePath.c_str(), textureType, flipTextureVertically, generateMipMaps);
+		index = rm->AddTexture(texture, key);
+
+		if (index == -1)
+			GetDevice()->DestroyImage(texture);
+
+		return index;
+	}
+
+	std::vector<int> LoadSharedTextures(const std::vector<TextureRequest>& requests, bool async) {
+		ResourceManager* rm = ResourceManager::Get();
+
+		struct DecodedTexture {
+			size_t		Request		= 0;
+			uint64_t	Key			= 0;
+			bool		Compress	= false;
+			bool		CPUMipMaps	= false;
+			bool		Loaded		= false;
+			stbi_uc*	Pixels		= nullptr;
+			int			Width		= 0;
+			int			Height		= 0;
+			int			Index		= -1;
+			Texture		Image		= {};
+
+			// compressed textures come either from their cache file or from the encoder
+			std::unique_ptr<TextureCache::CachedTexture>	Cached;
+			TextureCache::CompressedTexture					Compressed;
+
+			// uncompressed textures with their whole chain already built
+			MipChain										Mips;
+		};
+
+		bool supportsCompression = GetDevice()->SupportsBlockCompression();
+
+		std::vector<int> indices(requests.size(), -1);
+		std::vector<uint64_t> keys(requests.size());
+		std::vector<DecodedTexture> decoded;
+		std::unordered_map<uint64_t, size_t> pending;
+
+		for (size_t i = 0; i < requests.size(); i++) {
+			const TextureRequest& request = requests[i];
+			bool compress = request.Compress && supportsCompression;
+
+			keys[i] = GetTextureKey(request.Path, request.Type, request.FlipVertically, request.GenerateMipMaps, compress);
+			indices[i] = rm->FindTexture(keys[i]);
+
+			if (indices[i] == -1 && pending.emplace(keys[i], decoded.size()).second) {
+				bool cpuMipMaps = !compress && request.GenerateMipMaps && UseCPUMipMaps(GetTextureFormat(request.Type), request.CPUMipMaps);
+				decoded.push_back({ .Request = i, .Key = keys[i], .Compress = compress, .CPUMipMaps = cpuMipMaps });
+			}
+		}
+
+		// mip generation only spreads over threads of its own when there's a single texture to decode
+		const uint32_t mipWorkers = decoded.size() > 1 ? 1 : 0;
+
+		// Note: The stb flip flag is global, workers always decode unflipped and flip their own rows afterwards.
+		stbi_set_flip_vertically_on_load(false);
+
+		Utils::ParallelFor(decoded.size(), [&](size_t i) {
+			DecodedTexture& texture = decoded[i];
+			const TextureRequest& request = requests[texture.Request];
+
+			const char* profile = GetCompressionProfile(request.Type);
+			uint32_t cacheFlags = (request.FlipVertically ? TextureCache::eFlipVertically : 0) | (request.GenerateMipMaps ? TextureCache::eMipMaps : 0);
+
+			if (texture.Compress) {
+				texture.Cached = std::make_unique<TextureCache::CachedTexture>();
+
+				if (texture.Cached->Open(request.Path, profile, cacheFlags)) {
+					texture.Width	= static_cast<int>(texture.Cached->GetWidth());
+					texture.Height	= static_cast<int>(texture.Cached->GetHeight());
+					texture.Loaded	= true;
+					return;
+				}
+
+				texture.Cached.reset();
+			}
+
+			int channels = 0;
+			texture.Pixels = stbi_load(request.Path.c_str(), &texture.Width, &texture.Height, &channels, STBI_rgb_alpha);
+
+			if (!texture.Pixels)
+				return;
+
+			texture.Loaded = true;
+
+			size_t pixelCount = static_cast<size_t>(texture.Width) * texture.Height;
+
+			if (request.FlipVertically) {
+				size_t rowSize = static_cast<size_t>(texture.Width) * 4;
+				std::vector<stbi_uc> row(rowSize);
+
+				for (int y = 0; y < texture.Height / 2; y++) {
+					stbi_uc* top	= texture.Pixels + y * rowSize;
+					stbi_uc* bottom = texture.Pixels + (texture.Height - 1 - y) * rowSize;
+
+					memcpy(row.data(), top, rowSize);
+					memcpy(top, bottom, rowSize);
+					memcpy(bottom, row.data(), rowSize);
+				}
+			}
+
+			if (texture.CPUMipMaps) {
+				GenerateMipChain(texture.Pixels, texture.Width, texture.Height, GetTextureFormat(request.Type), texture.Mips, mipWorkers);
+
+				stbi_image_free(texture.Pixels);
+				texture.Pixels = nullptr;
+			}
+
+			if (!texture.Compress)
+				return;
+
+			bool hasAlpha = false;
+
+			for (size_t p = 0; p < pixelCount && !hasAlpha; p++)
+				hasAlpha = texture.Pixels[p * 4 + 3] != 255;
+
+			BlockFormat format = GetBlockFormat(request.Type, hasAlpha);
+
+			bool srgb = GetTextureFormat(request.Type) == VK_FORMAT_R8G8B8A8_SRGB;
+
+			TextureCache::Compress(texture.Pixels, texture.Width, texture.Height, format, srgb, request.GenerateMipMaps, texture.Compressed, mipWorkers);
+			TextureCache::Write(request.Path, profile, cacheFlags, texture.Compressed);
+
+			stbi_image_free(texture.Pixels);
+			texture.Pixels = nullptr;
+		});
+
+		for (const auto& texture : decoded) {
+			if (!texture.Loaded) {
+				std::cout << "Failed to load texture: " << requests[texture.Request].Path << '\n';
+
+				for (const auto& other : decoded)
+					stbi_image_free(other.Pixels);
+
+				throw std::runtime_error("Failed to load texture image!");
+			}
+		}
+
+		std::vector<TextureUpload> uploads;
+		uploads.reserve(decoded.size());
+
+		for (auto& texture : decoded) {
+			const TextureRequest& request = requests[texture.Request];
+
+			TextureUpload upload = {};
+			upload.Target = &texture.Image;
+
+			if (texture.Cached || !texture.Compressed.Data.empty()) {
+				BlockFormat format = texture.Cached ? texture.Cached->GetFormat() : texture.Compressed.Format;
+
+				upload.LevelOffsets = texture.Cached ? texture.Cached->GetLevelOffsets() : texture.Compressed.LevelOffsets;
+				upload.Data			= texture.Cached ? texture.Cached->GetData() : texture.Compressed.Data.data();
+				upload.DataSize		= texture.Cached ? texture.Cached->GetDataSize() : texture.Compressed.Data.size();
+				upload.Description	= GetTextureDescription(texture.Width, texture.Height, GetBlockCompressedFormat(format, request.Type), 
+					static_cast<uint32_t>(upload.LevelOffsets.size()), VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+			} else if (texture.CPUMipMaps) {
+				upload = GetMipChainUpload(texture.Mips, GetTextureFormat(request.Type), texture.Image);
+			} else {
+				upload.Data			= texture.Pixels;
+				upload.DataSize		= static_cast<size_t>(texture.Width) * texture.Height * 4;
+				upload.Description	= GetTextureDescription(texture.Width, texture.Height, request.Type, request.GenerateMipMaps);
+			}
+
+			uploads.push_back(upload);
+		}
+
+		if (!uploads.empty()) {
+			uint64_t ticket = GetDevice()->CreateTexturesAsync(uploads);
+
+			if (!async)
+				GetDevice()->RequireUploads(ticket);
+		}
+
+		for (auto& texture : decoded) {
+			stbi_image_free(texture.Pixels);
+
+			texture.Image.Name = Helper::get_filename(requests[texture.Request].Path);
+			texture.Image.Type = requests[texture.Request].Type;
+
+			texture.Index = rm->AddTexture(texture.Image, texture.Key);
+			indices[texture.Request] = texture.Index;
+
+			if (texture.Index == -1)
+				GetDevice()->DestroyImage(texture.Image);
+		}
+
+		// duplicates within the batch resolve through the cache like any later load would
+		for (size_t i = 0; i < requests.size(); i++) {
+			auto it = pending.find(keys[i]);
+
+			if (it != pending.end() && decoded[it->second].Request != i)
+				indices[i] = decoded[it->second].Index != -1 ? rm->FindTexture(keys[i]) : -1;
+		}
+
+		return indices;
+	}
+
 	uint32_t bytesPerTexFormat(VkFormat format) {
 		switch (format) {
 		case VK_FORMAT_R8_SINT:
@@ -87,6 +406,7 @@ namespace TextureLoader {
 		case VK_FORMAT_B8G8R8A8_UNORM:
 		case VK_FORMAT_R8G8B8A8_UNORM:
 		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
 			return 4;
 		case VK_FORMAT_R16G16B16A16_SFLOAT:
 			return 4 * sizeof(uint16_t);
@@ -99,21 +419,81 @@ namespace TextureLoader {
 		return 0;
 	}
 
-	static void float24to32(int w, int h, const float* img24, float* img32) {
-		const int numPixels = w * h;
+	// RGBA32F texels into 'format', split in chunks across the workers
+	static void PackHDRTexels(const float* src, size_t count, VkFormat format, uint8_t* dst) {
+		const size_t chunk = 64 * 1024;
+
+		Utils::ParallelFor((count + chunk - 1) / chunk, [&](size_t i) {
+			const size_t first = i * chunk;
+			const size_t size = std::min(chunk, count - first);
+
+			switch (format) {
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+				Utils::PixelPacker::PackHalf(src + first * 4, size * 4, reinterpret_cast<uint16_t*>(dst) + first * 4);
+				break;
+			case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+				Utils::PixelPacker::PackE5B9G9R9(src + first * 4, size, reinterpret_cast<uint32_t*>(dst) + first);
+				break;
+			default:
+				memcpy(dst + first * 4 * sizeof(float), src + first * 4, size * 4 * sizeof(float));
+				break;
+			}
+		});
+	}
+
+	// shared exponent and half float are both mandatory for filtered sampling, fall back anyway on odd drivers
+	static VkFormat GetHDRFormat(HDRFormat format) {
+		GraphicsDevice* device = GetDevice();
+
+		VkFormat texFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		if (format == HDRFormat::RGBA16F)	texFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+		if (format == HDRFormat::E5B9G9R9)	texFormat = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+
+		if (texFormat == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 && !device->SupportsFormat(texFormat, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+			texFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		if (texFormat == VK_FORMAT_R16G16B16A16_SFLOAT && !device->SupportsFormat(texFormat, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+			texFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		return texFormat;
+	}
+
+	// Every level holds its six faces back to back, returns the size of the whole chain.
+	static uint64_t GetCubemapLevelOffsets(uint32_t faceSize, uint32_t mipLevels, uint32_t bytesPerPixel, std::vector<uint64_t>& levelOffsets) {
+		uint64_t imageSize = 0;
+
+		levelOffsets.resize(mipLevels);
 
-		for (int i = 0; i < numPixels; i++) {
-			*img32++ = *img24++;
-			*img32++ = *img24++;
-			*img32++ = *img24++;
-			*img32++ = 1.0f;
+		for (uint32_t level = 0; level < mipLevels; level++) {
+			const uint64_t levelSize = std::max(faceSize >> level, 1u);
+
+			levelOffsets[level] = (imageSize + 15) & ~uint64_t(15);
+			imageSize = levelOffsets[level] + levelSize * levelSize * 6 * bytesPerPixel;
 		}
+
+		return imageSize;
 	}
 
-	Texture LoadCubemapTexture(const char* texturePath) {
-		Texture texture = {};
-		const uint32_t mipLevels = 1;
+	static ImageDescription GetCubemapDescription(uint32_t faceSize, uint32_t mipLevels, VkFormat format) {
+		return {
+			.Width = faceSize,
+			.Height = faceSize,
+			.MipLevels = mipLevels,
+			.LayerCount = 6,
+			.Format = format,
+			.Tiling = VK_IMAGE_TILING_OPTIMAL,
+			.Usage = static_cast<VkImageUsageFlagBits>(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT),
+			.MemoryProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			.AspectFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+			.ViewType = VK_IMAGE_VIEW_TYPE_CUBE,
+			.ImageType = VK_IMAGE_TYPE_2D,
+			.AddressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+		};
+	}
 
+	// RGBA32F cube faces (Vulkan face order) of an equirectangular HDR image
+	static Bitmap LoadEquirectangularCubemap(const char* texturePath) {
 		int width;
 		int height;
 		int comp;
@@ -126,49 +506,105 @@ namespace TextureLoader {
 			throw std::runtime_error("Failed to load image!");
 		}
 
-		// stbi_loadf only load 3 components, we need to convert it from float (8) 24 (RGB) float (8) to 32 (RGBA)
-		// setting the fourth component to 1.0f, Vulkan doesn't have a R24G24B24 format
-		std::vector<float> img32(width * height * 4);
-		float24to32(width, height, img, img32.data());
-		comp = 4;
-
-		Bitmap in(width, height, comp, eBitmapFormat_Float, img32.data());
-		Bitmap out = convertEquirectangularMapToVerticalCross(in);
+		// stbi_loadf only load 3 components, the fourth one is set to 1.0f while expanding straight into the bitmap, 
+		// Vulkan doesn't have a R32G32B32 format that can be sampled everywhere
+		Bitmap in(width, height, 4, eBitmapFormat_Float);
+		BitmapKernels::rgbToRGBA(img, in.view<eBitmapFormat_Float, 4>().data(), static_cast<size_t>(width) * height);
 
 		stbi_image_free((void*)img);
 
-		Bitmap cubemap = convertVerticalCrossToCubeMapFaces(out);
+		// straight to the six faces, no vertical cross in between
+		return convertEquirectangularMapToCubeMapFaces(in);
+	}
 
-		VkFormat texFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+	Texture LoadCubemapTexture(const char* texturePath, HDRFormat storageFormat, bool generateMipMaps) {
+		Texture texture = {};
 
-		// update texture image
-		uint32_t bytesPerPixel = bytesPerTexFormat(texFormat);
-		uint32_t layerCount = 6;
+		Bitmap cubemap = LoadEquirectangularCubemap(texturePath);
 
-		VkDeviceSize layerSize = cubemap.getWidth() * cubemap.getHeight() * bytesPerPixel;
-		VkDeviceSize imageSize = layerSize * layerCount;
+		const VkFormat texFormat = GetHDRFormat(storageFormat);
+		const uint32_t faceSize = static_cast<uint32_t>(cubemap.getWidth());
+		const uint32_t mipLevels = GetMipLevelCount(faceSize, faceSize, generateMipMaps);
+		const uint32_t layerCount = 6;
 
-		ImageDescription desc = {
-			.Width = static_cast<uint32_t>(cubemap.getWidth()),
-			.Height = static_cast<uint32_t>(cubemap.getHeight()),
-			.MipLevels = static_cast<uint32_t>(mipLevels),
-			.LayerCount = static_cast<uint32_t>(layerCount),
-			.Format = texFormat,
-			.Tiling = VK_IMAGE_TILING_OPTIMAL,
-			.Usage = static_cast<VkImageUsageFlagBits>(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT),
-			.MemoryProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			.AspectFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-			.ViewType = VK_IMAGE_VIEW_TYPE_CUBE,
-			.ImageType = VK_IMAGE_TYPE_2D,
-			.AddressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
-		};
+		// the levels are built on the CPU since the shared exponent format can't be blitted to and GPU mip
+		// generation only covers the first layer
+		std::vector<uint64_t> levelOffsets;
+		std::vector<uint8_t> packed(GetCubemapLevelOffsets(faceSize, mipLevels, bytesPerTexFormat(texFormat), levelOffsets));
 
-		GraphicsDevice* device = GetDevice();
-		device->CreateTexture(desc, texture, Texture::TextureType::CUBEMAP_SINGLE, cubemap.Data.data(), imageSize);
+		for (uint32_t level = 0; level < mipLevels; level++) {
+			const uint32_t levelSize = std::max(faceSize >> level, 1u);
+
+			PackHDRTexels(reinterpret_cast<const float*>(cubemap.Data.data()), static_cast<size_t>(levelSize) * levelSize * layerCount, 
+				texFormat, packed.data() + levelOffsets[level]);
+
+			if (level + 1 < mipLevels)
+				cubemap = downsampleCubeMapFaces(cubemap);
+		}
+
+		cubemap = {};
+
+		std::vector<TextureUpload> uploads(1);
+		uploads[0].Target		= &texture;
+		uploads[0].Description	= GetCubemapDescription(faceSize, mipLevels, texFormat);
+		uploads[0].Data			= packed.data();
+		uploads[0].DataSize		= packed.size();
+		uploads[0].LevelOffsets = levelOffsets;
+
+		GetDevice()->CreateTextures(uploads);
 
 		return texture;
 	}
 
+	EnvironmentLighting LoadEnvironmentLighting(const char* texturePath, HDRFormat storageFormat, const Utils::IBLSettings& settings) {
+		EnvironmentLighting lighting = {};
+		Utils::IBLData data;
+
+		if (!Utils::IBLBaker::ReadCache(texturePath, settings, data)) {
+			Bitmap cubemap = LoadEquirectangularCubemap(texturePath);
+
+			Utils::IBLBaker::Bake(cubemap, settings, data);
+			Utils::IBLBaker::WriteCache(texturePath, settings, data);
+		}
+
+		lighting.Irradiance = data.Irradiance;
+
+		// specular mips are already prefiltered, only the storage changes
+		const VkFormat specularFormat = GetHDRFormat(storageFormat);
+		const uint32_t mipLevels = static_cast<uint32_t>(data.SpecularLevelOffsets.size());
+
+		std::vector<uint64_t> levelOffsets;
+		std::vector<uint8_t> specular(GetCubemapLevelOffsets(data.SpecularSize, mipLevels, bytesPerTexFormat(specularFormat), levelOffsets));
+
+		for (uint32_t level = 0; level < mipLevels; level++) {
+			const uint32_t levelSize = std::max(data.SpecularSize >> level, 1u);
+
+			PackHDRTexels(data.Specular.data() + data.SpecularLevelOffsets[level], static_cast<size_t>(levelSize) * levelSize * 6,
+				specularFormat, specular.data() + levelOffsets[level]);
+		}
+
+		std::vector<uint16_t> brdf(data.BRDF.size());
+		Utils::PixelPacker::PackHalf(data.BRDF.data(), data.BRDF.size(), brdf.data());
+
+		std::vector<TextureUpload> uploads(2);
+		uploads[0].Target		= &lighting.Specular;
+		uploads[0].Description	= GetCubemapDescription(data.SpecularSize, mipLevels, specularFormat);
+		uploads[0].Data			= specular.data();
+		uploads[0].DataSize		= specular.size();
+		uploads[0].LevelOffsets = levelOffsets;
+
+		uploads[1].Target		= &lighting.BRDF;
+		uploads[1].Description	= GetTextureDescription(data.BRDFSize, data.BRDFSize, VK_FORMAT_R16G16_SFLOAT, 1, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		uploads[1].Description.AddressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		uploads[1].Data			= brdf.data();
+		uploads[1].DataSize		= brdf.size() * sizeof(uint16_t);
+		uploads[1].LevelOffsets = { 0 };
+
+		GetDevice()->CreateTextures(uploads);
+
+		return lighting;
+	}
+
 	Texture LoadCubemapTexture(std::vector<std::string> texturePaths) {
 		/* - Correct order to load
 		right
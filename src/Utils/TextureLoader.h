@@ -2,14 +2,68 @@
 
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <vector>
 
 #include "../Core/GraphicsDevice.h"
 #include "../Core/Graphics.h"
 
+#include "./IBLBaker.h"
+
 using namespace Graphics;
 
 namespace TextureLoader {
-	extern Texture LoadTexture(const char* texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps);
-	extern Texture LoadCubemapTexture(const char* texturePath);
+	struct TextureRequest {
+		std::string				Path				= "";
+		Texture::TextureType	Type				= Texture::TextureType::UNKNOWN;
+		bool					FlipVertically		= false;
+		bool					GenerateMipMaps		= true;
+
+		// block compress by type (see GetBlockFormat) with precomputed mips, cached next to the image as 
+		// "<path>.<profile>.texcache". Ignored on devices without BC support.
+		bool					Compress			= false;
+
+		// build the mip chain on the CPU (Utils::MipGenerator, Kaiser filtered, gamma correct for sRGB) instead of blitting
+		// it after the upload. Formats the device can't blit always take this path, compressed textures always have CPU mips.
+		bool					CPUMipMaps			= false;
+	};
+
+	extern Texture LoadTexture(const char* texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps, bool cpuMipMaps = false);
+
+	// Note: Loads through the ResourceManager texture cache and returns the index of the shared texture (-1 when full).
+	extern int LoadSharedTexture(const std::string& texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps);
+
+	// Note: Batched LoadSharedTexture, the files missing from the cache are decoded in parallel on worker threads and
+	// uploaded in one submission. Returns the shared texture index of every request, in order (-1 when full). With 
+	// 'async' the upload isn't required, the caller passes a later ticket to GraphicsDevice::RequireUploads before the
+	// textures are sampled.
+	extern std::vector<int> LoadSharedTextures(const std::vector<TextureRequest>& requests, bool async = false);
+
+	// Hash of the normalized path and of everything else that changes the uploaded image (format, flip, mips).
+	extern uint64_t GetTextureKey(const std::string& texturePath, Texture::TextureType textureType, bool flipTextureVertically, bool generateMipMaps, bool compress = false);
+
+	// Note: Storage of equirectangular HDR cubemaps, RGBA32F is 16 bytes per texel, RGBA16F 8 and the shared exponent
+	// E5B9G9R9 (RGB only, no negative values) 4.
+	enum class HDRFormat {
+		RGBA32F,
+		RGBA16F,
+		E5B9G9R9
+	};
+
+	// Note: Converts an equirectangular HDR image to a cubemap stored as 'storageFormat' (falls back to the next wider
+	// format when the device can't filter it). With 'generateMipMaps' the whole chain is built on the CPU. The defaults 
+	// keep the full precision single level cubemap, the smaller formats are opt in.
+	extern Texture LoadCubemapTexture(const char* texturePath, HDRFormat storageFormat = HDRFormat::RGBA32F, bool generateMipMaps = false);
+
+	struct EnvironmentLighting {
+		Texture				Specular;		// GGX prefiltered cubemap, roughness of mip i = i / (mip levels - 1)
+		Texture				BRDF;			// RG16F split sum LUT, (NdotV, roughness) -> (F0 scale, bias)
+		Utils::SHIrradiance	Irradiance;		// diffuse irradiance, see Utils::IBLBaker::EvaluateIrradiance
+	};
+
+	// Note: Image based lighting of an equirectangular HDR environment, baked on the CPU on the first load and read back
+	// from "<path>.ibl" afterwards (no decoding at all on a cache hit).
+	extern EnvironmentLighting LoadEnvironmentLighting(const char* texturePath, HDRFormat storageFormat = HDRFormat::RGBA16F, const Utils::IBLSettings& settings = {});
 	extern Texture LoadCubemapTexture(std::vector<std::string> texturePaths);
 }
@@ -1,12 +1,20 @@
 #include "UtilsCubemap.h"
 
 #include <cstdio>
+#include <cmath>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp> 
 
+#include "ParallelFor.h"
+
 namespace Utils {
 
 	static constexpr float PI = 3.14159265359f;
+	static constexpr float HALF_PI = PI * 0.5f;
+
+	// texels handled per batch by the direct converter, small enough to keep the batch arrays on the stack
+	static constexpr int BATCH_SIZE = 64;
 
 	glm::vec3 faceCoordsToXYZ(int i, int j, int faceId, int faceSize) {
 		const float A = 2.0f * float(i) / faceSize;
@@ -161,4 +169,193 @@ namespace Utils {
 
 		return cubemap;
 	}
+
+	// Max error ~1e-5 rad (about 1/80 of a texel on an 8K equirect), no branches so a batch loop over it vectorizes.
+	static inline float fastAtan2(float y, float x) {
+		const float ax = std::fabs(x);
+		const float ay = std::fabs(y);
+		const float t = std::min(ax, ay) / std::max(std::max(ax, ay), 1e-30f);
+		const float s = t * t;
+
+		float r = t * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+		r = ay > ax ? HALF_PI - r : r;
+		r = x < 0.0f ? PI - r : r;
+		r = y < 0.0f ? -r : r;
+
+		return r;
+	}
+
+	static inline float loadComponent(const uint8_t* src) { return float(*src) * (1.0f / 255.0f); }
+	static inline float loadComponent(const float* src) { return *src; }
+
+	static inline void storeComponent(uint8_t* dst, float value) { *dst = uint8_t(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f)); }
+	static inline void storeComponent(float* dst, float value) { *dst = value; }
+
+	// bilinear fetch of 'count' texels at texel space (u, v), wrapping around horizontally and clamping vertically
+	template<eBitmapFormat Format, int Components>
+	static void sampleEquirectangular(const ConstBitmapView<Format, Components>& src, const float* u, const float* v, int count, 
+		typename BitmapComponent<Format>::Type* dst) {
+
+		const int width = src.getWidth();
+		const int height = src.getHeight();
+
+		for (int k = 0; k < count; k++) {
+			const float fu = std::floor(u[k]);
+			const float fv = std::floor(v[k]);
+			const float s = u[k] - fu;
+			const float t = v[k] - fv;
+
+			int x0 = int(fu) % width;
+			x0 = x0 < 0 ? x0 + width : x0;
+			const int x1 = x0 + 1 == width ? 0 : x0 + 1;
+			const int y0 = std::clamp(int(fv), 0, height - 1);
+			const int y1 = std::min(int(fv) + 1, height - 1);
+
+			const auto* A = src.at(x0, y0);
+			const auto* B = src.at(x1, y0);
+			const auto* C = src.at(x0, y1);
+			const auto* D = src.at(x1, y1);
+
+			const float wA = (1.0f - s) * (1.0f - t);
+			const float wB = s * (1.0f - t);
+			const float wC = (1.0f - s) * t;
+			const float wD = s * t;
+
+			for (int c = 0; c < Components; c++)
+				storeComponent(dst + k * Components + c, loadComponent(A + c) * wA + loadComponent(B + c) * wB + loadComponent(C + c) * wC + loadComponent(D + c) * wD);
+		}
+	}
+
+	template<eBitmapFormat Format, int Components>
+	static void convertEquirectangularRows(const Bitmap& b, Bitmap& cubemap, uint32_t maxWorkers) {
+		/*
+			Direction of face texel (a, b) in [-1, 1] is Origin + a * AxisA + b * AxisB, the faces match the ones
+			convertVerticalCrossToCubeMapFaces cuts out of faceCoordsToXYZ's cross (+Y, -Y and +Z are read mirrored
+			from the cross, hence the negated axes).
+		*/
+		struct FaceBasis {
+			glm::vec3 Origin;
+			glm::vec3 AxisA;
+			glm::vec3 AxisB;
+		};
+
+		static const FaceBasis kFaces[6] = {
+			{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },	// +X
+			{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },	// -X
+			{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) },	// +Y
+			{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f) },	// -Y
+			{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },	// +Z
+			{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) }		// -Z
+		};
+
+		const int faceSize = cubemap.getWidth();
+		const int width = b.getWidth();
+		const int height = b.getHeight();
+
+		const ConstBitmapView<Format, Components> src = b.view<Format, Components>();
+
+		const float texelSize = 2.0f / float(faceSize);
+		const float uScale = float(width) / (2.0f * PI);
+		const float vScale = float(height) / PI;
+
+		Utils::ParallelFor(size_t(6) * faceSize, [&](size_t row) {
+			const int face = int(row / faceSize);
+			const int j = int(row % faceSize);
+
+			const FaceBasis& basis = kFaces[face];
+
+			// texel centers, the row only moves along AxisB
+			const float rowB = (float(j) + 0.5f) * texelSize - 1.0f;
+			const glm::vec3 rowOrigin = basis.Origin + basis.AxisB * rowB;
+
+			const auto rowDst = cubemap.view<Format, Components>(face).row(j);
+
+			float u[BATCH_SIZE];
+			float v[BATCH_SIZE];
+
+			for (int i0 = 0; i0 < faceSize; i0 += BATCH_SIZE) {
+				const int count = std::min(BATCH_SIZE, faceSize - i0);
+
+				for (int k = 0; k < count; k++) {
+					const float a = (float(i0 + k) + 0.5f) * texelSize - 1.0f;
+
+					const float x = rowOrigin.x + basis.AxisA.x * a;
+					const float y = rowOrigin.y + basis.AxisA.y * a;
+					const float z = rowOrigin.z + basis.AxisA.z * a;
+
+					const float theta = fastAtan2(y, x);
+					const float phi = fastAtan2(z, std::sqrt(x * x + y * y));
+
+					u[k] = (theta + PI) * uScale - 0.5f;
+					v[k] = (HALF_PI - phi) * vScale - 0.5f;
+				}
+
+				sampleEquirectangular<Format, Components>(src, u, v, count, rowDst.data() + size_t(i0) * Components);
+			}
+		}, maxWorkers);
+	}
+
+	template<eBitmapFormat Format>
+	static void convertEquirectangularFaces(const Bitmap& b, Bitmap& cubemap, uint32_t maxWorkers) {
+		switch (b.getComp()) {
+		case 1: convertEquirectangularRows<Format, 1>(b, cubemap, maxWorkers); break;
+		case 2: convertEquirectangularRows<Format, 2>(b, cubemap, maxWorkers); break;
+		case 3: convertEquirectangularRows<Format, 3>(b, cubemap, maxWorkers); break;
+		case 4: convertEquirectangularRows<Format, 4>(b, cubemap, maxWorkers); break;
+		}
+	}
+
+	Bitmap convertEquirectangularMapToCubeMapFaces(const Bitmap& b, uint32_t maxWorkers) {
+		if (b.getType() != eBitmapType_2D) return Bitmap();
+
+		const int faceSize = b.getWidth() / 4;
+
+		Bitmap cubemap(faceSize, faceSize, 6, b.getComp(), b.getFormat());
+		cubemap.setType(eBitmapType_Cube);
+
+		if (faceSize == 0) return cubemap;
+
+		if (b.getFormat() == eBitmapFormat_Float)
+			convertEquirectangularFaces<eBitmapFormat_Float>(b, cubemap, maxWorkers);
+		else
+			convertEquirectangularFaces<eBitmapFormat_UnsignedByte>(b, cubemap, maxWorkers);
+
+		return cubemap;
+	}
+
+	Bitmap downsampleCubeMapFaces(const Bitmap& b) {
+		if (b.getType() != eBitmapType_Cube || b.getFormat() != eBitmapFormat_Float) return Bitmap();
+
+		const int size = b.getWidth();
+		const int dstSize = std::max(size / 2, 1);
+		const int comp = b.getComp();
+
+		Bitmap result(dstSize, dstSize, 6, comp, eBitmapFormat_Float);
+		result.setType(eBitmapType_Cube);
+
+		const size_t srcFace = size_t(size) * size * comp;
+		const size_t dstFace = size_t(dstSize) * dstSize * comp;
+
+		const float* src = reinterpret_cast<const float*>(b.Data.data());
+		float* dst = reinterpret_cast<float*>(result.Data.data());
+
+		Utils::ParallelFor(size_t(6) * dstSize, [&](size_t row) {
+			const size_t face = row / dstSize;
+			const int y = int(row % dstSize);
+
+			const float* row0 = src + face * srcFace + size_t(std::min(y * 2, size - 1)) * size * comp;
+			const float* row1 = src + face * srcFace + size_t(std::min(y * 2 + 1, size - 1)) * size * comp;
+			float* out = dst + face * dstFace + size_t(y) * dstSize * comp;
+
+			for (int x = 0; x < dstSize; x++) {
+				const int x0 = std::min(x * 2, size - 1) * comp;
+				const int x1 = std::min(x * 2 + 1, size - 1) * comp;
+
+				for (int c = 0; c < comp; c++)
+					out[x * comp + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+			}
+		});
+
+		return result;
+	}
 }
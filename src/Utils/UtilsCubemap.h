@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include "Bitmap.h"
 
@@ -8,7 +9,12 @@ namespace Utils {
 	Bitmap convertEquirectangularMapToVerticalCross(const Bitmap& b);
 	Bitmap convertVerticalCrossToCubeMapFaces(const Bitmap& b);
 
-	inline Bitmap convertEquirectangularMapToCubeMapFaces(const Bitmap& b) {
-		return convertVerticalCrossToCubeMapFaces(convertEquirectangularMapToVerticalCross(b));
-	}
+	// Note: Single pass equirectangular -> six cube faces (same face order and orientation as going through the
+	// vertical cross), every face texel is bilinearly sampled straight from the source with no intermediate bitmaps.
+	// Rows of all six faces are spread over 'maxWorkers' threads (0 = all cores), the directions of a row are computed 
+	// in small batches of branchless math so the compiler can vectorize them.
+	Bitmap convertEquirectangularMapToCubeMapFaces(const Bitmap& b, uint32_t maxWorkers = 0);
+
+	// Note: Next mip level of float cube faces (2x2 box filter per face, odd sizes reuse the last texel), threaded per row.
+	Bitmap downsampleCubeMapFaces(const Bitmap& b);
 }
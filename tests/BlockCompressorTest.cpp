@@ -0,0 +1,328 @@
+#include "BlockCompressor.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using Utils::BlockCompressor;
+using Utils::BlockFormat;
+
+namespace {
+	uint32_t s_RandomState = 12345;
+
+	int Random(int range) {
+		s_RandomState = s_RandomState * 1664525u + 1013904223u;
+		return static_cast<int>((s_RandomState >> 8) % static_cast<uint32_t>(range));
+	}
+
+	uint8_t ToByte(int value) {
+		return static_cast<uint8_t>(std::clamp(value, 0, 255));
+	}
+
+	// smooth gradients in every channel with a little noise, close to what albedo/normal mips look like
+	std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height) {
+		std::vector<uint8_t> image(static_cast<size_t>(width) * height * 4);
+
+		for (uint32_t y = 0; y < height; y++) {
+			for (uint32_t x = 0; x < width; x++) {
+				uint8_t* texel = &image[(static_cast<size_t>(y) * width + x) * 4];
+
+				texel[0] = ToByte(static_cast<int>(x * 8) + Random(6));
+				texel[1] = ToByte(static_cast<int>(y * 8) + Random(6));
+				texel[2] = ToByte(static_cast<int>((x + y) * 4) + Random(6));
+				texel[3] = ToByte(255 - static_cast<int>(x * 4) + Random(6));
+			}
+		}
+
+		return image;
+	}
+
+	std::vector<uint8_t> RoundTrip(BlockFormat format, const std::vector<uint8_t>& image, uint32_t width, uint32_t height) {
+		std::vector<uint8_t> compressed(BlockCompressor::GetCompressedSize(format, width, height));
+		std::vector<uint8_t> decoded(image.size());
+
+		BlockCompressor::Compress(format, image.data(), width, height, compressed.data());
+		BlockCompressor::Decompress(format, compressed.data(), width, height, decoded.data());
+
+		return decoded;
+	}
+
+	double RootMeanSquareError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int firstChannel, int channelCount) {
+		double sum = 0.0;
+		size_t count = 0;
+
+		for (size_t i = 0; i < a.size(); i += 4) {
+			for (int c = firstChannel; c < firstChannel + channelCount; c++) {
+				double delta = static_cast<double>(a[i + c]) - b[i + c];
+				sum += delta * delta;
+				count++;
+			}
+		}
+
+		return std::sqrt(sum / count);
+	}
+
+	void FillBlock(uint8_t* block, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		for (int i = 0; i < 16; i++) {
+			block[i * 4 + 0] = r;
+			block[i * 4 + 1] = g;
+			block[i * 4 + 2] = b;
+			block[i * 4 + 3] = a;
+		}
+	}
+
+	uint16_t ReadColor(const uint8_t* src, int offset) {
+		return static_cast<uint16_t>(src[offset] | (src[offset + 1] << 8));
+	}
+
+	uint32_t ReadColorIndices(const uint8_t* src) {
+		uint32_t bits = 0;
+		std::memcpy(&bits, src + 4, sizeof(bits));
+		return bits;
+	}
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// encode -> decode round trips, the bounds leave some slack over what the current encoder reaches
+
+static void TestRoundTrips() {
+	const uint32_t width = 32, height = 32;
+	std::vector<uint8_t> image = MakeImage(width, height);
+
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC1, image, width, height), 0, 3) < 8.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC3, image, width, height), 0, 3) < 8.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC3, image, width, height), 3, 1) < 2.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC4, image, width, height), 0, 1) < 2.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC5, image, width, height), 0, 2) < 2.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC7, image, width, height), 0, 4) < 7.0);
+
+	// channels the format doesn't store
+	std::vector<uint8_t> bc4 = RoundTrip(BlockFormat::BC4, image, width, height);
+	std::vector<uint8_t> bc5 = RoundTrip(BlockFormat::BC5, image, width, height);
+
+	CHECK(bc4[1] == 0 && bc4[2] == 0 && bc4[3] == 255);
+	CHECK(bc5[2] == 0 && bc5[3] == 255);
+}
+
+// partial blocks on the right and bottom edges
+static void TestPartialBlocks() {
+	const uint32_t width = 13, height = 7;
+	std::vector<uint8_t> image = MakeImage(width, height);
+
+	CHECK(BlockCompressor::GetCompressedSize(BlockFormat::BC1, width, height) == 4 * 2 * 8);
+	CHECK(BlockCompressor::GetCompressedSize(BlockFormat::BC7, width, height) == 4 * 2 * 16);
+
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC1, image, width, height), 0, 3) < 8.0);
+	CHECK(RootMeanSquareError(image, RoundTrip(BlockFormat::BC7, image, width, height), 0, 4) < 7.0);
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// BC1 endpoint ordering
+
+static void TestColorSolidBlocks() {
+	const uint8_t colors[][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 200, 100, 50 }, { 13, 201, 77 }, { 128, 128, 128 } };
+
+	for (const auto& color : colors) {
+		uint8_t block[64], decoded[64], encoded[8];
+		FillBlock(block, color[0], color[1], color[2], 255);
+
+		BlockCompressor::CompressBlock(BlockFormat::BC1, block, encoded);
+		BlockCompressor::DecompressBlock(BlockFormat::BC1, encoded, decoded);
+
+		uint16_t c0 = ReadColor(encoded, 0);
+		uint16_t c1 = ReadColor(encoded, 2);
+
+		// c0 == c1 decodes in three color mode, where index 3 is black: every texel must stay on c0
+		CHECK(c0 >= c1);
+
+		if (c0 == c1)
+			CHECK(ReadColorIndices(encoded) == 0);
+
+		for (int i = 0; i < 16; i++) {
+			// 5:6:5 quantization
+			CHECK(std::abs(decoded[i * 4 + 0] - color[0]) <= 4);
+			CHECK(std::abs(decoded[i * 4 + 1] - color[1]) <= 2);
+			CHECK(std::abs(decoded[i * 4 + 2] - color[2]) <= 4);
+			CHECK(decoded[i * 4 + 3] == 255);
+		}
+	}
+}
+
+static void TestColorEndpointOrdering() {
+	for (int test = 0; test < 256; test++) {
+		uint8_t block[64], encoded[8];
+
+		for (int i = 0; i < 64; i++)
+			block[i] = static_cast<uint8_t>(Random(256));
+
+		BlockCompressor::CompressBlock(BlockFormat::BC1, block, encoded);
+
+		uint16_t c0 = ReadColor(encoded, 0);
+		uint16_t c1 = ReadColor(encoded, 2);
+
+		// opaque BC1 must never land in the three color (punch through) mode
+		CHECK(c0 > c1 || (c0 == c1 && ReadColorIndices(encoded) == 0));
+	}
+
+	// BC3 decodes its color block in four color mode whatever the endpoint order
+	uint8_t block[64], decoded[64], encoded[16];
+	FillBlock(block, 90, 180, 30, 77);
+
+	BlockCompressor::CompressBlock(BlockFormat::BC3, block, encoded);
+	BlockCompressor::DecompressBlock(BlockFormat::BC3, encoded, decoded);
+
+	for (int i = 0; i < 16; i++) {
+		CHECK(std::abs(decoded[i * 4 + 0] - 90) <= 4);
+		CHECK(std::abs(decoded[i * 4 + 1] - 180) <= 2);
+		CHECK(std::abs(decoded[i * 4 + 2] - 30) <= 4);
+		CHECK(decoded[i * 4 + 3] == 77);
+	}
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// BC4/BC5 ramps
+
+static void TestChannelBlocks() {
+	uint8_t block[64], decoded[64], encoded[8];
+
+	// solid values are exact
+	for (int value : { 0, 1, 127, 254, 255 }) {
+		FillBlock(block, static_cast<uint8_t>(value), 0, 0, 255);
+
+		BlockCompressor::CompressBlock(BlockFormat::BC4, block, encoded);
+		BlockCompressor::DecompressBlock(BlockFormat::BC4, encoded, decoded);
+
+		for (int i = 0; i < 16; i++)
+			CHECK(decoded[i * 4] == value);
+	}
+
+	// a smooth gradient uses the eight value ramp (a0 > a1)
+	for (int i = 0; i < 16; i++)
+		block[i * 4] = static_cast<uint8_t>(100 + i * 4);
+
+	BlockCompressor::CompressBlock(BlockFormat::BC4, block, encoded);
+	BlockCompressor::DecompressBlock(BlockFormat::BC4, encoded, decoded);
+
+	CHECK(encoded[0] > encoded[1]);
+
+	// 60 over seven steps
+	for (int i = 0; i < 16; i++)
+		CHECK(std::abs(decoded[i * 4] - block[i * 4]) <= 5);
+
+	// masked texels next to a gradient: the six value ramp (a0 <= a1) keeps exact 0 and 255
+	for (int i = 0; i < 16; i++)
+		block[i * 4] = static_cast<uint8_t>(i < 4 ? 0 : i < 8 ? 255 : 120 + i);
+
+	BlockCompressor::CompressBlock(BlockFormat::BC4, block, encoded);
+	BlockCompressor::DecompressBlock(BlockFormat::BC4, encoded, decoded);
+
+	CHECK(encoded[0] <= encoded[1]);
+
+	for (int i = 0; i < 8; i++)
+		CHECK(decoded[i * 4] == block[i * 4]);
+
+	for (int i = 8; i < 16; i++)
+		CHECK(std::abs(decoded[i * 4] - block[i * 4]) <= 2);
+}
+
+// normal map texels through BC5 with Z rebuilt the way the shaders do it
+static void TestNormalReconstruction() {
+	const uint32_t width = 16, height = 16;
+	std::vector<uint8_t> image(width * height * 4);
+	std::vector<float> normals(width * height * 3);
+
+	for (uint32_t i = 0; i < width * height; i++) {
+		float x = std::sin((i % width) * 0.15f + (i / width) * 0.05f) * 0.6f;
+		float y = std::cos((i / width) * 0.15f) * 0.6f;
+		float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+
+		normals[i * 3 + 0] = x;
+		normals[i * 3 + 1] = y;
+		normals[i * 3 + 2] = z;
+
+		image[i * 4 + 0] = ToByte(static_cast<int>(std::lround((x * 0.5f + 0.5f) * 255.0f)));
+		image[i * 4 + 1] = ToByte(static_cast<int>(std::lround((y * 0.5f + 0.5f) * 255.0f)));
+		image[i * 4 + 2] = ToByte(static_cast<int>(std::lround((z * 0.5f + 0.5f) * 255.0f)));
+		image[i * 4 + 3] = 255;
+	}
+
+	std::vector<uint8_t> decoded = RoundTrip(BlockFormat::BC5, image, width, height);
+
+	float worstCosine = 1.0f;
+
+	for (uint32_t i = 0; i < width * height; i++) {
+		float x = decoded[i * 4 + 0] / 255.0f * 2.0f - 1.0f;
+		float y = decoded[i * 4 + 1] / 255.0f * 2.0f - 1.0f;
+		float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+
+		worstCosine = std::min(worstCosine, x * normals[i * 3 + 0] + y * normals[i * 3 + 1] + z * normals[i * 3 + 2]);
+	}
+
+	// a few steps of the eight value ramp per channel, amplified where Z gets small
+	CHECK(worstCosine > std::cos(3.0f * 3.14159265f / 180.0f));
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// BC7 mode 6
+
+static void TestMode6Blocks() {
+	uint8_t block[64], decoded[64], encoded[16];
+
+	// solid colors: 7 bit endpoints plus a shared p-bit are within 1 of any RGBA8 value
+	const uint8_t colors[][4] = { { 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 201, 100, 51, 255 }, { 1, 2, 3, 4 } };
+
+	for (const auto& color : colors) {
+		FillBlock(block, color[0], color[1], color[2], color[3]);
+
+		BlockCompressor::CompressBlock(BlockFormat::BC7, block, encoded);
+		BlockCompressor::DecompressBlock(BlockFormat::BC7, encoded, decoded);
+
+		// mode 6 is a single 1 bit after six zeros
+		CHECK((encoded[0] & 0x7F) == 0x40);
+
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++)
+				CHECK(std::abs(decoded[i * 4 + c] - color[c]) <= 1);
+		}
+	}
+
+	// the first texel sits at the high end of the ramp, so its index has the top bit set until the encoder swaps the
+	// endpoints (the anchor index is stored with 3 bits)
+	for (int i = 0; i < 16; i++) {
+		uint8_t value = static_cast<uint8_t>(255 - i * 16);
+		block[i * 4 + 0] = value;
+		block[i * 4 + 1] = value;
+		block[i * 4 + 2] = value;
+		block[i * 4 + 3] = 255;
+	}
+
+	BlockCompressor::CompressBlock(BlockFormat::BC7, block, encoded);
+	BlockCompressor::DecompressBlock(BlockFormat::BC7, encoded, decoded);
+
+	for (int i = 0; i < 64; i++)
+		CHECK(std::abs(decoded[i] - block[i]) <= 3);
+
+	// an unknown mode decodes to zero instead of garbage
+	std::memset(encoded, 0, sizeof(encoded));
+	encoded[0] = 0x01;
+
+	BlockCompressor::DecompressBlock(BlockFormat::BC7, encoded, decoded);
+
+	for (int i = 0; i < 64; i++)
+		CHECK(decoded[i] == 0);
+}
+
+int main() {
+	TestRoundTrips();
+	TestPartialBlocks();
+	TestColorSolidBlocks();
+	TestColorEndpointOrdering();
+	TestChannelBlocks();
+	TestNormalReconstruction();
+	TestMode6Blocks();
+
+	return Tests::Finish("BlockCompressorTest");
+}
@@ -0,0 +1,201 @@
+#include "IBLBaker.h"
+#include "TestUtils.h"
+
+#include <cmath>
+#include <functional>
+
+using Utils::IBLBaker;
+
+namespace {
+	constexpr double PI = 3.14159265358979323846;
+
+	// RGBA float cubemap with every texel set from its direction, in the layout IBLBaker expects
+	Bitmap MakeCubemap(uint32_t size, const std::function<glm::vec3(const glm::vec3&)>& radiance) {
+		Bitmap cubemap(size, size, 6, 4, eBitmapFormat_Float);
+		cubemap.setType(eBitmapType_Cube);
+
+		for (uint32_t face = 0; face < 6; face++) {
+			auto texels = cubemap.view<eBitmapFormat_Float, 4>(face);
+
+			for (uint32_t y = 0; y < size; y++) {
+				for (uint32_t x = 0; x < size; x++) {
+					const glm::vec3 color = radiance(IBLBaker::GetTexelDirection(face, float(x), float(y), size));
+					float* texel = texels.at(x, y);
+
+					texel[0] = color.x;
+					texel[1] = color.y;
+					texel[2] = color.z;
+					texel[3] = 1.0f;
+				}
+			}
+		}
+
+		return cubemap;
+	}
+
+	bool Near(double value, double expected, double tolerance) {
+		return std::abs(value - expected) <= tolerance;
+	}
+
+	// Split sum terms by brute force quadrature over the hemisphere of L, same GGX and Schlick-Smith (k = alpha / 2)
+	// as the baker but without importance sampling: scale + bias = integral of D * G * NdotL / (4 * NdotV * NdotL).
+	void IntegrateBRDF(double NdotV, double roughness, double& scale, double& bias) {
+		const double alpha	= roughness * roughness;
+		const double alpha2 = alpha * alpha;
+		const double k		= alpha * 0.5;
+
+		const double vx = std::sqrt(1.0 - NdotV * NdotV);
+		const double vz = NdotV;
+
+		const int thetaSteps	= 1024;
+		const int phiSteps		= 1024;
+
+		const double dTheta = 0.5 * PI / thetaSteps;
+		const double dPhi	= 2.0 * PI / phiSteps;
+
+		scale = 0.0;
+		bias = 0.0;
+
+		for (int t = 0; t < thetaSteps; t++) {
+			const double theta = (t + 0.5) * dTheta;
+			const double NdotL = std::cos(theta);
+
+			for (int p = 0; p < phiSteps; p++) {
+				const double phi = (p + 0.5) * dPhi;
+
+				const double lx = std::sin(theta) * std::cos(phi);
+				const double ly = std::sin(theta) * std::sin(phi);
+
+				double hx = vx + lx, hy = ly, hz = vz + NdotL;
+				const double length = std::sqrt(hx * hx + hy * hy + hz * hz);
+				hx /= length;
+				hy /= length;
+				hz /= length;
+
+				const double NdotH = hz;
+				const double VdotH = vx * hx + vz * hz;
+
+				const double d = NdotH * NdotH * (alpha2 - 1.0) + 1.0;
+				const double D = alpha2 / (PI * d * d);
+				const double G = (NdotV / (NdotV * (1.0 - k) + k)) * (NdotL / (NdotL * (1.0 - k) + k));
+				const double fresnel = std::pow(1.0 - std::max(VdotH, 0.0), 5.0);
+
+				const double value = D * G / (4.0 * NdotV) * std::sin(theta) * dTheta * dPhi;
+
+				scale += (1.0 - fresnel) * value;
+				bias += fresnel * value;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// irradiance SH
+
+// constant radiance L: the irradiance is PI * L in every direction and only the first band is set
+static void TestConstantIrradiance() {
+	const glm::vec3 radiance(1.0f, 0.5f, 2.0f);
+	Bitmap cubemap = MakeCubemap(32, [&](const glm::vec3&) { return radiance; });
+
+	Utils::SHIrradiance irradiance;
+	IBLBaker::ComputeIrradiance(cubemap, irradiance);
+
+	// L * PI * sqrt(4 * PI)
+	const double coefficient = PI * std::sqrt(4.0 * PI);
+
+	CHECK(Near(irradiance.Coefficients[0].x, coefficient * radiance.x, 1e-3 * coefficient));
+	CHECK(Near(irradiance.Coefficients[0].y, coefficient * radiance.y, 1e-3 * coefficient));
+	CHECK(Near(irradiance.Coefficients[0].z, coefficient * radiance.z, 1e-3 * coefficient));
+
+	for (int i = 1; i < 9; i++)
+		CHECK(glm::length(irradiance.Coefficients[i]) < 1e-3f);
+
+	const glm::vec3 normals[] = { { 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, glm::normalize(glm::vec3(1, 1, -1)) };
+
+	for (const glm::vec3& normal : normals) {
+		const glm::vec3 value = IBLBaker::EvaluateIrradiance(irradiance, normal);
+
+		CHECK(Near(value.x, PI * radiance.x, 1e-3 * PI));
+		CHECK(Near(value.y, PI * radiance.y, 1e-3 * PI));
+		CHECK(Near(value.z, PI * radiance.z, 1e-3 * PI));
+	}
+}
+
+// L(w) = a + b * w.y is inside the first two bands, so the order 2 projection is exact:
+// E(n) = PI * a + 2 * PI / 3 * b * n.y
+static void TestLinearIrradiance() {
+	const float a = 1.0f, b = 0.5f;
+	Bitmap cubemap = MakeCubemap(32, [&](const glm::vec3& direction) { return glm::vec3(a + b * direction.y); });
+
+	Utils::SHIrradiance irradiance;
+	IBLBaker::ComputeIrradiance(cubemap, irradiance);
+
+	const glm::vec3 normals[] = { { 0, 1, 0 }, { 0, -1, 0 }, { 1, 0, 0 }, glm::normalize(glm::vec3(0.3f, 0.8f, -0.5f)) };
+
+	for (const glm::vec3& normal : normals) {
+		const double expected = PI * a + 2.0 * PI / 3.0 * b * normal.y;
+		const glm::vec3 value = IBLBaker::EvaluateIrradiance(irradiance, normal);
+
+		CHECK(Near(value.x, expected, 1e-3 * expected));
+		CHECK(Near(value.y, expected, 1e-3 * expected));
+		CHECK(Near(value.z, expected, 1e-3 * expected));
+	}
+
+	// Y_1,-1 holds the y term, the x and z ones stay empty
+	CHECK(std::abs(irradiance.Coefficients[1].x) > 0.1f);
+	CHECK(std::abs(irradiance.Coefficients[2].x) < 1e-3f);
+	CHECK(std::abs(irradiance.Coefficients[3].x) < 1e-3f);
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// split sum BRDF LUT
+
+static void TestBRDF() {
+	Utils::IBLSettings settings;
+	settings.BRDFSize		= 32;
+	settings.BRDFSamples	= 1024;
+
+	Utils::IBLData data;
+	IBLBaker::ComputeBRDF(settings, data);
+
+	CHECK(data.BRDFSize == 32);
+	CHECK(data.BRDF.size() == 32 * 32 * 2);
+
+	auto texel = [&](uint32_t x, uint32_t y) { return data.BRDF.data() + (y * data.BRDFSize + x) * 2; };
+	auto center = [&](uint32_t i) { return (i + 0.5) / data.BRDFSize; };
+
+	// smooth surfaces: G and the visibility term are 1, the LUT is Schlick's Fresnel at NdotV
+	for (uint32_t x : { 1u, 8u, 16u, 31u }) {
+		const double fresnel = std::pow(1.0 - center(x), 5.0);
+
+		CHECK(Near(texel(x, 0)[0], 1.0 - fresnel, 0.01));
+		CHECK(Near(texel(x, 0)[1], fresnel, 0.01));
+	}
+
+	// rough texels against the quadrature
+	const uint32_t samples[][2] = { { 4, 12 }, { 16, 16 }, { 28, 20 }, { 16, 31 } };
+
+	for (const auto& sample : samples) {
+		double scale, bias;
+		IntegrateBRDF(center(sample[0]), center(sample[1]), scale, bias);
+
+		CHECK(Near(texel(sample[0], sample[1])[0], scale, 0.01));
+		CHECK(Near(texel(sample[0], sample[1])[1], bias, 0.01));
+	}
+
+	// energy: the terms are positive and never add up to more than the incoming light
+	for (uint32_t i = 0; i < data.BRDFSize * data.BRDFSize; i++) {
+		const float scale	= data.BRDF[i * 2 + 0];
+		const float bias	= data.BRDF[i * 2 + 1];
+
+		CHECK(scale >= 0.0f && bias >= 0.0f && scale + bias <= 1.0f + 1e-3f);
+	}
+}
+
+int main() {
+	TestConstantIrradiance();
+	TestLinearIrradiance();
+	TestBRDF();
+
+	return Tests::Finish("IBLBakerTest");
+}
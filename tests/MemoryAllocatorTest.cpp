@@ -0,0 +1,556 @@
+#include "MemoryAllocator.h"
+#include "TestUtils.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace Graphics;
+
+// ----------------------------------------------------------------------------------------------------------------
+// fake device: the memory entry points the allocator calls, backed by host memory so mapped pointers are real
+
+namespace {
+	constexpr VkDeviceSize MB = 1024ull * 1024;
+
+	struct FakeMemory {
+		VkDeviceSize		Size		= 0;
+		uint32_t			MemoryType	= 0;
+		VkImage				Image		= VK_NULL_HANDLE;		// from VkMemoryDedicatedAllocateInfo
+		VkBuffer			Buffer		= VK_NULL_HANDLE;
+		std::vector<char>	Data;
+	};
+
+	struct FakeDevice {
+		std::map<VkDeviceMemory, FakeMemory>	Memories;
+		uintptr_t								NextHandle			= 1;
+		uint32_t								AllocateCalls		= 0;
+		VkDeviceSize							FailAbove			= ~0ull;	// vkAllocateMemory fails for larger sizes
+
+		// what the next vkGet*MemoryRequirements2 returns
+		VkMemoryRequirements					Requirements		= {};
+		bool									PrefersDedicated	= false;
+		bool									RequiresDedicated	= false;
+
+		std::vector<VkMappedMemoryRange>		Flushes;
+
+		void Reset() { *this = {}; }
+	};
+
+	FakeDevice g_Device;
+
+	void FillDedicatedRequirements(VkMemoryRequirements2* requirements) {
+		requirements->memoryRequirements = g_Device.Requirements;
+
+		auto dedicated = static_cast<VkMemoryDedicatedRequirements*>(requirements->pNext);
+		dedicated->prefersDedicatedAllocation = g_Device.PrefersDedicated;
+		dedicated->requiresDedicatedAllocation = g_Device.RequiresDedicated;
+	}
+
+	void CheckBinding(VkDeviceMemory memory, VkDeviceSize offset) {
+		auto it = g_Device.Memories.find(memory);
+
+		CHECK(it != g_Device.Memories.end());
+		CHECK(it != g_Device.Memories.end() && offset + g_Device.Requirements.size <= it->second.Size);
+		CHECK(offset % g_Device.Requirements.alignment == 0);
+	}
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* info, const VkAllocationCallbacks*, VkDeviceMemory* memory) {
+	g_Device.AllocateCalls++;
+
+	if (info->allocationSize > g_Device.FailAbove)
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+	FakeMemory fake = {};
+	fake.Size		= info->allocationSize;
+	fake.MemoryType = info->memoryTypeIndex;
+
+	if (info->pNext) {
+		auto dedicated = static_cast<const VkMemoryDedicatedAllocateInfo*>(info->pNext);
+		CHECK(dedicated->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO);
+
+		fake.Image	= dedicated->image;
+		fake.Buffer = dedicated->buffer;
+	}
+
+	*memory = (VkDeviceMemory)g_Device.NextHandle++;
+	g_Device.Memories[*memory] = std::move(fake);
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+	CHECK(g_Device.Memories.erase(memory) == 1);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags, void** data) {
+	FakeMemory& fake = g_Device.Memories.at(memory);
+
+	CHECK(offset == 0 && size == VK_WHOLE_SIZE);
+
+	fake.Data.resize(fake.Size);
+	*data = fake.Data.data();
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice, uint32_t count, const VkMappedMemoryRange* ranges) {
+	g_Device.Flushes.insert(g_Device.Flushes.end(), ranges, ranges + count);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(VkDevice, const VkImageMemoryRequirementsInfo2*, VkMemoryRequirements2* requirements) {
+	FillDedicatedRequirements(requirements);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(VkDevice, const VkBufferMemoryRequirementsInfo2*, VkMemoryRequirements2* requirements) {
+	FillDedicatedRequirements(requirements);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice, VkImage, VkDeviceMemory memory, VkDeviceSize offset) {
+	CheckBinding(memory, offset);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory memory, VkDeviceSize offset) {
+	CheckBinding(memory, offset);
+	return VK_SUCCESS;
+}
+
+namespace {
+	enum MemoryTypes : uint32_t {
+		eDeviceLocal	= 0,	// 4 GB heap, 256 MB blocks
+		eHostCoherent	= 1,	// 1 GB heap, 128 MB blocks
+		eHostCached		= 2,	// 1 GB heap, not coherent
+		eDeviceHost		= 3,	// resizable BAR
+		eAllTypes		= 0xF
+	};
+
+	// discrete GPU like table: device local VRAM, host visible system memory with and without coherency, and a small
+	// host visible window into VRAM
+	VkPhysicalDeviceMemoryProperties MakeMemoryProperties() {
+		VkPhysicalDeviceMemoryProperties properties = {};
+
+		properties.memoryHeapCount		= 2;
+		properties.memoryHeaps[0]		= { 4096 * MB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+		properties.memoryHeaps[1]		= { 1024 * MB, 0 };
+
+		properties.memoryTypeCount		= 4;
+		properties.memoryTypes[eDeviceLocal]	= { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+		properties.memoryTypes[eHostCoherent]	= { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+		properties.memoryTypes[eHostCached]		= { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1 };
+		properties.memoryTypes[eDeviceHost]		= { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0 };
+
+		return properties;
+	}
+
+	// non dispatchable handles are pointers on 64 bit and uint64_t on 32 bit builds
+	VkBuffer FakeBuffer(uintptr_t id) { return (VkBuffer)id; }
+	VkImage FakeImage(uintptr_t id) { return (VkImage)id; }
+
+	MemoryAllocation AllocateBuffer(MemoryAllocator& allocator, VkDeviceSize size, VkDeviceSize alignment, VkMemoryPropertyFlags properties, uint32_t typeBits = eAllTypes) {
+		g_Device.Requirements = { size, alignment, typeBits };
+		return allocator.AllocateBuffer(FakeBuffer(g_Device.NextHandle++), properties);
+	}
+
+	MemoryAllocation AllocateImage(MemoryAllocator& allocator, VkDeviceSize size, VkImageTiling tiling, VkImageUsageFlagBits usage = VK_IMAGE_USAGE_SAMPLED_BIT, VkImage image = VK_NULL_HANDLE) {
+		ImageDescription description = {};
+		description.Tiling	= tiling;
+		description.Usage	= usage;
+
+		g_Device.Requirements = { size, 4096, eAllTypes };
+		return allocator.AllocateImage(image ? image : FakeImage(g_Device.NextHandle++), description, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	bool Overlaps(const MemoryAllocation& a, const MemoryAllocation& b) {
+		return a.Memory == b.Memory && a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+	}
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// TLSF
+
+// ranges are taken from the front of the free space, sizes round up to the 16 byte granularity
+static void TestTLSFSplit() {
+	TLSF tlsf(1 * MB);
+
+	uint64_t offsets[3];
+	uint32_t nodes[3];
+
+	for (int i = 0; i < 3; i++)
+		CHECK(tlsf.Allocate(1024, 1, offsets[i], nodes[i]));
+
+	CHECK(offsets[0] == 0 && offsets[1] == 1024 && offsets[2] == 2048);
+	CHECK(tlsf.GetUsed() == 3 * 1024);
+	CHECK(tlsf.GetAllocationCount() == 3);
+
+	uint64_t offset;
+	uint32_t node;
+
+	CHECK(tlsf.Allocate(1, 1, offset, node));
+	CHECK(offset == 3 * 1024);
+	CHECK(tlsf.GetUsed() == 3 * 1024 + 16);
+
+	// a hole of the right size is reused before the rest of the block
+	tlsf.Free(nodes[1]);
+
+	CHECK(tlsf.Allocate(1024, 1, offset, nodes[1]));
+	CHECK(offset == 1024);
+}
+
+// neighbours are merged on free, so an emptied block holds one range of its full size again
+static void TestTLSFMerge() {
+	TLSF tlsf(64 * 1024);
+
+	uint64_t offset;
+	uint32_t nodes[4];
+
+	for (int i = 0; i < 4; i++)
+		CHECK(tlsf.Allocate(16 * 1024, 1, offset, nodes[i]));
+
+	CHECK(tlsf.GetUsed() == tlsf.GetSize());
+
+	uint32_t node;
+	CHECK(!tlsf.Allocate(16, 1, offset, node));
+
+	// middle first (no free neighbours), then the one before it (merges with the next) and the one after (merges
+	// with the previous), and the last one merges on both sides
+	tlsf.Free(nodes[1]);
+	CHECK(!tlsf.Allocate(32 * 1024, 1, offset, nodes[1]));
+
+	tlsf.Free(nodes[0]);
+	tlsf.Free(nodes[3]);
+	CHECK(!tlsf.Allocate(64 * 1024, 1, offset, nodes[0]));
+
+	tlsf.Free(nodes[2]);
+	CHECK(tlsf.IsEmpty());
+	CHECK(tlsf.GetUsed() == 0);
+
+	CHECK(tlsf.Allocate(64 * 1024, 1, offset, node));
+	CHECK(offset == 0);
+}
+
+// the padding in front of an aligned range stays free and is handed out to smaller requests
+static void TestTLSFAlignment() {
+	TLSF tlsf(1 * MB);
+
+	uint64_t offset;
+	uint32_t node;
+
+	CHECK(tlsf.Allocate(16, 1, offset, node));
+	CHECK(offset == 0);
+
+	CHECK(tlsf.Allocate(100, 4096, offset, node));
+	CHECK(offset == 4096);
+
+	CHECK(tlsf.Allocate(4000, 16, offset, node));
+	CHECK(offset == 16);
+
+	CHECK(tlsf.Allocate(256, 65536, offset, node));
+	CHECK(offset == 65536);
+
+	// larger than what is left
+	CHECK(!tlsf.Allocate(1 * MB, 1, offset, node));
+}
+
+// random allocations and frees: ranges stay aligned, inside the block and never overlap
+static void TestTLSFRandom() {
+	const uint64_t size = 16 * MB;
+	TLSF tlsf(size);
+
+	std::mt19937_64 rng(1);
+	std::map<uint32_t, std::pair<uint64_t, uint64_t>> live;
+
+	bool valid = true;
+
+	for (int i = 0; i < 20000 && valid; i++) {
+		if (live.empty() || rng() % 100 < 55) {
+			const uint64_t bytes = 1 + rng() % (rng() % 4 == 0 ? 256 * 1024 : 4096);
+			const uint64_t alignment = 1ull << (rng() % 17);
+
+			uint64_t offset;
+			uint32_t node;
+
+			if (!tlsf.Allocate(bytes, alignment, offset, node))
+				continue;
+
+			valid &= offset % alignment == 0 && offset + bytes <= size && live.count(node) == 0;
+
+			for (const auto& [other, range] : live)
+				valid &= offset + bytes <= range.first || range.first + range.second <= offset;
+
+			live[node] = { offset, bytes };
+		}
+		else {
+			auto it = live.begin();
+			std::advance(it, rng() % live.size());
+
+			tlsf.Free(it->first);
+			live.erase(it);
+		}
+	}
+
+	CHECK(valid);
+	CHECK(tlsf.GetAllocationCount() == live.size());
+
+	for (const auto& [node, range] : live)
+		tlsf.Free(node);
+
+	uint64_t offset;
+	uint32_t node;
+
+	CHECK(tlsf.IsEmpty());
+	CHECK(tlsf.Allocate(size, 1, offset, node));
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// MemoryAllocator
+
+static void TestMemoryTypeSelection() {
+	g_Device.Reset();
+
+	MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+
+	CHECK(allocator.FindMemoryType(eAllTypes, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == eDeviceLocal);
+	CHECK(allocator.FindMemoryType(eAllTypes, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == eHostCoherent);
+	CHECK(allocator.FindMemoryType(eAllTypes, VK_MEMORY_PROPERTY_HOST_CACHED_BIT) == eHostCached);
+	CHECK(allocator.FindMemoryType(eAllTypes, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == eDeviceHost);
+
+	// only the types the resource allows
+	CHECK(allocator.FindMemoryType(1u << eDeviceHost, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == eDeviceHost);
+	CHECK(allocator.FindMemoryType((1u << eHostCached) | (1u << eDeviceHost), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == eHostCached);
+
+	bool thrown = false;
+
+	try {
+		allocator.FindMemoryType(1u << eDeviceLocal, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+
+	CHECK(thrown);
+
+	// blocks are 256 MB at most, an eighth of smaller heaps, host visible ones are mapped
+	MemoryAllocation local	= AllocateBuffer(allocator, 1024, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	MemoryAllocation host	= AllocateBuffer(allocator, 1024, 256, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	CHECK(local.MemoryType == eDeviceLocal && g_Device.Memories.at(local.Memory).Size == 256 * MB);
+	CHECK(host.MemoryType == eHostCoherent && g_Device.Memories.at(host.Memory).Size == 128 * MB);
+
+	CHECK(local.Mapped == nullptr);
+	CHECK(host.Mapped == g_Device.Memories.at(host.Memory).Data.data() + host.Offset);
+
+	allocator.Free(local);
+	allocator.Free(host);
+}
+
+// resources share a block, one vkAllocateMemory for many resources
+static void TestSubAllocation() {
+	g_Device.Reset();
+
+	{
+		MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+		std::vector<MemoryAllocation> allocations;
+
+		for (int i = 0; i < 64; i++)
+			allocations.push_back(AllocateBuffer(allocator, 1000 + i * 37, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+		CHECK(g_Device.AllocateCalls == 1);
+
+		for (size_t i = 0; i < allocations.size(); i++) {
+			CHECK(allocations[i].Block != MemoryAllocation::DEDICATED);
+			CHECK(allocations[i].Memory == allocations[0].Memory);
+
+			for (size_t j = 0; j < i; j++)
+				CHECK(!Overlaps(allocations[i], allocations[j]));
+		}
+
+		auto stats = allocator.GetHeapStats();
+
+		CHECK(stats.size() == 2);
+		CHECK(stats[0].Blocks == 1 && stats[0].Allocations == 64 && stats[0].DedicatedAllocations == 0);
+		CHECK(stats[0].BlockBytes == 256 * MB && stats[0].UsedBytes >= 64 * 1000);
+		CHECK(stats[1].Blocks == 0);
+
+		// a second block once the first is full, the last empty block of a pool is kept
+		MemoryAllocation large[3];
+
+		for (MemoryAllocation& allocation : large)
+			allocation = AllocateBuffer(allocator, 100 * MB, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		CHECK(g_Device.AllocateCalls == 2);
+		CHECK(large[1].Memory == allocations[0].Memory && large[2].Memory != allocations[0].Memory);
+
+		for (MemoryAllocation& allocation : allocations)
+			allocator.Free(allocation);
+
+		allocator.Free(large[0]);
+		allocator.Free(large[1]);
+		CHECK(g_Device.Memories.size() == 1);
+
+		allocator.Free(large[2]);
+		CHECK(g_Device.Memories.size() == 1);
+		CHECK(allocator.GetHeapStats()[0].Blocks == 1 && allocator.GetHeapStats()[0].UsedBytes == 0);
+	}
+
+	// and everything goes with the allocator
+	CHECK(g_Device.Memories.empty());
+}
+
+// with bufferImageGranularity > 1 linear and optimal resources never share a block
+static void TestGranularity() {
+	g_Device.Reset();
+
+	{
+		MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1024, 64);
+
+		MemoryAllocation buffer	 = AllocateBuffer(allocator, 4096, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		MemoryAllocation optimal = AllocateImage(allocator, 64 * 1024, VK_IMAGE_TILING_OPTIMAL);
+		MemoryAllocation linear	 = AllocateImage(allocator, 64 * 1024, VK_IMAGE_TILING_LINEAR);
+
+		CHECK(buffer.MemoryType == optimal.MemoryType);
+		CHECK(buffer.Memory != optimal.Memory);
+		CHECK(buffer.Memory == linear.Memory);
+		CHECK(g_Device.AllocateCalls == 2);
+
+		allocator.Free(buffer);
+		allocator.Free(optimal);
+		allocator.Free(linear);
+	}
+
+	g_Device.Reset();
+
+	{
+		MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+
+		MemoryAllocation buffer	 = AllocateBuffer(allocator, 4096, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		MemoryAllocation optimal = AllocateImage(allocator, 64 * 1024, VK_IMAGE_TILING_OPTIMAL);
+
+		CHECK(buffer.Memory == optimal.Memory);
+		CHECK(!Overlaps(buffer, optimal));
+		CHECK(g_Device.AllocateCalls == 1);
+
+		allocator.Free(buffer);
+		allocator.Free(optimal);
+	}
+}
+
+static void TestDedicated() {
+	g_Device.Reset();
+
+	{
+		MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+
+		// the driver asks for it, the image is passed along in VkMemoryDedicatedAllocateInfo
+		const VkImage image = FakeImage(0xABC0);
+
+		g_Device.PrefersDedicated = true;
+		MemoryAllocation preferred = AllocateImage(allocator, 64 * 1024, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, image);
+		g_Device.PrefersDedicated = false;
+
+		CHECK(preferred.Block == MemoryAllocation::DEDICATED && preferred.Offset == 0);
+		CHECK(g_Device.Memories.at(preferred.Memory).Size == 64 * 1024);
+		CHECK(g_Device.Memories.at(preferred.Memory).Image == image);
+
+		// big render targets, but not small ones
+		MemoryAllocation target = AllocateImage(allocator, 32 * MB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+		MemoryAllocation small	= AllocateImage(allocator, 1 * MB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+		CHECK(target.Block == MemoryAllocation::DEDICATED);
+		CHECK(small.Block != MemoryAllocation::DEDICATED);
+
+		// more than half a block
+		MemoryAllocation huge = AllocateBuffer(allocator, 65 * MB, 256, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		CHECK(huge.Block == MemoryAllocation::DEDICATED && huge.Mapped != nullptr);
+		CHECK(g_Device.Memories.at(huge.Memory).Buffer != VK_NULL_HANDLE);
+
+		g_Device.RequiresDedicated = true;
+		MemoryAllocation required = AllocateBuffer(allocator, 1024, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		g_Device.RequiresDedicated = false;
+
+		CHECK(required.Block == MemoryAllocation::DEDICATED);
+
+		auto stats = allocator.GetHeapStats();
+		CHECK(stats[0].DedicatedAllocations == 3 && stats[0].DedicatedBytes == 64 * 1024 + 32 * MB + 1024);
+		CHECK(stats[1].DedicatedAllocations == 1 && stats[1].DedicatedBytes == 65 * MB);
+
+		const size_t memories = g_Device.Memories.size();
+
+		allocator.Free(preferred);
+		allocator.Free(target);
+		allocator.Free(huge);
+		allocator.Free(required);
+
+		CHECK(g_Device.Memories.size() == memories - 4);
+		CHECK(preferred.Memory == VK_NULL_HANDLE);
+
+		stats = allocator.GetHeapStats();
+		CHECK(stats[0].DedicatedAllocations == 0 && stats[0].DedicatedBytes == 0);
+		CHECK(stats[1].DedicatedAllocations == 0 && stats[1].DedicatedBytes == 0);
+
+		allocator.Free(small);
+	}
+
+	CHECK(g_Device.Memories.empty());
+
+	// no room for a new block, the resource alone still fits
+	g_Device.Reset();
+
+	{
+		MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+
+		g_Device.FailAbove = 16 * MB;
+		MemoryAllocation fallback = AllocateBuffer(allocator, 1 * MB, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		CHECK(fallback.Block == MemoryAllocation::DEDICATED);
+		CHECK(g_Device.Memories.at(fallback.Memory).Size == 1 * MB);
+
+		allocator.Free(fallback);
+	}
+}
+
+// only non coherent memory is flushed, with the range widened to nonCoherentAtomSize
+static void TestFlush() {
+	g_Device.Reset();
+
+	MemoryAllocator allocator(VK_NULL_HANDLE, MakeMemoryProperties(), 1, 64);
+
+	MemoryAllocation coherent = AllocateBuffer(allocator, 1024, 16, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	allocator.Flush(coherent, 0, 1024);
+
+	CHECK(g_Device.Flushes.empty());
+
+	MemoryAllocation padding = AllocateBuffer(allocator, 16, 16, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	MemoryAllocation cached = AllocateBuffer(allocator, 1024, 16, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+	CHECK(cached.MemoryType == eHostCached && cached.Offset == 16);
+
+	allocator.Flush(cached, 100, 10);
+
+	CHECK(g_Device.Flushes.size() == 1);
+	CHECK(g_Device.Flushes[0].memory == cached.Memory);
+	CHECK(g_Device.Flushes[0].offset == 64);
+	CHECK(g_Device.Flushes[0].size == 64);
+
+	allocator.Free(coherent);
+	allocator.Free(padding);
+	allocator.Free(cached);
+}
+
+int main() {
+	TestTLSFSplit();
+	TestTLSFMerge();
+	TestTLSFAlignment();
+	TestTLSFRandom();
+
+	TestMemoryTypeSelection();
+	TestSubAllocation();
+	TestGranularity();
+	TestDedicated();
+	TestFlush();
+
+	return Tests::Finish("MemoryAllocatorTest");
+}
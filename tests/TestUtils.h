@@ -0,0 +1,29 @@
+#pragma once
+
+#include <iostream>
+
+// Note: the tests are plain executables (CTest only looks at the exit code), CHECK keeps going after a failure so one 
+// run reports every broken case.
+namespace Tests {
+	inline int& FailureCount() {
+		static int failures = 0;
+		return failures;
+	}
+
+	inline int Finish(const char* suite) {
+		if (FailureCount() == 0)
+			std::cout << suite << ": all tests passed" << std::endl;
+		else
+			std::cout << suite << ": " << FailureCount() << " check(s) failed" << std::endl;
+
+		return FailureCount() == 0 ? 0 : 1;
+	}
+}
+
+#define CHECK(condition)																		\
+	do {																						\
+		if (!(condition)) {																		\
+			std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl;	\
+			Tests::FailureCount()++;															\
+		}																						\
+	} while (0)